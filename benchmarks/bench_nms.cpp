@@ -0,0 +1,141 @@
+/**
+ * @file bench_nms.cpp
+ * @brief NMS benchmark on synthetic dense crowd frames
+ *
+ * Generates YOLO-like candidate sets for crowded scenes (many people, each
+ * producing a cluster of jittered candidate boxes plus low-score clutter)
+ * and compares cv::dnn::NMSBoxes against the batched NMS engine in its
+ * class-aware, class-agnostic and soft modes.
+ *
+ * Usage:
+ * @code
+ * ./build/benchmarks/bench_nms [people] [candidates_per_person] [iterations]
+ * @endcode
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <opencv2/dnn.hpp>
+
+#include "nms.h"
+
+using namespace aa::server;
+
+namespace {
+
+/**
+ * @brief Build a dense crowd frame worth of candidates in a 640x640 input
+ */
+NmsCandidates MakeCrowd(int people, int per_person, uint32_t seed) {
+  std::mt19937 rng{seed};
+  std::uniform_real_distribution<float> pos(0.0f, 600.0f);
+  std::uniform_real_distribution<float> size(12.0f, 60.0f);
+  std::normal_distribution<float> jitter(0.0f, 2.5f);
+  std::uniform_real_distribution<float> score(0.3f, 0.95f);
+  std::uniform_int_distribution<int> cls(0, 3);
+
+  NmsCandidates candidates;
+  candidates.Reserve(static_cast<std::size_t>(people) * per_person);
+
+  for (int p = 0; p < people; ++p) {
+    float x = pos(rng);
+    float y = pos(rng);
+    float w = size(rng) * 0.5f;
+    float h = size(rng);
+    // Mostly people, with some bags/bicycles mixed into the crowd
+    int class_id = cls(rng) == 0 ? cls(rng) : 0;
+    for (int k = 0; k < per_person; ++k) {
+      float x1 = x + jitter(rng);
+      float y1 = y + jitter(rng);
+      candidates.Add(x1, y1, x1 + w + jitter(rng), y1 + h + jitter(rng),
+                     score(rng), class_id);
+    }
+  }
+
+  return candidates;
+}
+
+template <typename F>
+double MeasureMs(int iterations, F&& body) {
+  body();  // warm-up
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    body();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::milli>(elapsed).count() /
+         iterations;
+}
+
+void Report(const std::string& name, double ms, std::size_t kept) {
+  std::cout << std::left << std::setw(28) << name << std::right
+            << std::setw(10) << std::fixed << std::setprecision(3) << ms
+            << " ms/frame  kept=" << kept << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int people = argc > 1 ? std::atoi(argv[1]) : 400;
+  int per_person = argc > 2 ? std::atoi(argv[2]) : 15;
+  int iterations = argc > 3 ? std::atoi(argv[3]) : 50;
+
+  const float kScoreThreshold = 0.5f;
+  const float kIouThreshold = 0.45f;
+
+  NmsCandidates crowd = MakeCrowd(people, per_person, 42);
+  std::cout << "Dense crowd: " << people << " objects, " << crowd.Size()
+            << " candidates, " << iterations << " iterations\n";
+
+  // Baseline: OpenCV NMS over every candidate (class-agnostic)
+  std::vector<cv::Rect2d> boxes;
+  std::vector<float> scores;
+  for (std::size_t i = 0; i < crowd.Size(); ++i) {
+    boxes.emplace_back(crowd.x1[i], crowd.y1[i], crowd.x2[i] - crowd.x1[i],
+                       crowd.y2[i] - crowd.y1[i]);
+    scores.push_back(crowd.score[i]);
+  }
+  std::vector<int> cv_keep;
+  double cv_ms = MeasureMs(iterations, [&] {
+    cv::dnn::NMSBoxes(boxes, scores, kScoreThreshold, kIouThreshold, cv_keep);
+  });
+  Report("cv::dnn::NMSBoxes", cv_ms, cv_keep.size());
+
+  auto run_engine = [&](const std::string& name, NmsOptions options) {
+    options.score_threshold = kScoreThreshold;
+    options.iou_threshold = kIouThreshold;
+    Nms nms(options);
+    std::vector<int> keep;
+    NmsCandidates work = crowd;
+    double ms = MeasureMs(iterations, [&] {
+      // Soft NMS rewrites scores, so every iteration starts from the input
+      work.score = crowd.score;
+      nms.Run(work, keep);
+    });
+    Report(name, ms, keep.size());
+  };
+
+  NmsOptions options;
+  options.top_k = 0;
+  options.max_detections = 0;
+  run_engine("engine per-class", options);
+
+  options.class_agnostic = true;
+  run_engine("engine agnostic", options);
+
+  options.class_agnostic = false;
+  options.top_k = 1000;
+  options.max_detections = 300;
+  run_engine("engine per-class top1000", options);
+
+  options.mode = NmsMode::kSoft;
+  run_engine("engine soft top1000", options);
+
+  return 0;
+}
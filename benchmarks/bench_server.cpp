@@ -0,0 +1,138 @@
+/**
+ * @file bench_server.cpp
+ * @brief Non-inference throughput ceiling of the detector server
+ *
+ * Runs DetectorServer::ProcessFrame in-process from several client threads
+ * with the fake inference engine, so every frame pays for frame conversion,
+ * the pipeline hand-offs, zone filtering, drawing, encoding and response
+ * serialization, but not for a model. Server options after the positional
+ * arguments are passed through, e.g. --fake_latency_ms or --render_workers.
+ *
+ * Usage:
+ * @code
+ * ./build/benchmarks/bench_server [threads] [seconds] [width] [height] \
+ *   [--server_option=value ...]
+ * @endcode
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "detector_server.h"
+#include "frame.h"
+#include "frame_wire.h"
+#include "options.h"
+#include "polygon.h"
+
+using namespace aa::server;
+
+namespace {
+
+aa::proto::ProcessFrameRequest MakeRequest(int width, int height) {
+  cv::Mat image(height, width, CV_8UC3);
+  cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+
+  auto w = static_cast<double>(width);
+  auto h = static_cast<double>(height);
+  aa::proto::ProcessFrameRequest request;
+  *request.mutable_frame() = aa::shared::Frame{image}.ToProto();
+  *request.add_polygons() =
+      aa::shared::Polygon({{0, 0}, {w, 0}, {w, h}, {0, h}},
+                          aa::shared::PolygonType::INCLUSION, 1, {})
+          .ToProto();
+  *request.add_polygons() =
+      aa::shared::Polygon({{w / 2, 0}, {w, 0}, {w, h / 2}, {w / 2, h / 2}},
+                          aa::shared::PolygonType::EXCLUSION, 2, {})
+          .ToProto();
+  return request;
+}
+
+double Percentile(std::vector<double>& values, double fraction) {
+  if (values.empty()) return 0.0;
+  auto index = static_cast<std::size_t>(fraction * (values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> positional;
+  std::vector<const char*> server_argv = {argv[0], "--engine=fake",
+                                          "--address=localhost:0"};
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]).starts_with("--")) {
+      server_argv.push_back(argv[i]);
+    } else {
+      positional.emplace_back(argv[i]);
+    }
+  }
+  auto arg = [&](std::size_t i, int fallback) {
+    return i < positional.size() ? std::atoi(positional[i].c_str())
+                                 : fallback;
+  };
+  const int threads = std::max(1, arg(0, 8));
+  const int seconds = std::max(1, arg(1, 5));
+  const int width = std::max(1, arg(2, 1280));
+  const int height = std::max(1, arg(3, 720));
+
+  aa::shared::Options options(static_cast<int>(server_argv.size()),
+                              server_argv.data(), "Benchmark Detector Server");
+  if (!options.IsValid()) {
+    options.PrintHelp();
+    return 1;
+  }
+  DetectorServer server(options);
+  const auto request = MakeRequest(width, height);
+
+  std::cout << "ProcessFrame with the fake engine: " << threads
+            << " threads, " << width << "x" << height << ", " << seconds
+            << "s\n";
+
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> failures{0};
+  std::vector<std::vector<double>> latencies(threads);
+  std::vector<std::thread> clients;
+  for (int t = 0; t < threads; ++t) {
+    clients.emplace_back([&, t] {
+      grpc::ByteBuffer response;
+      aa::shared::FrameResponseView view;
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto start = std::chrono::steady_clock::now();
+        auto status = server.ProcessFrame(&request, &response);
+        latencies[t].push_back(std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count());
+        if (!status.ok() || !view.Parse(response) ||
+            !view.Response().success()) {
+          failures.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  stop = true;
+  for (auto& client : clients) client.join();
+
+  std::vector<double> all;
+  for (auto& thread_latencies : latencies) {
+    all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+  }
+  auto frames = static_cast<double>(all.size());
+  std::cout << std::fixed << std::setprecision(1) << frames / seconds
+            << " frames/s, " << failures.load() << " failed, latency p50 "
+            << std::setprecision(3) << Percentile(all, 0.50) << " ms, p99 "
+            << Percentile(all, 0.99) << " ms\n"
+            << server.GetStats().ToString() << "\n";
+  return failures.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace aa::client {
+
+/**
+ * @brief Whole-file reads and writes on a background I/O thread
+ *
+ * Reads return a future, so callers can prefetch files ahead of decoding.
+ * Writes are fire and forget: the data is owned by the queue until it is
+ * on disk, and Flush() waits for all of them. When built with liburing
+ * (AA_HAVE_LIBURING), the I/O thread keeps up to queue_depth operations in
+ * flight on an io_uring; otherwise it performs them one by one with
+ * blocking calls.
+ *
+ * Usage:
+ * @code
+ * AsyncFileIo io;
+ * auto contents = io.Read("input/1.jpg");
+ * ...
+ * io.Write("results/1.jpg", std::move(encoded));
+ * io.Flush();
+ * @endcode
+ *
+ * @threadsafe Read, Write and Flush may be called from any thread
+ */
+class AsyncFileIo {
+ public:
+  using Bytes = std::vector<uint8_t>;
+
+  /**
+   * @brief Start the I/O thread
+   *
+   * @param queue_depth Operations kept in flight with io_uring
+   */
+  explicit AsyncFileIo(unsigned queue_depth = 64);
+
+  /**
+   * @brief Finish queued writes and stop the I/O thread
+   */
+  ~AsyncFileIo();
+
+  AsyncFileIo(const AsyncFileIo&) = delete;
+  AsyncFileIo& operator=(const AsyncFileIo&) = delete;
+
+  /**
+   * @brief Read a whole file
+   *
+   * @return Future of the contents, std::nullopt if the file cannot be read
+   */
+  std::future<std::optional<Bytes>> Read(std::filesystem::path path);
+
+  /**
+   * @brief Write a whole file, replacing it
+   */
+  void Write(std::filesystem::path path, Bytes data);
+
+  /**
+   * @brief Wait until every queued write has completed
+   *
+   * @return Number of writes that failed since the last Flush()
+   */
+  std::size_t Flush();
+
+  /**
+   * @brief Whether operations run on an io_uring
+   */
+  bool UsesIoUring() const { return ring_ != nullptr; }
+
+ private:
+  struct Operation {
+    bool write{false};
+    std::filesystem::path path;
+    Bytes data;
+    std::promise<std::optional<Bytes>> read_done;
+    int fd{-1};
+    std::size_t done{0};  ///< Bytes transferred so far
+  };
+
+  void Enqueue(std::unique_ptr<Operation> operation);
+  void Run();
+  bool RunBlocking(Operation& operation);
+  void Complete(std::unique_ptr<Operation> operation, bool ok);
+
+  struct Ring;  ///< io_uring state, only defined with liburing
+
+  unsigned queue_depth_;
+  Ring* ring_{nullptr};
+
+  std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable flushed_;
+  std::deque<std::unique_ptr<Operation>> queue_;
+  std::size_t pending_writes_{0};
+  std::size_t failed_writes_{0};
+  bool stopping_{false};
+
+  std::thread thread_;
+};
+
+}  // namespace aa::client
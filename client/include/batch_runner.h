@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "detector_client.h"
+#include "options.h"
+
+namespace aa::client {
+
+/**
+ * @brief Settings of a directory batch run
+ */
+struct BatchOptions {
+  std::filesystem::path input_dir;   ///< Directory of images to process
+  std::filesystem::path output_dir;  ///< Directory receiving the results
+  int jobs{4};                       ///< Images decoded and in flight at once
+  std::size_t chunk_size{0};  ///< Chunked upload above this size (0 = never)
+  std::chrono::milliseconds progress_interval{5000};  ///< Progress log period
+
+  /**
+   * @brief Build batch settings from command line options
+   *
+   * Reads input_dir, output_dir, jobs and chunk_size.
+   *
+   * @param options Parsed command line options
+   * @return BatchOptions Batch settings
+   */
+  static BatchOptions FromOptions(const aa::shared::Options& options);
+};
+
+/**
+ * @brief Totals of a finished batch run
+ */
+struct BatchStats {
+  uint64_t images{0};         ///< Images found in the input directory
+  uint64_t processed{0};      ///< Images processed and written
+  uint64_t failed{0};         ///< Images unreadable, rejected or unwritten
+  uint64_t bytes_read{0};     ///< Input file bytes read
+  uint64_t bytes_written{0};  ///< Result file bytes written
+  double seconds{0.0};        ///< Wall time of the run
+  double p50_ms{0.0};         ///< Median request latency
+  double p99_ms{0.0};         ///< 99th percentile request latency
+
+  /**
+   * @brief Processed images per second of wall time
+   */
+  double ImagesPerSecond() const;
+
+  /**
+   * @brief One-line human-readable summary for logs
+   */
+  std::string ToString() const;
+};
+
+/**
+ * @brief Process every image of a directory through the detector server
+ *
+ * Files are read ahead on an AsyncFileIo, using io_uring where available,
+ * and decoded by a pool of jobs threads; each thread keeps one request in
+ * flight. Every image is sent with one inclusion zone covering the whole
+ * frame. Annotated results are written asynchronously to the output
+ * directory under the input file name plus the result extension, such as
+ * x.jpg.png: compressed result frames are written as received, raw ones are
+ * encoded as PNG on the client.
+ *
+ * Usage:
+ * @code
+ * BatchRunner runner(client, BatchOptions::FromOptions(options), request);
+ * BatchStats stats;
+ * if (!runner.Run(&stats)) return 1;
+ * @endcode
+ */
+class BatchRunner {
+ public:
+  /**
+   * @brief Construct a batch run
+   *
+   * @param client Connected detector client, shared by all jobs
+   * @param options Batch settings
+   * @param request Request template: detection budget and result options
+   */
+  BatchRunner(DetectorClient& client, BatchOptions options,
+              aa::proto::ProcessFrameRequest request);
+
+  /**
+   * @brief Run the batch to completion
+   *
+   * @param stats Receives the totals of the run (optional)
+   * @return true if every image was processed and written
+   */
+  bool Run(BatchStats* stats = nullptr);
+
+  /**
+   * @brief Image files of a directory, sorted by name
+   *
+   * Matches jpg, jpeg, png, bmp, webp, tif and tiff, case-insensitively;
+   * subdirectories are not searched.
+   */
+  static std::vector<std::filesystem::path> ListImages(
+      const std::filesystem::path& directory);
+
+ private:
+  DetectorClient& client_;
+  BatchOptions options_;
+  aa::proto::ProcessFrameRequest request_;
+};
+
+}  // namespace aa::client
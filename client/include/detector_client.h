@@ -1,7 +1,11 @@
 #pragma once
+#include <algorithm>
+#include <string>
+
 #include <grpcpp/grpcpp.h>
 
 #include "detector_service.grpc.pb.h"
+#include "frame_wire.h"
 #include "options.h"
 #include "rpc_client.h"
 
@@ -56,10 +60,12 @@ class DetectorClient final : public RpcClient<aa::proto::DetectorService> {
   /**
    * @brief Construct a new Detector Client object from options
    *
-   * @param options Configuration options containing server address
+   * @param options Configuration options containing server address and
+   * transport profile
    */
   explicit DetectorClient(aa::shared::Options options)
-      : RpcClient{options.Get<std::string>("address")},
+      : RpcClient{options.Get<std::string>("address"),
+                  aa::shared::TransportProfile::FromOptions(options)},
         options_{std::move(options)} {}
 
   /**
@@ -80,6 +86,21 @@ class DetectorClient final : public RpcClient<aa::proto::DetectorService> {
                      response);
   }
 
+  /**
+   * @brief Ask the server for the input of its model
+   *
+   * @param request Model info request (empty)
+   * @param response Input size, padding mode, pad value and channel order
+   * @return grpc::Status Result of the gRPC call
+   *
+   * @grpc Calls DetectorService::GetModelInfo
+   */
+  grpc::Status GetModelInfo(const aa::proto::GetModelInfoRequest& request,
+                            aa::proto::GetModelInfoResponse* response) {
+    return DoRequest(&aa::proto::DetectorService::Stub::GetModelInfo,
+                     request, response);
+  }
+
   /**
    * @brief Process a video frame for object detection
    *
@@ -100,6 +121,154 @@ class DetectorClient final : public RpcClient<aa::proto::DetectorService> {
                      response);
   }
 
+  /**
+   * @brief Process a burst of frames in one call
+   *
+   * The server runs the frames as one inference batch and returns their
+   * results in request order. Frames without polygons use the shared
+   * polygons of the request.
+   *
+   * @param request Frames and their shared zones
+   * @param response Per-frame results
+   * @return grpc::Status Result of the gRPC call
+   *
+   * @grpc Calls DetectorService::ProcessFrames
+   */
+  grpc::Status ProcessFrames(const aa::proto::ProcessFramesRequest& request,
+                             aa::proto::ProcessFramesResponse* response) {
+    return DoRequest(&aa::proto::DetectorService::Stub::ProcessFrames,
+                     request, response);
+  }
+
+  /**
+   * @brief Process a video frame, keeping the result frame in place
+   *
+   * Same call as ProcessFrame(), but the response is parsed into a view
+   * whose result frame references the received bytes instead of being
+   * copied into a protobuf message.
+   *
+   * @param request Frame processing request containing image data and polygons
+   * @param response View of the response; result().data() stays empty, the
+   * frame is available through Payload() and ToMat()
+   * @return grpc::Status Result of the gRPC call (INTERNAL if the response
+   * cannot be parsed)
+   *
+   * @grpc Calls DetectorService::ProcessFrame
+   */
+  grpc::Status ProcessFrameRaw(const aa::proto::ProcessFrameRequest& request,
+                               aa::shared::FrameResponseView* response) {
+    grpc::ByteBuffer buffer;
+    auto status = DoRawRequest("ProcessFrame", request, &buffer);
+    if (status.ok() && !response->Parse(buffer)) {
+      return grpc::Status(grpc::StatusCode::INTERNAL,
+                          "Malformed ProcessFrameResponse");
+    }
+    return status;
+  }
+
+  /**
+   * @brief Process a large frame uploaded in chunks
+   *
+   * Same call as ProcessFrame(), for frames whose payload would exceed the
+   * server's message size limit. The request is sent with the first chunk
+   * and the payload in pieces of chunk_size bytes.
+   *
+   * @param request Frame processing request; its frame data is moved out
+   * @param response Frame processing response with detection results
+   * @param chunk_size Payload bytes per chunk
+   * @return grpc::Status Result of the gRPC call
+   *
+   * @grpc Calls DetectorService::ProcessFrameChunked
+   */
+  grpc::Status ProcessFrameChunked(aa::proto::ProcessFrameRequest request,
+                                   aa::proto::ProcessFrameResponse* response,
+                                   std::size_t chunk_size) {
+    std::string payload = std::move(*request.mutable_frame()->mutable_data());
+    request.mutable_frame()->clear_data();
+    chunk_size = std::max<std::size_t>(chunk_size, 1);
+
+    grpc::ClientContext ctx;
+    SetRequestDeadline(&ctx);
+    auto writer = CreateWriter<aa::proto::FrameChunk>(
+        &aa::proto::DetectorService::Stub::ProcessFrameChunked, &ctx,
+        response);
+
+    aa::proto::FrameChunk chunk;
+    *chunk.mutable_request() = std::move(request);
+    chunk.set_total_size(payload.size());
+
+    std::size_t offset = 0;
+    do {
+      std::size_t size = std::min(chunk_size, payload.size() - offset);
+      chunk.set_data(payload.data() + offset, size);
+      offset += size;
+      if (!writer->Write(chunk)) break;
+      chunk.clear_request();
+      chunk.clear_total_size();
+    } while (offset < payload.size());
+
+    writer->WritesDone();
+    return writer->Finish();
+  }
+
+  /**
+   * @brief Open a streaming frame processing session
+   *
+   * Each request written to the stream yields one response. Requests may
+   * carry a FrameDelta instead of a full frame and may omit polygons to
+   * keep the previous ones.
+   *
+   * @param context Client context owning the session
+   * @return Stream for writing requests and reading responses
+   *
+   * @grpc Calls DetectorService::ProcessFrameStream
+   */
+  std::unique_ptr<grpc::ClientReaderWriter<aa::proto::ProcessFrameRequest,
+                                           aa::proto::ProcessFrameResponse>>
+  ProcessFrameStream(grpc::ClientContext* context) {
+    return CreateReaderWriter<aa::proto::ProcessFrameRequest,
+                              aa::proto::ProcessFrameResponse>(
+        &aa::proto::DetectorService::Stub::ProcessFrameStream, context);
+  }
+
+  /**
+   * @brief Have the server process a video source it opens itself
+   *
+   * The server decodes the source and streams back only the detections of
+   * each processed frame, so no frames cross the network.
+   *
+   * @param context Client context owning the session
+   * @param request Source uri, zones and detection budget
+   * @return Stream of per-frame detections
+   *
+   * @grpc Calls DetectorService::StartSource
+   */
+  std::unique_ptr<grpc::ClientReader<aa::proto::SourceDetections>>
+  StartSource(grpc::ClientContext* context,
+              const aa::proto::StartSourceRequest& request) {
+    return CreateReader<aa::proto::SourceDetections>(
+        &aa::proto::DetectorService::Stub::StartSource, context, request);
+  }
+
+  /**
+   * @brief Watch zone occupancy of a video source the server opens itself
+   *
+   * Like StartSource, but the server only sends debounced changes of the
+   * per-zone, per-class object counts.
+   *
+   * @param context Client context owning the session
+   * @param request Source request and debounce setting
+   * @return Stream of zone events, one message per changed frame
+   *
+   * @grpc Calls DetectorService::WatchZones
+   */
+  std::unique_ptr<grpc::ClientReader<aa::proto::ZoneEvents>> WatchZones(
+      grpc::ClientContext* context,
+      const aa::proto::WatchZonesRequest& request) {
+    return CreateReader<aa::proto::ZoneEvents>(
+        &aa::proto::DetectorService::Stub::WatchZones, context, request);
+  }
+
  private:
   aa::shared::Options options_;
 };
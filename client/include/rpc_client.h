@@ -1,8 +1,15 @@
 #pragma once
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
 #include <string_view>
 
+#include <grpcpp/generic/generic_stub.h>
 #include <grpcpp/grpcpp.h>
 
+#include "transport_profile.h"
+
 namespace aa::client {
 
 /**
@@ -43,9 +50,26 @@ class RpcClient {
    * @grpc Creates insecure gRPC channel for communication
    */
   explicit RpcClient(std::string_view remote, std::size_t timeout = 10000)
-      : channel_{CreateChannel(remote.data(),
-                               grpc::InsecureChannelCredentials())},
-        service_stub_{std::make_unique<typename Impl::Stub>(channel_)} {
+      : RpcClient{remote, aa::shared::TransportProfile{}, timeout} {}
+
+  /**
+   * @brief Construct a new RPC Client with a transport profile
+   *
+   * @param remote Server address in format "host:port"
+   * @param transport Window, message size, keepalive and compression
+   * settings of the channel
+   * @param timeout Request timeout in milliseconds (default: 10000ms)
+   *
+   * @grpc Creates insecure gRPC channel for communication
+   */
+  RpcClient(std::string_view remote,
+            const aa::shared::TransportProfile& transport,
+            std::size_t timeout = 10000)
+      : channel_{grpc::CreateCustomChannel(remote.data(),
+                                           grpc::InsecureChannelCredentials(),
+                                           MakeChannelArguments(transport))},
+        service_stub_{std::make_unique<typename Impl::Stub>(channel_)},
+        generic_stub_{channel_} {
     timeout > 0 ? timeout_ = timeout : timeout_ = 100;
   }
 
@@ -85,6 +109,71 @@ class RpcClient {
                        res);
   }
 
+  /**
+   * @brief Execute a unary request returning the serialized response
+   *
+   * Calls the method through a generic stub so the response bytes are left
+   * as received, e.g. to be parsed without copying large payloads or to be
+   * forwarded as is.
+   *
+   * @tparam Req Request message type
+   * @param method Method name of the service (e.g. "ProcessFrame")
+   * @param req Request message
+   * @param res Serialized response
+   * @return grpc::Status Result of the gRPC call
+   */
+  template <typename Req>
+  grpc::Status DoRawRequest(std::string_view method, const Req& req,
+                            grpc::ByteBuffer* res) {
+    std::promise<grpc::Status> done;
+    DoRawRequestAsync(method, req, res, [&done](grpc::Status result) {
+      done.set_value(std::move(result));
+    });
+    return done.get_future().get();
+  }
+
+  /**
+   * @brief Start a unary request returning the serialized response
+   *
+   * Asynchronous form of DoRawRequest(): returns once the call is started
+   * and reports its status through done, on a gRPC callback thread.
+   *
+   * @tparam Req Request message type
+   * @param method Method name of the service (e.g. "ProcessFrame")
+   * @param req Request message, serialized before the call returns
+   * @param res Serialized response, valid until done is called
+   * @param done Called once with the result of the gRPC call
+   */
+  template <typename Req>
+  void DoRawRequestAsync(std::string_view method, const Req& req,
+                         grpc::ByteBuffer* res,
+                         std::function<void(grpc::Status)> done) {
+    // Context and request buffer live until gRPC completes the call
+    struct Call {
+      grpc::ClientContext ctx;
+      grpc::ByteBuffer request;
+    };
+    auto call = std::make_shared<Call>();
+    bool own_buffer = false;
+    auto status = grpc::SerializationTraits<Req>::Serialize(
+        req, &call->request, &own_buffer);
+    if (!status.ok()) {
+      done(std::move(status));
+      return;
+    }
+
+    SetRequestDeadline(&call->ctx);
+
+    std::string path = "/";
+    path.append(Impl::service_full_name()).append("/").append(method);
+
+    generic_stub_.UnaryCall(
+        &call->ctx, path, grpc::StubOptions{}, &call->request, res,
+        [call, done = std::move(done)](grpc::Status result) {
+          done(std::move(result));
+        });
+  }
+
   /**
    * @brief Create a gRPC client writer for streaming requests
    *
@@ -103,11 +192,43 @@ class RpcClient {
     return std::invoke(std::forward<Func>(func), *service_stub_, ctx, res);
   }
 
- private:
-  std::shared_ptr<grpc::Channel> channel_;  ///< gRPC communication channel
-  std::unique_ptr<typename Impl::Stub>
-      service_stub_;     ///< Service-specific gRPC stub
-  std::size_t timeout_;  ///< Request timeout in milliseconds
+  /**
+   * @brief Create a gRPC client reader for server streaming
+   *
+   * The stream has no deadline; it lives until the server finishes it or
+   * the caller cancels the context.
+   *
+   * @tparam Res Response message type
+   * @tparam Func gRPC streaming method function type
+   * @tparam Req Request message type
+   * @param func gRPC streaming method to invoke
+   * @param ctx Client context for the stream
+   * @param req Request message
+   * @return std::unique_ptr<grpc::ClientReader<Res>> Reader for responses
+   */
+  template <typename Res, typename Func, typename Req>
+  std::unique_ptr<grpc::ClientReader<Res>> CreateReader(
+      Func&& func, grpc::ClientContext* ctx, const Req& req) {
+    return std::invoke(std::forward<Func>(func), *service_stub_, ctx, req);
+  }
+
+  /**
+   * @brief Create a gRPC client reader-writer for bidirectional streaming
+   *
+   * The stream has no deadline; it lives until the caller finishes it.
+   *
+   * @tparam Req Request message type
+   * @tparam Res Response message type
+   * @tparam Func gRPC streaming method function type
+   * @param func gRPC streaming method to invoke
+   * @param ctx Client context for the stream
+   * @return std::unique_ptr<grpc::ClientReaderWriter<Req, Res>> Stream
+   */
+  template <typename Req, typename Res, typename Func>
+  std::unique_ptr<grpc::ClientReaderWriter<Req, Res>> CreateReaderWriter(
+      Func&& func, grpc::ClientContext* ctx) {
+    return std::invoke(std::forward<Func>(func), *service_stub_, ctx);
+  }
 
   /**
    * @brief Set request deadline based on configured timeout
@@ -122,6 +243,28 @@ class RpcClient {
     auto deadline = system_clock::now() + milliseconds{timeout_};
     ctx->set_deadline(deadline);
   }
+
+ private:
+  std::shared_ptr<grpc::Channel> channel_;  ///< gRPC communication channel
+  std::unique_ptr<typename Impl::Stub>
+      service_stub_;     ///< Service-specific gRPC stub
+  grpc::GenericStub generic_stub_;  ///< Stub for raw ByteBuffer calls
+  std::size_t timeout_;  ///< Request timeout in milliseconds
+
+  /**
+   * @brief Channel arguments of a client
+   *
+   * Responses are not limited in size unless the profile sets a limit:
+   * result frames of large inputs exceed gRPC's 4 MB receive default.
+   * Large requests are uploaded in chunks instead.
+   */
+  static grpc::ChannelArguments MakeChannelArguments(
+      const aa::shared::TransportProfile& transport) {
+    grpc::ChannelArguments args;
+    args.SetMaxReceiveMessageSize(-1);
+    transport.ApplyTo(args);
+    return args;
+  }
 };
 
 }  // namespace aa::client
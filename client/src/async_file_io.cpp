@@ -0,0 +1,261 @@
+#include "async_file_io.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#ifdef AA_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include "logging.h"
+
+namespace {
+
+// Largest transfer of a single read or write call
+constexpr std::size_t kMaxTransfer = std::size_t{1} << 30;
+
+/**
+ * @brief Open the file of an operation; reads are sized to the file
+ */
+int OpenFile(const std::filesystem::path& path, bool write,
+             std::vector<uint8_t>& data) {
+  if (write) {
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+  }
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st {};
+  if (fd >= 0 && ::fstat(fd, &st) == 0) {
+    data.resize(static_cast<std::size_t>(st.st_size));
+  }
+  return fd;
+}
+
+}  // namespace
+
+namespace aa::client {
+
+#ifdef AA_HAVE_LIBURING
+struct AsyncFileIo::Ring {
+  io_uring ring;
+  unsigned in_flight{0};
+};
+#endif
+
+AsyncFileIo::AsyncFileIo(unsigned queue_depth)
+    : queue_depth_{std::max(1u, queue_depth)} {
+#ifdef AA_HAVE_LIBURING
+  ring_ = new Ring;
+  if (int error = io_uring_queue_init(queue_depth_, &ring_->ring, 0);
+      error < 0) {
+    // Containers and hardened kernels may forbid io_uring
+    AA_LOG_WARNING("io_uring unavailable (" << -error
+                                            << "), using blocking file I/O");
+    delete ring_;
+    ring_ = nullptr;
+  }
+#endif
+  thread_ = std::thread([this] { Run(); });
+}
+
+AsyncFileIo::~AsyncFileIo() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  queued_.notify_all();
+  thread_.join();
+
+#ifdef AA_HAVE_LIBURING
+  if (ring_ != nullptr) {
+    io_uring_queue_exit(&ring_->ring);
+    delete ring_;
+  }
+#endif
+}
+
+std::future<std::optional<AsyncFileIo::Bytes>> AsyncFileIo::Read(
+    std::filesystem::path path) {
+  auto operation = std::make_unique<Operation>();
+  operation->path = std::move(path);
+  auto result = operation->read_done.get_future();
+  Enqueue(std::move(operation));
+  return result;
+}
+
+void AsyncFileIo::Write(std::filesystem::path path, Bytes data) {
+  auto operation = std::make_unique<Operation>();
+  operation->write = true;
+  operation->path = std::move(path);
+  operation->data = std::move(data);
+  Enqueue(std::move(operation));
+}
+
+std::size_t AsyncFileIo::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  flushed_.wait(lock, [this] { return pending_writes_ == 0; });
+  return std::exchange(failed_writes_, 0);
+}
+
+void AsyncFileIo::Enqueue(std::unique_ptr<Operation> operation) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (operation->write) ++pending_writes_;
+    queue_.push_back(std::move(operation));
+  }
+  queued_.notify_one();
+}
+
+bool AsyncFileIo::RunBlocking(Operation& operation) {
+  operation.fd = OpenFile(operation.path, operation.write, operation.data);
+  if (operation.fd < 0) return false;
+
+  while (operation.done < operation.data.size()) {
+    auto size = std::min(operation.data.size() - operation.done, kMaxTransfer);
+    auto* bytes = operation.data.data() + operation.done;
+    ssize_t result = operation.write ? ::write(operation.fd, bytes, size)
+                                     : ::read(operation.fd, bytes, size);
+    if (result < 0 && errno == EINTR) continue;
+    if (result < 0) return false;
+    // End of a file that shrank since it was opened
+    if (result == 0) return !operation.write;
+    operation.done += static_cast<std::size_t>(result);
+  }
+  return true;
+}
+
+void AsyncFileIo::Complete(std::unique_ptr<Operation> operation, bool ok) {
+  if (operation->fd >= 0 && ::close(operation->fd) != 0) {
+    ok = ok && !operation->write;
+  }
+
+  if (!operation->write) {
+    if (ok) {
+      // A file that shrank since it was opened ends early
+      operation->data.resize(operation->done);
+      operation->read_done.set_value(std::move(operation->data));
+    } else {
+      AA_LOG_ERROR("Cannot read " << operation->path);
+      operation->read_done.set_value(std::nullopt);
+    }
+    return;
+  }
+
+  if (!ok) {
+    AA_LOG_ERROR("Cannot write " << operation->path);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --pending_writes_;
+    if (!ok) ++failed_writes_;
+  }
+  flushed_.notify_all();
+}
+
+void AsyncFileIo::Run() {
+#ifdef AA_HAVE_LIBURING
+  if (ring_ != nullptr) {
+    auto submit = [this](Operation* operation) {
+      auto size =
+          std::min(operation->data.size() - operation->done, kMaxTransfer);
+      auto* bytes = operation->data.data() + operation->done;
+      auto* sqe = io_uring_get_sqe(&ring_->ring);
+      if (operation->write) {
+        io_uring_prep_write(sqe, operation->fd, bytes,
+                            static_cast<unsigned>(size), operation->done);
+      } else {
+        io_uring_prep_read(sqe, operation->fd, bytes,
+                           static_cast<unsigned>(size), operation->done);
+      }
+      io_uring_sqe_set_data(sqe, operation);
+    };
+
+    while (true) {
+      std::deque<std::unique_ptr<Operation>> batch;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (ring_->in_flight == 0) {
+          queued_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+          if (queue_.empty()) break;
+        }
+        while (!queue_.empty() &&
+               ring_->in_flight + batch.size() < queue_depth_) {
+          batch.push_back(std::move(queue_.front()));
+          queue_.pop_front();
+        }
+      }
+
+      // Files are opened here; the transfers run on the ring
+      for (auto& operation : batch) {
+        operation->fd =
+            OpenFile(operation->path, operation->write, operation->data);
+        if (operation->fd < 0) {
+          Complete(std::move(operation), false);
+        } else if (operation->data.empty()) {
+          Complete(std::move(operation), true);
+        } else {
+          submit(operation.release());
+          ++ring_->in_flight;
+        }
+      }
+      io_uring_submit(&ring_->ring);
+
+      // Wake up regularly to pick up newly queued operations
+      __kernel_timespec timeout{0, 1000000};
+      io_uring_cqe* cqe = nullptr;
+      if (io_uring_wait_cqe_timeout(&ring_->ring, &cqe, &timeout) != 0) {
+        continue;
+      }
+
+      unsigned head = 0;
+      unsigned seen = 0;
+      bool resubmit = false;
+      io_uring_for_each_cqe(&ring_->ring, head, cqe) {
+        ++seen;
+        std::unique_ptr<Operation> operation{
+            static_cast<Operation*>(io_uring_cqe_get_data(cqe))};
+        if (cqe->res > 0) {
+          operation->done += static_cast<std::size_t>(cqe->res);
+        }
+
+        if (cqe->res > 0 && operation->done < operation->data.size()) {
+          // Short transfer: queue the remainder in the same slot
+          submit(operation.release());
+          resubmit = true;
+          continue;
+        }
+
+        --ring_->in_flight;
+        bool ok = cqe->res >= 0 && (!operation->write ||
+                                    operation->done == operation->data.size());
+        Complete(std::move(operation), ok);
+      }
+      io_uring_cq_advance(&ring_->ring, seen);
+      if (resubmit) io_uring_submit(&ring_->ring);
+    }
+    return;
+  }
+#endif
+
+  while (true) {
+    std::unique_ptr<Operation> operation;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queued_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) break;
+      operation = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    bool ok = RunBlocking(*operation);
+    Complete(std::move(operation), ok);
+  }
+}
+
+}  // namespace aa::client
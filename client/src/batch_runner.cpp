@@ -0,0 +1,290 @@
+#include "batch_runner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <future>
+#include <iomanip>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "async_file_io.h"
+#include "frame.h"
+#include "logging.h"
+#include "polygon.h"
+
+namespace {
+
+// File reads issued ahead of each job
+constexpr std::size_t kReadsAheadPerJob = 2;
+
+bool IsImageFile(const std::filesystem::path& path) {
+  auto extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension == ".jpg" || extension == ".jpeg" || extension == ".png" ||
+         extension == ".bmp" || extension == ".webp" || extension == ".tif" ||
+         extension == ".tiff";
+}
+
+/**
+ * @brief File extension of a compressed result frame
+ */
+std::string ResultExtension(aa::proto::FrameEncoding encoding) {
+  switch (encoding) {
+    case aa::proto::FRAME_ENCODING_JPEG:
+      return ".jpg";
+    case aa::proto::FRAME_ENCODING_WEBP:
+      return ".webp";
+    default:
+      return ".png";
+  }
+}
+
+/**
+ * @brief Replace the zones of a request with one covering the whole image
+ */
+void SetFullFrameZone(const cv::Size& size,
+                      aa::proto::ProcessFrameRequest& request) {
+  auto width = static_cast<double>(size.width);
+  auto height = static_cast<double>(size.height);
+  aa::shared::Polygon zone({{0.0, 0.0}, {width, 0.0}, {width, height},
+                            {0.0, height}},
+                           aa::shared::PolygonType::INCLUSION, 0, {});
+  request.clear_polygons();
+  *request.add_polygons() = zone.ToProto();
+}
+
+double Percentile(std::vector<double>& values, double fraction) {
+  if (values.empty()) return 0.0;
+  auto index = static_cast<std::size_t>(fraction * (values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+}  // namespace
+
+namespace aa::client {
+
+BatchOptions BatchOptions::FromOptions(const aa::shared::Options& options) {
+  BatchOptions batch_options;
+  batch_options.input_dir = options.Get<std::string>("input_dir");
+  batch_options.output_dir = options.Get<std::string>("output_dir");
+  batch_options.jobs = std::max(1, options.Get<int>("jobs"));
+  batch_options.chunk_size =
+      static_cast<std::size_t>(options.Get<uint64_t>("chunk_size"));
+  return batch_options;
+}
+
+double BatchStats::ImagesPerSecond() const {
+  return seconds > 0.0 ? static_cast<double>(processed) / seconds : 0.0;
+}
+
+std::string BatchStats::ToString() const {
+  std::ostringstream out;
+  out << processed << "/" << images << " images in " << std::fixed
+      << std::setprecision(2) << seconds << "s (" << std::setprecision(1)
+      << ImagesPerSecond() << " images/s), " << failed << " failed, read "
+      << std::setprecision(1) << bytes_read / 1e6 << " MB, wrote "
+      << bytes_written / 1e6 << " MB, latency p50 " << p50_ms << "ms, p99 "
+      << p99_ms << "ms";
+  return out.str();
+}
+
+BatchRunner::BatchRunner(DetectorClient& client, BatchOptions options,
+                         aa::proto::ProcessFrameRequest request)
+    : client_{client},
+      options_{std::move(options)},
+      request_{std::move(request)} {}
+
+std::vector<std::filesystem::path> BatchRunner::ListImages(
+    const std::filesystem::path& directory) {
+  std::vector<std::filesystem::path> images;
+  std::error_code error;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(directory, error)) {
+    if (entry.is_regular_file() && IsImageFile(entry.path())) {
+      images.push_back(entry.path());
+    }
+  }
+  std::sort(images.begin(), images.end());
+  return images;
+}
+
+bool BatchRunner::Run(BatchStats* stats) {
+  const auto start = std::chrono::steady_clock::now();
+
+  const auto images = ListImages(options_.input_dir);
+  if (images.empty()) {
+    AA_LOG_ERROR("No images found in " << options_.input_dir);
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(options_.output_dir, error);
+  if (error) {
+    AA_LOG_ERROR("Cannot create " << options_.output_dir << ": "
+                                  << error.message());
+    return false;
+  }
+
+  const auto jobs = static_cast<std::size_t>(options_.jobs);
+  AsyncFileIo io(static_cast<unsigned>(jobs * kReadsAheadPerJob * 2));
+  AA_LOG_INFO("Processing " << images.size() << " images from "
+                            << options_.input_dir << " with " << jobs
+                            << " jobs"
+                            << (io.UsesIoUring() ? " (io_uring)" : ""));
+
+  // Reads are issued in file order, a window ahead of the jobs
+  std::vector<std::future<std::optional<AsyncFileIo::Bytes>>> reads(
+      images.size());
+  std::size_t issued = 0;
+  std::mutex reads_mutex;
+  const std::size_t read_ahead = jobs * kReadsAheadPerJob;
+
+  std::atomic<std::size_t> next{0};
+  std::atomic<uint64_t> processed{0};
+  std::atomic<uint64_t> failed{0};
+  std::atomic<uint64_t> bytes_read{0};
+  std::atomic<uint64_t> bytes_written{0};
+  std::vector<std::vector<double>> latencies(jobs);
+  std::mutex progress_mutex;
+  auto last_progress = start;
+
+  auto work = [&](std::size_t job) {
+    aa::proto::ProcessFrameRequest request = request_;
+    aa::proto::ProcessFrameResponse response;
+    aa::shared::FrameResponseView view;
+
+    for (std::size_t i = next.fetch_add(1); i < images.size();
+         i = next.fetch_add(1)) {
+      {
+        std::lock_guard<std::mutex> lock(reads_mutex);
+        for (; issued < std::min(images.size(), i + 1 + read_ahead);
+             ++issued) {
+          reads[issued] = io.Read(images[issued]);
+        }
+      }
+
+      auto contents = reads[i].get();
+      cv::Mat image;
+      if (contents) {
+        bytes_read += contents->size();
+        image = cv::imdecode(
+            cv::Mat(1, static_cast<int>(contents->size()), CV_8UC1,
+                    contents->data()),
+            cv::IMREAD_COLOR);
+      }
+      if (image.empty()) {
+        AA_LOG_WARNING("Cannot decode " << images[i]);
+        ++failed;
+        continue;
+      }
+
+      SetFullFrameZone(image.size(), request);
+      *request.mutable_frame() = aa::shared::Frame(image).ToProto();
+
+      // Large images go up in chunks, like in single-image mode
+      auto sent = std::chrono::steady_clock::now();
+      grpc::Status status;
+      bool chunked = options_.chunk_size > 0 &&
+                     request.frame().data().size() > options_.chunk_size;
+      if (chunked) {
+        status = client_.ProcessFrameChunked(request, &response,
+                                             options_.chunk_size);
+      } else {
+        status = client_.ProcessFrameRaw(request, &view);
+      }
+      latencies[job].push_back(std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - sent)
+                                   .count());
+
+      const auto& result = chunked ? response : view.Response();
+      if (!status.ok() || !result.success()) {
+        AA_LOG_WARNING("Processing " << images[i] << " failed: "
+                                     << (status.ok() ? "rejected by server"
+                                                     : status.error_message()));
+        ++failed;
+        continue;
+      }
+
+      // Compressed results are written as received
+      auto encoding = result.result().encoding();
+      AsyncFileIo::Bytes output;
+      if (encoding != aa::proto::FRAME_ENCODING_RAW) {
+        std::string_view payload =
+            chunked ? std::string_view{response.result().data()}
+                    : view.Payload();
+        output.assign(payload.begin(), payload.end());
+      } else {
+        cv::Mat result_image =
+            chunked ? aa::shared::Frame::FromProto(response.result()).ToMat()
+                    : view.ToMat();
+        if (result_image.empty() ||
+            !cv::imencode(".png", result_image, output)) {
+          AA_LOG_WARNING("Cannot encode the result of " << images[i]);
+          ++failed;
+          continue;
+        }
+      }
+
+      bytes_written += output.size();
+      // The source extension stays, so x.jpg and x.png get separate results
+      io.Write(options_.output_dir /
+                   (images[i].filename().string() + ResultExtension(encoding)),
+               std::move(output));
+      ++processed;
+
+      auto now = std::chrono::steady_clock::now();
+      std::lock_guard<std::mutex> lock(progress_mutex);
+      if (now - last_progress >= options_.progress_interval) {
+        last_progress = now;
+        double seconds = std::chrono::duration<double>(now - start).count();
+        AA_LOG_INFO("Batch progress: " << processed.load() << "/"
+                                       << images.size() << " images, "
+                                       << std::fixed << std::setprecision(1)
+                                       << processed.load() / seconds
+                                       << " images/s");
+      }
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(jobs);
+    for (std::size_t job = 0; job < jobs; ++job) {
+      workers.emplace_back(work, job);
+    }
+  }
+
+  // Every result file is on disk before the run counts as done
+  auto unwritten = io.Flush();
+
+  BatchStats totals;
+  totals.images = images.size();
+  totals.processed = processed.load() - unwritten;
+  totals.failed = failed.load() + unwritten;
+  totals.bytes_read = bytes_read.load();
+  totals.bytes_written = bytes_written.load();
+  totals.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::vector<double> all_latencies;
+  for (auto& job_latencies : latencies) {
+    all_latencies.insert(all_latencies.end(), job_latencies.begin(),
+                         job_latencies.end());
+  }
+  totals.p50_ms = Percentile(all_latencies, 0.50);
+  totals.p99_ms = Percentile(all_latencies, 0.99);
+  if (stats != nullptr) *stats = totals;
+
+  AA_LOG_INFO("Batch finished: " << totals.ToString());
+  return totals.failed == 0;
+}
+
+}  // namespace aa::client
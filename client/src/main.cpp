@@ -12,11 +12,18 @@
  * - Image loading and frame conversion
  * - Polygon zone generation for detection filtering
  * - Result visualization and output saving
+ * - Streaming sessions sending only changed tiles of video frames
+ * - Server-opened video sources streaming back detections only
+ * - Debounced zone occupancy events of server-opened sources
+ * - Directory batch mode with asynchronous file I/O
+ * - Client-side letterboxing to the model input of the server
  *
  * @author AA Video Processing Team
  * @version 1.2.0
  */
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <random>
 #include <set>
@@ -24,8 +31,11 @@
 
 #include <opencv2/opencv.hpp>
 
+#include "batch_runner.h"
 #include "detector_client.h"
 #include "frame.h"
+#include "frame_delta.h"
+#include "frame_transform.h"
 #include "logging.h"
 #include "options.h"
 #include "point.h"
@@ -34,6 +44,286 @@
 using namespace aa::client;
 using namespace aa::shared;
 
+namespace {
+
+/**
+ * @brief Set the detection budget and result options of a request
+ *
+ * @param options Parsed command line options
+ * @param request Request to update
+ */
+void ApplyRequestOptions(const Options& options,
+                         aa::proto::ProcessFrameRequest& request) {
+  // Optional detection budget: the server drops everything else during
+  // decode, which keeps per-frame cost low on crowded scenes
+  if (options.Has("classes")) {
+    // Validated with the other options, so every entry parses
+    std::vector<int32_t> classes;
+    ParseClassList(options.Get<std::string>("classes"), classes);
+    for (auto class_id : classes) {
+      request.add_class_whitelist(class_id);
+    }
+  }
+  if (options.Has("min_conf")) {
+    request.set_min_confidence(options.Get<float>("min_conf"));
+  }
+  if (options.Has("max_results")) {
+    request.set_max_detections(options.Get<uint32_t>("max_results"));
+  }
+
+  // Smaller, compressed result frames for display
+  auto* result_options = request.mutable_result_options();
+  if (options.Has("result_width")) {
+    result_options->set_max_width(options.Get<uint32_t>("result_width"));
+  }
+  if (options.Has("result_height")) {
+    result_options->set_max_height(options.Get<uint32_t>("result_height"));
+  }
+  if (options.Has("result_codec")) {
+    aa::proto::FrameEncoding encoding = aa::proto::FRAME_ENCODING_RAW;
+    std::string codec = options.Get<std::string>("result_codec");
+    std::transform(codec.begin(), codec.end(), codec.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+    aa::proto::FrameEncoding_Parse("FRAME_ENCODING_" + codec, &encoding);
+    result_options->set_encoding(encoding);
+  }
+  if (options.Has("result_quality")) {
+    result_options->set_quality(options.Get<uint32_t>("result_quality"));
+  }
+}
+
+/**
+ * @brief Shrink a frame to the server's model input before sending it
+ *
+ * Asks the server for its model input and shrinks the frame the way the
+ * server would, so the pixels it would discard are never sent. The
+ * transform is attached to the request; zones stay in input image
+ * coordinates. Falls back to the full frame when the server cannot
+ * describe its model.
+ *
+ * @param client Connected detector client
+ * @param mode "letterbox" pads to the input size, "resize" only scales
+ * @param image Input image
+ * @param request Request receiving the transform
+ * @return cv::Mat Frame to send
+ */
+cv::Mat FitToModel(DetectorClient& client, const std::string& mode,
+                   const cv::Mat& image,
+                   aa::proto::ProcessFrameRequest& request) {
+  aa::proto::GetModelInfoResponse info;
+  grpc::Status status = client.GetModelInfo({}, &info);
+  if (!status.ok()) {
+    AA_LOG_WARNING("Model info unavailable (" << status.error_message()
+                                              << "), sending the full frame");
+    return image;
+  }
+  if (info.padding_mode() != aa::proto::PADDING_MODE_LETTERBOX) {
+    AA_LOG_WARNING(
+        "Server model does not letterbox its input, sending the full frame");
+    return image;
+  }
+
+  cv::Size input(static_cast<int>(info.input_width()),
+                 static_cast<int>(info.input_height()));
+  auto transform =
+      FrameTransform::Fit(image.size(), input, mode == "letterbox");
+  if (transform.IsIdentity()) {
+    return image;
+  }
+
+  cv::Mat sent = transform.Apply(image, info.pad_value());
+  *request.mutable_transform() = transform.ToProto();
+  AA_LOG_INFO("Resized frame " << image.cols << "x" << image.rows << " to "
+                               << sent.cols << "x" << sent.rows << " for a "
+                               << input.width << "x" << input.height
+                               << " model input");
+  return sent;
+}
+
+/**
+ * @brief Send a video as one streaming session of frame deltas
+ *
+ * Only tiles that changed since the previous frame are sent, and zones are
+ * sent with the first frame only. The last processed frame is saved to the
+ * output path.
+ *
+ * @param client Connected detector client
+ * @param options Parsed command line options
+ * @param request Request template with polygons and detection budget
+ * @param capture Opened video source
+ * @param frame First frame already read from the source
+ * @return int Process exit code
+ */
+int RunStream(DetectorClient& client, const Options& options,
+              aa::proto::ProcessFrameRequest request,
+              cv::VideoCapture& capture, cv::Mat frame) {
+  grpc::ClientContext context;
+  auto stream = client.ProcessFrameStream(&context);
+
+  FrameDeltaEncoder encoder(options.Get<int>("tile_size"),
+                            options.Get<double>("delta_threshold"));
+  aa::proto::ProcessFrameResponse response;
+  cv::Mat result_image;
+  std::size_t frames = 0;
+  std::size_t sent_bytes = 0;
+  std::size_t raw_bytes = 0;
+
+  do {
+    *request.mutable_delta() = encoder.Encode(frame);
+    sent_bytes += request.delta().tiles().size();
+    raw_bytes += frame.total() * frame.elemSize();
+
+    if (!stream->Write(request) || !stream->Read(&response)) {
+      break;
+    }
+    request.clear_polygons();
+    ++frames;
+
+    if (response.success()) {
+      result_image = aa::shared::Frame::FromProto(response.result()).ToMat();
+    } else if (response.keyframe_required()) {
+      // The server dropped its session frame, start a new delta chain
+      AA_LOG_WARNING("Frame " << frames << " rejected, sending a keyframe");
+      encoder.Reset();
+    } else {
+      AA_LOG_WARNING("Frame " << frames << " failed on the server");
+    }
+  } while (capture.read(frame));
+
+  stream->WritesDone();
+  grpc::Status status = stream->Finish();
+
+  if (!status.ok()) {
+    AA_LOG_ERROR("Frame stream failed: " << status.error_message());
+    return 1;
+  }
+
+  AA_LOG_INFO("Streamed " << frames << " frames, sent " << sent_bytes
+                          << " of " << raw_bytes << " pixel bytes");
+
+  if (!result_image.empty()) {
+    auto output_path = options.Get<std::string>("output");
+    cv::imwrite(output_path, result_image);
+    AA_LOG_INFO("Last processed frame saved to: " << output_path);
+  }
+  return 0;
+}
+
+/**
+ * @brief Build a source request for the input from the frame request
+ *
+ * @param options Parsed command line options
+ * @param frame_request Request template with polygons and detection budget
+ * @return aa::proto::StartSourceRequest Request for --input
+ */
+aa::proto::StartSourceRequest MakeSourceRequest(
+    const Options& options,
+    const aa::proto::ProcessFrameRequest& frame_request) {
+  aa::proto::StartSourceRequest request;
+  request.set_uri(options.Get<std::string>("input"));
+  *request.mutable_polygons() = frame_request.polygons();
+  *request.mutable_class_whitelist() = frame_request.class_whitelist();
+  if (frame_request.has_max_detections()) {
+    request.set_max_detections(frame_request.max_detections());
+  }
+  if (frame_request.has_min_confidence()) {
+    request.set_min_confidence(frame_request.min_confidence());
+  }
+  request.set_lossless(options.Get<bool>("lossless"));
+  return request;
+}
+
+/**
+ * @brief Have the server open the input as a video source
+ *
+ * The server decodes and processes the source itself and streams back the
+ * detections of each frame; frames never cross the network.
+ *
+ * @param client Connected detector client
+ * @param options Parsed command line options
+ * @param frame_request Request template with polygons and detection budget
+ * @return int Process exit code
+ */
+int RunSource(DetectorClient& client, const Options& options,
+              const aa::proto::ProcessFrameRequest& frame_request) {
+  auto request = MakeSourceRequest(options, frame_request);
+
+  grpc::ClientContext context;
+  auto reader = client.StartSource(&context, request);
+
+  aa::proto::SourceDetections detections;
+  std::size_t frames = 0;
+  std::size_t dropped = 0;
+  std::size_t objects = 0;
+
+  while (reader->Read(&detections)) {
+    ++frames;
+    dropped += detections.dropped_frames();
+    objects += detections.detections_size();
+    AA_LOG_DEBUG("Frame " << detections.frame_index() << " at "
+                          << detections.timestamp_ms() << "ms: "
+                          << detections.detections_size() << " detections");
+  }
+
+  grpc::Status status = reader->Finish();
+  if (!status.ok()) {
+    AA_LOG_ERROR("Video source failed: " << status.error_message());
+    return 1;
+  }
+
+  AA_LOG_INFO("Source processed " << frames << " frames, dropped " << dropped
+                                  << ", found " << objects << " detections");
+  return 0;
+}
+
+/**
+ * @brief Watch zone occupancy of the input opened by the server
+ *
+ * The server streams only debounced changes of the per-zone object counts,
+ * which are logged as they arrive.
+ *
+ * @param client Connected detector client
+ * @param options Parsed command line options
+ * @param frame_request Request template with polygons and detection budget
+ * @return int Process exit code
+ */
+int RunWatch(DetectorClient& client, const Options& options,
+             const aa::proto::ProcessFrameRequest& frame_request) {
+  aa::proto::WatchZonesRequest request;
+  *request.mutable_source() = MakeSourceRequest(options, frame_request);
+  request.set_debounce_frames(options.Get<uint32_t>("debounce"));
+
+  grpc::ClientContext context;
+  auto reader = client.WatchZones(&context, request);
+
+  aa::proto::ZoneEvents events;
+  std::size_t count = 0;
+
+  while (reader->Read(&events)) {
+    for (const auto& event : events.events()) {
+      ++count;
+      AA_LOG_INFO("Frame " << event.frame_index() << " at "
+                           << event.timestamp_ms() << "ms: "
+                           << aa::proto::ZoneEventType_Name(event.type())
+                           << " zone " << event.zone() << " class "
+                           << event.class_id() << " count "
+                           << event.previous_count() << " -> "
+                           << event.count());
+    }
+  }
+
+  grpc::Status status = reader->Finish();
+  if (!status.ok()) {
+    AA_LOG_ERROR("Zone watch failed: " << status.error_message());
+    return 1;
+  }
+
+  AA_LOG_INFO("Zone watch ended after " << count << " events");
+  return 0;
+}
+
+}  // namespace
+
 int main(int argc, char* argv[]) {
   // Parse command line arguments
   Options options(argc, argv, "Detector Client");
@@ -61,12 +351,41 @@ int main(int argc, char* argv[]) {
     AA_LOG_INFO("Health check passed");
   }
 
+  // Every image of a directory, with one full-frame zone each
+  if (options.Has("input_dir")) {
+    aa::proto::ProcessFrameRequest batch_request;
+    ApplyRequestOptions(options, batch_request);
+    if (!options.Has("result_codec")) {
+      batch_request.mutable_result_options()->set_encoding(
+          aa::proto::FRAME_ENCODING_JPEG);
+    }
+    BatchRunner runner(client, BatchOptions::FromOptions(options),
+                       std::move(batch_request));
+    return runner.Run() ? 0 : 1;
+  }
+
   aa::proto::ProcessFrameRequest frame_request;
-  aa::proto::ProcessFrameResponse frame_response;
+  aa::shared::FrameResponseView frame_response;
 
-  // Load image using OpenCV
+  // Load image (or the first video frame in stream mode) using OpenCV
   std::string input_path = options.Get<std::string>("input");
-  cv::Mat input_image = cv::imread(input_path);
+  bool stream_mode = options.Get<bool>("stream");
+  bool source_mode = options.Get<bool>("source");
+  cv::VideoCapture capture;
+  cv::Mat input_image;
+
+  if (stream_mode || source_mode) {
+    capture.open(input_path);
+    capture.read(input_image);
+  } else {
+    input_image = cv::imread(input_path);
+  }
+
+  // A source may be reachable from the server only; size zones by options
+  if (source_mode && input_image.empty()) {
+    input_image = cv::Mat(options.Get<int>("height"), options.Get<int>("width"),
+                          CV_8UC3, cv::Scalar::all(0));
+  }
 
   if (input_image.empty()) {
     AA_LOG_ERROR("Failed to load image from: " << input_path);
@@ -76,9 +395,15 @@ int main(int argc, char* argv[]) {
   AA_LOG_INFO("Loaded image: " << input_path << " (" << input_image.rows << "x"
                                << input_image.cols << ")");
 
-  // Create Frame from cv::Mat and set in request
-  aa::shared::Frame frame(input_image);
-  *frame_request.mutable_frame() = frame.ToProto();
+  // Create Frame from cv::Mat and set in request (streams send deltas)
+  if (!stream_mode && !source_mode) {
+    cv::Mat sent_image = input_image;
+    if (auto mode = options.Get<std::string>("preprocess"); mode != "none") {
+      sent_image = FitToModel(client, mode, input_image, frame_request);
+    }
+    aa::shared::Frame frame(sent_image);
+    *frame_request.mutable_frame() = frame.ToProto();
+  }
 
   // Use all COCO classes (0-79)
   std::vector<int32_t> class_options;
@@ -150,15 +475,67 @@ int main(int argc, char* argv[]) {
                 << ", classes=" << class_options.size());
   }
 
-  status = client.ProcessFrame(frame_request, &frame_response);
+  ApplyRequestOptions(options, frame_request);
+
+  // Frames of one stream are pinned to one backend behind a dispatcher
+  if (options.Has("stream_id")) {
+    frame_request.set_stream_id(options.Get<std::string>("stream_id"));
+  }
+
+  if (source_mode && options.Get<bool>("events")) {
+    return RunWatch(client, options, frame_request);
+  }
+
+  if (source_mode) {
+    return RunSource(client, options, frame_request);
+  }
+
+  if (stream_mode) {
+    return RunStream(client, options, std::move(frame_request), capture,
+                     input_image);
+  }
+
+  // Frames beyond the message size limit are uploaded in pieces
+  auto chunk_size =
+      static_cast<std::size_t>(options.Get<uint64_t>("chunk_size"));
+  bool chunked =
+      chunk_size > 0 && frame_request.frame().data().size() > chunk_size;
+  aa::proto::ProcessFrameResponse chunked_response;
+
+  if (chunked) {
+    status = client.ProcessFrameChunked(std::move(frame_request),
+                                        &chunked_response, chunk_size);
+  } else {
+    status = client.ProcessFrameRaw(frame_request, &frame_response);
+  }
 
   if (!status.ok()) {
     AA_LOG_ERROR("Process frame failed: " << status.error_message());
     return 1;
   }
 
+  const auto& load = chunked ? chunked_response.load()
+                             : frame_response.Response().load();
+  AA_LOG_DEBUG("Server load: queue " << load.queue_depth() << ", in flight "
+                                     << load.in_flight() << ", service "
+                                     << load.ewma_service_ms() << "ms");
+
+  // Sent frames were resized, so the server also reports input coordinates
+  const auto& detections = chunked ? chunked_response.detections()
+                                   : frame_response.Response().detections();
+  for (const auto& detection : detections) {
+    AA_LOG_INFO("Detected class " << detection.class_id() << " ("
+                                  << detection.confidence() << ") at "
+                                  << detection.x() << "," << detection.y()
+                                  << " " << detection.width() << "x"
+                                  << detection.height());
+  }
+
+  // Raw results are wrapped in place; frame_response outlives result_image
   auto result_image =
-      aa::shared::Frame::FromProto(frame_response.result()).ToMat();
+      chunked
+          ? aa::shared::Frame::FromProto(chunked_response.result()).ToMat()
+          : frame_response.ToMat();
   auto output_path = options.Get<std::string>("output");
 
   if (!result_image.empty()) {
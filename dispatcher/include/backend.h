@@ -0,0 +1,244 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include <grpcpp/grpcpp.h>
+
+#include "detector_service.grpc.pb.h"
+#include "rpc_client.h"
+#include "transport_profile.h"
+
+namespace aa::dispatcher {
+
+/**
+ * @brief Connection to one detector_server backend
+ *
+ * Wraps a gRPC channel to the backend together with the dispatcher-side
+ * state used for routing: the health flag and the load report maintained
+ * by the health poller, a bounded count of requests in flight and a
+ * bounded queue of requests waiting for a slot. A forwarded call holds a
+ * slot until it completes; when all slots are taken, requests wait in the
+ * queue in arrival order, and requests beyond the queue are rejected
+ * instead of piling up behind a slow node.
+ *
+ * @grpc Client of aa::proto::DetectorService
+ * @threadsafe All methods are safe to call concurrently
+ */
+class Backend final : public aa::client::RpcClient<aa::proto::DetectorService> {
+ public:
+  /**
+   * @brief Construct a backend connection
+   *
+   * @param address Backend address in "host:port" format
+   * @param max_inflight Maximum concurrent forwarded requests (at least 1)
+   * @param max_queued Maximum requests waiting for a slot (at least 0)
+   * @param timeout Per-request timeout in milliseconds
+   * @param transport Transport profile of the backend channel
+   */
+  Backend(std::string address, int max_inflight, int max_queued,
+          std::size_t timeout,
+          const aa::shared::TransportProfile& transport = {});
+
+  /**
+   * @brief Backend address
+   */
+  const std::string& Address() const { return address_; }
+
+  /**
+   * @brief Whether the backend passed its last health check
+   */
+  bool IsHealthy() const { return healthy_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Update the health flag
+   *
+   * @param healthy New health state
+   * @return true if the state changed
+   */
+  bool SetHealthy(bool healthy);
+
+  /**
+   * @brief Reserve a slot for a forwarded request without queueing
+   *
+   * @return false if the backend already has max_inflight requests
+   */
+  bool TryAcquire();
+
+  /**
+   * @brief Run a forwarded request once it holds a slot
+   *
+   * start runs right away if a slot is free. Otherwise it is queued and
+   * runs on the thread whose Release() hands the slot over, so it must not
+   * block. The slot is released with Release() when the request completes.
+   *
+   * @param start Starts the request; left untouched when false is returned
+   * @return false if all slots are taken and the queue is full
+   */
+  bool Submit(std::function<void()>&& start);
+
+  /**
+   * @brief Wait in the queue for a slot
+   *
+   * For handlers that forward on their own thread.
+   *
+   * @return false if all slots are taken and the queue is full
+   */
+  bool Acquire();
+
+  /**
+   * @brief Release a slot, handing it to the oldest queued request
+   */
+  void Release();
+
+  /**
+   * @brief Number of requests currently forwarded to the backend
+   */
+  int InFlight() const { return inflight_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Number of requests waiting for a slot
+   */
+  int Queued() const { return queued_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Whether all slots are taken and the queue is full
+   */
+  bool IsFull() const {
+    return InFlight() >= max_inflight_ && Queued() >= max_queued_;
+  }
+
+  /**
+   * @brief Estimated milliseconds until a new request would complete
+   *
+   * Requests ahead of a new one (the larger of the dispatcher's own count,
+   * in flight and queued, and the backend's last reported in-flight count)
+   * times the backend's smoothed service time. Until the backend has
+   * reported a service time, every request counts as 1 ms.
+   */
+  double LoadScore() const;
+
+  /**
+   * @brief Probe the backend and update the health flag and load report
+   *
+   * A channel in TRANSIENT_FAILURE is reported unhealthy without an RPC.
+   *
+   * @return true if the health state changed
+   */
+  bool Probe();
+
+  /**
+   * @brief Forward a frame processing request, keeping the response as is
+   *
+   * The serialized response is passed back to the caller without being
+   * parsed, so the result frame is never copied by the dispatcher.
+   *
+   * @param request Frame processing request
+   * @param response Serialized ProcessFrameResponse
+   * @return grpc::Status Result of the backend call
+   *
+   * @grpc Calls DetectorService::ProcessFrame
+   */
+  grpc::Status ProcessFrameRaw(const aa::proto::ProcessFrameRequest& request,
+                               grpc::ByteBuffer* response) {
+    return DoRawRequest("ProcessFrame", request, response);
+  }
+
+  /**
+   * @brief Forward a frame processing request without waiting for it
+   *
+   * @param request Frame processing request, serialized before returning
+   * @param response Serialized ProcessFrameResponse, valid until done runs
+   * @param done Called once with the result, on a gRPC callback thread
+   *
+   * @grpc Calls DetectorService::ProcessFrame
+   */
+  void ProcessFrameRawAsync(const aa::proto::ProcessFrameRequest& request,
+                            grpc::ByteBuffer* response,
+                            std::function<void(grpc::Status)> done) {
+    DoRawRequestAsync("ProcessFrame", request, response, std::move(done));
+  }
+
+  /**
+   * @brief Forward a burst of frames
+   *
+   * @param request Frames to process as one batch
+   * @param response Per-frame results
+   * @return grpc::Status Result of the backend call
+   *
+   * @grpc Calls DetectorService::ProcessFrames
+   */
+  grpc::Status ProcessFrames(const aa::proto::ProcessFramesRequest& request,
+                             aa::proto::ProcessFramesResponse* response) {
+    return DoRequest(&aa::proto::DetectorService::Stub::ProcessFrames,
+                     request, response);
+  }
+
+  /**
+   * @brief Ask the backend for the input of its model
+   *
+   * @param request Model info request (empty)
+   * @param response Model input description
+   * @return grpc::Status Result of the backend call
+   *
+   * @grpc Calls DetectorService::GetModelInfo
+   */
+  grpc::Status GetModelInfo(const aa::proto::GetModelInfoRequest& request,
+                            aa::proto::GetModelInfoResponse* response) {
+    return DoRequest(&aa::proto::DetectorService::Stub::GetModelInfo,
+                     request, response);
+  }
+
+  /**
+   * @brief Open a streaming session on the backend
+   *
+   * @param context Client context owning the session
+   * @return Stream for forwarding requests and reading responses
+   *
+   * @grpc Calls DetectorService::ProcessFrameStream
+   */
+  std::unique_ptr<grpc::ClientReaderWriter<aa::proto::ProcessFrameRequest,
+                                           aa::proto::ProcessFrameResponse>>
+  OpenFrameStream(grpc::ClientContext* context) {
+    return CreateReaderWriter<aa::proto::ProcessFrameRequest,
+                              aa::proto::ProcessFrameResponse>(
+        &aa::proto::DetectorService::Stub::ProcessFrameStream, context);
+  }
+
+  /**
+   * @brief Open a chunked frame upload on the backend
+   *
+   * @param context Client context owning the upload
+   * @param response Receives the backend response after Finish()
+   * @return Stream for forwarding frame chunks
+   *
+   * @grpc Calls DetectorService::ProcessFrameChunked
+   */
+  std::unique_ptr<grpc::ClientWriter<aa::proto::FrameChunk>>
+  OpenChunkedUpload(grpc::ClientContext* context,
+                    aa::proto::ProcessFrameResponse* response) {
+    return CreateWriter<aa::proto::FrameChunk>(
+        &aa::proto::DetectorService::Stub::ProcessFrameChunked, context,
+        response);
+  }
+
+ private:
+  std::string address_;
+  int max_inflight_;
+  int max_queued_;
+
+  // Counts change under the mutex and are read without it
+  std::mutex mutex_;
+  std::deque<std::function<void()>> queue_;
+  std::atomic<int> inflight_{0};
+  std::atomic<int> queued_{0};
+  std::atomic<bool> healthy_{true};
+  std::atomic<uint32_t> reported_in_flight_{0};
+  std::atomic<float> reported_service_ms_{0.0f};
+};
+
+}  // namespace aa::dispatcher
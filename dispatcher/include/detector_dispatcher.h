@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "backend.h"
+#include "detector_service.h"
+#include "hash_ring.h"
+#include "options.h"
+
+/**
+ * @brief Dispatcher tier for the AA Video Processing System
+ *
+ * Contains the stream-sharding front end that exposes DetectorService and
+ * forwards requests to a fleet of detector_server backends, keeping every
+ * stream on one backend so per-stream state stays on a single node.
+ */
+namespace aa::dispatcher {
+
+/**
+ * @brief DetectorService front end sharding streams across backends
+ *
+ * Serves the same DetectorService as detector_server. ProcessFrame requests
+ * are routed by their stream_id on a consistent hash ring, so all frames of
+ * a stream reach the same backend; requests without a stream_id go to the
+ * healthy backend with the lowest estimated completion time, from its load
+ * reports and the dispatcher's own in-flight counts.
+ *
+ * A background thread probes every backend with CheckHealth. Streams of an
+ * unhealthy backend move to the next backend on the ring and move back once
+ * it recovers; other streams are not reshuffled. Each backend has a bounded
+ * number of requests in flight and a bounded queue of requests waiting for
+ * a slot, so short bursts stay on the stream's backend. A backend whose
+ * slots and queue are both full is skipped like an unhealthy one until it
+ * drains. Requests fail with RESOURCE_EXHAUSTED when every healthy backend
+ * is full. A streaming session holds one slot of its backend for its whole
+ * lifetime, since frame deltas cannot be dropped or moved.
+ *
+ * StartSource and WatchZones are not forwarded: a source is opened by the
+ * server that can reach it, so clients call that server directly.
+ *
+ * Usage:
+ * @code
+ * DetectorDispatcher dispatcher(options);
+ * dispatcher.Initialize();
+ * dispatcher.Start();  // Blocks until Shutdown()
+ * @endcode
+ */
+class DetectorDispatcher {
+ public:
+  /**
+   * @brief Construct a dispatcher from options
+   *
+   * @param options Configuration with address, backends, max_inflight,
+   * max_queued, health_interval and timeout
+   */
+  explicit DetectorDispatcher(aa::shared::Options options);
+
+  /**
+   * @brief Stop the health poller
+   */
+  ~DetectorDispatcher();
+
+  // Disable copy and move: handlers and the poller capture this
+  DetectorDispatcher(const DetectorDispatcher&) = delete;
+  DetectorDispatcher& operator=(const DetectorDispatcher&) = delete;
+
+  /**
+   * @brief Register the service handlers
+   */
+  void Initialize();
+
+  /**
+   * @brief Probe backends, start the health poller and serve requests
+   *
+   * Blocks until Shutdown() is called.
+   */
+  void Start();
+
+  /**
+   * @brief Stop serving and stop the health poller
+   */
+  void Shutdown();
+
+  /**
+   * @brief Backend a request with the given stream id would be routed to
+   *
+   * Unhealthy and full backends are skipped.
+   *
+   * @param stream_id Routing key (empty = least loaded backend)
+   * @return Backend index, or std::nullopt if no backend is available
+   */
+  std::optional<std::size_t> SelectBackend(std::string_view stream_id) const;
+
+  /**
+   * @brief Backend at an index returned by SelectBackend()
+   */
+  Backend& GetBackend(std::size_t index) { return *backends_[index]; }
+
+ private:
+  aa::shared::Options options_;
+  std::unique_ptr<aa::server::DetectorServiceImpl> service_;
+  std::vector<std::unique_ptr<Backend>> backends_;
+  HashRing ring_;
+
+  std::chrono::milliseconds health_interval_;
+  std::thread health_thread_;
+  std::atomic<bool> stopping_{false};
+  std::mutex health_mutex_;
+  std::condition_variable health_cv_;
+
+  /**
+   * @brief Probe every backend once and log state changes
+   */
+  void PollHealth();
+
+  /**
+   * @brief Status of a request SelectBackend() found no backend for
+   *
+   * RESOURCE_EXHAUSTED if some backend is healthy but all healthy ones are
+   * full, UNAVAILABLE otherwise.
+   */
+  grpc::Status NoBackendStatus() const;
+
+  /**
+   * @brief Report healthy if at least one backend is healthy
+   *
+   * The load report sums the dispatcher's in-flight requests over all
+   * backends.
+   */
+  grpc::Status CheckHealth(const aa::proto::CheckHealthRequest* request,
+                           aa::proto::CheckHealthResponse* response) const;
+
+  /**
+   * @brief Forward a model info request to the least loaded backend
+   *
+   * All backends are expected to serve the same model.
+   */
+  grpc::Status GetModelInfo(const aa::proto::GetModelInfoRequest* request,
+                            aa::proto::GetModelInfoResponse* response) const;
+
+  /**
+   * @brief Forward a frame to the backend owning its stream
+   *
+   * The backend's serialized response is relayed without parsing. The
+   * backend call is asynchronous: no thread waits for it, and done runs
+   * from its completion callback.
+   */
+  void ProcessFrame(const aa::proto::ProcessFrameRequest* request,
+                    grpc::ByteBuffer* response,
+                    std::function<void(grpc::Status)> done) const;
+
+  /**
+   * @brief Forward a burst of frames to the backend owning its stream
+   *
+   * The whole burst goes to one backend, so its frames share a batch.
+   */
+  grpc::Status ProcessFrames(const aa::proto::ProcessFramesRequest* request,
+                             aa::proto::ProcessFramesResponse* response) const;
+
+  /**
+   * @brief Proxy a streaming session to the backend owning its stream
+   *
+   * The backend is chosen from the stream_id of the first request.
+   */
+  grpc::Status ProcessFrameStream(
+      grpc::ServerReaderWriter<aa::proto::ProcessFrameResponse,
+                               aa::proto::ProcessFrameRequest>* stream) const;
+
+  /**
+   * @brief Relay a chunked frame upload to the backend owning its stream
+   *
+   * The backend is chosen from the stream_id of the request in the first
+   * chunk; chunks are forwarded one by one as they arrive.
+   */
+  grpc::Status ProcessFrameChunked(
+      grpc::ServerReader<aa::proto::FrameChunk>* reader,
+      aa::proto::ProcessFrameResponse* response) const;
+};
+
+}  // namespace aa::dispatcher
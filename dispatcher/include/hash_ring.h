@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aa::dispatcher {
+
+/**
+ * @brief Consistent hash ring mapping stream ids to backends
+ *
+ * Each backend is placed on a 64-bit ring at several virtual points derived
+ * from its address, and a key maps to the first point at or after its own
+ * hash. Adding or removing a backend only moves the keys of that backend,
+ * and the mapping does not depend on the order in which backends are given,
+ * so every dispatcher instance routes a stream to the same node.
+ *
+ * Lookup() accepts a predicate to skip backends (e.g. unhealthy ones): keys
+ * of a skipped backend fall through to the next backend on the ring and
+ * return once it is accepted again, while all other keys stay in place.
+ *
+ * Usage:
+ * @code
+ * HashRing ring({"10.0.0.1:50051", "10.0.0.2:50051"});
+ * auto backend = ring.Lookup("camera-7", [&](std::size_t index) {
+ *   return backends[index].IsHealthy();
+ * });
+ * @endcode
+ *
+ * @threadsafe Immutable after construction, safe for concurrent lookups
+ */
+class HashRing {
+ public:
+  /// @brief Default number of virtual points per backend
+  static constexpr int kDefaultVirtualNodes = 160;
+
+  /**
+   * @brief Build a ring over the given backends
+   *
+   * @param nodes Backend identifiers (addresses), indexed by Lookup() results
+   * @param virtual_nodes Ring points per backend (at least 1)
+   */
+  explicit HashRing(const std::vector<std::string>& nodes,
+                    int virtual_nodes = kDefaultVirtualNodes);
+
+  /**
+   * @brief Find the backend owning a key
+   *
+   * @param key Routing key, e.g. a stream id
+   * @param accept Predicate on backend index; rejected backends are skipped
+   * @return Backend index, or std::nullopt if no backend is accepted
+   */
+  template <typename Accept>
+  std::optional<std::size_t> Lookup(std::string_view key,
+                                    Accept&& accept) const {
+    if (points_.empty()) return std::nullopt;
+
+    uint64_t hash = Hash(key);
+    auto it = std::lower_bound(
+        points_.begin(), points_.end(), hash,
+        [](const Point& point, uint64_t value) { return point.hash < value; });
+
+    // Each backend is tried at most once per full turn of the ring
+    std::vector<bool> rejected(num_nodes_, false);
+    std::size_t remaining = num_nodes_;
+    for (std::size_t step = 0; step < points_.size() && remaining > 0;
+         ++step, ++it) {
+      if (it == points_.end()) it = points_.begin();
+      if (rejected[it->node]) continue;
+      if (accept(it->node)) return it->node;
+      rejected[it->node] = true;
+      --remaining;
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Find the backend owning a key, ignoring health
+   *
+   * @param key Routing key
+   * @return Backend index, or std::nullopt if the ring is empty
+   */
+  std::optional<std::size_t> Lookup(std::string_view key) const {
+    return Lookup(key, [](std::size_t) { return true; });
+  }
+
+  /**
+   * @brief Number of backends on the ring
+   */
+  std::size_t Size() const { return num_nodes_; }
+
+  /**
+   * @brief Stable 64-bit hash used for ring placement and keys
+   *
+   * FNV-1a followed by a 64-bit mixer, so short and similar keys such as
+   * "camera-1" and "camera-2" still spread over the whole ring.
+   */
+  static uint64_t Hash(std::string_view key);
+
+ private:
+  struct Point {
+    uint64_t hash;
+    std::size_t node;
+  };
+
+  std::vector<Point> points_;  ///< Sorted by hash
+  std::size_t num_nodes_{0};
+};
+
+}  // namespace aa::dispatcher
@@ -0,0 +1,103 @@
+#include "backend.h"
+
+#include <algorithm>
+#include <future>
+#include <memory>
+
+namespace aa::dispatcher {
+
+Backend::Backend(std::string address, int max_inflight, int max_queued,
+                 std::size_t timeout,
+                 const aa::shared::TransportProfile& transport)
+    : RpcClient{address, transport, timeout},
+      address_{std::move(address)},
+      max_inflight_{std::max(1, max_inflight)},
+      max_queued_{std::max(0, max_queued)} {}
+
+bool Backend::SetHealthy(bool healthy) {
+  return healthy_.exchange(healthy, std::memory_order_acq_rel) != healthy;
+}
+
+bool Backend::TryAcquire() {
+  // Requests are only queued while every slot is taken, so a free slot
+  // never jumps the queue
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (inflight_.load(std::memory_order_relaxed) >= max_inflight_) {
+    return false;
+  }
+  inflight_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool Backend::Submit(std::function<void()>&& start) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (inflight_.load(std::memory_order_relaxed) < max_inflight_) {
+      inflight_.fetch_add(1, std::memory_order_relaxed);
+    } else if (static_cast<int>(queue_.size()) < max_queued_) {
+      queue_.push_back(std::move(start));
+      queued_.store(static_cast<int>(queue_.size()),
+                    std::memory_order_relaxed);
+      return true;
+    } else {
+      return false;
+    }
+  }
+  start();
+  return true;
+}
+
+bool Backend::Acquire() {
+  // Shared, since the releasing thread may still be inside set_value()
+  // when the waiter returns
+  auto ready = std::make_shared<std::promise<void>>();
+  auto started = ready->get_future();
+  if (!Submit([ready] { ready->set_value(); })) return false;
+  started.wait();
+  return true;
+}
+
+void Backend::Release() {
+  std::function<void()> next;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) {
+      inflight_.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+    next = std::move(queue_.front());
+    queue_.pop_front();
+    queued_.store(static_cast<int>(queue_.size()), std::memory_order_relaxed);
+  }
+  // The slot passes to the queued request without being freed
+  next();
+}
+
+double Backend::LoadScore() const {
+  auto ahead = std::max<uint32_t>(
+      static_cast<uint32_t>(InFlight() + Queued()),
+      reported_in_flight_.load(std::memory_order_relaxed));
+  float service_ms = reported_service_ms_.load(std::memory_order_relaxed);
+  return (static_cast<double>(ahead) + 1.0) *
+         (service_ms > 0.0f ? service_ms : 1.0);
+}
+
+bool Backend::Probe() {
+  if (Channel()->GetState(true) == GRPC_CHANNEL_TRANSIENT_FAILURE) {
+    return SetHealthy(false);
+  }
+
+  aa::proto::CheckHealthRequest request;
+  aa::proto::CheckHealthResponse response;
+  auto status = DoRequest(&aa::proto::DetectorService::Stub::CheckHealth,
+                          request, &response);
+  if (status.ok() && response.has_load()) {
+    reported_in_flight_.store(response.load().in_flight(),
+                              std::memory_order_relaxed);
+    reported_service_ms_.store(response.load().ewma_service_ms(),
+                               std::memory_order_relaxed);
+  }
+  return SetHealthy(status.ok());
+}
+
+}  // namespace aa::dispatcher
@@ -0,0 +1,360 @@
+#include "detector_dispatcher.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include "logging.h"
+
+namespace {
+
+/**
+ * @brief Split a comma-separated backend list, dropping empty entries
+ */
+std::vector<std::string> ParseBackends(const std::string& list) {
+  std::vector<std::string> backends;
+  std::stringstream stream{list};
+  std::string address;
+  while (std::getline(stream, address, ',')) {
+    address.erase(0, address.find_first_not_of(" \t"));
+    address.erase(address.find_last_not_of(" \t") + 1);
+    if (!address.empty()) {
+      backends.push_back(std::move(address));
+    }
+  }
+  return backends;
+}
+
+}  // namespace
+
+namespace aa::dispatcher {
+
+DetectorDispatcher::DetectorDispatcher(aa::shared::Options options)
+    : options_{std::move(options)},
+      ring_{ParseBackends(options_.Get<std::string>("backends"))},
+      health_interval_{options_.Get<int>("health_interval")} {
+  auto addresses = ParseBackends(options_.Get<std::string>("backends"));
+  auto max_inflight = options_.Get<int>("max_inflight");
+  auto max_queued = options_.Get<int>("max_queued");
+  auto timeout = static_cast<std::size_t>(options_.Get<int>("timeout"));
+  auto transport = aa::shared::TransportProfile::FromOptions(options_);
+
+  backends_.reserve(addresses.size());
+  for (auto& address : addresses) {
+    backends_.push_back(
+        std::make_unique<Backend>(std::move(address), max_inflight,
+                                  max_queued, timeout, transport));
+  }
+
+  service_ = std::make_unique<aa::server::DetectorServiceImpl>(
+      options_.Get<std::string>("address"), std::move(transport));
+}
+
+DetectorDispatcher::~DetectorDispatcher() {
+  stopping_.store(true);
+  health_cv_.notify_all();
+  if (health_thread_.joinable()) {
+    health_thread_.join();
+  }
+}
+
+void DetectorDispatcher::Initialize() {
+  using aa::server::DetectorServiceMethods;
+
+  service_->Register<DetectorServiceMethods::kCheckHealth>(
+      [this](auto request, auto response) {
+        return CheckHealth(request, response);
+      });
+  service_->Register<DetectorServiceMethods::kProcessFrame>(
+      [this](auto request, auto response, auto done) {
+        ProcessFrame(request, response, std::move(done));
+      });
+  service_->Register<DetectorServiceMethods::kProcessFrameStream>(
+      [this](auto stream) { return ProcessFrameStream(stream); });
+  service_->Register<DetectorServiceMethods::kProcessFrameChunked>(
+      [this](auto reader, auto response) {
+        return ProcessFrameChunked(reader, response);
+      });
+  service_->Register<DetectorServiceMethods::kGetModelInfo>(
+      [this](auto request, auto response) {
+        return GetModelInfo(request, response);
+      });
+  service_->Register<DetectorServiceMethods::kProcessFrames>(
+      [this](auto request, auto response) {
+        return ProcessFrames(request, response);
+      });
+}
+
+void DetectorDispatcher::Start() {
+  AA_LOG_INFO("Dispatching across " << backends_.size() << " backends");
+  PollHealth();
+
+  health_thread_ = std::thread([this] {
+    std::unique_lock<std::mutex> lock(health_mutex_);
+    while (!health_cv_.wait_for(lock, health_interval_,
+                                [this] { return stopping_.load(); })) {
+      lock.unlock();
+      PollHealth();
+      lock.lock();
+    }
+  });
+
+  service_->Build();
+  service_->Wait();
+}
+
+void DetectorDispatcher::Shutdown() {
+  stopping_.store(true);
+  health_cv_.notify_all();
+  service_->Stop();
+}
+
+std::optional<std::size_t> DetectorDispatcher::SelectBackend(
+    std::string_view stream_id) const {
+  auto available = [this](std::size_t index) {
+    return backends_[index]->IsHealthy() && !backends_[index]->IsFull();
+  };
+
+  if (!stream_id.empty()) {
+    return ring_.Lookup(stream_id, available);
+  }
+
+  // Stateless requests: backend expected to finish first
+  std::optional<std::size_t> best;
+  double best_score = 0.0;
+  for (std::size_t i = 0; i < backends_.size(); ++i) {
+    if (!available(i)) continue;
+    double score = backends_[i]->LoadScore();
+    if (!best || score < best_score) {
+      best = i;
+      best_score = score;
+    }
+  }
+  return best;
+}
+
+grpc::Status DetectorDispatcher::NoBackendStatus() const {
+  bool any_healthy = std::any_of(
+      backends_.begin(), backends_.end(),
+      [](const auto& backend) { return backend->IsHealthy(); });
+  if (any_healthy) {
+    return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                        "All detector backends are overloaded");
+  }
+  return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                      "No healthy detector backend");
+}
+
+void DetectorDispatcher::PollHealth() {
+  for (auto& backend : backends_) {
+    if (stopping_.load()) return;
+    if (backend->Probe()) {
+      if (backend->IsHealthy()) {
+        AA_LOG_INFO("Backend " << backend->Address()
+                               << " is healthy, its streams are restored");
+      } else {
+        AA_LOG_WARNING("Backend " << backend->Address()
+                                  << " is unhealthy, rerouting its streams");
+      }
+    }
+  }
+}
+
+grpc::Status DetectorDispatcher::CheckHealth(
+    const aa::proto::CheckHealthRequest*,
+    aa::proto::CheckHealthResponse* response) const {
+  auto healthy = std::count_if(
+      backends_.begin(), backends_.end(),
+      [](const auto& backend) { return backend->IsHealthy(); });
+
+  uint32_t in_flight = 0;
+  for (const auto& backend : backends_) {
+    in_flight += static_cast<uint32_t>(backend->InFlight());
+  }
+
+  response->set_healthy(healthy > 0);
+  response->mutable_load()->set_in_flight(in_flight);
+  response->set_status(std::to_string(healthy) + "/" +
+                       std::to_string(backends_.size()) +
+                       " backends healthy");
+  return grpc::Status::OK;
+}
+
+grpc::Status DetectorDispatcher::GetModelInfo(
+    const aa::proto::GetModelInfoRequest* request,
+    aa::proto::GetModelInfoResponse* response) const {
+  auto index = SelectBackend({});
+  if (!index) {
+    AA_LOG_ERROR("No available backend for a model info request");
+    return NoBackendStatus();
+  }
+  return backends_[*index]->GetModelInfo(*request, response);
+}
+
+void DetectorDispatcher::ProcessFrame(
+    const aa::proto::ProcessFrameRequest* request, grpc::ByteBuffer* response,
+    std::function<void(grpc::Status)> done) const {
+  auto index = SelectBackend(request->stream_id());
+  if (!index) {
+    AA_LOG_ERROR("No available backend for stream '" << request->stream_id()
+                                                     << "'");
+    done(NoBackendStatus());
+    return;
+  }
+
+  // Holds its own copy of done, since a queued forward outlives this call
+  // and a rejected one is never run
+  auto& backend = *backends_[*index];
+  std::function<void()> forward = [&backend, request, response, done] {
+    backend.ProcessFrameRawAsync(
+        *request, response,
+        [&backend, done](grpc::Status status) {
+          backend.Release();
+
+          // Reroute right away instead of waiting for the next health poll
+          if (status.error_code() == grpc::StatusCode::UNAVAILABLE &&
+              backend.SetHealthy(false)) {
+            AA_LOG_WARNING("Backend "
+                           << backend.Address()
+                           << " is unavailable, rerouting its streams");
+          }
+
+          done(std::move(status));
+        });
+  };
+  if (!backend.Submit(std::move(forward))) {
+    AA_LOG_WARNING("Backend " << backend.Address()
+                              << " queue is full, rejecting stream '"
+                              << request->stream_id() << "'");
+    done(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                      "Detector backend is overloaded"));
+  }
+}
+
+grpc::Status DetectorDispatcher::ProcessFrames(
+    const aa::proto::ProcessFramesRequest* request,
+    aa::proto::ProcessFramesResponse* response) const {
+  auto index = SelectBackend(request->stream_id());
+  if (!index) {
+    AA_LOG_ERROR("No available backend for stream '" << request->stream_id()
+                                                     << "'");
+    return NoBackendStatus();
+  }
+
+  auto& backend = *backends_[*index];
+  if (!backend.Acquire()) {
+    AA_LOG_WARNING("Backend " << backend.Address()
+                              << " queue is full, rejecting batch of stream '"
+                              << request->stream_id() << "'");
+    return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                        "Detector backend is overloaded");
+  }
+
+  auto status = backend.ProcessFrames(*request, response);
+  backend.Release();
+
+  if (status.error_code() == grpc::StatusCode::UNAVAILABLE &&
+      backend.SetHealthy(false)) {
+    AA_LOG_WARNING("Backend " << backend.Address()
+                              << " is unavailable, rerouting its streams");
+  }
+
+  return status;
+}
+
+grpc::Status DetectorDispatcher::ProcessFrameStream(
+    grpc::ServerReaderWriter<aa::proto::ProcessFrameResponse,
+                             aa::proto::ProcessFrameRequest>* stream) const {
+  aa::proto::ProcessFrameRequest request;
+  if (!stream->Read(&request)) {
+    return grpc::Status::OK;
+  }
+
+  auto index = SelectBackend(request.stream_id());
+  if (!index) {
+    AA_LOG_ERROR("No available backend for stream '" << request.stream_id()
+                                                     << "'");
+    return NoBackendStatus();
+  }
+
+  auto& backend = *backends_[*index];
+  if (!backend.Acquire()) {
+    AA_LOG_WARNING("Backend " << backend.Address()
+                              << " queue is full, rejecting session '"
+                              << request.stream_id() << "'");
+    return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                        "Detector backend is overloaded");
+  }
+
+  grpc::ClientContext context;
+  auto upstream = backend.OpenFrameStream(&context);
+  aa::proto::ProcessFrameResponse response;
+
+  // The backend answers every request, so the session is proxied in lockstep
+  do {
+    if (!upstream->Write(request) || !upstream->Read(&response) ||
+        !stream->Write(response)) {
+      break;
+    }
+  } while (stream->Read(&request));
+
+  upstream->WritesDone();
+  auto status = upstream->Finish();
+  backend.Release();
+
+  if (status.error_code() == grpc::StatusCode::UNAVAILABLE &&
+      backend.SetHealthy(false)) {
+    AA_LOG_WARNING("Backend " << backend.Address()
+                              << " is unavailable, rerouting its streams");
+  }
+
+  return status;
+}
+
+grpc::Status DetectorDispatcher::ProcessFrameChunked(
+    grpc::ServerReader<aa::proto::FrameChunk>* reader,
+    aa::proto::ProcessFrameResponse* response) const {
+  aa::proto::FrameChunk chunk;
+  if (!reader->Read(&chunk)) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "Chunked upload without chunks");
+  }
+
+  const auto& stream_id = chunk.request().stream_id();
+  auto index = SelectBackend(stream_id);
+  if (!index) {
+    AA_LOG_ERROR("No available backend for stream '" << stream_id << "'");
+    return NoBackendStatus();
+  }
+
+  auto& backend = *backends_[*index];
+  if (!backend.Acquire()) {
+    AA_LOG_WARNING("Backend " << backend.Address()
+                              << " queue is full, rejecting stream '"
+                              << stream_id << "'");
+    return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                        "Detector backend is overloaded");
+  }
+
+  grpc::ClientContext context;
+  auto upstream = backend.OpenChunkedUpload(&context, response);
+
+  // Only one chunk is held at a time, however large the frame
+  do {
+    if (!upstream->Write(chunk)) break;
+  } while (reader->Read(&chunk));
+
+  upstream->WritesDone();
+  auto status = upstream->Finish();
+  backend.Release();
+
+  if (status.error_code() == grpc::StatusCode::UNAVAILABLE &&
+      backend.SetHealthy(false)) {
+    AA_LOG_WARNING("Backend " << backend.Address()
+                              << " is unavailable, rerouting its streams");
+  }
+
+  return status;
+}
+
+}  // namespace aa::dispatcher
@@ -0,0 +1,41 @@
+#include "hash_ring.h"
+
+namespace aa::dispatcher {
+
+HashRing::HashRing(const std::vector<std::string>& nodes, int virtual_nodes)
+    : num_nodes_{nodes.size()} {
+  int replicas = std::max(1, virtual_nodes);
+  points_.reserve(nodes.size() * static_cast<std::size_t>(replicas));
+
+  for (std::size_t node = 0; node < nodes.size(); ++node) {
+    for (int replica = 0; replica < replicas; ++replica) {
+      points_.push_back(
+          {Hash(nodes[node] + "#" + std::to_string(replica)), node});
+    }
+  }
+
+  // Ties are broken by address so the ring is independent of input order
+  std::sort(points_.begin(), points_.end(),
+            [&nodes](const Point& a, const Point& b) {
+              if (a.hash != b.hash) return a.hash < b.hash;
+              return nodes[a.node] < nodes[b.node];
+            });
+}
+
+uint64_t HashRing::Hash(std::string_view key) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+
+  // splitmix64 finalizer
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebULL;
+  hash ^= hash >> 31;
+  return hash;
+}
+
+}  // namespace aa::dispatcher
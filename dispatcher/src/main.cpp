@@ -0,0 +1,71 @@
+/**
+ * @file main.cpp
+ * @brief Dispatcher application entry point for AA Video Processing System
+ *
+ * Runs the stream-sharding dispatcher in front of several detector servers.
+ * Clients talk to the dispatcher exactly as they would to a single server;
+ * frames are forwarded by stream id to the backend owning the stream.
+ *
+ * Features:
+ * - Command line argument parsing and validation
+ * - Consistent hashing of streams to backends
+ * - Health-driven rerouting and per-backend in-flight bounds
+ * - Signal handling for graceful shutdown
+ *
+ * @author AA Video Processing Team
+ * @version 1.2.0
+ */
+
+#include <signal.h>
+
+#include "detector_dispatcher.h"
+#include "logging.h"
+#include "options.h"
+#include "signal_set.h"
+
+using namespace aa::dispatcher;
+using namespace aa::shared;
+
+int main(int argc, char* argv[]) {
+  // Parse command line arguments
+  Options options(argc, argv, "Detector Dispatcher");
+
+  // Check if arguments are valid
+  if (!options.IsValid()) {
+    options.PrintHelp();
+    return 1;
+  }
+
+  Logging::Initialize(options.IsVerbose());
+
+  AA_LOG_INFO("Starting detector dispatcher...");
+
+  DetectorDispatcher dispatcher(options);
+
+  // Set up graceful shutdown signal handling
+  SignalSet signal_set;
+
+  signal_set.Add(SIGINT, [&](int sig) {
+    AA_LOG_INFO("Received SIGINT (" << sig
+                                    << "), requesting graceful shutdown...");
+    dispatcher.Shutdown();
+  });
+
+  signal_set.Add(SIGTERM, [&](int sig) {
+    AA_LOG_INFO("Received SIGTERM (" << sig
+                                     << "), requesting graceful shutdown...");
+    dispatcher.Shutdown();
+  });
+
+  dispatcher.Initialize();
+
+  try {
+    dispatcher.Start();  // This will block until shutdown
+  } catch (const std::exception& e) {
+    AA_LOG_ERROR("Dispatcher error: " << e.what());
+    return 1;
+  }
+
+  AA_LOG_INFO("Dispatcher shutdown completed gracefully.");
+  return 0;
+}
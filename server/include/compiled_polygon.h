@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "polygon.h"
+
+namespace aa::server {
+
+/**
+ * @brief Zone preprocessed for fast point-in-polygon queries
+ *
+ * Built once per zone set, then queried for every detection center.
+ * Compilation simplifies the outline with Douglas-Peucker, dropping
+ * vertices that deviate from it by at most the tolerance, and picks a test:
+ * - Convex zones: binary search of the fan around the first vertex,
+ *   O(log n) per query
+ * - Other zones: a table of horizontal slabs between consecutive vertex
+ *   heights listing the edges that span each slab; a query ray-casts only
+ *   against the edges of its slab
+ *
+ * Contains() keeps the semantics of aa::shared::Polygon::Contains on the
+ * simplified outline: points on a vertex or an edge are outside, interior
+ * points follow the ray casting crossing rule. Queries exactly at a vertex
+ * height fall back to the full ray cast.
+ *
+ * @threadsafe Contains() is const and safe to call concurrently
+ */
+class CompiledPolygon {
+ public:
+  CompiledPolygon() = default;
+
+  /**
+   * @brief Compile a zone
+   *
+   * @param polygon Zone to compile
+   * @param tolerance Largest distance in pixels of a dropped vertex from the
+   * simplified outline (0 = drop only duplicate and collinear vertices)
+   * @return CompiledPolygon Compiled zone; contains no point if the zone has
+   * fewer than 3 distinct vertices
+   */
+  static CompiledPolygon Compile(const aa::shared::Polygon& polygon,
+                                 double tolerance);
+
+  /**
+   * @brief Check whether a point lies strictly inside the zone
+   */
+  bool Contains(double x, double y) const;
+
+  /**
+   * @brief Whether the simplified outline is convex
+   */
+  bool IsConvex() const { return convex_; }
+
+  /**
+   * @brief Vertices of the simplified outline, positively oriented if convex
+   */
+  const std::vector<cv::Point2d>& GetVertices() const { return vertices_; }
+
+ private:
+  std::vector<cv::Point2d> vertices_;
+  bool convex_{false};
+  double min_x_{0.0};
+  double min_y_{0.0};
+  double max_x_{0.0};
+  double max_y_{0.0};
+
+  std::vector<double> slab_y_;    ///< Sorted distinct vertex heights
+  std::vector<int> slab_start_;   ///< Slab i edges: [start[i], start[i + 1])
+  std::vector<int> slab_edges_;   ///< Edge k joins vertices k and k + 1
+
+  void BuildSlabs();
+  bool ContainsConvex(double x, double y) const;
+  bool ContainsSlab(double x, double y) const;
+  bool ContainsScan(double x, double y) const;
+};
+
+}  // namespace aa::server
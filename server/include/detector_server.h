@@ -1,16 +1,27 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <opencv2/dnn.hpp>
 #include <opencv2/opencv.hpp>
 
 #include "detector_service.h"
+#include "frame_pool.h"
+#include "frame_wire.h"
+#include "inference_engine.h"
+#include "load_tracker.h"
 #include "options.h"
+#include "pipeline_stage.h"
 #include "polygon_filter.h"
+#include "server_stats.h"
 #include "types.h"
 #include "yolo.h"
+#include "zone_crops.h"
 
 // Forward declarations
 namespace aa::shared {
@@ -33,15 +44,39 @@ namespace aa::server {
  * Provides a convenient interface to manage the lifecycle of the detector
  * service server, including initialization, startup, and shutdown operations.
  * Uses composition with DetectorServiceImpl instead of inheritance.
+ *
+ * Frames are processed by a staged pipeline: decode and zone parsing,
+ * inference, and filtering with rendering and encoding each run on a worker
+ * group of their own, connected by bounded lock-free queues. The CPU-light
+ * stages of one frame overlap with the inference of the next, and frames
+ * queued for inference are run as one batch.
  */
 class DetectorServer {
  public:
+  /// @brief Receives the detections of each source frame, false stops it
+  using SourceSink = std::function<bool(const aa::proto::SourceDetections&)>;
+
   /**
    * @brief Construct a new Detector Server object from options
    *
    * @param options Configuration options containing server settings
+   * @param stats External counters to record into, e.g. a worker's block in
+   * shared memory (nullptr = counters owned by the server)
+   */
+  explicit DetectorServer(aa::shared::Options options,
+                          ServerStats* stats = nullptr);
+
+  /**
+   * @brief Construct a Detector Server with a given inference engine
+   *
+   * @param options Configuration options containing server settings
+   * @param engine Detector used instead of loading the model from options
+   * @param stats External counters to record into (nullptr = counters owned
+   * by the server)
    */
-  explicit DetectorServer(aa::shared::Options options);
+  DetectorServer(aa::shared::Options options,
+                 std::unique_ptr<InferenceEngine> engine,
+                 ServerStats* stats = nullptr);
 
   /**
    * @brief Destroy the Detector Server object
@@ -52,15 +87,24 @@ class DetectorServer {
   DetectorServer(const DetectorServer&) = delete;
   DetectorServer& operator=(const DetectorServer&) = delete;
 
-  // Enable move construction and assignment
-  DetectorServer(DetectorServer&&) noexcept = default;
-  DetectorServer& operator=(DetectorServer&&) noexcept = default;
+  // Disable move: registered handlers capture this
+  DetectorServer(DetectorServer&&) = delete;
+  DetectorServer& operator=(DetectorServer&&) = delete;
 
   /**
    * @brief Initialize the server components
    */
   void Initialize();
 
+  /**
+   * @brief Run the engine once on a blank frame of the model input size
+   *
+   * Allocates the engine's activations before the first request, so memory
+   * measured afterwards is what the server runs with. Engines without a
+   * fixed input size are skipped, and failures are only logged.
+   */
+  void WarmUp();
+
   /**
    * @brief Start the server and begin listening for requests
    */
@@ -71,17 +115,121 @@ class DetectorServer {
    */
   void Shutdown();
 
+  /**
+   * @brief Snapshot of the request counters
+   */
+  ServerStatsSnapshot GetStats() const;
+
+  /**
+   * @brief Process a frame for detection
+   *
+   * Performs object detection on the provided frame using the inference
+   * engine and applies polygon-based filtering to the detection results. The
+   * response is serialized directly with the result frame as a separate
+   * slice referencing the rendered image. Registered as the ProcessFrame
+   * handler: it only submits the frame to the pipeline and returns, never
+   * waiting, so it can run on gRPC's callback threads. The stage that
+   * finishes the frame calls done when the response is ready; a frame that
+   * finds the decode queue full fails with RESOURCE_EXHAUSTED.
+   *
+   * @param request Frame processing request (pointer containing frame and
+   * polygons), valid until done is called
+   * @param response Serialized ProcessFrameResponse (pointer to populate),
+   * valid until done is called
+   * @param done Called once with the status, on the calling thread if the
+   * frame never entered the pipeline, else on a pipeline thread
+   */
+  void ProcessFrame(const aa::proto::ProcessFrameRequest* request,
+                    grpc::ByteBuffer* response,
+                    std::function<void(grpc::Status)> done) const;
+
+  /**
+   * @brief Process a frame for detection and wait for the response
+   *
+   * Blocking form of the asynchronous ProcessFrame(), for in-process
+   * callers such as tests and benchmarks.
+   *
+   * @param request Frame processing request
+   * @param response Serialized ProcessFrameResponse (pointer to populate)
+   * @return grpc::Status indicating success or failure
+   */
+  grpc::Status ProcessFrame(const aa::proto::ProcessFrameRequest* request,
+                            grpc::ByteBuffer* response) const;
+
+  /**
+   * @brief Process a burst of frames as one inference batch
+   *
+   * The frames are decoded in parallel and handed to the forward stage
+   * together, so they share forward passes (up to the batch size each)
+   * without waiting for other requests to fill a batch. Frames without
+   * polygons use the shared polygons of the request. Each frame gets its
+   * own result, success=false for frames failing validation. Registered as
+   * the ProcessFrames handler, and callable in-process by tests.
+   *
+   * @param request Frames and their shared zones
+   * @param response Results in frame order (pointer to populate)
+   * @return grpc::Status INVALID_ARGUMENT for a batch without frames, or
+   * the first failure of a frame's processing
+   */
+  grpc::Status ProcessFrames(const aa::proto::ProcessFramesRequest* request,
+                             aa::proto::ProcessFramesResponse* response) const;
+
+  /**
+   * @brief Describe the input of the model
+   *
+   * Reports the input size, padding mode, pad value and channel order of
+   * the engine, so clients can shrink frames before sending them.
+   * Registered as the GetModelInfo handler, and callable in-process by
+   * tests.
+   *
+   * @param request Model info request (empty)
+   * @param response Model input description to populate
+   * @return grpc::Status FAILED_PRECONDITION if the engine has no fixed
+   * input size
+   */
+  grpc::Status GetModelInfo(const aa::proto::GetModelInfoRequest* request,
+                            aa::proto::GetModelInfoResponse* response) const;
+
+  /**
+   * @brief Run detection on a video source opened by the server
+   *
+   * Opens the source with cv::VideoCapture and decodes it on a thread of
+   * its own into a bounded queue, so inference never waits on I/O. When
+   * inference falls behind, the oldest decoded frames are dropped and
+   * counted, unless the request asks for lossless processing. Returns when
+   * the source ends or the sink returns false. Backs the StartSource
+   * handler, and callable in-process by tests.
+   *
+   * @param request Source uri, zones and detection budget
+   * @param sink Receives the filtered detections of every processed frame
+   * @return grpc::Status INVALID_ARGUMENT for missing zones or a bad
+   * budget, NOT_FOUND if the source cannot be opened
+   */
+  grpc::Status RunSource(const aa::proto::StartSourceRequest& request,
+                         const SourceSink& sink) const;
+
  private:
   aa::shared::Options options_;
   std::unique_ptr<DetectorServiceImpl> service_;
-  Yolo yolo_;
-  PolygonFilter polygon_filter_;
+  std::unique_ptr<InferenceEngine> engine_;
+  mutable std::mutex engine_mutex_;  ///< The engine runs one frame at a time
+  mutable LoadTracker load_;
+  mutable FramePool frame_pool_;  ///< Assembly buffers of chunked uploads
+  ZoneCropOptions zone_crop_options_;
+  mutable ZoneCropMerger zone_crop_merger_;  ///< Used by the forward stage
+  double zone_tolerance_;  ///< Zone simplification tolerance (pixels)
+  std::size_t batch_size_;  ///< Most frames per forward pass
+  uint64_t perf_sample_;  ///< Every Nth frame reads hardware counters (0 = off)
+  mutable std::atomic<uint64_t> frame_sequence_{0};
+  std::unique_ptr<ServerStats> owned_stats_;
+  ServerStats* stats_;
 
   /**
    * @brief Check the health of the server
    *
    * Provides a health check endpoint to verify server status and availability.
-   * Always returns success for a running server instance.
+   * Always reports a running server instance as healthy, together with its
+   * current load.
    *
    * @param request Health check request (pointer, typically empty)
    * @param response Health check response (pointer to populate)
@@ -91,19 +239,158 @@ class DetectorServer {
                            aa::proto::CheckHealthResponse* response) const;
 
   /**
-   * @brief Process a frame for detection
+   * @brief Process a streaming session of frames
    *
-   * Performs object detection on the provided frame using the loaded YOLO model
-   * and applies polygon-based filtering to the detection results.
+   * Requests may carry a FrameDelta instead of a full frame; the session
+   * keeps the reconstructed frame and patches only the changed tiles. A
+   * request without polygons reuses the zones of the previous request. A
+   * rejected delta yields success=false and the session then waits for a
+   * keyframe.
    *
-   * @param request Frame processing request (pointer containing frame and
-   * polygons)
-   * @param response Frame processing response (pointer to populate with
-   * results)
+   * @param stream Session stream, one response is written per request
    * @return grpc::Status indicating success or failure
    */
-  grpc::Status ProcessFrame(const aa::proto::ProcessFrameRequest* request,
-                            aa::proto::ProcessFrameResponse* response) const;
+  grpc::Status ProcessFrameStream(
+      grpc::ServerReaderWriter<aa::proto::ProcessFrameResponse,
+                               aa::proto::ProcessFrameRequest>* stream) const;
+
+  /**
+   * @brief Process a frame uploaded as a sequence of chunks
+   *
+   * The chunks are copied in order into a pooled buffer of total_size
+   * bytes, which a raw frame is then wrapped by without a further copy.
+   * An undecodable frame yields success=false.
+   *
+   * @param reader Stream of chunks, the request in the first one
+   * @param response Response to populate
+   * @return grpc::Status INVALID_ARGUMENT if the chunks do not add up to
+   * total_size, RESOURCE_EXHAUSTED if total_size exceeds the upload limit
+   */
+  grpc::Status ProcessFrameChunked(
+      grpc::ServerReader<aa::proto::FrameChunk>* reader,
+      aa::proto::ProcessFrameResponse* response) const;
+
+  /**
+   * @brief Stream the detections of a server-side video source
+   *
+   * @param request Source uri, zones and detection budget
+   * @param writer Stream receiving one message per processed frame
+   * @return grpc::Status indicating success or failure
+   */
+  grpc::Status StartSource(
+      const aa::proto::StartSourceRequest* request,
+      grpc::ServerWriter<aa::proto::SourceDetections>* writer) const;
+
+  /**
+   * @brief Stream zone occupancy events of a server-side video source
+   *
+   * Runs the source like StartSource, but counts the filtered detections
+   * per zone and class with an OccupancyTracker and writes only the frames
+   * on which a debounced count changed. A quiet scene sends nothing.
+   *
+   * @param context Server context, polled for cancellation between writes
+   * @param request Source request and debounce setting
+   * @param writer Stream receiving the events of each changed frame
+   * @return grpc::Status indicating success or failure
+   */
+  grpc::Status WatchZones(grpc::ServerContext* context,
+                          const aa::proto::WatchZonesRequest* request,
+                          grpc::ServerWriter<aa::proto::ZoneEvents>* writer)
+      const;
+
+  /**
+   * @brief Run the inference engine on one image
+   *
+   * Waits for the engine, leaving the ticket's queue when it gets it.
+   *
+   * @param img Image to run detection on
+   * @param budget Detection budget of the request
+   * @param ticket Load ticket of the request
+   * @param detections Receives the detections
+   */
+  void RunInference(cv::Mat& img, const DetectionBudget& budget,
+                    LoadTracker::Ticket& ticket,
+                    std::vector<aa::shared::Detection>& detections) const;
+
+  /**
+   * @brief Run detection on an image and render the response
+   *
+   * Hands the frame to the pipeline and waits until its render stage has
+   * finished the response. Only the inference itself is serialized on the
+   * engine; decoding, zone filtering, drawing and encoding of concurrent
+   * requests run in parallel.
+   *
+   * @param request Request providing polygons and detection budget
+   * @param img Decoded frame, drawn on in place, or empty to decode
+   * request.frame() on the decode stage
+   * @param response Frame processing response to populate
+   * @param payload Receives the result frame bytes, which are then left out
+   * of response->result() (nullptr = copy them into the response)
+   * @param zones Zones to use instead of request.polygons() (nullptr = the
+   * request's own)
+   * @param canvas Scratch frame to draw on, leaving img untouched (nullptr =
+   * draw on img). Its buffer is reused when the size matches, so a payload
+   * referencing it must be released before the next call.
+   * @return grpc::Status indicating success or failure
+   */
+  grpc::Status ProcessImage(
+      const aa::proto::ProcessFrameRequest& request, cv::Mat img,
+      aa::proto::ProcessFrameResponse* response,
+      aa::shared::FramePayload* payload = nullptr,
+      const google::protobuf::RepeatedPtrField<aa::proto::Polygon>* zones =
+          nullptr,
+      cv::Mat* canvas = nullptr) const;
+
+  /// @brief State of one frame travelling through the pipeline
+  struct FrameJob;
+
+  /// @brief Frames of one ProcessFrames call meeting after decoding
+  struct FrameGroup;
+
+  /// @brief Asynchronous ProcessFrame call owning its job and results
+  struct FrameCall;
+
+  /**
+   * @brief Take the next frame sequence number and check whether the frame
+   * reads hardware counters
+   */
+  bool NextFrameSampled() const;
+
+  /**
+   * @brief Decode stage: prepare the frame and pass it on to inference
+   *
+   * Frames of a group are passed on together once all of them are
+   * prepared; frames failing preparation are finished right away.
+   */
+  void DecodeFrame(FrameJob& job) const;
+
+  /**
+   * @brief Decode the frame, parse zones and budget, and select the zone
+   * crops
+   *
+   * @return true if the frame goes on to inference; false after setting
+   * success=false or an error status on the job
+   */
+  bool PrepareFrame(FrameJob& job) const;
+
+  /**
+   * @brief Forward stage: run inference on the queued frames
+   *
+   * Consecutive frames with equal budgets run as one engine batch, together
+   * with the zone crops of those frames. Crop detections are merged into
+   * the detections of their frame.
+   */
+  void ForwardFrames(std::vector<FrameJob*>& jobs) const;
+
+  /**
+   * @brief Render stage: filter detections, draw and encode the result
+   */
+  void RenderFrame(FrameJob& job) const;
+
+  // Declared in reverse order: each stage drains into the next on shutdown
+  std::unique_ptr<PipelineStage<FrameJob*>> render_stage_;
+  std::unique_ptr<PipelineStage<FrameJob*>> forward_stage_;
+  std::unique_ptr<PipelineStage<FrameJob*>> decode_stage_;
 };
 
 }  // namespace aa::server
@@ -14,14 +14,36 @@ namespace aa::server {
  */
 struct DetectorServiceMethods {
   /// @brief Enumeration of available service methods
-  enum { kCheckHealth = 0, kProcessFrame };
+  enum {
+    kCheckHealth = 0,
+    kProcessFrame,
+    kProcessFrameStream,
+    kProcessFrameChunked,
+    kStartSource,
+    kWatchZones,
+    kGetModelInfo,
+    kProcessFrames
+  };
 
   /// @brief Observer table type mapping method IDs to their signatures
   using ObserverTable =
       std::tuple<ServiceMethod<aa::proto::CheckHealthRequest,
                                aa::proto::CheckHealthResponse>,
-                 ServiceMethod<aa::proto::ProcessFrameRequest,
-                               aa::proto::ProcessFrameResponse>>;
+                 ServiceRawMethod<aa::proto::ProcessFrameRequest>,
+                 ServiceBidiStream<aa::proto::ProcessFrameRequest,
+                                   aa::proto::ProcessFrameResponse>,
+                 ServiceStream<aa::proto::FrameChunk,
+                               aa::proto::ProcessFrameResponse>,
+                 ServiceServerStream<aa::proto::StartSourceRequest,
+                                     aa::proto::SourceDetections>,
+                 // Writes are sparse, so the handler polls for cancellation
+                 Observer<grpc::Status(
+                     grpc::ServerContext*, const aa::proto::WatchZonesRequest*,
+                     grpc::ServerWriter<aa::proto::ZoneEvents>*)>,
+                 ServiceMethod<aa::proto::GetModelInfoRequest,
+                               aa::proto::GetModelInfoResponse>,
+                 ServiceMethod<aa::proto::ProcessFramesRequest,
+                               aa::proto::ProcessFramesResponse>>;
 };
 
 /**
@@ -31,6 +53,12 @@ struct DetectorServiceMethods {
  * pattern with RpcServerFromThis and Observable pattern for method
  * registration. Handles health checks and frame processing requests.
  *
+ * ProcessFrame is served as a raw callback method: the request is parsed
+ * here, but the handler returns the response already serialized, so the
+ * result frame can reference the rendered image instead of being copied
+ * into the message. Clients still see a regular ProcessFrameResponse. The
+ * handler completes asynchronously, so no thread waits for the frame.
+ *
  * @grpc Implements aa::proto::DetectorService interface
  * @threadsafe Methods are thread-safe through gRPC framework
  *
@@ -42,9 +70,11 @@ struct DetectorServiceMethods {
  * service.Wait();
  * @endcode
  */
-class DetectorServiceImpl final : public aa::proto::DetectorService::Service,
-                                  public RpcServerFromThis<DetectorServiceImpl>,
-                                  public Observable<DetectorServiceMethods> {
+class DetectorServiceImpl final
+    : public aa::proto::DetectorService::WithRawCallbackMethod_ProcessFrame<
+          aa::proto::DetectorService::Service>,
+      public RpcServerFromThis<DetectorServiceImpl>,
+      public Observable<DetectorServiceMethods> {
  public:
   /// @brief Inherit constructors from RpcServerFromThis
   using RpcServerFromThis::RpcServerFromThis;
@@ -69,21 +99,150 @@ class DetectorServiceImpl final : public aa::proto::DetectorService::Service,
   /**
    * @brief Handle frame processing requests
    *
-   * @param context gRPC server context for the request
-   * @param request Frame processing request with image data
-   * @param response Frame processing response to populate with detections
+   * @param context gRPC callback context for the request
+   * @param request Serialized ProcessFrameRequest
+   * @param response Serialized ProcessFrameResponse to populate
+   * @return grpc::ServerUnaryReactor* Reactor finished with the handler
+   * status once the handler completes
+   *
+   * Parses the request and invokes the registered frame processing handler
+   * through the Observable pattern. The handler only hands the frame off, so
+   * the callback executor thread returns right away; the reactor is
+   * finished from the handler's completion callback.
+   */
+  grpc::ServerUnaryReactor* ProcessFrame(grpc::CallbackServerContext* context,
+                                         const grpc::ByteBuffer* request,
+                                         grpc::ByteBuffer* response) override {
+    auto* reactor = context->DefaultReactor();
+
+    // Deserialize consumes its input; the copy only shares the slices
+    grpc::ByteBuffer buffer{*request};
+    auto message = std::make_shared<aa::proto::ProcessFrameRequest>();
+    auto status =
+        grpc::SerializationTraits<aa::proto::ProcessFrameRequest>::Deserialize(
+            &buffer, message.get());
+    if (!status.ok()) {
+      reactor->Finish(status);
+      return reactor;
+    }
+
+    // The callback keeps the request alive until the handler is done
+    InvokeAsync<DetectorServiceMethods::kProcessFrame>(
+        context,
+        [reactor, message](grpc::Status result) { reactor->Finish(result); },
+        message.get(), response);
+    return reactor;
+  }
+
+  /**
+   * @brief Handle a streaming frame processing session
+   *
+   * @param context gRPC server context for the session
+   * @param stream Stream of requests in, one response per request out
    * @return grpc::Status indicating success or failure
    *
-   * Invokes the registered frame processing handler through the Observable
+   * Invokes the registered streaming handler through the Observable pattern.
+   */
+  grpc::Status ProcessFrameStream(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<aa::proto::ProcessFrameResponse,
+                               aa::proto::ProcessFrameRequest>* stream)
+      override {
+    return Invoke<DetectorServiceMethods::kProcessFrameStream>(context,
+                                                               stream);
+  }
+
+  /**
+   * @brief Handle a frame uploaded as a sequence of chunks
+   *
+   * @param context gRPC server context for the upload
+   * @param reader Stream of frame chunks, the request in the first one
+   * @param response Processing response to populate
+   * @return grpc::Status indicating success or failure
+   *
+   * Invokes the registered chunked upload handler through the Observable
    * pattern.
    */
-  grpc::Status ProcessFrame(
+  grpc::Status ProcessFrameChunked(
       grpc::ServerContext* context,
-      const aa::proto::ProcessFrameRequest* request,
+      grpc::ServerReader<aa::proto::FrameChunk>* reader,
       aa::proto::ProcessFrameResponse* response) override {
-    return Invoke<DetectorServiceMethods::kProcessFrame>(context, request,
+    return Invoke<DetectorServiceMethods::kProcessFrameChunked>(
+        context, reader, response);
+  }
+
+  /**
+   * @brief Handle a request to process a server-side video source
+   *
+   * @param context gRPC server context for the session
+   * @param request Source and zones to process
+   * @param writer Stream of per-frame detections
+   * @return grpc::Status indicating success or failure
+   *
+   * Invokes the registered source handler through the Observable pattern.
+   */
+  grpc::Status StartSource(
+      grpc::ServerContext* context,
+      const aa::proto::StartSourceRequest* request,
+      grpc::ServerWriter<aa::proto::SourceDetections>* writer) override {
+    return Invoke<DetectorServiceMethods::kStartSource>(context, request,
+                                                        writer);
+  }
+
+  /**
+   * @brief Handle a request to watch zone occupancy of a video source
+   *
+   * @param context gRPC server context for the session
+   * @param request Source, zones and debounce setting
+   * @param writer Stream of zone occupancy events
+   * @return grpc::Status indicating success or failure
+   *
+   * Invokes the registered watch handler through the Observable pattern.
+   */
+  grpc::Status WatchZones(
+      grpc::ServerContext* context,
+      const aa::proto::WatchZonesRequest* request,
+      grpc::ServerWriter<aa::proto::ZoneEvents>* writer) override {
+    return Invoke<DetectorServiceMethods::kWatchZones>(context, context,
+                                                       request, writer);
+  }
+
+  /**
+   * @brief Handle model info requests
+   *
+   * @param context gRPC server context for the request
+   * @param request Model info request (empty)
+   * @param response Model input description to populate
+   * @return grpc::Status indicating success or failure
+   *
+   * Invokes the registered model info handler through the Observable
+   * pattern.
+   */
+  grpc::Status GetModelInfo(
+      grpc::ServerContext* context,
+      const aa::proto::GetModelInfoRequest* request,
+      aa::proto::GetModelInfoResponse* response) override {
+    return Invoke<DetectorServiceMethods::kGetModelInfo>(context, request,
                                                          response);
   }
+
+  /**
+   * @brief Handle requests carrying a burst of frames
+   *
+   * @param context gRPC server context for the request
+   * @param request Frames to process as one batch
+   * @param response Per-frame results to populate
+   * @return grpc::Status indicating success or failure
+   *
+   * Invokes the registered batch handler through the Observable pattern.
+   */
+  grpc::Status ProcessFrames(
+      grpc::ServerContext* context,
+      const aa::proto::ProcessFramesRequest* request,
+      aa::proto::ProcessFramesResponse* response) override {
+    return Invoke<DetectorServiceMethods::kProcessFrames>(context, request,
+                                                          response);
+  }
 };
 
 }  // namespace aa::server
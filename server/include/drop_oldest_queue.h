@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace aa::server {
+
+/**
+ * @brief Bounded FIFO handing items from a producer to a consumer thread
+ *
+ * Push() never blocks: when the queue is full the oldest item is dropped to
+ * make room, so a fast producer (e.g. a video decoder) never waits on a slow
+ * consumer and the consumer always sees the freshest items. PushWait()
+ * blocks for room instead, for sources that must not lose items.
+ *
+ * Close() wakes both sides. Pop() still drains the remaining items and
+ * returns false once the queue is closed and empty.
+ *
+ * @tparam T Item type, moved in and out
+ *
+ * @threadsafe All methods may be called concurrently
+ */
+template <typename T>
+class DropOldestQueue {
+ public:
+  /**
+   * @brief Construct a queue
+   * @param capacity Maximum number of queued items (at least 1)
+   */
+  explicit DropOldestQueue(std::size_t capacity)
+      : capacity_{capacity > 0 ? capacity : 1} {}
+
+  DropOldestQueue(const DropOldestQueue&) = delete;
+  DropOldestQueue& operator=(const DropOldestQueue&) = delete;
+
+  /**
+   * @brief Enqueue an item, dropping the oldest one if full
+   *
+   * @param item Item to enqueue
+   * @return true if an item was dropped to make room
+   */
+  bool Push(T item) {
+    bool dropped = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (closed_) return false;
+      if (items_.size() == capacity_) {
+        items_.pop_front();
+        dropped = true;
+      }
+      items_.push_back(std::move(item));
+    }
+    not_empty_.notify_one();
+    return dropped;
+  }
+
+  /**
+   * @brief Enqueue an item, waiting for room if full
+   *
+   * @param item Item to enqueue
+   * @return false if the queue was closed before the item was enqueued
+   */
+  bool PushWait(T item) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_full_.wait(lock,
+                     [this] { return closed_ || items_.size() < capacity_; });
+      if (closed_) return false;
+      items_.push_back(std::move(item));
+    }
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Dequeue the oldest item, waiting until one is available
+   *
+   * @param item Receives the dequeued item
+   * @return false if the queue is closed and drained
+   */
+  bool Pop(T& item) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+      if (items_.empty()) return false;
+      item = std::move(items_.front());
+      items_.pop_front();
+    }
+    not_full_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Dequeue up to max_items of the oldest items at once
+   *
+   * Waits until at least one item is available, then takes whatever is
+   * queued without waiting for more.
+   *
+   * @param items Receives the dequeued items (cleared first)
+   * @param max_items Maximum number of items to take (at least 1)
+   * @return false if the queue is closed and drained
+   */
+  bool PopBatch(std::vector<T>& items, std::size_t max_items) {
+    const std::size_t limit = std::max<std::size_t>(max_items, 1);
+    items.clear();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+      while (!items_.empty() && items.size() < limit) {
+        items.push_back(std::move(items_.front()));
+        items_.pop_front();
+      }
+    }
+    if (items.empty()) return false;
+    not_full_.notify_all();
+    return true;
+  }
+
+  /**
+   * @brief Stop accepting items and wake all waiters
+   */
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+ private:
+  const std::size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<T> items_;
+  bool closed_{false};
+};
+
+}  // namespace aa::server
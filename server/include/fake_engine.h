@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "inference_engine.h"
+#include "options.h"
+#include "types.h"
+
+namespace aa::server {
+
+/**
+ * @brief Settings of the fake inference engine
+ */
+struct FakeEngineOptions {
+  int detections{10};                       ///< Synthetic detections per frame
+  int num_classes{80};                      ///< Class ids cycle through these
+  std::chrono::microseconds compute_time{0};  ///< Simulated time per frame
+  bool spin{false};  ///< Busy-wait the compute time instead of sleeping
+  cv::Size input_size{640, 640};  ///< Model input reported to clients
+
+  /**
+   * @brief Build fake engine settings from command line options
+   *
+   * Reads fake_detections, fake_latency_ms, fake_spin, width and height.
+   *
+   * @param options Parsed command line options
+   * @return FakeEngineOptions Engine settings
+   */
+  static FakeEngineOptions FromOptions(const aa::shared::Options& options);
+};
+
+/**
+ * @brief Deterministic stand-in for the model, selected with --engine=fake
+ *
+ * Returns the same synthetic detections for every frame of a given size:
+ * boxes laid out on a grid over the frame, class ids counting up from 0 and
+ * confidences falling from 0.95. The detection budget is applied as the
+ * real engine applies it. Each frame then takes the configured compute
+ * time, either asleep, which leaves the core to the rest of the server, or
+ * spinning, which also models the CPU the model would occupy.
+ *
+ * With a compute time of zero, a server running this engine measures the
+ * throughput ceiling of everything but inference: RPC, serialization, zone
+ * filtering, drawing and encoding.
+ *
+ * @threadsafe Inference() may be called concurrently
+ */
+class FakeEngine final : public InferenceEngine {
+ public:
+  /**
+   * @brief Construct a fake engine
+   * @param options Engine settings
+   */
+  explicit FakeEngine(FakeEngineOptions options);
+
+  void Inference(cv::Mat& input,
+                 std::vector<aa::shared::Detection>& detections,
+                 const DetectionBudget& budget) override;
+
+  /**
+   * @brief Report a letterboxed BGR input of the configured size
+   */
+  ModelInfo GetModelInfo() const override;
+
+  void DrawBoundingBoxes(cv::Mat& img,
+                         const std::vector<aa::shared::Detection>& detections,
+                         double scale) const override;
+
+  /**
+   * @brief Synthetic detections of a frame, before the budget
+   *
+   * @param size Frame size
+   * @return Detections in frame coordinates, highest confidence first
+   */
+  std::vector<aa::shared::Detection> Generate(const cv::Size& size) const;
+
+ private:
+  FakeEngineOptions options_;
+};
+
+}  // namespace aa::server
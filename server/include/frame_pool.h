@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace aa::server {
+
+/**
+ * @brief Pool of reusable byte buffers for frames assembled from chunks
+ *
+ * Large frames arrive in pieces; each is copied straight into a pooled
+ * buffer, so no single protobuf message has to hold the frame and a warm
+ * server allocates nothing per frame. A new buffer starts at the size of
+ * the data at hand and grows with the upload, so an announced size alone
+ * reserves no memory. Buffers are left uninitialized, since every byte is
+ * overwritten by the upload.
+ *
+ * The pool keeps at most max_free idle buffers holding max_free_bytes in
+ * total; buffers above max_buffer_bytes are freed on release, so one huge
+ * frame does not stay resident.
+ *
+ * Usage:
+ * @code
+ * auto buffer = pool.Acquire(chunk.size(), total_size);
+ * std::memcpy(buffer.Data(), chunk.data(), chunk.size());
+ * buffer.Resize(offset + next.size());  // May move the data
+ * std::memcpy(buffer.Data() + offset, next.data(), next.size());
+ * cv::Mat image(rows, cols, type, buffer.Data());  // valid while buffer is
+ * @endcode
+ *
+ * @threadsafe Acquire and buffer release are safe to call concurrently
+ */
+class FramePool {
+ public:
+  /**
+   * @brief Scoped lease of a pooled buffer
+   *
+   * Returns its storage to the pool when destroyed. The pool must outlive
+   * its buffers.
+   */
+  class Buffer {
+   public:
+    ~Buffer();
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+    Buffer(Buffer&& other) noexcept;
+    Buffer& operator=(Buffer&&) = delete;
+
+    /// @brief First byte of the buffer
+    uint8_t* Data() { return storage_.get(); }
+
+    /// @brief Requested size in bytes
+    std::size_t Size() const { return size_; }
+
+    /// @brief Allocated size in bytes
+    std::size_t Capacity() const { return capacity_; }
+
+    /**
+     * @brief Change the size, keeping the first Size() bytes
+     *
+     * Growing past the capacity moves the data to new storage, at least
+     * doubling the capacity but not beyond the expected size given to
+     * Acquire() unless size needs more. Data() may change.
+     */
+    void Resize(std::size_t size);
+
+   private:
+    friend class FramePool;
+    Buffer(FramePool* pool, std::unique_ptr<uint8_t[]> storage,
+           std::size_t capacity, std::size_t size, std::size_t expected);
+
+    FramePool* pool_;
+    std::unique_ptr<uint8_t[]> storage_;
+    std::size_t capacity_;
+    std::size_t size_;
+    std::size_t expected_;  ///< Growth of the capacity stops here
+  };
+
+  /**
+   * @brief Construct a pool
+   *
+   * @param max_free Idle buffers kept for reuse; more are freed on release
+   * @param max_free_bytes Total capacity of the idle buffers kept
+   * @param max_buffer_bytes Buffers larger than this are never kept
+   */
+  explicit FramePool(std::size_t max_free = 4,
+                     std::size_t max_free_bytes = std::size_t{128} << 20,
+                     std::size_t max_buffer_bytes = std::size_t{64} << 20);
+
+  /**
+   * @brief Lease a buffer of at least size bytes
+   *
+   * Reuses the smallest idle buffer that is large enough, or allocates one.
+   */
+  Buffer Acquire(std::size_t size) { return Acquire(size, size); }
+
+  /**
+   * @brief Lease a buffer of size bytes expected to grow to expected bytes
+   *
+   * Reuses the smallest idle buffer that holds expected bytes, so a warm
+   * pool serves the whole upload without moving it. Otherwise allocates
+   * only size bytes and leaves the rest to Buffer::Resize().
+   */
+  Buffer Acquire(std::size_t size, std::size_t expected);
+
+  /**
+   * @brief Number of idle buffers
+   */
+  std::size_t FreeCount() const;
+
+  /**
+   * @brief Total capacity of the idle buffers in bytes
+   */
+  std::size_t FreeBytes() const;
+
+ private:
+  struct Storage {
+    std::unique_ptr<uint8_t[]> data;
+    std::size_t capacity{0};
+  };
+
+  void Release(std::unique_ptr<uint8_t[]> data, std::size_t capacity);
+
+  std::size_t max_free_;
+  std::size_t max_free_bytes_;
+  std::size_t max_buffer_bytes_;
+  mutable std::mutex mutex_;
+  std::vector<Storage> free_;
+  std::size_t free_bytes_{0};  ///< Capacity of free_, guarded by mutex_
+};
+
+}  // namespace aa::server
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "common.h"
+#include "types.h"
+
+namespace aa::shared {
+class Options;
+}
+
+namespace aa::server {
+
+/**
+ * @brief Per-request limits applied while decoding network output
+ *
+ * Candidates outside the budget are dropped during decode, so NMS and
+ * everything after it only see the budgeted set.
+ */
+struct DetectionBudget {
+  int max_detections{0};                 ///< Cap after NMS (0 = server default)
+  float min_confidence{0.0f};            ///< Raises the server threshold
+  std::vector<int32_t> class_whitelist;  ///< Classes to decode (empty = all)
+
+  bool operator==(const DetectionBudget&) const = default;
+};
+
+/**
+ * @brief Input the engine feeds its model, reported to clients
+ *
+ * Clients use it to shrink frames before sending them, the way the engine
+ * would shrink them itself.
+ */
+struct ModelInfo {
+  cv::Size input_size;      ///< Model input size (empty = unknown)
+  bool letterbox{true};     ///< Keep aspect ratio and pad, else stretch
+  float pad_value{114.0f};  ///< Value of letterbox padding pixels
+  bool rgb{false};          ///< Model expects RGB instead of BGR
+};
+
+/**
+ * @brief Object detector used by DetectorServer
+ *
+ * Yolo is the production implementation. Tests and benchmarks inject other
+ * engines to run the server without a model.
+ */
+class InferenceEngine {
+ public:
+  virtual ~InferenceEngine() = default;
+
+  /**
+   * @brief Detect objects in an image
+   *
+   * @param input Input image (any size, BGR)
+   * @param detections Output detections in input image coordinates
+   * @param budget Per-request detection budget
+   */
+  virtual void Inference(cv::Mat& input,
+                         std::vector<aa::shared::Detection>& detections,
+                         const DetectionBudget& budget) = 0;
+
+  /**
+   * @brief Detect objects in a batch of images
+   *
+   * The default runs Inference() on each image in turn. Engines that can
+   * process several images in one forward pass override it.
+   *
+   * @param inputs Input images (any sizes, BGR)
+   * @param detections Resized to inputs.size(), detections of each image in
+   * its own coordinates
+   * @param budget Detection budget applied to every image
+   */
+  virtual void InferenceBatch(
+      std::vector<cv::Mat>& inputs,
+      std::vector<std::vector<aa::shared::Detection>>& detections,
+      const DetectionBudget& budget) {
+    detections.resize(inputs.size());
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+      Inference(inputs[i], detections[i], budget);
+    }
+  }
+
+  /**
+   * @brief Describe the input of the model
+   *
+   * The default reports an unknown input, for engines without a fixed one.
+   */
+  virtual ModelInfo GetModelInfo() const { return {}; }
+
+  /**
+   * @brief Draw detections with their labels
+   *
+   * @param img Image to draw on (modified in-place)
+   * @param detections Detections to visualize
+   * @param scale Factor from detection coordinates to img coordinates
+   */
+  virtual void DrawBoundingBoxes(
+      cv::Mat& img, const std::vector<aa::shared::Detection>& detections,
+      double scale) const = 0;
+
+ protected:
+  /**
+   * @brief Draw detections as filled red boxes labeled from a class list
+   *
+   * Shared implementation of DrawBoundingBoxes() for engines with a list of
+   * class labels; class ids outside the list are drawn without a label.
+   *
+   * @param labels Class labels indexed by class id, convertible to
+   * std::string_view
+   */
+  template <typename Labels>
+  static void DrawLabeledBoxes(
+      cv::Mat& img, const std::vector<aa::shared::Detection>& detections,
+      double scale, const Labels& labels) {
+    for (const auto& detection : detections) {
+      cv::Rect box(cvRound(detection.bbox.x * scale),
+                   cvRound(detection.bbox.y * scale),
+                   cvRound(detection.bbox.width * scale),
+                   cvRound(detection.bbox.height * scale));
+      std::string_view label =
+          detection.class_id >= 0 &&
+                  detection.class_id < static_cast<int>(labels.size())
+              ? std::string_view{labels[detection.class_id]}
+              : std::string_view{};
+      aa::shared::DrawBoundingBox(img, box.x, box.y, box.x + box.width,
+                                  box.y + box.height, label,
+                                  detection.confidence,
+                                  aa::shared::Color::kRed, true);
+    }
+  }
+};
+
+/**
+ * @brief Create the engine selected with --engine
+ *
+ * "yolo" loads the model from --model; "fake" creates a FakeEngine that
+ * needs no model.
+ *
+ * @param options Parsed command line options
+ * @return std::unique_ptr<InferenceEngine> The engine
+ * @throws cv::Exception if the model cannot be loaded
+ */
+std::unique_ptr<InferenceEngine> CreateInferenceEngine(
+    const aa::shared::Options& options);
+
+}  // namespace aa::server
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "detector_service.pb.h"
+
+namespace aa::server {
+
+/**
+ * @brief Live load figures of a detector server
+ *
+ * Tracks requests waiting for the inference engine, requests in flight, an
+ * exponentially weighted moving average of the processing time and the
+ * resolution of the last input frame, and renders them as a LoadReport.
+ *
+ * Usage:
+ * @code
+ * auto ticket = tracker.Enter();  // queued and in flight
+ * std::lock_guard<std::mutex> lock(engine_mutex);
+ * ticket.Begin();                 // no longer queued, service clock starts
+ * ...
+ * ticket.Complete(width, height); // folds the service time into the EWMA
+ * @endcode
+ *
+ * @threadsafe All methods are lock-free and safe to call concurrently
+ */
+class LoadTracker {
+ public:
+  /**
+   * @brief Scoped registration of one request
+   *
+   * Leaves the queue and the in-flight count when destroyed.
+   */
+  class Ticket {
+   public:
+    ~Ticket();
+
+    Ticket(const Ticket&) = delete;
+    Ticket& operator=(const Ticket&) = delete;
+    Ticket(Ticket&& other) noexcept;
+    Ticket& operator=(Ticket&&) = delete;
+
+    /**
+     * @brief Leave the queue and start the service clock
+     */
+    void Begin();
+
+    /**
+     * @brief Record the service time of a processed frame
+     *
+     * @param width Input frame width
+     * @param height Input frame height
+     */
+    void Complete(int width, int height);
+
+   private:
+    friend class LoadTracker;
+    explicit Ticket(LoadTracker* tracker);
+
+    LoadTracker* tracker_;
+    bool queued_{true};
+    std::chrono::steady_clock::time_point started_;
+  };
+
+  /**
+   * @brief Construct a tracker
+   * @param alpha EWMA weight of the newest sample (0, 1]
+   */
+  explicit LoadTracker(double alpha = 0.2);
+
+  /**
+   * @brief Register a request as queued and in flight
+   */
+  Ticket Enter();
+
+  /**
+   * @brief Write the current figures to a report
+   */
+  void Fill(aa::proto::LoadReport* report) const;
+
+ private:
+  double alpha_;
+  std::atomic<uint32_t> queue_depth_{0};
+  std::atomic<uint32_t> in_flight_{0};
+  std::atomic<double> ewma_service_ms_{0.0};
+  std::atomic<uint32_t> input_width_{0};
+  std::atomic<uint32_t> input_height_{0};
+
+  void RecordService(std::chrono::nanoseconds elapsed);
+};
+
+}  // namespace aa::server
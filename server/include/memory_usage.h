@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+
+namespace aa::server {
+
+/**
+ * @brief Resident memory of the calling process, split by sharing
+ *
+ * Shared pages are mapped by other processes too, such as the model
+ * weights a worker inherited from the supervisor or the page cache of a
+ * mapped model file. Private pages are this process's own: activations,
+ * buffers and pages copied on write. PSS charges each shared page to its
+ * processes in equal parts, so the PSS of all workers adds up to their
+ * real footprint.
+ */
+struct MemoryUsage {
+  uint64_t rss{0};            ///< Resident bytes
+  uint64_t pss{0};            ///< Proportional set size (0 = unknown)
+  uint64_t shared{0};         ///< Resident bytes shared with processes
+  uint64_t private_bytes{0};  ///< Resident bytes of this process only
+
+  /**
+   * @brief Read the usage of the calling process
+   *
+   * Uses /proc/self/smaps_rollup, or /proc/self/statm on kernels without
+   * it, where shared counts file-backed pages and PSS is unknown.
+   *
+   * @return MemoryUsage Usage, all zero if neither file can be read
+   */
+  static MemoryUsage Read();
+
+  /**
+   * @brief Parse the contents of an smaps_rollup file
+   *
+   * @param smaps_rollup Stream positioned at the start of the file
+   * @return MemoryUsage Usage read from the Rss, Pss, Shared_* and
+   * Private_* lines
+   */
+  static MemoryUsage Parse(std::istream& smaps_rollup);
+
+  /**
+   * @brief One-line human-readable summary for logs, in MiB
+   */
+  std::string ToString() const;
+};
+
+}  // namespace aa::server
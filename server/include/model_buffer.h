@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace aa::server {
+
+/**
+ * @brief Model file mapped read-only into memory
+ *
+ * The mapping is shared: every process mapping the file, and every worker
+ * forked after the mapping was made, reads the same page cache pages, so
+ * the raw model costs its size once however many workers parse it.
+ * Engines that can parse a model from memory read it from here instead of
+ * the file.
+ *
+ * Usage:
+ * @code
+ * ModelBuffer model("yolox_s.onnx");
+ * auto net = cv::dnn::readNetFromONNX(model.Data(), model.Size());
+ * @endcode
+ *
+ * @threadsafe Immutable after construction
+ */
+class ModelBuffer {
+ public:
+  /**
+   * @brief Map a model file
+   *
+   * @param path Path of the model file
+   * @throws std::runtime_error if the file cannot be opened, is empty or
+   * cannot be mapped
+   */
+  explicit ModelBuffer(const std::string& path);
+
+  /**
+   * @brief Unmap the file
+   */
+  ~ModelBuffer();
+
+  // Disable copy and move: the mapping is owned by this instance
+  ModelBuffer(const ModelBuffer&) = delete;
+  ModelBuffer& operator=(const ModelBuffer&) = delete;
+
+  const char* Data() const { return static_cast<const char*>(data_); }
+  std::size_t Size() const { return size_; }
+  const std::string& Path() const { return path_; }
+
+ private:
+  std::string path_;
+  void* data_{nullptr};
+  std::size_t size_{0};
+};
+
+}  // namespace aa::server
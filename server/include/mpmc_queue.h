@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace aa::server {
+
+/**
+ * @brief Bounded lock-free multi-producer multi-consumer FIFO
+ *
+ * A ring of cells, each tagged with a sequence number that tells producers
+ * and consumers whose turn the cell is (D. Vyukov's bounded MPMC queue).
+ * TryPush() and TryPop() claim a cell with one compare-and-swap and never
+ * block. Push() and Pop() spin briefly and then sleep on an atomic wait
+ * until the other side makes progress; a side that never waits pays no
+ * wake-up system calls.
+ *
+ * Close() wakes all waiters. Pop() still drains the remaining items and
+ * returns false once the queue is closed and empty. An item pushed while
+ * the queue is being closed may be left in it.
+ *
+ * @tparam T Item type, default constructible and moved in and out;
+ * typically a pointer or other small handle
+ *
+ * @threadsafe All methods may be called concurrently
+ */
+template <typename T>
+class MpmcQueue {
+ public:
+  /**
+   * @brief Construct a queue
+   * @param capacity Minimum number of queued items, rounded up to a power
+   * of two (at least 2)
+   */
+  explicit MpmcQueue(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) size <<= 1;
+    mask_ = size - 1;
+    cells_ = std::make_unique<Cell[]>(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  /**
+   * @brief Enqueue an item if there is room
+   *
+   * @param item Item to enqueue, moved from only on success
+   * @return false if the queue is full
+   */
+  bool TryPush(T& item) {
+    Cell* cell;
+    std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells_[position & mask_];
+      auto sequence = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(sequence) -
+                  static_cast<std::intptr_t>(position);
+      if (diff == 0) {
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->item = std::move(item);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    Signal(pushed_, pop_waiters_);
+    return true;
+  }
+
+  /**
+   * @brief Dequeue the oldest item if there is one
+   *
+   * @param item Receives the dequeued item
+   * @return false if the queue is empty
+   */
+  bool TryPop(T& item) {
+    Cell* cell;
+    std::size_t position = dequeue_position_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells_[position & mask_];
+      auto sequence = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(sequence) -
+                  static_cast<std::intptr_t>(position + 1);
+      if (diff == 0) {
+        if (dequeue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = dequeue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    item = std::move(cell->item);
+    cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+    Signal(popped_, push_waiters_);
+    return true;
+  }
+
+  /**
+   * @brief Enqueue an item, waiting for room if full
+   *
+   * @param item Item to enqueue
+   * @return false if the queue was closed before the item was enqueued
+   */
+  bool Push(T item) {
+    for (int spin = 0;; ++spin) {
+      if (closed_.load()) return false;
+      if (spin < kSpins) {
+        if (TryPush(item)) return true;
+        std::this_thread::yield();
+        continue;
+      }
+
+      // Read the counter first: a pop after a failed attempt changes it
+      push_waiters_.fetch_add(1);
+      auto seen = popped_.load();
+      bool pushed = TryPush(item);
+      if (!pushed && !closed_.load()) popped_.wait(seen);
+      push_waiters_.fetch_sub(1);
+      if (pushed) return true;
+    }
+  }
+
+  /**
+   * @brief Dequeue the oldest item, waiting until one is available
+   *
+   * @param item Receives the dequeued item
+   * @return false if the queue is closed and drained
+   */
+  bool Pop(T& item) {
+    for (int spin = 0;; ++spin) {
+      if (TryPop(item)) return true;
+      if (closed_.load()) return TryPop(item);
+      if (spin < kSpins) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      pop_waiters_.fetch_add(1);
+      auto seen = pushed_.load();
+      bool popped = TryPop(item);
+      if (!popped && !closed_.load()) pushed_.wait(seen);
+      pop_waiters_.fetch_sub(1);
+      if (popped) return true;
+    }
+  }
+
+  /**
+   * @brief Stop accepting items and wake all waiters
+   */
+  void Close() {
+    closed_.store(true);
+    pushed_.fetch_add(1);
+    popped_.fetch_add(1);
+    pushed_.notify_all();
+    popped_.notify_all();
+  }
+
+  /**
+   * @brief Number of cells, the most items the queue holds at once
+   */
+  std::size_t Capacity() const { return mask_ + 1; }
+
+ private:
+  // Keeps the hot indices and every cell on cache lines of their own
+  static constexpr std::size_t kCacheLine = 64;
+
+  // Failed attempts before a waiting side sleeps
+  static constexpr int kSpins = 64;
+
+  struct alignas(kCacheLine) Cell {
+    std::atomic<std::size_t> sequence{0};
+    T item{};
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  std::size_t mask_{0};
+  alignas(kCacheLine) std::atomic<std::size_t> enqueue_position_{0};
+  alignas(kCacheLine) std::atomic<std::size_t> dequeue_position_{0};
+  alignas(kCacheLine) std::atomic<uint32_t> pushed_{0};
+  std::atomic<uint32_t> pop_waiters_{0};
+  alignas(kCacheLine) std::atomic<uint32_t> popped_{0};
+  std::atomic<uint32_t> push_waiters_{0};
+  std::atomic<bool> closed_{false};
+
+  /**
+   * @brief Bump a progress counter and wake its waiters, if any
+   */
+  static void Signal(std::atomic<uint32_t>& counter,
+                     std::atomic<uint32_t>& waiters) {
+    counter.fetch_add(1);
+    if (waiters.load() > 0) counter.notify_all();
+  }
+};
+
+}  // namespace aa::server
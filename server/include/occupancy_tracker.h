@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "detector_service.pb.h"
+#include "polygon.h"
+#include "types.h"
+
+namespace aa::server {
+
+/**
+ * @brief Debounced per-zone, per-class object counts across frames
+ *
+ * Counts the detections of each class whose center lies inside each
+ * inclusion zone (and whose class the zone targets), and reports a
+ * ZoneEvent only when a count changes. A new count must be observed on
+ * debounce_frames consecutive frames before it replaces the reported one,
+ * so a detection missed or hallucinated for a frame or two causes no
+ * events. Exclusion zones only take part through the detection filter
+ * applied before Update().
+ *
+ * Counts are not object identities: two objects swapping places in a zone
+ * cause no event.
+ *
+ * Usage:
+ * @code
+ * OccupancyTracker tracker(zones, 3);
+ * aa::proto::ZoneEvents events;
+ * tracker.Update(filtered, frame_index, timestamp_ms, &events);
+ * if (events.events_size() > 0) writer->Write(events);
+ * @endcode
+ */
+class OccupancyTracker {
+ public:
+  /**
+   * @brief Construct a tracker
+   *
+   * @param zones Zones in request order; events carry their index here
+   * @param debounce_frames Consecutive frames a new count must hold (values
+   * below 1 report every change immediately)
+   */
+  OccupancyTracker(std::vector<aa::shared::Polygon> zones,
+                   int debounce_frames);
+
+  /**
+   * @brief Count the detections of a frame and append confirmed changes
+   *
+   * @param detections Detections of the frame, already zone-filtered
+   * @param frame_index Index of the frame in the source
+   * @param timestamp_ms Source position of the frame
+   * @param events Receives the events confirmed on this frame (appended)
+   */
+  void Update(const std::vector<aa::shared::Detection>& detections,
+              uint64_t frame_index, double timestamp_ms,
+              aa::proto::ZoneEvents* events);
+
+  /**
+   * @brief Reported count of a class in a zone
+   */
+  uint32_t Count(uint32_t zone, int32_t class_id) const;
+
+ private:
+  using Key = std::pair<uint32_t, int32_t>;  ///< Zone index and class
+
+  struct State {
+    uint32_t stable{0};   ///< Last reported count
+    uint32_t pending{0};  ///< Candidate count being debounced
+    int streak{0};        ///< Consecutive frames the candidate was seen
+  };
+
+  std::vector<aa::shared::Polygon> zones_;
+  int debounce_frames_;
+  std::map<Key, State> states_;
+  std::map<Key, uint32_t> counts_;  ///< Per-frame scratch counts
+};
+
+}  // namespace aa::server
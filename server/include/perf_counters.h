@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace aa::server {
+
+struct ServerStats;
+
+/**
+ * @brief Frame processing stages sampled with hardware counters
+ */
+enum class PerfStage : int {
+  kDecode = 0,   ///< Request frame to cv::Mat
+  kPreprocess,   ///< Letterbox and blob conversion
+  kForward,      ///< Network forward pass
+  kPostprocess,  ///< Output decoding and NMS
+  kFilter,       ///< Zone filtering
+  kDraw,         ///< Result resize and overlays
+  kEncode,       ///< Result frame encoding
+};
+
+/// @brief Number of PerfStage values
+inline constexpr int kPerfStageCount = 7;
+
+/**
+ * @brief Short lowercase name of a stage for logs
+ */
+std::string_view PerfStageName(PerfStage stage);
+
+/**
+ * @brief Raw hardware counter values, or the difference of two readings
+ */
+struct PerfReading {
+  uint64_t cycles{0};
+  uint64_t instructions{0};
+  uint64_t llc_misses{0};       ///< Last level cache misses
+  uint64_t branch_misses{0};    ///< Mispredicted branches
+  uint64_t time_ns{0};          ///< Wall time
+  uint64_t time_enabled_ns{0};  ///< Time the event group was enabled
+  uint64_t time_running_ns{0};  ///< Time the event group was on the PMU
+
+  /**
+   * @brief Counts between two readings
+   *
+   * When the group was multiplexed off the PMU in between, the count
+   * differences are extrapolated by the enabled over the running time of
+   * the same interval.
+   */
+  PerfReading operator-(const PerfReading& start) const;
+};
+
+/**
+ * @brief Hardware counters of the calling thread (Linux perf_event_open)
+ *
+ * Cycles, instructions, LLC misses and branch misses are opened as one
+ * event group, so a reading is a single read() call and the four values
+ * are always taken together. User-space events only, which works with the
+ * default perf_event_paranoid setting. Readings hold raw counts; only the
+ * difference of two readings is scaled when the kernel multiplexed the
+ * group with other events.
+ *
+ * Counters are opened lazily once per thread and stay open until the
+ * thread exits.
+ */
+class PerfCounters {
+ public:
+  /**
+   * @brief Counters of the calling thread
+   *
+   * @return Open counters, or nullptr if the kernel, permissions or the
+   * (virtual) CPU do not provide them
+   */
+  static PerfCounters* ForThisThread();
+
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  /**
+   * @brief Current counter values
+   *
+   * @return Raw counts, or std::nullopt if the read failed
+   */
+  std::optional<PerfReading> Read() const;
+
+ private:
+  static constexpr int kEvents = 4;
+  std::array<int, kEvents> fds_{-1, -1, -1, -1};
+
+  PerfCounters() = default;
+  bool Open();
+};
+
+/**
+ * @brief Enables counter sampling of the calling thread while in scope
+ *
+ * Stages measured with a PerfScope on this thread, including those inside
+ * the inference engine, are added to the stats. The frames are credited
+ * to each stage once, however often the stage runs under the guard, so
+ * per-frame averages hold for engines that loop over a batch. Sampling
+ * guards do not nest; a guard with stats == nullptr or frames == 0
+ * samples nothing.
+ *
+ * Usage:
+ * @code
+ * PerfSampling sampling(job.sampled ? stats : nullptr);
+ * {
+ *   PerfScope scope(PerfStage::kDecode);
+ *   Decode();
+ * }
+ * @endcode
+ */
+class PerfSampling {
+ public:
+  /**
+   * @brief Start sampling on this thread
+   *
+   * @param stats Receives the counters of each measured stage
+   * @param frames Frames processed together by the sampled stages
+   */
+  explicit PerfSampling(ServerStats* stats, uint32_t frames = 1);
+  ~PerfSampling();
+
+  PerfSampling(const PerfSampling&) = delete;
+  PerfSampling& operator=(const PerfSampling&) = delete;
+};
+
+/**
+ * @brief Measures one stage if the calling thread is sampling
+ *
+ * Costs one thread-local load when it is not. A sample is dropped if a
+ * read fails or the counters never ran on the PMU during the stage.
+ */
+class PerfScope {
+ public:
+  explicit PerfScope(PerfStage stage);
+  ~PerfScope();
+
+  PerfScope(const PerfScope&) = delete;
+  PerfScope& operator=(const PerfScope&) = delete;
+
+ private:
+  PerfStage stage_;
+  PerfCounters* counters_{nullptr};
+  std::optional<PerfReading> start_;
+};
+
+}  // namespace aa::server
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mpmc_queue.h"
+
+namespace aa::server {
+
+/**
+ * @brief Group of worker threads draining one bounded lock-free queue
+ *
+ * One stage of a processing pipeline: Submit() hands an item to the stage
+ * and every worker pops items and runs the handler on them. A worker takes
+ * one item, waiting if needed, plus whatever else is already queued up to
+ * max_batch items, so a stage with max_batch > 1 batches under load without
+ * ever waiting for a batch to fill. Each worker calls its own copy of the
+ * handler, which may therefore keep scratch state between calls.
+ *
+ * Stages are chained by submitting to the next stage from the handler.
+ * Destruction closes the queue, lets the workers drain it and joins them,
+ * so a stage must be destroyed before the stages it submits to.
+ *
+ * Usage:
+ * @code
+ * PipelineStage<Job*> stage(2, 16, 1, [&](std::vector<Job*>& jobs) {
+ *   for (auto* job : jobs) Process(job);
+ * });
+ * stage.Submit(&job);
+ * @endcode
+ *
+ * @tparam T Item type, typically a pointer to a job
+ *
+ * @threadsafe Submit() and TrySubmit() may be called concurrently
+ */
+template <typename T>
+class PipelineStage {
+ public:
+  /// @brief Processes a batch of items; must not throw
+  using Handler = std::function<void(std::vector<T>& items)>;
+
+  /**
+   * @brief Construct a stage and start its workers
+   *
+   * @param workers Number of worker threads (at least 1)
+   * @param capacity Items queued before Submit() waits
+   * @param max_batch Most items passed to one handler call (at least 1)
+   * @param handler Called by the workers with the items they took
+   */
+  PipelineStage(std::size_t workers, std::size_t capacity,
+                std::size_t max_batch, Handler handler)
+      : queue_{capacity}, max_batch_{std::max<std::size_t>(max_batch, 1)} {
+    workers = std::max<std::size_t>(workers, 1);
+    workers_.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+      workers_.emplace_back([this, handler] { Work(handler); });
+    }
+  }
+
+  /**
+   * @brief Drain the queue and join the workers
+   */
+  ~PipelineStage() {
+    queue_.Close();
+    workers_.clear();
+  }
+
+  PipelineStage(const PipelineStage&) = delete;
+  PipelineStage& operator=(const PipelineStage&) = delete;
+
+  /**
+   * @brief Hand an item to the stage, waiting for room if its queue is full
+   *
+   * @param item Item to process
+   * @return false if the stage is shutting down and the item was not taken
+   */
+  bool Submit(T item) { return queue_.Push(std::move(item)); }
+
+  /**
+   * @brief Hand an item to the stage if its queue has room, never waiting
+   *
+   * @param item Item to process
+   * @return false if the queue is full and the item was not taken
+   */
+  bool TrySubmit(T item) { return queue_.TryPush(item); }
+
+  /**
+   * @brief Number of worker threads
+   */
+  std::size_t Workers() const { return workers_.size(); }
+
+ private:
+  MpmcQueue<T> queue_;
+  const std::size_t max_batch_;
+  std::vector<std::jthread> workers_;
+
+  void Work(Handler handler) {
+    std::vector<T> items;
+    items.reserve(max_batch_);
+    T item{};
+    while (queue_.Pop(item)) {
+      items.clear();
+      items.push_back(std::move(item));
+      while (items.size() < max_batch_ && queue_.TryPop(item)) {
+        items.push_back(std::move(item));
+      }
+      handler(items);
+    }
+  }
+};
+
+}  // namespace aa::server
@@ -2,6 +2,7 @@
 
 #include <vector>
 
+#include "compiled_polygon.h"
 #include "polygon.h"
 #include "types.h"
 
@@ -13,7 +14,9 @@ namespace aa::server {
  * Provides sophisticated detection zone management with inclusion/exclusion
  * polygons, priority-based adjudication, and class-specific filtering.
  * Uses ray casting algorithm for point-in-polygon testing with 100%
- * accuracy compared to OpenCV's pointPolygonTest.
+ * accuracy compared to OpenCV's pointPolygonTest. Zones are compiled once
+ * in SetPolygons() (see CompiledPolygon), so a test costs O(log n) for
+ * convex zones and O(edges at the point's height) for the others.
  *
  * Features:
  * - Inclusion zones: Detect only specified classes within areas
@@ -36,9 +39,10 @@ class PolygonFilter {
    * @brief Draw filled bounding boxes for polygons
    *
    * @param frame Image frame to draw on
-   * @param polygons Vector of polygons to visualize
+   * @param scale Factor from polygon coordinates to frame coordinates, for
+   * drawing on a downscaled frame
    */
-  void DrawPolygonBoundingBoxes(cv::Mat& frame) const;
+  void DrawPolygonBoundingBoxes(cv::Mat& frame, double scale = 1.0) const;
 
   /**
    * @brief Filter detections based on polygon rules
@@ -50,16 +54,39 @@ class PolygonFilter {
   std::vector<aa::shared::Detection> FilterDetectionsByPolygons(
       const std::vector<aa::shared::Detection>& detections);
 
-  void SetPolygons(std::vector<aa::shared::Polygon>&& polygons);
+  /**
+   * @brief Filter detections into a caller-owned vector
+   *
+   * Does not allocate once filtered and the internal scratch buffer have
+   * grown to their steady-state size.
+   *
+   * @param detections Input detections to filter
+   * @param filtered Cleared and filled with the kept detections
+   */
+  void FilterDetectionsByPolygons(
+      const std::vector<aa::shared::Detection>& detections,
+      std::vector<aa::shared::Detection>& filtered);
+
+  /**
+   * @brief Replace the zones and compile them for point queries
+   *
+   * @param polygons Zones to filter by
+   * @param tolerance Simplification tolerance in pixels (0 = exact)
+   */
+  void SetPolygons(std::vector<aa::shared::Polygon>&& polygons,
+                   double tolerance = 0.0);
 
  private:
   std::vector<aa::shared::Polygon> polygons_;
+  std::vector<CompiledPolygon> compiled_;  ///< Parallel to polygons_
+  std::vector<const aa::shared::Polygon*> containing_;  ///< Scratch buffer
 
   std::pair<double, double> GetDetectionCenter(
       const aa::shared::Detection& detection);
 
-  std::vector<const aa::shared::Polygon*> FindContainingPolygons(
-      double center_x, double center_y);
+  void FindContainingPolygons(
+      double center_x, double center_y,
+      std::vector<const aa::shared::Polygon*>& containing_polygons);
 
   bool ShouldIncludeDetection(
       const aa::shared::Detection& detection,
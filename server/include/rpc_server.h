@@ -8,6 +8,7 @@
 #include <grpcpp/health_check_service_interface.h>
 
 #include "logging.h"
+#include "transport_profile.h"
 // #include "manual_reset_event.h"
 
 namespace aa::server {
@@ -48,11 +49,16 @@ class RpcServerFromThis {
    *
    * @param address Server address in format "host:port" (e.g.,
    * "localhost:50051")
+   * @param transport Window, message size, keepalive, poller, quota and
+   * compression settings applied when the server is built
    *
    * Automatically enables default health check service and proto reflection.
    */
-  constexpr explicit RpcServerFromThis(std::string_view address)
-      : address_{address}, service_impl_{static_cast<Impl&>(*this)} {
+  constexpr explicit RpcServerFromThis(
+      std::string_view address, aa::shared::TransportProfile transport = {})
+      : address_{address},
+        transport_{std::move(transport)},
+        service_impl_{static_cast<Impl&>(*this)} {
     grpc::EnableDefaultHealthCheckService(true);
     grpc::reflection::InitProtoReflectionServerBuilderPlugin();
   }
@@ -61,11 +67,15 @@ class RpcServerFromThis {
    * @brief Build and start the gRPC server
    *
    * Creates the server with insecure credentials and registers the service.
-   * Must be called before Wait().
+   * The transport profile is applied to the builder. The port is bound
+   * with SO_REUSEPORT so several worker processes can listen on the same
+   * address. Must be called before Wait().
    */
   void Build() {
     grpc::ServerBuilder builder;
 
+    builder.AddChannelArgument(GRPC_ARG_ALLOW_REUSEPORT, 1);
+    transport_.ApplyTo(builder);
     builder.AddListeningPort(address_, grpc::InsecureServerCredentials());
     builder.RegisterService(&service_impl_);
 
@@ -103,6 +113,7 @@ class RpcServerFromThis {
 
  private:
   std::string address_;  ///< Server listening address
+  aa::shared::TransportProfile transport_;  ///< Transport tuning
   Impl& service_impl_;   ///< Reference to derived service implementation
   std::unique_ptr<grpc::Server> server_;  ///< gRPC server instance
 };
@@ -164,7 +175,37 @@ class Observable {
  protected:
   constexpr Observable() = default;
   template <size_t ObserverId, typename... Args>
-  grpc::Status Invoke(grpc::ServerContext* ctx, Args&&... args) const {
+  grpc::Status Invoke(grpc::ServerContextBase* ctx, Args&&... args) const {
+    auto status = CanInvoke<ObserverId>(ctx);
+    if (!status.ok()) return status;
+
+    return std::get<ObserverId>(methods_).method_(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Invoke an asynchronous method, which reports through done
+   *
+   * done is called exactly once: here if the call cannot be started,
+   * otherwise by the handler, possibly on another thread after Invoke
+   * returned.
+   */
+  template <size_t ObserverId, typename... Args>
+  void InvokeAsync(grpc::ServerContextBase* ctx,
+                   std::function<void(grpc::Status)> done,
+                   Args&&... args) const {
+    auto status = CanInvoke<ObserverId>(ctx);
+    if (!status.ok()) {
+      done(std::move(status));
+      return;
+    }
+
+    std::get<ObserverId>(methods_).method_(std::forward<Args>(args)...,
+                                           std::move(done));
+  }
+
+ private:
+  template <size_t ObserverId>
+  grpc::Status CanInvoke(grpc::ServerContextBase* ctx) const {
     using grpc::Status;
     using grpc::StatusCode;
 
@@ -172,18 +213,42 @@ class Observable {
       return {StatusCode::CANCELLED,
               "deadline exceeded or client cancelled, abandoning."};
 
-    return std::get<ObserverId>(methods_).method_(std::forward<Args>(args)...);
+    if (!std::get<ObserverId>(methods_).method_)
+      return {StatusCode::UNIMPLEMENTED, "method has no registered handler"};
+
+    return Status::OK;
   }
 
- private:
   ObserverTable methods_;
 };
 
 template <typename Request, typename Response>
 using ServiceMethod = Observer<grpc::Status(const Request*, Response*)>;
 
+/**
+ * @brief Asynchronous unary method whose handler writes the serialized
+ * response itself
+ *
+ * Used for responses carrying large payloads that are handed to gRPC as
+ * separate slices instead of being copied into a protobuf message. The
+ * handler returns without waiting for the result and calls the completion
+ * callback once, from any thread; request and response stay valid until
+ * then.
+ */
+template <typename Request>
+using ServiceRawMethod = Observer<void(
+    const Request*, grpc::ByteBuffer*, std::function<void(grpc::Status)>)>;
+
 template <typename Request, typename Response>
 using ServiceStream =
     Observer<grpc::Status(grpc::ServerReader<Request>*, Response*)>;
 
+template <typename Request, typename Response>
+using ServiceServerStream =
+    Observer<grpc::Status(const Request*, grpc::ServerWriter<Response>*)>;
+
+template <typename Request, typename Response>
+using ServiceBidiStream =
+    Observer<grpc::Status(grpc::ServerReaderWriter<Response, Request>*)>;
+
 }  // namespace aa::server
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "perf_counters.h"
+
+namespace aa::server {
+
+/**
+ * @brief Hardware counter totals of one stage over the sampled frames
+ */
+struct PerfStageSnapshot {
+  uint64_t frames{0};  ///< Sampled frames
+  uint64_t cycles{0};
+  uint64_t instructions{0};
+  uint64_t llc_misses{0};
+  uint64_t branch_misses{0};
+  uint64_t time_ns{0};
+
+  PerfStageSnapshot& operator+=(const PerfStageSnapshot& other);
+};
+
+/**
+ * @brief Point-in-time copy of server counters
+ */
+struct ServerStatsSnapshot {
+  uint64_t requests{0};    ///< Frames processed (successful or not)
+  uint64_t failures{0};    ///< Frames that failed processing
+  uint64_t detections{0};  ///< Detections returned after filtering
+  uint64_t busy_ns{0};     ///< Total processing time in nanoseconds
+  std::array<PerfStageSnapshot, kPerfStageCount> stages{};  ///< By PerfStage
+
+  /**
+   * @brief Mean processing time per request in milliseconds
+   */
+  double MeanLatencyMs() const;
+
+  /**
+   * @brief Per-stage hardware counter summary, one line per sampled stage
+   *
+   * Reports cycles per frame, instructions per cycle, and LLC and branch
+   * misses per thousand instructions. Empty if no frame was sampled.
+   */
+  std::string StagesToString() const;
+
+  /**
+   * @brief Accumulate another snapshot (used to aggregate workers)
+   */
+  ServerStatsSnapshot& operator+=(const ServerStatsSnapshot& other);
+
+  /**
+   * @brief One-line human-readable summary for logs
+   */
+  std::string ToString() const;
+};
+
+/**
+ * @brief Lock-free request counters of a detector server
+ *
+ * Only holds lock-free atomics and no pointers, so an instance can live in
+ * anonymous shared memory: the pre-fork supervisor maps one block per
+ * worker before forking and reads all of them to aggregate metrics.
+ *
+ * @threadsafe All methods are safe to call concurrently, also across
+ * processes sharing the memory
+ */
+struct ServerStats {
+  std::atomic<uint64_t> requests{0};
+  std::atomic<uint64_t> failures{0};
+  std::atomic<uint64_t> detections{0};
+  std::atomic<uint64_t> busy_ns{0};
+
+  /// @brief Hardware counter sums of one stage
+  struct StageCounters {
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> cycles{0};
+    std::atomic<uint64_t> instructions{0};
+    std::atomic<uint64_t> llc_misses{0};
+    std::atomic<uint64_t> branch_misses{0};
+    std::atomic<uint64_t> time_ns{0};
+  };
+  std::array<StageCounters, kPerfStageCount> stages;
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "ServerStats must be lock-free to be shared across processes");
+
+  /**
+   * @brief Record one processed request
+   *
+   * @param ok Whether processing succeeded
+   * @param elapsed Processing time
+   */
+  void Record(bool ok, std::chrono::nanoseconds elapsed);
+
+  /**
+   * @brief Count detections returned to a client
+   * @param count Number of detections
+   */
+  void AddDetections(uint64_t count);
+
+  /**
+   * @brief Add the hardware counters of one sampled stage
+   *
+   * @param stage Measured stage
+   * @param delta Counter difference over the stage
+   * @param frames Frames processed by the stage in that time
+   */
+  void RecordStage(PerfStage stage, const PerfReading& delta,
+                   uint32_t frames);
+
+  /**
+   * @brief Take a relaxed snapshot of all counters
+   */
+  ServerStatsSnapshot Snapshot() const;
+};
+
+}  // namespace aa::server
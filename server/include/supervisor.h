@@ -0,0 +1,137 @@
+#pragma once
+
+#include <sched.h>
+#include <signal.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "server_stats.h"
+
+namespace aa::server {
+
+/**
+ * @brief Pre-fork supervisor running the detector in worker processes
+ *
+ * Forks N worker processes that each run a complete detector server. All
+ * workers listen on the same address: gRPC binds with SO_REUSEPORT and the
+ * kernel load-balances incoming connections across them. Each worker is
+ * pinned to its own slice of the cores the supervisor may run on (its
+ * sched_getaffinity set, so taskset and cgroup cpusets are respected), so
+ * OpenCV DNN global state and allocator arenas are never shared between
+ * workers.
+ *
+ * The supervisor restarts workers that exit unexpectedly and aggregates
+ * their request counters, which live in a shared memory block mapped
+ * before the first fork. A worker that dies within a second of starting
+ * is restarted a second later; the wait is a deadline of the poll loop,
+ * so signals and the other workers are still handled meanwhile.
+ *
+ * Run() handles SIGINT and SIGTERM (stop) and SIGUSR1 (log stats) itself
+ * through a signalfd, so the supervisor needs no signal thread and stays
+ * single-threaded whenever it forks, restarts included. Locks a forked
+ * child inherits can then never be held by a thread that no longer
+ * exists. Before handing over to the worker, the child only makes
+ * async-signal-safe calls: it restores the signal mask and pins its cores.
+ *
+ * Usage:
+ * @code
+ * Supervisor supervisor(4, 0, [&](int index, ServerStats* stats) {
+ *   return RunWorker(options, stats);
+ * });
+ * return supervisor.Run();  // Until SIGINT or SIGTERM
+ * @endcode
+ *
+ * @threadsafe Stop(), Aggregate() and LogStats() may be called from other
+ * threads while Run() is blocked
+ */
+class Supervisor {
+ public:
+  /**
+   * @brief Entry point executed in each worker process
+   *
+   * Receives the worker index and the worker's shared stats block and
+   * returns the process exit code.
+   */
+  using WorkerMain = std::function<int(int index, ServerStats* stats)>;
+
+  /**
+   * @brief Construct a supervisor
+   *
+   * @param workers Number of worker processes (at least 1)
+   * @param cpus_per_worker Cores pinned per worker (0 = split evenly)
+   * @param worker_main Function run in each worker process
+   * @throws std::runtime_error if the shared stats block or the wake-up
+   * eventfd cannot be created
+   */
+  Supervisor(int workers, int cpus_per_worker, WorkerMain worker_main);
+
+  /**
+   * @brief Unmap the shared stats block and close the wake-up eventfd
+   */
+  ~Supervisor();
+
+  // Disable copy and move: worker bookkeeping is tied to this instance
+  Supervisor(const Supervisor&) = delete;
+  Supervisor& operator=(const Supervisor&) = delete;
+
+  /**
+   * @brief Spawn the workers and supervise them until Stop()
+   *
+   * Blocks SIGINT, SIGTERM, SIGUSR1 and SIGCHLD in the calling thread and
+   * handles them until it returns. Call it from the only thread of the
+   * process, so that no other thread can receive these signals or run
+   * during fork().
+   *
+   * @return int 0 after a clean shutdown, 1 if workers could not be spawned
+   */
+  int Run();
+
+  /**
+   * @brief Request shutdown: forward SIGTERM to all workers and wake Run()
+   */
+  void Stop();
+
+  /**
+   * @brief Aggregate counters of all workers
+   */
+  ServerStatsSnapshot Aggregate() const;
+
+  /**
+   * @brief Log aggregated and per-worker counters
+   */
+  void LogStats() const;
+
+ private:
+  int workers_;
+  int cpus_per_worker_;
+  WorkerMain worker_main_;
+
+  ServerStats* stats_{nullptr};  ///< One block per worker, shared memory
+  std::vector<pid_t> pids_;      ///< Worker PIDs, 0 when not running
+  std::vector<std::chrono::steady_clock::time_point> started_;
+  /// Pending restart of each worker, touched by the Run() thread only
+  std::vector<std::optional<std::chrono::steady_clock::time_point>>
+      restart_at_;
+  std::atomic<bool> stopping_{false};
+  mutable std::mutex mutex_;  ///< Guards pids_, never held across fork()
+
+  int wake_fd_{-1};    ///< eventfd written by Stop() to wake Run()
+  int signal_fd_{-1};  ///< signalfd of Run(), -1 outside Run()
+
+  pid_t SpawnWorker(int index, const sigset_t& worker_mask);
+  void ReapWorkers();
+  bool RestartWorkers(const sigset_t& worker_mask);
+  int PollTimeoutMs() const;
+  cpu_set_t WorkerCpus(int index) const;
+  int FindWorker(pid_t pid) const;
+  bool HasLiveWorkers() const;
+  bool HasPendingRestarts() const;
+};
+
+}  // namespace aa::server
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "inference_engine.h"
+#include "options.h"
+#include "polygon.h"
+
+namespace aa::server {
+
+/**
+ * @brief Settings of an offline video job
+ */
+struct VideoJobOptions {
+  std::string input;   ///< Video file to process
+  std::string output;  ///< CSV file receiving the per-frame detections
+  std::string zones;   ///< Text-format PolygonSet file (empty = whole frame)
+  int segments{1};     ///< Parts of the file decoded in parallel
+  int batch_size{8};   ///< Frames per inference batch
+  double zone_tolerance{0.0};  ///< Zone simplification tolerance (pixels)
+  std::chrono::milliseconds progress_interval{5000};  ///< Progress log period
+
+  /**
+   * @brief Build job settings from command line options
+   *
+   * Reads job, job_output, zones, segments, batch and zone_tolerance.
+   *
+   * @param options Parsed command line options
+   * @return VideoJobOptions Job settings
+   */
+  static VideoJobOptions FromOptions(const aa::shared::Options& options);
+};
+
+/**
+ * @brief Totals of a finished video job
+ */
+struct VideoJobStats {
+  uint64_t frames{0};      ///< Frames decoded and processed
+  uint64_t detections{0};  ///< Detections written after zone filtering
+  uint64_t batches{0};     ///< Inference batches run
+  double seconds{0.0};     ///< Wall time of the job
+
+  /**
+   * @brief Processed frames per second of wall time
+   */
+  double FramesPerSecond() const;
+
+  /**
+   * @brief One-line human-readable summary for logs
+   */
+  std::string ToString() const;
+};
+
+/**
+ * @brief Offline detection over a local video file, as fast as possible
+ *
+ * Splits the file into segments by frame count and decodes them on one
+ * thread each, seeking every decoder to the start of its segment. Decoded
+ * frames meet in a bounded queue that never drops frames; the calling
+ * thread takes them in batches, runs InferenceEngine::InferenceBatch and
+ * filters the detections through the zones with PolygonFilter.
+ *
+ * Detections are written as CSV rows (frame, timestamp_ms, class_id,
+ * confidence, x, y, width, height) in frame order; frames without
+ * detections have no rows. Each segment is written to a part file next to
+ * the output while the job runs, and the parts are joined at the end.
+ *
+ * Streams and files without a frame count are decoded as one segment.
+ *
+ * Usage:
+ * @code
+ * VideoJob job(engine, VideoJobOptions::FromOptions(options));
+ * VideoJobStats stats;
+ * if (!job.Run(&stats)) return 1;
+ * @endcode
+ */
+class VideoJob {
+ public:
+  /**
+   * @brief Construct a job
+   *
+   * @param engine Detector running the batches, used by Run() only
+   * @param options Job settings
+   * @param budget Detection budget applied to every frame
+   */
+  VideoJob(InferenceEngine& engine, VideoJobOptions options,
+           DetectionBudget budget = {});
+
+  /**
+   * @brief Process the whole input file
+   *
+   * @param stats Receives the job totals (nullptr = not reported)
+   * @return true if every frame was processed and the output written
+   */
+  bool Run(VideoJobStats* stats = nullptr);
+
+ private:
+  InferenceEngine& engine_;
+  VideoJobOptions options_;
+  DetectionBudget budget_;
+};
+
+/**
+ * @brief Read detection zones from a text-format PolygonSet file
+ *
+ * Zones of UNSPECIFIED type are skipped with a warning.
+ *
+ * @param path Zone file path
+ * @param zones Receives the zones
+ * @return true if the file was read and parsed
+ */
+bool LoadZones(const std::string& path,
+               std::vector<aa::shared::Polygon>& zones);
+
+}  // namespace aa::server
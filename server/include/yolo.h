@@ -4,8 +4,11 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
 
+#include "inference_engine.h"
+#include "nms.h"
 #include "options.h"
 #include "types.h"
+#include "yolo_decoder.h"
 
 namespace aa::server {
 
@@ -13,14 +16,20 @@ namespace aa::server {
  * @brief YOLO object detection neural network inference engine
  *
  * Provides real-time object detection using YOLO neural networks with
- * support for multiple model formats (YOLOv7, YOLOv10, YOLOv11, YOLOX).
+ * support for YOLOX, YOLOv5 and YOLOv8-style output layouts, detected from
+ * the output shape or selected with --layout.
  * Handles preprocessing, inference, and postprocessing with OpenCV DNN.
  *
  * Features:
  * - Multi-YOLO model support (.onnx, .weights+.cfg)
+ * - ONNX models parsed straight from a read-only mapping of the file
  * - Letterboxing preprocessing for aspect ratio preservation
- * - Non-Maximum Suppression (NMS) for duplicate filtering
- * - COCO dataset class support (80 classes)
+ * - Optional 8-bit input blobs (--input_u8): preprocessing only resizes,
+ *   pads and copies bytes, and the network's input layer converts them to
+ *   float with the scale and mean in a single pass
+ * - Class-aware batched Non-Maximum Suppression (hard or soft)
+ * - Class count and labels from the model, a label file, or COCO; the
+ *   class count is checked against the labels when the model is loaded
  * - Real-time performance optimization
  *
  * @yolo Compatible with YOLO model architectures
@@ -29,7 +38,7 @@ namespace aa::server {
  * @performance Optimized for CPU inference (~100-200ms per frame)
  * @memorysafe Input validation and bounds checking
  */
-class Yolo {
+class Yolo final : public InferenceEngine {
  public:
   /**
    * @brief Construct YOLO inference engine with configuration options
@@ -49,7 +58,7 @@ class Yolo {
   /**
    * @brief Default destructor with automatic cleanup
    */
-  ~Yolo() = default;
+  ~Yolo() override = default;
 
   /**
    * @brief Perform object detection inference on input image
@@ -61,13 +70,38 @@ class Yolo {
    * @param input Input image in OpenCV Mat format (any size, BGR)
    * @param detections Output vector of detected objects with bounding boxes,
    *                   class IDs, and confidence scores
+   * @param budget Per-request detection budget applied during decode
    * @yolo Compatible with all supported YOLO model formats
    * @coco Returns COCO dataset class IDs (0-79)
    * @performance Optimized for real-time CPU inference
    * @memorysafe Input validation and bounds checking
    */
   void Inference(cv::Mat& input,
-                 std::vector<aa::shared::Detection>& detections);
+                 std::vector<aa::shared::Detection>& detections,
+                 const DetectionBudget& budget = {}) override;
+
+  /**
+   * @brief Perform object detection on a batch of images
+   *
+   * Letterboxes all images into one blob and runs a single forward pass.
+   * Models exported with a fixed batch size of one reject the blob; the
+   * engine then logs it once and processes images one by one from then on.
+   *
+   * @param inputs Input images (any sizes, BGR)
+   * @param detections Detections of each image in its own coordinates
+   * @param budget Per-request detection budget applied during decode
+   */
+  void InferenceBatch(
+      std::vector<cv::Mat>& inputs,
+      std::vector<std::vector<aa::shared::Detection>>& detections,
+      const DetectionBudget& budget = {}) override;
+
+  /**
+   * @brief Describe the letterboxed input of the model
+   *
+   * Reports --width, --height, --padvalue and --rgb.
+   */
+  ModelInfo GetModelInfo() const override;
 
   /**
    * @brief Draw detection bounding boxes on image for visualization
@@ -78,11 +112,14 @@ class Yolo {
    *
    * @param img Input/output image to draw on (modified in-place)
    * @param detections Vector of detections to visualize
+   * @param scale Factor from detection coordinates to img coordinates, for
+   * drawing on a downscaled frame
    * @opencv Uses OpenCV drawing functions for rendering
    * @coco Displays COCO class names with confidence scores
    */
-  void DrawBoundingBoxes(
-      cv::Mat& img, const std::vector<aa::shared::Detection>& detections) const;
+  void DrawBoundingBoxes(cv::Mat& img,
+                         const std::vector<aa::shared::Detection>& detections,
+                         double scale = 1.0) const override;
 
  private:
   cv::dnn::Net net_;
@@ -95,15 +132,54 @@ class Yolo {
   int input_height_;
 
   float thr_;
-  float nms_;
   float padding_value_;
   bool swap_rb_;
+  bool input_u8_;  ///< Blobs stay 8-bit, the net input layer normalizes
 
   cv::Size input_size_;
+  bool batching_{true};  ///< Cleared when the model rejects batched input
+
+  Nms nms_engine_;
+  NmsCandidates candidates_;
+  std::vector<int> keep_;
+
+  YoloFamily family_{YoloFamily::kAuto};
+  YoloDecoder decoder_;
+  std::vector<std::string> labels_;
 
   void Initialize();
+  void ResolveLayout(const std::vector<int>& shape);
   auto PreProcess();
-  auto PostProcess(std::vector<cv::Mat>& outs);
+  void SetInput(const cv::Mat& blob);
+  auto PostProcess(std::vector<cv::Mat>& outs, const DetectionBudget& budget);
 };
 
+/**
+ * @brief Blob parameters turning a frame into network input
+ *
+ * With input_u8 the blob keeps 8-bit pixels and carries neither scale nor
+ * mean; SetNetInput() hands those to the net, whose input layer applies
+ * them while converting to float.
+ *
+ * @param scale Scale applied after the mean is subtracted
+ * @param mean Mean subtracted from every channel
+ * @param size Network input size, reached by letterboxing
+ * @param swap_rb Swap the red and blue channels
+ * @param pad_value Value of the letterbox padding
+ * @param input_u8 Keep the blob 8-bit
+ */
+cv::dnn::Image2BlobParams MakeBlobParams(const cv::Scalar& scale,
+                                         const cv::Scalar& mean,
+                                         const cv::Size& size, bool swap_rb,
+                                         float pad_value, bool input_u8);
+
+/**
+ * @brief Set a blob made with MakeBlobParams() as the network input
+ *
+ * Both forms give the network the same float input.
+ */
+void SetNetInput(cv::dnn::Net& net, const cv::Mat& blob,
+                 const cv::Scalar& scale, const cv::Scalar& mean,
+                 bool input_u8);
+
 }  // namespace aa::server
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "inference_engine.h"
+#include "nms.h"
+
+namespace aa::server {
+
+/**
+ * @brief YOLO model family selecting the output tensor layout
+ */
+enum class YoloFamily {
+  kAuto = 0,    ///< Detect the layout from the output shape
+  kYolox = 1,   ///< [1, anchors, 4 + 1 + nc], with objectness
+  kYolov5 = 2,  ///< [1, anchors, 4 + 1 + nc], with objectness
+  kYolov8 = 3   ///< [1, 4 + nc, anchors], transposed, no objectness
+};
+
+/**
+ * @brief Parse a YOLO family name ("auto", "yolox", "yolov5", "yolov8")
+ *
+ * @param name Family name
+ * @param family Output family, untouched on failure
+ * @return true if the name is a known family
+ */
+bool ParseYoloFamily(std::string_view name, YoloFamily& family);
+
+/**
+ * @brief Descriptor of a detection head output tensor
+ *
+ * Boxes are always (cx, cy, w, h) in network input pixels, followed by an
+ * optional objectness score and one score per class. Row layouts keep the
+ * attributes of one anchor contiguous; transposed layouts keep one
+ * attribute of all anchors contiguous.
+ */
+struct OutputLayout {
+  YoloFamily family{YoloFamily::kAuto};  ///< Resolved model family
+  bool transposed{false};                ///< [1, attrs, anchors] when true
+  bool has_objectness{true};             ///< Objectness after the box
+  int num_classes{0};                    ///< Number of class scores
+  int num_anchors{0};                    ///< Number of predictions
+
+  /**
+   * @brief Offset of the first class score within the attributes
+   */
+  int ClassOffset() const { return has_objectness ? 5 : 4; }
+
+  /**
+   * @brief Number of attributes per anchor
+   */
+  int Attributes() const { return ClassOffset() + num_classes; }
+
+  /**
+   * @brief Resolve the layout of a network output
+   *
+   * @param family Requested family, kAuto to detect from the shape
+   * @param output Output tensor of shape [1, d1, d2]
+   * @param num_classes_hint Expected class count (0 = infer from shape)
+   * @return OutputLayout Resolved layout
+   * @throws cv::Exception if the shape does not match the family or hint
+   */
+  static OutputLayout Resolve(YoloFamily family, const cv::Mat& output,
+                              int num_classes_hint = 0);
+
+  /**
+   * @brief Resolve the layout of an output shape, e.g. from shape inference
+   *
+   * @param family Requested family, kAuto to detect from the shape
+   * @param shape Output shape [1, d1, d2]
+   * @param num_classes_hint Expected class count (0 = infer from shape)
+   * @return OutputLayout Resolved layout
+   * @throws cv::Exception if the shape does not match the family or hint
+   */
+  static OutputLayout Resolve(YoloFamily family, const std::vector<int>& shape,
+                              int num_classes_hint = 0);
+
+  /**
+   * @brief Human-readable description for logging
+   */
+  std::string ToString() const;
+};
+
+/**
+ * @brief Decoder of YOLO outputs into NMS candidates
+ *
+ * Decoding is template-specialized on the layout (row or transposed, with
+ * or without objectness) and on the class count, with COCO's 80 classes
+ * compiled as a fixed trip count so the per-anchor score scan vectorizes.
+ * Other class counts use the runtime-sized instantiation. The matching
+ * specialization is selected once when the decoder is constructed.
+ *
+ * Transposed outputs are scanned class row by class row, keeping a running
+ * best score per anchor, which turns the scan into contiguous
+ * element-wise max operations.
+ *
+ * @threadsafe Not thread-safe; scratch buffers are reused between calls
+ */
+class YoloDecoder {
+ public:
+  YoloDecoder() = default;
+
+  /**
+   * @brief Construct a decoder for the given layout
+   * @param layout Resolved output layout
+   */
+  explicit YoloDecoder(OutputLayout layout);
+
+  /**
+   * @brief Decode one output tensor, appending candidates
+   *
+   * @param output Output tensor matching the layout (CV_32F, continuous)
+   * @param threshold Minimum final score (objectness * class score)
+   * @param whitelist Classes to consider (empty = all)
+   * @param candidates Candidate buffer to append to
+   */
+  void Decode(const cv::Mat& output, float threshold,
+              const std::vector<int32_t>& whitelist,
+              NmsCandidates& candidates);
+
+  const OutputLayout& GetLayout() const { return layout_; }
+  bool IsValid() const { return decode_ != nullptr; }
+
+ private:
+  using DecodeFn = void (*)(const float* data, const OutputLayout& layout,
+                            float threshold,
+                            const std::vector<int32_t>& whitelist,
+                            NmsCandidates& candidates,
+                            std::vector<float>& best_score,
+                            std::vector<int32_t>& best_class);
+
+  OutputLayout layout_;
+  DecodeFn decode_{nullptr};
+  std::vector<float> best_score_;
+  std::vector<int32_t> best_class_;
+};
+
+/**
+ * @brief Decode network outputs and suppress them within a request budget
+ *
+ * The budget raises the score threshold, restricts decoding to its class
+ * whitelist and lowers the number of kept boxes below the NMS engine's own
+ * max_detections.
+ *
+ * @param decoder Decoder of the model's output layout
+ * @param nms NMS engine with the server-wide options
+ * @param outs Network outputs, decoded in turn
+ * @param threshold Server score threshold
+ * @param budget Per-request detection budget
+ * @param candidates Scratch candidate buffer, cleared first
+ * @param keep Output indices into candidates, in descending score order
+ */
+void DecodeWithinBudget(YoloDecoder& decoder, Nms& nms,
+                        const std::vector<cv::Mat>& outs, float threshold,
+                        const DetectionBudget& budget,
+                        NmsCandidates& candidates, std::vector<int>& keep);
+
+/**
+ * @brief Load class labels from a text file, one label per line
+ *
+ * Blank lines are skipped.
+ *
+ * @param path Label file path
+ * @return std::vector<std::string> Labels indexed by class ID
+ * @throws std::runtime_error if the file cannot be opened
+ */
+std::vector<std::string> LoadLabelsFromFile(const std::string& path);
+
+/**
+ * @brief Load class labels embedded in an ONNX model
+ *
+ * Reads the "names" entry of the model's metadata_props, written by
+ * Ultralytics exports as a "{0: 'person', 1: 'bicycle', ...}" dictionary.
+ * Only the top-level fields of the ModelProto are walked; the graph and
+ * its weights are skipped by length without being read.
+ *
+ * @param model Serialized ONNX model, e.g. a ModelBuffer
+ * @return std::vector<std::string> Labels, empty if none are embedded or
+ * the model cannot be parsed
+ */
+std::vector<std::string> LoadLabelsFromModel(std::string_view model);
+
+}  // namespace aa::server
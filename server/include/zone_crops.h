@@ -0,0 +1,97 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "nms.h"
+#include "options.h"
+#include "polygon.h"
+#include "types.h"
+
+namespace aa::server {
+
+/**
+ * @brief Tunables of per-zone inference crops
+ */
+struct ZoneCropOptions {
+  int max_crops{4};               ///< Crops per frame (0 = disabled)
+  cv::Size input_size{640, 640};  ///< Model input size
+  float min_gain{1.25f};          ///< Magnification a crop must add
+  NmsOptions nms;                 ///< Merge suppression across scales
+
+  /**
+   * @brief Build crop options from command line options
+   *
+   * Reads zone_crops, width and height, and the NMS options.
+   *
+   * @param options Parsed command line options
+   * @return ZoneCropOptions Crop configuration
+   */
+  static ZoneCropOptions FromOptions(const aa::shared::Options& options);
+};
+
+/**
+ * @brief Select the regions of a frame that get an inference pass of their
+ * own
+ *
+ * Takes the bounding rectangle of every inclusion zone that requests an
+ * inference crop, clipped to the frame. A crop is kept only if letterboxing
+ * it to the model input magnifies it at least min_gain times more than the
+ * full frame; larger zones are already seen well by the full-frame pass.
+ * At most max_crops crops are kept, in zone order.
+ *
+ * @param zones Zones of the request
+ * @param frame_size Size of the frame
+ * @param options Crop configuration
+ * @param crops Receives the crop rectangles in frame coordinates
+ */
+void SelectZoneCrops(const std::vector<aa::shared::Polygon>& zones,
+                     const cv::Size& frame_size,
+                     const ZoneCropOptions& options,
+                     std::vector<cv::Rect>& crops);
+
+/**
+ * @brief Merges the detections of zone crops into those of the full frame
+ *
+ * Crop detections are moved into frame coordinates and pooled with the
+ * full-frame detections, then class-aware hard NMS keeps the best box of
+ * every object seen at both scales. Boxes touching a crop edge that lies
+ * inside the frame are cut off by the crop and are dropped; the full-frame
+ * pass sees those objects whole.
+ *
+ * @threadsafe Not thread-safe; owns reused scratch buffers
+ */
+class ZoneCropMerger {
+ public:
+  /**
+   * @brief Construct a merger
+   * @param options Crop configuration
+   */
+  explicit ZoneCropMerger(const ZoneCropOptions& options = {});
+
+  /**
+   * @brief Merge crop detections into the frame detections
+   *
+   * @param frame_size Size of the frame
+   * @param crops Crop rectangles in frame coordinates
+   * @param crop_detections Detections of each crop in crop coordinates
+   * @param max_detections Cap on merged detections (0 = server default)
+   * @param detections Full-frame detections, replaced by the merged set in
+   * descending confidence order
+   */
+  void Merge(const cv::Size& frame_size, std::span<const cv::Rect> crops,
+             std::span<const std::vector<aa::shared::Detection>>
+                 crop_detections,
+             int max_detections,
+             std::vector<aa::shared::Detection>& detections);
+
+ private:
+  Nms nms_;
+  NmsCandidates candidates_;
+  std::vector<int> keep_;
+  std::vector<aa::shared::Detection> merged_;
+};
+
+}  // namespace aa::server
@@ -0,0 +1,313 @@
+#include "compiled_polygon.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Same tolerance as aa::shared::Polygon::Contains
+constexpr double kEpsilon = 1e-10;
+
+/**
+ * @brief Cross product of (a - o) and (b - o)
+ */
+double Cross(const cv::Point2d& o, const cv::Point2d& a, const cv::Point2d& b) {
+  return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+/**
+ * @brief Distance from a point to the segment from a to b
+ */
+double SegmentDistance(const cv::Point2d& p, const cv::Point2d& a,
+                       const cv::Point2d& b) {
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  double length2 = dx * dx + dy * dy;
+  double t = 0.0;
+  if (length2 > 0.0) {
+    t = std::clamp(((p.x - a.x) * dx + (p.y - a.y) * dy) / length2, 0.0, 1.0);
+  }
+  return std::hypot(p.x - (a.x + t * dx), p.y - (a.y + t * dy));
+}
+
+/**
+ * @brief Check whether a point lies on a segment, as Polygon does
+ */
+bool IsPointOnSegment(double px, double py, const cv::Point2d& a,
+                      const cv::Point2d& b) {
+  if (px < std::min(a.x, b.x) - kEpsilon ||
+      px > std::max(a.x, b.x) + kEpsilon ||
+      py < std::min(a.y, b.y) - kEpsilon ||
+      py > std::max(a.y, b.y) + kEpsilon) {
+    return false;
+  }
+  return std::abs((b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x)) <
+         kEpsilon;
+}
+
+/**
+ * @brief Drop consecutive duplicate vertices, including the closing one
+ */
+std::vector<cv::Point2d> RemoveDuplicates(
+    const std::vector<aa::shared::Point>& vertices) {
+  std::vector<cv::Point2d> points;
+  points.reserve(vertices.size());
+  for (const auto& vertex : vertices) {
+    cv::Point2d point(vertex.GetX(), vertex.GetY());
+    if (points.empty() || !(points.back() == point)) {
+      points.push_back(point);
+    }
+  }
+  while (points.size() > 1 && points.back() == points.front()) {
+    points.pop_back();
+  }
+  return points;
+}
+
+/**
+ * @brief Douglas-Peucker simplification of a closed outline, in place
+ *
+ * The ring is split at the first vertex and the vertex farthest from it,
+ * both of which are kept, and each half is simplified on its own. Leaves
+ * the outline unchanged if fewer than 3 vertices would remain.
+ */
+void Simplify(std::vector<cv::Point2d>& points, double tolerance) {
+  const std::size_t n = points.size();
+  if (n < 4) return;
+
+  std::size_t farthest = 0;
+  double farthest_distance = 0.0;
+  for (std::size_t i = 1; i < n; ++i) {
+    double distance = std::hypot(points[i].x - points[0].x,
+                                 points[i].y - points[0].y);
+    if (distance > farthest_distance) {
+      farthest = i;
+      farthest_distance = distance;
+    }
+  }
+
+  std::vector<char> keep(n, 0);
+  keep[0] = 1;
+  keep[farthest] = 1;
+  std::size_t kept = 2;
+  // Index n stands for vertex 0, closing the ring
+  std::vector<std::pair<std::size_t, std::size_t>> ranges;
+  ranges.reserve(n);
+  ranges.emplace_back(0, farthest);
+  ranges.emplace_back(farthest, n);
+  while (!ranges.empty()) {
+    auto [first, last] = ranges.back();
+    ranges.pop_back();
+    if (last - first < 2) continue;
+
+    std::size_t split = first;
+    double split_distance = -1.0;
+    for (std::size_t i = first + 1; i < last; ++i) {
+      double distance =
+          SegmentDistance(points[i], points[first], points[last % n]);
+      if (distance > split_distance) {
+        split = i;
+        split_distance = distance;
+      }
+    }
+    if (split_distance > tolerance) {
+      keep[split] = 1;
+      ++kept;
+      ranges.emplace_back(first, split);
+      ranges.emplace_back(split, last);
+    }
+  }
+
+  // The tolerance swallows the whole zone; keep its outline as drawn
+  if (kept < 3) return;
+
+  std::size_t out = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (keep[i]) points[out++] = points[i];
+  }
+  points.resize(out);
+}
+
+/**
+ * @brief Check convexity and orient a convex outline positively
+ *
+ * Requires every turn to go the same way (straight vertices are allowed)
+ * and the fan around the first vertex to sweep monotonically, which rules
+ * out self-intersecting outlines such as star polygons.
+ */
+bool OrientConvex(std::vector<cv::Point2d>& points) {
+  const std::size_t n = points.size();
+  double area = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto& a = points[i];
+    const auto& b = points[(i + 1) % n];
+    area += a.x * b.y - a.y * b.x;
+  }
+  if (std::abs(area) < kEpsilon) return false;
+
+  const double sign = area > 0.0 ? 1.0 : -1.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto& prev = points[(i + n - 1) % n];
+    if (sign * Cross(prev, points[i], points[(i + 1) % n]) < 0.0) {
+      return false;
+    }
+  }
+  for (std::size_t i = 1; i + 1 < n; ++i) {
+    if (sign * Cross(points[0], points[i], points[i + 1]) <= 0.0) {
+      return false;
+    }
+  }
+
+  if (sign < 0.0) std::reverse(points.begin() + 1, points.end());
+  return true;
+}
+
+}  // namespace
+
+namespace aa::server {
+
+CompiledPolygon CompiledPolygon::Compile(const aa::shared::Polygon& polygon,
+                                         double tolerance) {
+  CompiledPolygon compiled;
+  compiled.vertices_ = RemoveDuplicates(polygon.GetVertices());
+  if (compiled.vertices_.size() < 3) return compiled;
+
+  Simplify(compiled.vertices_, std::max(0.0, tolerance));
+
+  const auto& vertices = compiled.vertices_;
+  compiled.min_x_ = compiled.max_x_ = vertices[0].x;
+  compiled.min_y_ = compiled.max_y_ = vertices[0].y;
+  for (const auto& vertex : vertices) {
+    compiled.min_x_ = std::min(compiled.min_x_, vertex.x);
+    compiled.max_x_ = std::max(compiled.max_x_, vertex.x);
+    compiled.min_y_ = std::min(compiled.min_y_, vertex.y);
+    compiled.max_y_ = std::max(compiled.max_y_, vertex.y);
+  }
+
+  compiled.convex_ = OrientConvex(compiled.vertices_);
+  if (!compiled.convex_) compiled.BuildSlabs();
+  return compiled;
+}
+
+void CompiledPolygon::BuildSlabs() {
+  const int n = static_cast<int>(vertices_.size());
+  slab_y_.clear();
+  slab_y_.reserve(n);
+  for (const auto& vertex : vertices_) slab_y_.push_back(vertex.y);
+  std::sort(slab_y_.begin(), slab_y_.end());
+  slab_y_.erase(std::unique(slab_y_.begin(), slab_y_.end()), slab_y_.end());
+
+  // Edge k spans the slabs from the height of its lower end up to the
+  // height of its upper end; horizontal edges span none
+  auto slab_range = [this](const cv::Point2d& a, const cv::Point2d& b) {
+    auto low = std::lower_bound(slab_y_.begin(), slab_y_.end(),
+                                std::min(a.y, b.y));
+    auto high = std::lower_bound(slab_y_.begin(), slab_y_.end(),
+                                 std::max(a.y, b.y));
+    return std::make_pair(static_cast<int>(low - slab_y_.begin()),
+                          static_cast<int>(high - slab_y_.begin()));
+  };
+
+  const int slabs = static_cast<int>(slab_y_.size()) - 1;
+  slab_start_.assign(slabs + 1, 0);
+  for (int k = 0; k < n; ++k) {
+    auto [low, high] = slab_range(vertices_[k], vertices_[(k + 1) % n]);
+    for (int slab = low; slab < high; ++slab) ++slab_start_[slab + 1];
+  }
+  for (int slab = 0; slab < slabs; ++slab) {
+    slab_start_[slab + 1] += slab_start_[slab];
+  }
+
+  slab_edges_.assign(slab_start_[slabs], 0);
+  std::vector<int> fill(slab_start_.begin(), slab_start_.end() - 1);
+  for (int k = 0; k < n; ++k) {
+    auto [low, high] = slab_range(vertices_[k], vertices_[(k + 1) % n]);
+    for (int slab = low; slab < high; ++slab) slab_edges_[fill[slab]++] = k;
+  }
+}
+
+bool CompiledPolygon::Contains(double x, double y) const {
+  if (vertices_.size() < 3) return false;
+  // Points on the bounding box are on the outline or outside it
+  if (x <= min_x_ || x >= max_x_ || y <= min_y_ || y >= max_y_) return false;
+  return convex_ ? ContainsConvex(x, y) : ContainsSlab(x, y);
+}
+
+bool CompiledPolygon::ContainsConvex(double x, double y) const {
+  const int n = static_cast<int>(vertices_.size());
+  const cv::Point2d point(x, y);
+  const cv::Point2d& pivot = vertices_[0];
+
+  // Outside the fan, or on one of the two edges at the pivot
+  if (Cross(pivot, vertices_[1], point) < kEpsilon ||
+      Cross(pivot, vertices_[n - 1], point) > -kEpsilon) {
+    return false;
+  }
+
+  // Find the fan triangle (pivot, lo, lo + 1) holding the point
+  int lo = 1;
+  int hi = n - 1;
+  while (hi - lo > 1) {
+    int mid = (lo + hi) / 2;
+    if (Cross(pivot, vertices_[mid], point) >= 0.0) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return Cross(vertices_[lo], vertices_[lo + 1], point) > kEpsilon;
+}
+
+bool CompiledPolygon::ContainsSlab(double x, double y) const {
+  auto upper = std::upper_bound(slab_y_.begin(), slab_y_.end(), y);
+  int slab = static_cast<int>(upper - slab_y_.begin()) - 1;
+  if (slab < 0 || slab + 1 >= static_cast<int>(slab_y_.size())) return false;
+
+  // At a vertex height the slab edges miss horizontal edges and vertices
+  if (y - slab_y_[slab] < kEpsilon || slab_y_[slab + 1] - y < kEpsilon) {
+    return ContainsScan(x, y);
+  }
+
+  const int n = static_cast<int>(vertices_.size());
+  bool inside = false;
+  for (int e = slab_start_[slab]; e < slab_start_[slab + 1]; ++e) {
+    const int k = slab_edges_[e];
+    const cv::Point2d& a = vertices_[k];
+    const cv::Point2d& b = vertices_[(k + 1) % n];
+    double cross = (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+    if (std::abs(cross) < kEpsilon) {
+      return false;  // Points on edges are considered outside
+    }
+    if (x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+bool CompiledPolygon::ContainsScan(double x, double y) const {
+  const int n = static_cast<int>(vertices_.size());
+  for (int i = 0; i < n; ++i) {
+    const cv::Point2d& a = vertices_[i];
+    if (std::abs(x - a.x) < kEpsilon && std::abs(y - a.y) < kEpsilon) {
+      return false;  // Points on vertices are considered outside
+    }
+    if (IsPointOnSegment(x, y, a, vertices_[(i + 1) % n])) {
+      return false;  // Points on edges are considered outside
+    }
+  }
+
+  bool inside = false;
+  for (int i = 0, j = n - 1; i < n; j = i++) {
+    const cv::Point2d& a = vertices_[i];
+    const cv::Point2d& b = vertices_[j];
+    if (((a.y > y) != (b.y > y)) &&
+        (x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x)) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+}  // namespace aa::server
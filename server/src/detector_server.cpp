@@ -1,15 +1,30 @@
 #include "detector_server.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <span>
+#include <thread>
+#include <utility>
 #include <opencv2/dnn.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
 
 #include "common.h"
+#include "drop_oldest_queue.h"
 #include "frame.h"
+#include "frame_delta.h"
+#include "frame_transform.h"
 #include "logging.h"
+#include "occupancy_tracker.h"
+#include "perf_counters.h"
 #include "polygon.h"
 
 namespace {
@@ -19,14 +34,288 @@ const cv::Scalar kMean = 0;
 const float kPadValue = 144.0f;
 const auto kPaddingMode = cv::dnn::ImagePaddingMode::DNN_PMODE_LETTERBOX;
 
+// Decoded source frames buffered ahead of inference by default
+constexpr std::size_t kDefaultSourceQueue = 2;
+
+// Largest source queue a client may request, in decoded frames
+constexpr std::size_t kMaxSourceQueue = 32;
+
+// The engine is not reentrant; the forward stage batches frames instead
+constexpr std::size_t kForwardWorkers = 1;
+
+// Largest frame payload accepted by ProcessFrameChunked (512 MiB)
+constexpr uint64_t kMaxChunkedFrameBytes = uint64_t{512} << 20;
+
+// Raw element types accepted by ProcessFrameChunked: 8-bit images with the
+// channel counts the engine and the drawing code handle
+constexpr std::array<int, 3> kChunkedRawTypes = {CV_8UC1, CV_8UC3, CV_8UC4};
+
+/**
+ * @brief Decoded frame of a server-side video source
+ */
+struct SourceFrame {
+  uint64_t index{0};
+  double timestamp_ms{0.0};
+  cv::Mat image;
+};
+
+/**
+ * @brief Extract the optional detection budget from a request
+ */
+template <typename Request>
+aa::server::DetectionBudget MakeDetectionBudget(const Request& request) {
+  aa::server::DetectionBudget budget;
+  if (request.has_max_detections()) {
+    budget.max_detections = static_cast<int>(request.max_detections());
+  }
+  if (request.has_min_confidence()) {
+    budget.min_confidence = request.min_confidence();
+  }
+  budget.class_whitelist.assign(request.class_whitelist().begin(),
+                                request.class_whitelist().end());
+  return budget;
+}
+
+/**
+ * @brief Check the optional detection budget of a request
+ */
+template <typename Request>
+bool IsValidBudget(const Request& request) {
+  if (request.has_min_confidence() &&
+      (request.min_confidence() < 0.0f || request.min_confidence() > 1.0f)) {
+    AA_LOG_ERROR("min_confidence must be between 0.0 and 1.0, got "
+                 << request.min_confidence());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Convert request zones, highest priority first
+ *
+ * Zones of UNSPECIFIED type are skipped with a warning.
+ */
+std::vector<aa::shared::Polygon> ParseZones(
+    const google::protobuf::RepeatedPtrField<aa::proto::Polygon>& zones) {
+  std::vector<aa::shared::Polygon> polygons;
+  polygons.reserve(zones.size());
+
+  for (int i = 0; i < zones.size(); ++i) {
+    auto polygon = aa::shared::Polygon::FromProto(zones.Get(i));
+
+    if (polygon.GetType() == aa::shared::PolygonType::UNSPECIFIED) {
+      AA_LOG_WARNING("Skipping polygon at index "
+                     << i << " with UNSPECIFIED type");
+      continue;
+    }
+
+    polygons.push_back(std::move(polygon));
+  }
+
+  std::sort(polygons.begin(), polygons.end(),
+            [](const aa::shared::Polygon& a, const aa::shared::Polygon& b) {
+              return a.GetPriority() > b.GetPriority();
+            });
+  return polygons;
+}
+
+/**
+ * @brief Fill a detection message
+ *
+ * @param detection Detection providing class and confidence
+ * @param box Bounding box to report, in the coordinates of the receiver
+ * @param out Message to fill
+ */
+void SetDetection(const aa::shared::Detection& detection, const cv::Rect& box,
+                  aa::proto::Detection* out) {
+  out->set_class_id(detection.class_id);
+  out->set_confidence(detection.confidence);
+  out->set_x(box.x);
+  out->set_y(box.y);
+  out->set_width(box.width);
+  out->set_height(box.height);
+}
+
+/**
+ * @brief Downscale factor fitting a frame into the requested result size
+ */
+double ResultScale(const aa::proto::ResultOptions& options,
+                   const cv::Size& size) {
+  double scale = 1.0;
+  if (options.max_width() > 0) {
+    scale = std::min(scale, static_cast<double>(options.max_width()) /
+                                static_cast<double>(size.width));
+  }
+  if (options.max_height() > 0) {
+    scale = std::min(scale, static_cast<double>(options.max_height()) /
+                                static_cast<double>(size.height));
+  }
+  return scale;
+}
+
 }  // namespace
 
 namespace aa::server {
 
-DetectorServer::DetectorServer(aa::shared::Options options)
-    : options_{std::move(options)}, yolo_{options_} {
+struct DetectorServer::FrameJob {
+  FrameJob(const aa::proto::ProcessFrameRequest& request, cv::Mat img,
+           aa::proto::ProcessFrameResponse* response,
+           aa::shared::FramePayload* payload, LoadTracker::Ticket ticket)
+      : request{request},
+        img{std::move(img)},
+        response{response},
+        payload{payload},
+        ticket{std::move(ticket)},
+        zones{&request.polygons()} {}
+
+  const aa::proto::ProcessFrameRequest& request;
+  cv::Mat img;
+  aa::proto::ProcessFrameResponse* response;
+  aa::shared::FramePayload* payload;
+  LoadTracker::Ticket ticket;
+  /// Zones of the frame: its own, or the shared zones of its batch
+  const google::protobuf::RepeatedPtrField<aa::proto::Polygon>* zones;
+  /// Scratch frame to draw on when img is shared and must stay untouched
+  cv::Mat* canvas{nullptr};
+  FrameGroup* group{nullptr};  ///< ProcessFrames call of the frame
+  std::vector<FrameJob*> batch;  ///< Group leader: the decoded group frames
+  cv::Size input_size;
+  PolygonFilter polygon_filter;
+  DetectionBudget budget;
+  aa::shared::FrameTransform transform;  ///< Client-side resize of img
+  std::vector<cv::Rect> crops;  ///< Zones with an inference pass of their own
+  std::vector<aa::shared::Detection> outs;
+  grpc::Status status;
+  bool sampled{false};  ///< Hardware counters are read on every stage
+  /// Called instead of waking Wait() when no thread waits for the job
+  std::function<void()> on_finish;
+
+  /**
+   * @brief Hand the job back to the request thread waiting in Wait(), or
+   * to on_finish
+   *
+   * Notifies under the lock, so the waiter cannot return and destroy the
+   * job before the notification is done with it. on_finish may destroy the
+   * job, so it is moved out first.
+   */
+  void Finish() {
+    if (on_finish) {
+      auto callback = std::move(on_finish);
+      callback();
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    finished_.notify_one();
+  }
+
+  /**
+   * @brief Hand the job to the next stage, or fail it on shutdown
+   *
+   * A group leader carries its whole group, which fails with it.
+   */
+  void Submit(PipelineStage<FrameJob*>& stage) {
+    if (stage.Submit(this)) return;
+    if (batch.empty()) {
+      Fail();
+      return;
+    }
+    for (auto* job : std::exchange(batch, {})) job->Fail();
+  }
+
+  void Fail() {
+    status =
+        grpc::Status(grpc::StatusCode::UNAVAILABLE, "Server is shutting down");
+    Finish();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this] { return done_; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable finished_;
+  bool done_{false};
+};
+
+struct DetectorServer::FrameGroup {
+  explicit FrameGroup(std::size_t size) : pending{size} { jobs.reserve(size); }
+
+  /**
+   * @brief Record a frame of the group leaving the decode stage
+   *
+   * @param job The frame if it goes on to inference, nullptr if it failed
+   * @return FrameJob* Once every frame has arrived, the first decoded frame
+   * carrying all decoded frames in its batch; nullptr before that or if
+   * none decoded
+   */
+  FrameJob* Arrive(FrameJob* job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (job != nullptr) jobs.push_back(job);
+    if (--pending > 0 || jobs.empty()) return nullptr;
+
+    FrameJob* leader = jobs.front();
+    leader->batch = std::move(jobs);
+    return leader;
+  }
+
+  std::mutex mutex;
+  std::size_t pending;  ///< Frames still being decoded
+  std::vector<FrameJob*> jobs;
+};
+
+struct DetectorServer::FrameCall {
+  FrameCall(const aa::proto::ProcessFrameRequest& request,
+            LoadTracker::Ticket ticket)
+      : job{request, cv::Mat{}, &message, &payload, std::move(ticket)} {}
+
+  aa::proto::ProcessFrameResponse message;
+  aa::shared::FramePayload payload;
+  FrameJob job;
+};
+
+DetectorServer::DetectorServer(aa::shared::Options options,
+                               ServerStats* stats)
+    : DetectorServer{options, CreateInferenceEngine(options), stats} {}
+
+DetectorServer::DetectorServer(aa::shared::Options options,
+                               std::unique_ptr<InferenceEngine> engine,
+                               ServerStats* stats)
+    : options_{std::move(options)},
+      engine_{std::move(engine)},
+      zone_crop_options_{ZoneCropOptions::FromOptions(options_)},
+      zone_crop_merger_{zone_crop_options_},
+      zone_tolerance_{std::max(0.0, options_.Get<double>("zone_tolerance"))},
+      batch_size_{
+          static_cast<std::size_t>(std::max(1, options_.Get<int>("batch")))},
+      perf_sample_{static_cast<uint64_t>(
+          std::max(0, options_.Get<int>("perf_sample")))},
+      stats_{stats} {
+  if (stats_ == nullptr) {
+    owned_stats_ = std::make_unique<ServerStats>();
+    stats_ = owned_stats_.get();
+  }
+
   service_ = std::make_unique<DetectorServiceImpl>(
-      options_.Get<std::string>("address"));
+      options_.Get<std::string>("address"),
+      aa::shared::TransportProfile::FromOptions(options_));
+
+  const auto queue = static_cast<std::size_t>(options_.Get<int>("stage_queue"));
+  render_stage_ = std::make_unique<PipelineStage<FrameJob*>>(
+      static_cast<std::size_t>(options_.Get<int>("render_workers")), queue, 1,
+      [this](auto& jobs) {
+        for (auto* job : jobs) RenderFrame(*job);
+      });
+  forward_stage_ = std::make_unique<PipelineStage<FrameJob*>>(
+      kForwardWorkers, queue, batch_size_,
+      [this](auto& jobs) { ForwardFrames(jobs); });
+  decode_stage_ = std::make_unique<PipelineStage<FrameJob*>>(
+      static_cast<std::size_t>(options_.Get<int>("decode_workers")), queue, 1,
+      [this](auto& jobs) {
+        for (auto* job : jobs) DecodeFrame(*job);
+      });
 }
 
 void DetectorServer::Initialize() {
@@ -35,9 +324,45 @@ void DetectorServer::Initialize() {
         return CheckHealth(request, response);
       });
   service_->Register<DetectorServiceMethods::kProcessFrame>(
+      [this](auto request, auto response, auto done) {
+        ProcessFrame(request, response, std::move(done));
+      });
+  service_->Register<DetectorServiceMethods::kProcessFrameStream>(
+      [this](auto stream) { return ProcessFrameStream(stream); });
+  service_->Register<DetectorServiceMethods::kProcessFrameChunked>(
+      [this](auto reader, auto response) {
+        return ProcessFrameChunked(reader, response);
+      });
+  service_->Register<DetectorServiceMethods::kStartSource>(
+      [this](auto request, auto writer) {
+        return StartSource(request, writer);
+      });
+  service_->Register<DetectorServiceMethods::kWatchZones>(
+      [this](auto context, auto request, auto writer) {
+        return WatchZones(context, request, writer);
+      });
+  service_->Register<DetectorServiceMethods::kGetModelInfo>(
       [this](auto request, auto response) {
-        return ProcessFrame(request, response);
+        return GetModelInfo(request, response);
       });
+  service_->Register<DetectorServiceMethods::kProcessFrames>(
+      [this](auto request, auto response) {
+        return ProcessFrames(request, response);
+      });
+}
+
+void DetectorServer::WarmUp() {
+  const auto size = engine_->GetModelInfo().input_size;
+  if (size.empty()) return;
+
+  cv::Mat blank(size, CV_8UC3, cv::Scalar::all(0));
+  std::vector<aa::shared::Detection> detections;
+  try {
+    std::lock_guard<std::mutex> lock(engine_mutex_);
+    engine_->Inference(blank, detections, {});
+  } catch (const std::exception& e) {
+    AA_LOG_WARNING("Warm-up inference failed: " << e.what());
+  }
 }
 
 void DetectorServer::Start() {
@@ -47,78 +372,722 @@ void DetectorServer::Start() {
 
 void DetectorServer::Shutdown() { service_->Stop(); }
 
+ServerStatsSnapshot DetectorServer::GetStats() const {
+  return stats_->Snapshot();
+}
+
 grpc::Status DetectorServer::CheckHealth(
     const aa::proto::CheckHealthRequest*,
-    aa::proto::CheckHealthResponse*) const {
+    aa::proto::CheckHealthResponse* response) const {
   // For now, we assume the server is always healthy
-  AA_LOG_INFO("Health check passed");
+  response->set_healthy(true);
+  response->set_status("serving");
+  load_.Fill(response->mutable_load());
+  AA_LOG_DEBUG("Health check passed");
 
   return grpc::Status::OK;
 }
 
+grpc::Status DetectorServer::GetModelInfo(
+    const aa::proto::GetModelInfoRequest*,
+    aa::proto::GetModelInfoResponse* response) const {
+  auto info = engine_->GetModelInfo();
+  if (info.input_size.empty()) {
+    return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                        "Inference engine has no fixed input size");
+  }
+
+  response->set_input_width(static_cast<uint32_t>(info.input_size.width));
+  response->set_input_height(static_cast<uint32_t>(info.input_size.height));
+  response->set_padding_mode(info.letterbox
+                                 ? aa::proto::PADDING_MODE_LETTERBOX
+                                 : aa::proto::PADDING_MODE_RESIZE);
+  response->set_pad_value(info.pad_value);
+  response->set_channel_order(info.rgb ? aa::proto::CHANNEL_ORDER_RGB
+                                       : aa::proto::CHANNEL_ORDER_BGR);
+  return grpc::Status::OK;
+}
+
+void DetectorServer::ProcessFrame(
+    const aa::proto::ProcessFrameRequest* request, grpc::ByteBuffer* response,
+    std::function<void(grpc::Status)> done) const {
+  auto start = std::chrono::steady_clock::now();
+  auto* call = new FrameCall(*request, load_.Enter());
+  call->job.sampled = NextFrameSampled();
+
+  // Runs on the stage that finishes the job; the call is gone before done
+  call->job.on_finish = [this, call, response, start,
+                         done = std::move(done)] {
+    std::unique_ptr<FrameCall> owned{call};
+    grpc::Status status = call->job.status;
+    stats_->Record(status.ok() && call->message.success(),
+                   std::chrono::steady_clock::now() - start);
+    if (status.ok()) {
+      load_.Fill(call->message.mutable_load());
+      *response = aa::shared::SerializeFrameResponse(call->message,
+                                                     call->payload);
+    }
+    owned.reset();
+    done(std::move(status));
+  };
+
+  if (request->has_delta()) {
+    AA_LOG_ERROR("Frame deltas are only supported on ProcessFrameStream");
+    call->message.set_success(false);
+    call->job.Finish();
+  } else if (!decode_stage_->TrySubmit(&call->job)) {
+    // Runs on a gRPC callback thread, which must never wait for the queue
+    call->job.status = grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                    "Server is overloaded");
+    call->job.Finish();
+  }
+}
+
 grpc::Status DetectorServer::ProcessFrame(
     const aa::proto::ProcessFrameRequest* request,
+    grpc::ByteBuffer* response) const {
+  std::promise<grpc::Status> finished;
+  auto result = finished.get_future();
+  ProcessFrame(request, response, [&finished](grpc::Status status) {
+    finished.set_value(std::move(status));
+  });
+  return result.get();
+}
+
+grpc::Status DetectorServer::ProcessFrames(
+    const aa::proto::ProcessFramesRequest* request,
+    aa::proto::ProcessFramesResponse* response) const {
+  auto start = std::chrono::steady_clock::now();
+  const int count = request->frames_size();
+  if (count == 0) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "Batch without frames");
+  }
+
+  std::vector<std::unique_ptr<FrameJob>> jobs;
+  jobs.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    const auto& frame = request->frames(i);
+    auto* result = response->add_results();
+    if (frame.has_delta()) {
+      AA_LOG_ERROR("Frame deltas are only supported on ProcessFrameStream");
+      result->set_success(false);
+      continue;
+    }
+    auto job = std::make_unique<FrameJob>(frame, cv::Mat{}, result, nullptr,
+                                          load_.Enter());
+    if (frame.polygons_size() == 0) {
+      job->zones = &request->polygons();
+    }
+    job->sampled = NextFrameSampled();
+    jobs.push_back(std::move(job));
+  }
+
+  // Decoded in parallel, then handed to the forward stage as one item
+  FrameGroup group(jobs.size());
+  std::size_t submitted = 0;
+  for (auto& job : jobs) {
+    job->group = &group;
+    if (!decode_stage_->Submit(job.get())) break;
+    ++submitted;
+  }
+  grpc::Status status = grpc::Status::OK;
+  if (submitted < jobs.size()) {
+    status =
+        grpc::Status(grpc::StatusCode::UNAVAILABLE, "Server is shutting down");
+    for (std::size_t i = submitted; i < jobs.size(); ++i) {
+      if (auto* leader = group.Arrive(nullptr)) {
+        leader->Submit(*forward_stage_);
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < submitted; ++i) {
+    jobs[i]->Wait();
+    if (status.ok()) status = jobs[i]->status;
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  for (const auto& result : response->results()) {
+    stats_->Record(status.ok() && result.success(), elapsed);
+  }
+  if (status.ok()) {
+    load_.Fill(response->mutable_load());
+  }
+  return status;
+}
+
+grpc::Status DetectorServer::ProcessFrameStream(
+    grpc::ServerReaderWriter<aa::proto::ProcessFrameResponse,
+                             aa::proto::ProcessFrameRequest>* stream) const {
+  aa::shared::FrameDeltaDecoder decoder;
+  google::protobuf::RepeatedPtrField<aa::proto::Polygon> polygons;
+  cv::Mat canvas;  // Reused by every delta frame of the stream
+  aa::proto::ProcessFrameRequest request;
+
+  while (stream->Read(&request)) {
+    auto start = std::chrono::steady_clock::now();
+    aa::proto::ProcessFrameResponse response;
+
+    // Zones are sent once and kept until the client sends new ones
+    if (request.polygons_size() > 0) {
+      polygons.Swap(request.mutable_polygons());
+    }
+
+    cv::Mat img;
+    bool shared = false;
+    if (request.has_delta()) {
+      if (decoder.Apply(request.delta())) {
+        // The next delta applies to this frame, so drawing goes to canvas
+        img = decoder.GetFrame();
+        shared = true;
+      } else {
+        AA_LOG_ERROR("Rejected frame delta, a keyframe is required");
+        decoder.Reset();
+        response.set_keyframe_required(true);
+      }
+    } else {
+      img = aa::shared::Frame::FromProto(request.frame()).ToMat();
+    }
+
+    grpc::Status status = grpc::Status::OK;
+    if (img.empty()) {
+      response.set_success(false);
+    } else {
+      status = ProcessImage(request, std::move(img), &response, nullptr,
+                            &polygons, shared ? &canvas : nullptr);
+    }
+
+    stats_->Record(status.ok() && response.success(),
+                   std::chrono::steady_clock::now() - start);
+    if (!status.ok()) {
+      return status;
+    }
+    load_.Fill(response.mutable_load());
+    if (!stream->Write(response)) {
+      break;
+    }
+  }
+
+  return grpc::Status::OK;
+}
+
+grpc::Status DetectorServer::ProcessFrameChunked(
+    grpc::ServerReader<aa::proto::FrameChunk>* reader,
     aa::proto::ProcessFrameResponse* response) const {
+  auto start = std::chrono::steady_clock::now();
+  aa::proto::FrameChunk chunk;
+  if (!reader->Read(&chunk)) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "Chunked upload without chunks");
+  }
+
+  auto request = std::move(*chunk.mutable_request());
+  const uint64_t total = chunk.total_size();
+  if (total == 0) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "First chunk must carry total_size");
+  }
+  if (total > kMaxChunkedFrameBytes) {
+    AA_LOG_ERROR("Rejecting chunked frame of " << total << " bytes");
+    return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                        "Frame exceeds the upload limit");
+  }
+
+  // Chunks go straight into the frame buffer, no message holds the frame.
+  // A new buffer grows with the data received, not with total_size.
+  auto buffer = frame_pool_.Acquire(chunk.data().size(),
+                                    static_cast<std::size_t>(total));
+  uint64_t received = 0;
+  do {
+    const auto& data = chunk.data();
+    if (data.size() > total - received) {
+      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                          "Chunks exceed total_size");
+    }
+    buffer.Resize(static_cast<std::size_t>(received + data.size()));
+    std::memcpy(buffer.Data() + received, data.data(), data.size());
+    received += data.size();
+  } while (reader->Read(&chunk));
+
+  if (received != total) {
+    AA_LOG_ERROR("Chunked upload ended after " << received << " of "
+                                               << total << " bytes");
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "Chunks do not add up to total_size");
+  }
+
+  grpc::Status status = grpc::Status::OK;
   try {
-    if (request->polygons_size() == 0) {
-      AA_LOG_ERROR("No polygons provided in request");
+    const auto& frame = request.frame();
+    cv::Mat img;
+    if (frame.encoding() != aa::proto::FRAME_ENCODING_RAW) {
+      img = cv::imdecode(cv::Mat(1, static_cast<int>(total), CV_8UC1,
+                                 buffer.Data()),
+                         cv::IMREAD_UNCHANGED);
+    } else if (std::ranges::find(kChunkedRawTypes, frame.elm_type()) !=
+                   kChunkedRawTypes.end() &&
+               frame.rows() > 0 && frame.cols() > 0 &&
+               static_cast<uint64_t>(frame.rows()) * frame.cols() *
+                       CV_ELEM_SIZE(frame.elm_type()) ==
+                   total) {
+      // The size follows from the type, elm_size is not trusted. Wraps the
+      // pooled buffer, which outlives the processing below
+      img = cv::Mat(frame.rows(), frame.cols(), frame.elm_type(),
+                    buffer.Data());
+    }
+
+    if (img.empty()) {
+      AA_LOG_ERROR("Cannot decode chunked frame of " << total << " bytes");
       response->set_success(false);
-      return grpc::Status::OK;
+    } else {
+      status = ProcessImage(request, std::move(img), response);
     }
+  } catch (const std::exception& e) {
+    AA_LOG_ERROR("Error processing chunked frame: " << e.what());
+    status =
+        grpc::Status(grpc::StatusCode::INTERNAL, "Frame processing failed");
+  }
+
+  stats_->Record(status.ok() && response->success(),
+                 std::chrono::steady_clock::now() - start);
+  if (status.ok()) {
+    load_.Fill(response->mutable_load());
+  }
+  return status;
+}
+
+grpc::Status DetectorServer::RunSource(
+    const aa::proto::StartSourceRequest& request,
+    const SourceSink& sink) const {
+  auto polygons = ParseZones(request.polygons());
+  if (polygons.empty()) {
+    AA_LOG_ERROR("No valid polygons provided for source " << request.uri());
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "No valid polygons provided");
+  }
+  if (!IsValidBudget(request)) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "Invalid detection budget");
+  }
+  if (request.queue_size() > kMaxSourceQueue) {
+    return grpc::Status(
+        grpc::StatusCode::INVALID_ARGUMENT,
+        "queue_size exceeds " + std::to_string(kMaxSourceQueue) + " frames");
+  }
+
+  cv::VideoCapture capture;
+  try {
+    capture.open(request.uri());
+  } catch (const std::exception& e) {
+    AA_LOG_ERROR("Error opening video source: " << e.what());
+  }
+  if (!capture.isOpened()) {
+    AA_LOG_ERROR("Cannot open video source " << request.uri());
+    return grpc::Status(grpc::StatusCode::NOT_FOUND,
+                        "Cannot open video source");
+  }
 
-    std::vector<aa::shared::Polygon> polygons;
-    polygons.reserve(request->polygons_size());
+  PolygonFilter polygon_filter;
+  polygon_filter.SetPolygons(std::move(polygons), zone_tolerance_);
+  const auto budget = MakeDetectionBudget(request);
+  const bool lossless = request.lossless();
 
-    for (int i = 0; i < request->polygons_size(); ++i) {
-      auto polygon = aa::shared::Polygon::FromProto(request->polygons(i));
+  DropOldestQueue<SourceFrame> queue(request.queue_size() > 0
+                                         ? request.queue_size()
+                                         : kDefaultSourceQueue);
+  std::atomic<uint32_t> dropped{0};
 
-      if (polygon.GetType() == aa::shared::PolygonType::UNSPECIFIED) {
-        AA_LOG_WARNING("Skipping polygon at index "
-                       << i << " with UNSPECIFIED type");
-        continue;
+  AA_LOG_INFO("Started video source " << request.uri());
+
+  // Decoding runs ahead of inference; the queue keeps the newest frames
+  std::jthread decoder([&](std::stop_token stop) {
+    try {
+      uint64_t index = 0;
+      SourceFrame frame;
+      while (!stop.stop_requested() && capture.read(frame.image)) {
+        frame.index = index++;
+        frame.timestamp_ms = capture.get(cv::CAP_PROP_POS_MSEC);
+        if (lossless) {
+          if (!queue.PushWait(std::move(frame))) break;
+        } else if (queue.Push(std::move(frame))) {
+          dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        frame = SourceFrame{};
       }
+    } catch (const std::exception& e) {
+      AA_LOG_ERROR("Error decoding video source: " << e.what());
+    }
+    queue.Close();
+  });
+
+  grpc::Status status = grpc::Status::OK;
+  SourceFrame frame;
+  std::vector<aa::shared::Detection> outs;
+  std::vector<aa::shared::Detection> filtered;
+  aa::proto::SourceDetections message;
+  uint64_t frames = 0;
+
+  while (queue.Pop(frame)) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+      auto ticket = load_.Enter();
+      outs.clear();
+      RunInference(frame.image, budget, ticket, outs);
+      polygon_filter.FilterDetectionsByPolygons(outs, filtered);
+      ticket.Complete(frame.image.cols, frame.image.rows);
+    } catch (const std::exception& e) {
+      AA_LOG_ERROR("Error processing source frame: " << e.what());
+      status =
+          grpc::Status(grpc::StatusCode::INTERNAL, "Frame processing failed");
+      break;
+    }
+
+    message.Clear();
+    message.set_frame_index(frame.index);
+    message.set_timestamp_ms(frame.timestamp_ms);
+    message.set_width(static_cast<uint32_t>(frame.image.cols));
+    message.set_height(static_cast<uint32_t>(frame.image.rows));
+    for (const auto& detection : filtered) {
+      SetDetection(detection, detection.bbox, message.add_detections());
+    }
+    message.set_dropped_frames(
+        dropped.exchange(0, std::memory_order_relaxed));
+    load_.Fill(message.mutable_load());
+
+    stats_->Record(true, std::chrono::steady_clock::now() - start);
+    stats_->AddDetections(filtered.size());
+    ++frames;
+
+    if (!sink(message)) {
+      AA_LOG_INFO("Video source " << request.uri() << " cancelled");
+      break;
+    }
+  }
+
+  // Wake a decoder waiting for room before joining it
+  decoder.request_stop();
+  queue.Close();
+  decoder.join();
+
+  AA_LOG_INFO("Stopped video source " << request.uri() << " after "
+                                      << frames << " frames");
+  return status;
+}
+
+grpc::Status DetectorServer::StartSource(
+    const aa::proto::StartSourceRequest* request,
+    grpc::ServerWriter<aa::proto::SourceDetections>* writer) const {
+  return RunSource(*request, [writer](const auto& detections) {
+    return writer->Write(detections);
+  });
+}
+
+grpc::Status DetectorServer::WatchZones(
+    grpc::ServerContext* context, const aa::proto::WatchZonesRequest* request,
+    grpc::ServerWriter<aa::proto::ZoneEvents>* writer) const {
+  // Events name zones by their index in the request
+  std::vector<aa::shared::Polygon> zones;
+  zones.reserve(request->source().polygons_size());
+  for (const auto& polygon : request->source().polygons()) {
+    zones.push_back(aa::shared::Polygon::FromProto(polygon));
+  }
+  OccupancyTracker tracker(std::move(zones),
+                           static_cast<int>(request->debounce_frames()));
+
+  std::vector<aa::shared::Detection> detections;
+  aa::proto::ZoneEvents events;
+  return RunSource(request->source(), [&](const auto& message) {
+    detections.clear();
+    for (const auto& detection : message.detections()) {
+      detections.push_back(
+          {cv::Rect(detection.x(), detection.y(), detection.width(),
+                    detection.height()),
+           detection.class_id(), detection.confidence()});
+    }
+
+    events.Clear();
+    tracker.Update(detections, message.frame_index(), message.timestamp_ms(),
+                   &events);
+    if (events.events_size() > 0) {
+      return writer->Write(events);
+    }
+    return !context->IsCancelled();
+  });
+}
 
-      polygons.push_back(std::move(polygon));
+void DetectorServer::RunInference(
+    cv::Mat& img, const DetectionBudget& budget, LoadTracker::Ticket& ticket,
+    std::vector<aa::shared::Detection>& detections) const {
+  std::lock_guard<std::mutex> lock(engine_mutex_);
+  ticket.Begin();
+  engine_->Inference(img, detections, budget);
+}
+
+grpc::Status DetectorServer::ProcessImage(
+    const aa::proto::ProcessFrameRequest& request, cv::Mat img,
+    aa::proto::ProcessFrameResponse* response,
+    aa::shared::FramePayload* payload,
+    const google::protobuf::RepeatedPtrField<aa::proto::Polygon>* zones,
+    cv::Mat* canvas) const {
+  FrameJob job(request, std::move(img), response, payload, load_.Enter());
+  if (zones != nullptr) job.zones = zones;
+  job.canvas = canvas;
+  job.sampled = NextFrameSampled();
+  if (!decode_stage_->Submit(&job)) {
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                        "Server is shutting down");
+  }
+  job.Wait();
+  return job.status;
+}
+
+bool DetectorServer::NextFrameSampled() const {
+  return perf_sample_ > 0 &&
+         frame_sequence_.fetch_add(1, std::memory_order_relaxed) %
+                 perf_sample_ ==
+             0;
+}
+
+void DetectorServer::DecodeFrame(FrameJob& job) const {
+  const bool decoded = PrepareFrame(job);
+  if (job.group != nullptr) {
+    // Frames of one ProcessFrames call enter the forward stage together
+    if (auto* leader = job.group->Arrive(decoded ? &job : nullptr)) {
+      leader->Submit(*forward_stage_);
     }
+  } else if (decoded) {
+    job.Submit(*forward_stage_);
+  }
+  if (!decoded) job.Finish();
+}
 
+bool DetectorServer::PrepareFrame(FrameJob& job) const {
+  const auto& request = job.request;
+  auto* response = job.response;
+  PerfSampling sampling(job.sampled ? stats_ : nullptr);
+  try {
+    if (job.img.empty()) {
+      PerfScope scope(PerfStage::kDecode);
+      job.img = aa::shared::Frame::FromProto(request.frame()).ToMat();
+    }
+    job.input_size = job.img.size();
+
+    if (job.img.empty()) {
+      AA_LOG_ERROR("Cannot decode frame");
+      response->set_success(false);
+      return false;
+    }
+
+    if (job.zones->empty()) {
+      AA_LOG_ERROR("No polygons provided in request");
+      response->set_success(false);
+      return false;
+    }
+
+    auto polygons = ParseZones(*job.zones);
     if (polygons.empty()) {
       AA_LOG_ERROR(
           "No valid polygons found after filtering out UNSPECIFIED types");
       response->set_success(false);
-      return grpc::Status::OK;
+      return false;
+    }
+
+    if (!IsValidBudget(request)) {
+      response->set_success(false);
+      return false;
+    }
+
+    const auto& result_options = request.result_options();
+    if (!aa::proto::FrameEncoding_IsValid(result_options.encoding()) ||
+        result_options.quality() > 100) {
+      AA_LOG_ERROR("Invalid result options: encoding "
+                   << result_options.encoding() << ", quality "
+                   << result_options.quality());
+      response->set_success(false);
+      return false;
+    }
+
+    // Zones of a resized frame are given in source frame coordinates
+    if (request.has_transform()) {
+      job.transform =
+          aa::shared::FrameTransform::FromProto(request.transform());
+      if (!job.transform.IsValid()) {
+        AA_LOG_ERROR("Invalid frame transform: source size and scales must "
+                     "be positive, offsets non-negative");
+        response->set_success(false);
+        return false;
+      }
+      for (auto& polygon : polygons) {
+        std::vector<aa::shared::Point> vertices;
+        vertices.reserve(polygon.GetVertices().size());
+        for (const auto& vertex : polygon.GetVertices()) {
+          vertices.push_back(job.transform.ToSent(vertex));
+        }
+        polygon.SetVertices(std::move(vertices));
+      }
     }
 
-    std::sort(polygons.begin(), polygons.end(),
-              [](const aa::shared::Polygon& a, const aa::shared::Polygon& b) {
-                return a.GetPriority() > b.GetPriority();
-              });
+    SelectZoneCrops(polygons, job.img.size(), zone_crop_options_, job.crops);
+    job.polygon_filter.SetPolygons(std::move(polygons), zone_tolerance_);
+    job.budget = MakeDetectionBudget(request);
+  } catch (const std::exception& e) {
+    AA_LOG_ERROR("Error processing frame: " << e.what());
+    job.status =
+        grpc::Status(grpc::StatusCode::INTERNAL, "Frame processing failed");
+    return false;
+  }
+  return true;
+}
 
-    auto img = aa::shared::Frame::FromProto(request->frame()).ToMat();
+void DetectorServer::ForwardFrames(std::vector<FrameJob*>& jobs) const {
+  // A group leader stands for all decoded frames of its ProcessFrames call
+  if (std::any_of(jobs.begin(), jobs.end(),
+                  [](const FrameJob* job) { return !job->batch.empty(); })) {
+    std::vector<FrameJob*> expanded;
+    for (auto* job : jobs) {
+      if (job->batch.empty()) {
+        expanded.push_back(job);
+      } else {
+        auto batch = std::exchange(job->batch, {});
+        expanded.insert(expanded.end(), batch.begin(), batch.end());
+      }
+    }
+    jobs.swap(expanded);
+  }
 
-    std::vector<aa::shared::Detection> outs;
-    const_cast<Yolo&>(yolo_).Inference(img, outs);
+  {
+    std::lock_guard<std::mutex> lock(engine_mutex_);
+    for (std::size_t begin = 0; begin < jobs.size();) {
+      // Consecutive frames with the same budget share one forward pass of
+      // up to batch_size_ images, zone crops included
+      std::size_t end = begin + 1;
+      std::size_t images = 1 + jobs[begin]->crops.size();
+      bool sampled = jobs[begin]->sampled;
+      while (end < jobs.size() &&
+             images + 1 + jobs[end]->crops.size() <= batch_size_ &&
+             jobs[end]->budget == jobs[begin]->budget) {
+        images += 1 + jobs[end]->crops.size();
+        sampled = sampled || jobs[end]->sampled;
+        ++end;
+      }
+      PerfSampling sampling(sampled ? stats_ : nullptr,
+                            static_cast<uint32_t>(end - begin));
 
-    const_cast<PolygonFilter&>(polygon_filter_)
-        .SetPolygons(std::move(polygons));
-    auto filtered = const_cast<PolygonFilter&>(polygon_filter_)
-                        .FilterDetectionsByPolygons(outs);
+      try {
+        for (std::size_t i = begin; i < end; ++i) {
+          jobs[i]->ticket.Begin();
+        }
+        if (end - begin == 1 && jobs[begin]->crops.empty()) {
+          auto& job = *jobs[begin];
+          engine_->Inference(job.img, job.outs, job.budget);
+        } else {
+          // Zone crops are views into their frame and join the same batch
+          std::vector<cv::Mat> images;
+          std::vector<std::vector<aa::shared::Detection>> detections;
+          for (std::size_t i = begin; i < end; ++i) {
+            images.push_back(jobs[i]->img);
+            for (const auto& crop : jobs[i]->crops) {
+              images.push_back(jobs[i]->img(crop));
+            }
+          }
+          engine_->InferenceBatch(images, detections, jobs[begin]->budget);
 
-    polygon_filter_.DrawPolygonBoundingBoxes(img);
-    yolo_.DrawBoundingBoxes(img, filtered);
+          std::span<const std::vector<aa::shared::Detection>> results(
+              detections);
+          for (std::size_t i = begin, next = 0; i < end; ++i) {
+            auto& job = *jobs[i];
+            job.outs = std::move(detections[next]);
+            zone_crop_merger_.Merge(job.img.size(), job.crops,
+                                    results.subspan(next + 1, job.crops.size()),
+                                    job.budget.max_detections, job.outs);
+            next += 1 + job.crops.size();
+          }
+        }
+      } catch (const std::exception& e) {
+        AA_LOG_ERROR("Error processing frame: " << e.what());
+        for (std::size_t i = begin; i < end; ++i) {
+          jobs[i]->status = grpc::Status(grpc::StatusCode::INTERNAL,
+                                         "Frame processing failed");
+        }
+      }
+      begin = end;
+    }
+  }
 
-    auto result_frame = aa::shared::Frame(img);
-    auto proto_result_frame = result_frame.ToProto();
+  // Hand over outside the engine lock, the render queue may be full
+  for (auto* job : jobs) {
+    if (job->status.ok()) {
+      job->Submit(*render_stage_);
+    } else {
+      job->Finish();
+    }
+  }
+}
+
+void DetectorServer::RenderFrame(FrameJob& job) const {
+  auto& img = job.img;
+  auto* response = job.response;
+  PerfSampling sampling(job.sampled ? stats_ : nullptr);
+  try {
+    std::vector<aa::shared::Detection> filtered;
+    {
+      PerfScope scope(PerfStage::kFilter);
+      job.polygon_filter.FilterDetectionsByPolygons(job.outs, filtered);
+    }
+
+    // Shrink before drawing so overlays are rendered at output size only.
+    // A shared frame is resized or copied into the canvas, whose buffer is
+    // reused as long as the frame size does not change.
+    const auto& result_options = job.request.result_options();
+    double scale = ResultScale(result_options, img.size());
+    cv::Mat& canvas = job.canvas != nullptr ? *job.canvas : img;
+    {
+      PerfScope scope(PerfStage::kDraw);
+      if (scale < 1.0) {
+        cv::Size size(std::max(1, cvRound(img.cols * scale)),
+                      std::max(1, cvRound(img.rows * scale)));
+        cv::resize(img, canvas, size, 0, 0, cv::INTER_AREA);
+      } else if (&canvas != &img) {
+        img.copyTo(canvas);
+      }
 
-    response->mutable_result()->CopyFrom(proto_result_frame);
+      job.polygon_filter.DrawPolygonBoundingBoxes(canvas, scale);
+      engine_->DrawBoundingBoxes(canvas, filtered, scale);
+    }
+
+    auto* result = response->mutable_result();
+    aa::shared::FramePayload result_payload;
+    {
+      PerfScope scope(PerfStage::kEncode);
+      result_payload = aa::shared::FramePayload::Encode(
+          canvas, result_options.encoding(),
+          static_cast<int>(result_options.quality()), result);
+    }
+    if (job.payload != nullptr) {
+      *job.payload = std::move(result_payload);
+    } else {
+      result->set_data(result_payload.Data(), result_payload.Size());
+    }
+    // The result is the reduced frame, so boxes go back in source pixels
+    if (!job.transform.IsIdentity()) {
+      for (const auto& detection : filtered) {
+        SetDetection(detection, job.transform.ToSource(detection.bbox),
+                     response->add_detections());
+      }
+    }
     response->set_success(true);
+    stats_->AddDetections(filtered.size());
+    job.ticket.Complete(job.input_size.width, job.input_size.height);
 
-    AA_LOG_INFO("Processed frame successfully. Found " << outs.size()
+    AA_LOG_INFO("Processed frame successfully. Found " << job.outs.size()
                                                        << " detections.");
-    return grpc::Status::OK;
   } catch (const std::exception& e) {
     AA_LOG_ERROR("Error processing frame: " << e.what());
-    return grpc::Status(grpc::StatusCode::INTERNAL, "Frame processing failed");
+    job.status =
+        grpc::Status(grpc::StatusCode::INTERNAL, "Frame processing failed");
   }
+  job.Finish();
 }
 
 /*
@@ -0,0 +1,95 @@
+#include "fake_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+namespace aa::server {
+
+FakeEngineOptions FakeEngineOptions::FromOptions(
+    const aa::shared::Options& options) {
+  FakeEngineOptions engine_options;
+  engine_options.detections = std::max(0, options.Get<int>("fake_detections"));
+  engine_options.compute_time = std::chrono::microseconds(
+      std::llround(std::max(0.0, options.Get<double>("fake_latency_ms")) *
+                   1000.0));
+  engine_options.spin = options.Get<bool>("fake_spin");
+  engine_options.input_size =
+      cv::Size(options.Get<int>("width"), options.Get<int>("height"));
+  return engine_options;
+}
+
+FakeEngine::FakeEngine(FakeEngineOptions options)
+    : options_{std::move(options)} {
+  options_.num_classes = std::max(1, options_.num_classes);
+}
+
+std::vector<aa::shared::Detection> FakeEngine::Generate(
+    const cv::Size& size) const {
+  std::vector<aa::shared::Detection> detections;
+  const int count = options_.detections;
+  if (count <= 0 || size.width <= 0 || size.height <= 0) return detections;
+
+  // One box centred in each cell of a near-square grid
+  const int columns = static_cast<int>(std::ceil(std::sqrt(count)));
+  const int rows = (count + columns - 1) / columns;
+  const int cell_width = std::max(1, size.width / columns);
+  const int cell_height = std::max(1, size.height / rows);
+
+  detections.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    int x = (i % columns) * cell_width + cell_width / 4;
+    int y = (i / columns) * cell_height + cell_height / 4;
+    aa::shared::Detection detection;
+    detection.bbox = cv::Rect(x, y, std::max(1, cell_width / 2),
+                              std::max(1, cell_height / 2));
+    detection.class_id = i % options_.num_classes;
+    detection.confidence = 0.95f - 0.9f * static_cast<float>(i) /
+                                       static_cast<float>(count);
+    detections.push_back(detection);
+  }
+  return detections;
+}
+
+void FakeEngine::Inference(cv::Mat& input,
+                           std::vector<aa::shared::Detection>& detections,
+                           const DetectionBudget& budget) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + options_.compute_time;
+
+  detections = Generate(input.size());
+  std::erase_if(detections, [&budget](const aa::shared::Detection& d) {
+    return d.confidence < budget.min_confidence ||
+           (!budget.class_whitelist.empty() &&
+            std::find(budget.class_whitelist.begin(),
+                      budget.class_whitelist.end(),
+                      d.class_id) == budget.class_whitelist.end());
+  });
+  if (budget.max_detections > 0 &&
+      detections.size() > static_cast<std::size_t>(budget.max_detections)) {
+    detections.resize(static_cast<std::size_t>(budget.max_detections));
+  }
+
+  if (options_.compute_time.count() <= 0) return;
+  if (options_.spin) {
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+  } else {
+    std::this_thread::sleep_until(deadline);
+  }
+}
+
+ModelInfo FakeEngine::GetModelInfo() const {
+  ModelInfo info;
+  info.input_size = options_.input_size;
+  return info;
+}
+
+void FakeEngine::DrawBoundingBoxes(
+    cv::Mat& img, const std::vector<aa::shared::Detection>& detections,
+    double scale) const {
+  DrawLabeledBoxes(img, detections, scale, aa::shared::kCocoClasses);
+}
+
+}  // namespace aa::server
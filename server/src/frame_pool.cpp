@@ -0,0 +1,105 @@
+#include "frame_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace aa::server {
+
+FramePool::Buffer::Buffer(FramePool* pool, std::unique_ptr<uint8_t[]> storage,
+                          std::size_t capacity, std::size_t size,
+                          std::size_t expected)
+    : pool_{pool},
+      storage_{std::move(storage)},
+      capacity_{capacity},
+      size_{size},
+      expected_{expected} {}
+
+FramePool::Buffer::Buffer(Buffer&& other) noexcept
+    : pool_{other.pool_},
+      storage_{std::move(other.storage_)},
+      capacity_{other.capacity_},
+      size_{other.size_},
+      expected_{other.expected_} {
+  other.pool_ = nullptr;
+}
+
+FramePool::Buffer::~Buffer() {
+  if (pool_ != nullptr && storage_) {
+    pool_->Release(std::move(storage_), capacity_);
+  }
+}
+
+void FramePool::Buffer::Resize(std::size_t size) {
+  if (size > capacity_) {
+    // Geometric growth keeps the copies linear in the upload size
+    std::size_t capacity =
+        std::max(size, std::min(expected_, capacity_ * 2));
+    auto storage = std::make_unique_for_overwrite<uint8_t[]>(capacity);
+    if (size_ > 0) std::memcpy(storage.get(), storage_.get(), size_);
+    storage_ = std::move(storage);
+    capacity_ = capacity;
+  }
+  size_ = size;
+}
+
+FramePool::FramePool(std::size_t max_free, std::size_t max_free_bytes,
+                     std::size_t max_buffer_bytes)
+    : max_free_{max_free},
+      max_free_bytes_{max_free_bytes},
+      max_buffer_bytes_{max_buffer_bytes} {}
+
+FramePool::Buffer FramePool::Acquire(std::size_t size, std::size_t expected) {
+  expected = std::max(size, expected);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto best = free_.end();
+    for (auto it = free_.begin(); it != free_.end(); ++it) {
+      if (it->capacity >= expected &&
+          (best == free_.end() || it->capacity < best->capacity)) {
+        best = it;
+      }
+    }
+    if (best != free_.end()) {
+      Storage storage = std::move(*best);
+      free_.erase(best);
+      free_bytes_ -= storage.capacity;
+      return Buffer{this, std::move(storage.data), storage.capacity, size,
+                    expected};
+    }
+  }
+
+  // Allocated outside the lock; the upload overwrites every byte
+  return Buffer{this, std::make_unique_for_overwrite<uint8_t[]>(size), size,
+                size, expected};
+}
+
+std::size_t FramePool::FreeCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return free_.size();
+}
+
+std::size_t FramePool::FreeBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return free_bytes_;
+}
+
+void FramePool::Release(std::unique_ptr<uint8_t[]> data,
+                        std::size_t capacity) {
+  if (capacity > max_buffer_bytes_ || capacity > max_free_bytes_) return;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_.push_back(Storage{std::move(data), capacity});
+  free_bytes_ += capacity;
+
+  // Over a limit: keep the larger buffers, they serve every smaller request
+  while (free_.size() > max_free_ || free_bytes_ > max_free_bytes_) {
+    auto smallest = std::min_element(free_.begin(), free_.end(),
+                                     [](const Storage& a, const Storage& b) {
+                                       return a.capacity < b.capacity;
+                                     });
+    free_bytes_ -= smallest->capacity;
+    free_.erase(smallest);
+  }
+}
+
+}  // namespace aa::server
@@ -0,0 +1,23 @@
+#include "inference_engine.h"
+
+#include "fake_engine.h"
+#include "logging.h"
+#include "options.h"
+#include "yolo.h"
+
+namespace aa::server {
+
+std::unique_ptr<InferenceEngine> CreateInferenceEngine(
+    const aa::shared::Options& options) {
+  if (options.Get<std::string>("engine") == "fake") {
+    auto engine_options = FakeEngineOptions::FromOptions(options);
+    AA_LOG_WARNING("Using the fake inference engine: "
+                   << engine_options.detections << " detections per frame, "
+                   << engine_options.compute_time.count() << "us "
+                   << (engine_options.spin ? "spinning" : "sleeping"));
+    return std::make_unique<FakeEngine>(engine_options);
+  }
+  return std::make_unique<Yolo>(options);
+}
+
+}  // namespace aa::server
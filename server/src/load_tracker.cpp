@@ -0,0 +1,68 @@
+#include "load_tracker.h"
+
+#include <algorithm>
+
+namespace aa::server {
+
+LoadTracker::Ticket::Ticket(LoadTracker* tracker) : tracker_{tracker} {
+  tracker_->in_flight_.fetch_add(1, std::memory_order_relaxed);
+  tracker_->queue_depth_.fetch_add(1, std::memory_order_relaxed);
+}
+
+LoadTracker::Ticket::Ticket(Ticket&& other) noexcept
+    : tracker_{other.tracker_},
+      queued_{other.queued_},
+      started_{other.started_} {
+  other.tracker_ = nullptr;
+}
+
+LoadTracker::Ticket::~Ticket() {
+  if (tracker_ == nullptr) return;
+  if (queued_) {
+    tracker_->queue_depth_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  tracker_->in_flight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void LoadTracker::Ticket::Begin() {
+  if (!queued_) return;
+  queued_ = false;
+  tracker_->queue_depth_.fetch_sub(1, std::memory_order_relaxed);
+  started_ = std::chrono::steady_clock::now();
+}
+
+void LoadTracker::Ticket::Complete(int width, int height) {
+  if (queued_) return;
+  tracker_->RecordService(std::chrono::steady_clock::now() - started_);
+  tracker_->input_width_.store(static_cast<uint32_t>(std::max(0, width)),
+                               std::memory_order_relaxed);
+  tracker_->input_height_.store(static_cast<uint32_t>(std::max(0, height)),
+                                std::memory_order_relaxed);
+}
+
+LoadTracker::LoadTracker(double alpha)
+    : alpha_{std::clamp(alpha, 1e-3, 1.0)} {}
+
+LoadTracker::Ticket LoadTracker::Enter() { return Ticket{this}; }
+
+void LoadTracker::Fill(aa::proto::LoadReport* report) const {
+  report->set_queue_depth(queue_depth_.load(std::memory_order_relaxed));
+  report->set_in_flight(in_flight_.load(std::memory_order_relaxed));
+  report->set_ewma_service_ms(
+      static_cast<float>(ewma_service_ms_.load(std::memory_order_relaxed)));
+  report->set_input_width(input_width_.load(std::memory_order_relaxed));
+  report->set_input_height(input_height_.load(std::memory_order_relaxed));
+}
+
+void LoadTracker::RecordService(std::chrono::nanoseconds elapsed) {
+  double sample = std::chrono::duration<double, std::milli>(elapsed).count();
+  double current = ewma_service_ms_.load(std::memory_order_relaxed);
+  double next = 0.0;
+  do {
+    // The first sample seeds the average instead of decaying from zero
+    next = current == 0.0 ? sample : current + alpha_ * (sample - current);
+  } while (!ewma_service_ms_.compare_exchange_weak(
+      current, next, std::memory_order_relaxed));
+}
+
+}  // namespace aa::server
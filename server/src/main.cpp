@@ -11,6 +11,10 @@
  * - YOLO model loading and initialization
  * - gRPC server setup and lifecycle management
  * - Signal handling for graceful shutdown
+ * - Optional pre-fork worker processes sharing the port via SO_REUSEPORT
+ *   and the model loaded once before forking
+ * - Startup memory report split into shared and private pages
+ * - Offline job mode running a local video file as fast as possible
  * - Comprehensive logging and error handling
  *
  * @author AA Video Processing Team
@@ -26,25 +30,34 @@
 #include "signal_set.h"
 
 #include "detector_server.h"
+#include "inference_engine.h"
+#include "memory_usage.h"
+#include "supervisor.h"
+#include "video_job.h"
 
 using namespace aa::server;
 using namespace aa::shared;
 
-int main(int argc, char* argv[]) {  // Parse command line arguments
-  Options options(argc, argv, "Detector Server");
-
-  // Check if arguments are valid
-  if (!options.IsValid()) {
-    options.PrintHelp();
-    return 1;
-  }
-
-  Logging::Initialize(options.IsVerbose());
-
-  AA_LOG_INFO("Starting detector server...");
+namespace {
 
+/**
+ * @brief Run one detector server until SIGINT/SIGTERM
+ *
+ * @param options Parsed command line options
+ * @param stats Counters to record into (nullptr = owned by the server)
+ * @param engine Engine loaded before forking (nullptr = load the model)
+ * @return int Process exit code
+ */
+int RunServer(const Options& options, ServerStats* stats,
+              std::unique_ptr<InferenceEngine> engine = nullptr) {
   // Initialize the detector server
-  DetectorServer server(options);
+  DetectorServer server(
+      options, engine ? std::move(engine) : CreateInferenceEngine(options),
+      stats);
+
+  // Allocate the activations, so the report shows the serving footprint
+  server.WarmUp();
+  AA_LOG_INFO("Memory after warm-up: " << MemoryUsage::Read().ToString());
 
   // Set up graceful shutdown signal handling
   SignalSet signal_set;
@@ -68,9 +81,14 @@ int main(int argc, char* argv[]) {  // Parse command line arguments
   });
 
   signal_set.Add(SIGUSR1, [&](int sig) {
+    auto stats = server.GetStats();
     AA_LOG_INFO("Received SIGUSR1 ("
                 << sig << "), server status: "
-                << (shutdown_requested.load() ? "shutting down" : "running"));
+                << (shutdown_requested.load() ? "shutting down" : "running")
+                << ", " << stats.ToString());
+    if (auto stages = stats.StagesToString(); !stages.empty()) {
+      AA_LOG_INFO("Stage counters:\n" << stages);
+    }
   });
 
   AA_LOG_INFO(
@@ -93,3 +111,81 @@ int main(int argc, char* argv[]) {  // Parse command line arguments
 
   return 0;
 }
+
+/**
+ * @brief Supervise several server processes listening on the same port
+ *
+ * @param options Parsed command line options
+ * @return int Process exit code
+ */
+int RunSupervisor(const Options& options) {
+  // Workers inherit the loaded model copy-on-write, so its weights stay in
+  // pages shared by all of them. The supervisor never runs it: a forward
+  // pass would start thread pools that do not survive fork().
+  std::unique_ptr<InferenceEngine> engine;
+  if (options.Get<bool>("share_model")) {
+    try {
+      engine = CreateInferenceEngine(options);
+    } catch (const std::exception& e) {
+      AA_LOG_ERROR("Failed to load the model: " << e.what());
+      return 1;
+    }
+    AA_LOG_INFO("Model loaded once for all workers, supervisor memory: "
+                << MemoryUsage::Read().ToString());
+  }
+
+  // Moving the engine only empties the forked child's copy, so restarted
+  // workers get it again
+  Supervisor supervisor(
+      options.Get<int>("workers"), options.Get<int>("cpus_per_worker"),
+      [&options, &engine](int, ServerStats* stats) {
+        return RunServer(options, stats, std::move(engine));
+      });
+
+  // Handles SIGINT, SIGTERM and SIGUSR1 itself: a signal thread would
+  // still be running in the supervisor at every fork()
+  return supervisor.Run();
+}
+
+/**
+ * @brief Process a local video file offline and exit
+ *
+ * @param options Parsed command line options
+ * @return int Process exit code
+ */
+int RunJob(const Options& options) {
+  try {
+    auto engine = CreateInferenceEngine(options);
+    VideoJob job(*engine, VideoJobOptions::FromOptions(options));
+    return job.Run() ? 0 : 1;
+  } catch (const std::exception& e) {
+    AA_LOG_ERROR("Job error: " << e.what());
+    return 1;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {  // Parse command line arguments
+  Options options(argc, argv, "Detector Server");
+
+  // Check if arguments are valid
+  if (!options.IsValid()) {
+    options.PrintHelp();
+    return 1;
+  }
+
+  Logging::Initialize(options.IsVerbose());
+
+  if (options.Has("job")) {
+    return RunJob(options);
+  }
+
+  AA_LOG_INFO("Starting detector server...");
+
+  if (options.Get<int>("workers") > 1) {
+    return RunSupervisor(options);
+  }
+
+  return RunServer(options, nullptr);
+}
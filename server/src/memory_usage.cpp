@@ -0,0 +1,68 @@
+#include "memory_usage.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+constexpr double kMiB = 1024.0 * 1024.0;
+
+}  // namespace
+
+namespace aa::server {
+
+MemoryUsage MemoryUsage::Read() {
+  std::ifstream rollup("/proc/self/smaps_rollup");
+  if (rollup) {
+    return Parse(rollup);
+  }
+
+  MemoryUsage usage;
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  uint64_t file_backed = 0;
+  if (statm >> size >> resident >> file_backed) {
+    const auto page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    usage.rss = resident * page;
+    usage.shared = file_backed * page;
+    usage.private_bytes = usage.rss - usage.shared;
+  }
+  return usage;
+}
+
+MemoryUsage MemoryUsage::Parse(std::istream& smaps_rollup) {
+  MemoryUsage usage;
+  std::string line;
+  while (std::getline(smaps_rollup, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    uint64_t kib = 0;
+    if (!(fields >> key >> kib)) continue;
+
+    const uint64_t bytes = kib * 1024;
+    if (key == "Rss:") {
+      usage.rss = bytes;
+    } else if (key == "Pss:") {
+      usage.pss = bytes;
+    } else if (key == "Shared_Clean:" || key == "Shared_Dirty:") {
+      usage.shared += bytes;
+    } else if (key == "Private_Clean:" || key == "Private_Dirty:") {
+      usage.private_bytes += bytes;
+    }
+  }
+  return usage;
+}
+
+std::string MemoryUsage::ToString() const {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1) << "rss " << rss / kMiB
+      << " MiB, pss " << pss / kMiB << " MiB, shared " << shared / kMiB
+      << " MiB, private " << private_bytes / kMiB << " MiB";
+  return out.str();
+}
+
+}  // namespace aa::server
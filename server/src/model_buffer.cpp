@@ -0,0 +1,51 @@
+#include "model_buffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "logging.h"
+
+namespace aa::server {
+
+ModelBuffer::ModelBuffer(const std::string& path) : path_{path} {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    AA_LOG_ERROR("Cannot open model " << path << ": " << std::strerror(errno));
+    throw std::runtime_error("Cannot open model file");
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    AA_LOG_ERROR("Model " << path << " is empty or cannot be read");
+    throw std::runtime_error("Cannot read model file");
+  }
+
+  size_ = static_cast<std::size_t>(st.st_size);
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps the file referenced
+  close(fd);
+  if (data == MAP_FAILED) {
+    AA_LOG_ERROR("Failed to map model " << path << ": "
+                                        << std::strerror(errno));
+    throw std::runtime_error("Failed to map model file");
+  }
+
+  data_ = data;
+  // Parsers read the model front to back, once per worker
+  madvise(data_, size_, MADV_SEQUENTIAL);
+}
+
+ModelBuffer::~ModelBuffer() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+}  // namespace aa::server
@@ -0,0 +1,253 @@
+#include "nms.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "logging.h"
+
+namespace aa::server {
+
+NmsOptions NmsOptions::FromOptions(const aa::shared::Options& options) {
+  NmsOptions nms_options;
+  nms_options.score_threshold = options.Get<float>("thr");
+  nms_options.iou_threshold = options.Get<float>("nms");
+  nms_options.top_k = std::max(0, options.Get<int>("topk"));
+  nms_options.max_detections = std::max(0, options.Get<int>("max_det"));
+  nms_options.class_agnostic = options.Get<bool>("nms_agnostic");
+  nms_options.soft_sigma = options.Get<float>("soft_sigma");
+
+  auto mode = options.Get<std::string>("nms_mode");
+  if (!ParseNmsMode(mode, nms_options.mode)) {
+    AA_LOG_WARNING("Unknown NMS mode '" << mode << "', using hard NMS");
+  }
+
+  return nms_options;
+}
+
+bool ParseNmsMode(std::string_view name, NmsMode& mode) {
+  if (name == "hard") {
+    mode = NmsMode::kHard;
+    return true;
+  }
+  if (name == "soft") {
+    mode = NmsMode::kSoft;
+    return true;
+  }
+  return false;
+}
+
+void NmsCandidates::Clear() {
+  x1.clear();
+  y1.clear();
+  x2.clear();
+  y2.clear();
+  score.clear();
+  class_id.clear();
+}
+
+void NmsCandidates::Reserve(std::size_t capacity) {
+  x1.reserve(capacity);
+  y1.reserve(capacity);
+  x2.reserve(capacity);
+  y2.reserve(capacity);
+  score.reserve(capacity);
+  class_id.reserve(capacity);
+}
+
+void NmsCandidates::Add(float left, float top, float right, float bottom,
+                        float conf, int32_t cls) {
+  x1.push_back(left);
+  y1.push_back(top);
+  x2.push_back(right);
+  y2.push_back(bottom);
+  score.push_back(conf);
+  class_id.push_back(cls);
+}
+
+Nms::Nms(NmsOptions options) : options_{options} {}
+
+void Nms::Run(NmsCandidates& candidates, std::vector<int>& keep) {
+  Run(candidates, options_.score_threshold, options_.max_detections, keep);
+}
+
+void Nms::Run(NmsCandidates& candidates, float score_threshold,
+              int max_detections, std::vector<int>& keep) {
+  keep.clear();
+  if (candidates.Empty()) {
+    return;
+  }
+
+  std::size_t count = SelectTopK(candidates, score_threshold);
+  if (count == 0) {
+    return;
+  }
+
+  Gather(candidates, count);
+
+  std::size_t max_keep =
+      max_detections > 0 ? static_cast<std::size_t>(max_detections) : count;
+
+  if (options_.mode == NmsMode::kSoft) {
+    RunSoft(candidates, count, score_threshold, max_keep, keep);
+  } else {
+    RunHard(count, max_keep, keep);
+  }
+}
+
+std::size_t Nms::SelectTopK(const NmsCandidates& candidates,
+                            float score_threshold) {
+  const auto& scores = candidates.score;
+
+  order_.clear();
+  for (std::size_t i = 0; i < candidates.Size(); ++i) {
+    if (scores[i] >= score_threshold) {
+      order_.push_back(static_cast<int>(i));
+    }
+  }
+
+  // Ties are broken by index so results are deterministic
+  auto by_score = [&scores](int a, int b) {
+    return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+  };
+
+  std::size_t top_k = static_cast<std::size_t>(options_.top_k);
+  if (top_k > 0 && order_.size() > top_k) {
+    std::nth_element(order_.begin(), order_.begin() + top_k, order_.end(),
+                     by_score);
+    order_.resize(top_k);
+  }
+
+  std::sort(order_.begin(), order_.end(), by_score);
+  return order_.size();
+}
+
+void Nms::Gather(const NmsCandidates& candidates, std::size_t count) {
+  x1_.resize(count);
+  y1_.resize(count);
+  x2_.resize(count);
+  y2_.resize(count);
+  area_.resize(count);
+  score_.resize(count);
+  suppressed_.assign(count, 0);
+
+  // Per-class suppression is batched into one pass by moving every class
+  // into its own disjoint coordinate region: boxes of different classes can
+  // then never overlap and a single agnostic sweep handles all classes.
+  float min_coord = 0.0f;
+  float max_coord = 0.0f;
+  if (!options_.class_agnostic) {
+    min_coord = candidates.x1[order_[0]];
+    max_coord = candidates.x2[order_[0]];
+    for (std::size_t i = 0; i < count; ++i) {
+      int idx = order_[i];
+      min_coord = std::min({min_coord, candidates.x1[idx], candidates.y1[idx]});
+      max_coord = std::max({max_coord, candidates.x2[idx], candidates.y2[idx]});
+    }
+  }
+  const float class_offset = max_coord - min_coord + 1.0f;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    int idx = order_[i];
+    float offset = options_.class_agnostic
+                       ? 0.0f
+                       : static_cast<float>(candidates.class_id[idx]) *
+                             class_offset;
+    x1_[i] = candidates.x1[idx] + offset;
+    y1_[i] = candidates.y1[idx] + offset;
+    x2_[i] = candidates.x2[idx] + offset;
+    y2_[i] = candidates.y2[idx] + offset;
+    area_[i] = std::max(0.0f, candidates.x2[idx] - candidates.x1[idx]) *
+               std::max(0.0f, candidates.y2[idx] - candidates.y1[idx]);
+    score_[i] = candidates.score[idx];
+  }
+}
+
+void Nms::RunHard(std::size_t count, std::size_t max_keep,
+                  std::vector<int>& keep) {
+  const float* x1 = x1_.data();
+  const float* y1 = y1_.data();
+  const float* x2 = x2_.data();
+  const float* y2 = y2_.data();
+  const float* area = area_.data();
+  uint8_t* suppressed = suppressed_.data();
+  const float iou_threshold = options_.iou_threshold;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    if (suppressed[i]) continue;
+
+    keep.push_back(order_[i]);
+    if (keep.size() >= max_keep) break;
+
+    const float bx1 = x1[i];
+    const float by1 = y1[i];
+    const float bx2 = x2[i];
+    const float by2 = y2[i];
+    const float barea = area[i];
+
+    // Branch-free so the loop vectorizes: IoU > t <=> inter > t * union
+    for (std::size_t j = i + 1; j < count; ++j) {
+      const float w =
+          std::max(0.0f, std::min(bx2, x2[j]) - std::max(bx1, x1[j]));
+      const float h =
+          std::max(0.0f, std::min(by2, y2[j]) - std::max(by1, y1[j]));
+      const float inter = w * h;
+      const float uni = barea + area[j] - inter;
+      suppressed[j] |= static_cast<uint8_t>(inter > iou_threshold * uni);
+    }
+  }
+}
+
+void Nms::RunSoft(NmsCandidates& candidates, std::size_t count,
+                  float score_threshold, std::size_t max_keep,
+                  std::vector<int>& keep) {
+  const float* x1 = x1_.data();
+  const float* y1 = y1_.data();
+  const float* x2 = x2_.data();
+  const float* y2 = y2_.data();
+  const float* area = area_.data();
+  float* score = score_.data();
+  uint8_t* suppressed = suppressed_.data();
+  const float inv_sigma = 1.0f / std::max(options_.soft_sigma, 1e-6f);
+
+  while (keep.size() < max_keep) {
+    // Scores change after every pick, so the best box is searched each round
+    std::size_t best = count;
+    float best_score = score_threshold;
+    for (std::size_t j = 0; j < count; ++j) {
+      if (!suppressed[j] && score[j] >= best_score) {
+        if (best == count || score[j] > best_score) {
+          best = j;
+          best_score = score[j];
+        }
+      }
+    }
+    if (best == count) break;
+
+    suppressed[best] = 1;
+    keep.push_back(order_[best]);
+    candidates.score[order_[best]] = best_score;
+
+    const float bx1 = x1[best];
+    const float by1 = y1[best];
+    const float bx2 = x2[best];
+    const float by2 = y2[best];
+    const float barea = area[best];
+
+    for (std::size_t j = 0; j < count; ++j) {
+      const float w =
+          std::max(0.0f, std::min(bx2, x2[j]) - std::max(bx1, x1[j]));
+      const float h =
+          std::max(0.0f, std::min(by2, y2[j]) - std::max(by1, y1[j]));
+      const float inter = w * h;
+      const float uni = barea + area[j] - inter;
+      const float iou = uni > 0.0f ? inter / uni : 0.0f;
+      score[j] *= std::exp(-(iou * iou) * inv_sigma);
+    }
+
+    for (std::size_t j = 0; j < count; ++j) {
+      suppressed[j] |= static_cast<uint8_t>(score[j] < score_threshold);
+    }
+  }
+}
+
+}  // namespace aa::server
@@ -0,0 +1,97 @@
+#include "occupancy_tracker.h"
+
+#include <algorithm>
+
+namespace aa::server {
+
+namespace {
+
+bool TargetsClass(const aa::shared::Polygon& zone, int32_t class_id) {
+  const auto& classes = zone.GetTargetClasses();
+  return classes.empty() ||
+         std::find(classes.begin(), classes.end(), class_id) != classes.end();
+}
+
+aa::proto::ZoneEventType EventType(uint32_t previous, uint32_t count) {
+  if (previous == 0) return aa::proto::ZONE_EVENT_TYPE_ENTER;
+  if (count == 0) return aa::proto::ZONE_EVENT_TYPE_EXIT;
+  return aa::proto::ZONE_EVENT_TYPE_COUNT_CHANGED;
+}
+
+}  // namespace
+
+OccupancyTracker::OccupancyTracker(std::vector<aa::shared::Polygon> zones,
+                                   int debounce_frames)
+    : zones_{std::move(zones)},
+      debounce_frames_{std::max(1, debounce_frames)} {}
+
+void OccupancyTracker::Update(
+    const std::vector<aa::shared::Detection>& detections,
+    uint64_t frame_index, double timestamp_ms,
+    aa::proto::ZoneEvents* events) {
+  counts_.clear();
+  for (const auto& detection : detections) {
+    double center_x = detection.bbox.x + detection.bbox.width / 2.0;
+    double center_y = detection.bbox.y + detection.bbox.height / 2.0;
+
+    for (std::size_t i = 0; i < zones_.size(); ++i) {
+      const auto& zone = zones_[i];
+      if (zone.GetType() == aa::shared::PolygonType::INCLUSION &&
+          TargetsClass(zone, detection.class_id) &&
+          zone.Contains(center_x, center_y)) {
+        ++counts_[{static_cast<uint32_t>(i), detection.class_id}];
+      }
+    }
+  }
+
+  // Classes seen for the first time start from an empty state
+  for (const auto& [key, count] : counts_) {
+    states_.try_emplace(key);
+  }
+
+  for (auto it = states_.begin(); it != states_.end();) {
+    auto& state = it->second;
+    auto found = counts_.find(it->first);
+    uint32_t observed = found != counts_.end() ? found->second : 0;
+
+    if (observed == state.stable) {
+      state.pending = observed;
+      state.streak = 0;
+    } else {
+      if (observed == state.pending) {
+        ++state.streak;
+      } else {
+        state.pending = observed;
+        state.streak = 1;
+      }
+
+      if (state.streak >= debounce_frames_) {
+        auto* event = events->add_events();
+        event->set_type(EventType(state.stable, observed));
+        event->set_zone(it->first.first);
+        event->set_class_id(it->first.second);
+        event->set_count(observed);
+        event->set_previous_count(state.stable);
+        event->set_frame_index(frame_index);
+        event->set_timestamp_ms(timestamp_ms);
+
+        state.stable = observed;
+        state.streak = 0;
+      }
+    }
+
+    // Empty, settled states carry no information
+    if (state.stable == 0 && state.streak == 0) {
+      it = states_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+uint32_t OccupancyTracker::Count(uint32_t zone, int32_t class_id) const {
+  auto it = states_.find({zone, class_id});
+  return it != states_.end() ? it->second.stable : 0;
+}
+
+}  // namespace aa::server
@@ -0,0 +1,202 @@
+#include "perf_counters.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "logging.h"
+#include "server_stats.h"
+
+namespace {
+
+/**
+ * @brief Sampling target of the calling thread
+ */
+struct ThreadSampling {
+  aa::server::ServerStats* stats{nullptr};
+  uint32_t frames{0};
+  uint32_t credited{0};  ///< Stages already credited with the frames
+};
+
+// Logged once per process rather than once per thread
+std::atomic<bool> g_unavailable_logged{false};
+
+thread_local ThreadSampling t_sampling;
+
+#ifdef __linux__
+uint64_t NowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+// Event order matches the PerfReading fields
+constexpr uint64_t kEventConfigs[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+int OpenEvent(uint64_t config, int group_fd) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1,
+                                  group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+#endif
+
+}  // namespace
+
+namespace aa::server {
+
+std::string_view PerfStageName(PerfStage stage) {
+  switch (stage) {
+    case PerfStage::kDecode:
+      return "decode";
+    case PerfStage::kPreprocess:
+      return "preprocess";
+    case PerfStage::kForward:
+      return "forward";
+    case PerfStage::kPostprocess:
+      return "postprocess";
+    case PerfStage::kFilter:
+      return "filter";
+    case PerfStage::kDraw:
+      return "draw";
+    case PerfStage::kEncode:
+      return "encode";
+  }
+  return "unknown";
+}
+
+PerfReading PerfReading::operator-(const PerfReading& start) const {
+  PerfReading delta{cycles - start.cycles,
+                    instructions - start.instructions,
+                    llc_misses - start.llc_misses,
+                    branch_misses - start.branch_misses,
+                    time_ns - start.time_ns,
+                    time_enabled_ns - start.time_enabled_ns,
+                    time_running_ns - start.time_running_ns};
+
+  // Extrapolate counts when the group was multiplexed off the PMU in
+  // this interval; the cumulative ratio would smear earlier intervals in
+  if (delta.time_running_ns > 0 &&
+      delta.time_running_ns < delta.time_enabled_ns) {
+    double scale = static_cast<double>(delta.time_enabled_ns) /
+                   static_cast<double>(delta.time_running_ns);
+    for (uint64_t* count : {&delta.cycles, &delta.instructions,
+                            &delta.llc_misses, &delta.branch_misses}) {
+      *count = static_cast<uint64_t>(static_cast<double>(*count) * scale);
+    }
+  }
+  return delta;
+}
+
+PerfCounters* PerfCounters::ForThisThread() {
+  // Opened on first use; a thread without counters does not retry
+  thread_local std::unique_ptr<PerfCounters> counters = [] {
+    std::unique_ptr<PerfCounters> opened{new PerfCounters()};
+    if (!opened->Open()) opened.reset();
+    return opened;
+  }();
+  return counters.get();
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (int fd : fds_) {
+    if (fd >= 0) close(fd);
+  }
+#endif
+}
+
+bool PerfCounters::Open() {
+#ifdef __linux__
+  for (int i = 0; i < kEvents; ++i) {
+    fds_[i] = OpenEvent(kEventConfigs[i], i == 0 ? -1 : fds_[0]);
+    if (fds_[i] < 0) {
+      if (!g_unavailable_logged.exchange(true)) {
+        AA_LOG_WARNING("Hardware performance counters unavailable "
+                       "(perf_event_open failed for event "
+                       << i << "), stage counters are not sampled");
+      }
+      return false;
+    }
+  }
+  ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::optional<PerfReading> PerfCounters::Read() const {
+#ifdef __linux__
+  PerfReading reading;
+  reading.time_ns = NowNs();
+
+  // nr, time_enabled, time_running, then one value per event
+  uint64_t values[3 + kEvents] = {};
+  if (read(fds_[0], values, sizeof(values)) !=
+          static_cast<ssize_t>(sizeof(values)) ||
+      values[0] != kEvents) {
+    return std::nullopt;
+  }
+
+  reading.time_enabled_ns = values[1];
+  reading.time_running_ns = values[2];
+  reading.cycles = values[3];
+  reading.instructions = values[4];
+  reading.llc_misses = values[5];
+  reading.branch_misses = values[6];
+  return reading;
+#else
+  return std::nullopt;
+#endif
+}
+
+PerfSampling::PerfSampling(ServerStats* stats, uint32_t frames) {
+  t_sampling = ThreadSampling{frames > 0 ? stats : nullptr, frames, 0};
+}
+
+PerfSampling::~PerfSampling() { t_sampling = ThreadSampling{}; }
+
+PerfScope::PerfScope(PerfStage stage) : stage_{stage} {
+  if (t_sampling.stats == nullptr) return;
+  counters_ = PerfCounters::ForThisThread();
+  if (counters_ != nullptr) start_ = counters_->Read();
+}
+
+PerfScope::~PerfScope() {
+  if (!start_ || t_sampling.stats == nullptr) return;
+
+  // A failed read or a stage the group never ran in has no counts to scale
+  auto end = counters_->Read();
+  if (!end) return;
+  PerfReading delta = *end - *start_;
+  if (delta.time_running_ns == 0) return;
+
+  // A stage run once per frame of a batch counts the frames only once
+  const uint32_t bit = 1u << static_cast<int>(stage_);
+  uint32_t frames = (t_sampling.credited & bit) ? 0 : t_sampling.frames;
+  t_sampling.credited |= bit;
+  t_sampling.stats->RecordStage(stage_, delta, frames);
+}
+
+}  // namespace aa::server
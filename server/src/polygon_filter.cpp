@@ -15,17 +15,16 @@ std::pair<double, double> PolygonFilter::GetDetectionCenter(
   return {center_x, center_y};
 }
 
-std::vector<const aa::shared::Polygon*> PolygonFilter::FindContainingPolygons(
-    double center_x, double center_y) {
-  std::vector<const aa::shared::Polygon*> containing_polygons;
-
-  for (const auto& polygon : polygons_) {
-    if (polygon.Contains(center_x, center_y)) {
-      containing_polygons.push_back(&polygon);
+void PolygonFilter::FindContainingPolygons(
+    double center_x, double center_y,
+    std::vector<const aa::shared::Polygon*>& containing_polygons) {
+  containing_polygons.clear();
+
+  for (std::size_t i = 0; i < polygons_.size(); ++i) {
+    if (compiled_[i].Contains(center_x, center_y)) {
+      containing_polygons.push_back(&polygons_[i]);
     }
   }
-
-  return containing_polygons;
 }
 
 bool PolygonFilter::ShouldIncludeDetection(
@@ -65,34 +64,47 @@ bool PolygonFilter::IsDetectionClassAllowed(
 std::vector<aa::shared::Detection> PolygonFilter::FilterDetectionsByPolygons(
     const std::vector<aa::shared::Detection>& detections) {
   std::vector<aa::shared::Detection> filtered_detections;
+  FilterDetectionsByPolygons(detections, filtered_detections);
+  return filtered_detections;
+}
+
+void PolygonFilter::FilterDetectionsByPolygons(
+    const std::vector<aa::shared::Detection>& detections,
+    std::vector<aa::shared::Detection>& filtered) {
+  filtered.clear();
 
   for (const auto& detection : detections) {
     auto [center_x, center_y] = GetDetectionCenter(detection);
 
-    auto containing_polygons = FindContainingPolygons(center_x, center_y);
+    FindContainingPolygons(center_x, center_y, containing_);
 
-    if (containing_polygons.empty()) {
+    if (containing_.empty()) {
       continue;
     }
 
-    std::sort(containing_polygons.begin(), containing_polygons.end(),
+    std::sort(containing_.begin(), containing_.end(),
               [](const aa::shared::Polygon* a, const aa::shared::Polygon* b) {
                 return a->GetPriority() > b->GetPriority();
               });
 
-    if (ShouldIncludeDetection(detection, containing_polygons)) {
-      filtered_detections.push_back(detection);
+    if (ShouldIncludeDetection(detection, containing_)) {
+      filtered.push_back(detection);
     }
   }
-
-  return filtered_detections;
 }
 
-void PolygonFilter::SetPolygons(std::vector<aa::shared::Polygon>&& polygons) {
+void PolygonFilter::SetPolygons(std::vector<aa::shared::Polygon>&& polygons,
+                                double tolerance) {
   polygons_ = std::move(polygons);
+  compiled_.clear();
+  compiled_.reserve(polygons_.size());
+  for (const auto& polygon : polygons_) {
+    compiled_.push_back(CompiledPolygon::Compile(polygon, tolerance));
+  }
 }
 
-void PolygonFilter::DrawPolygonBoundingBoxes(cv::Mat& frame) const {
+void PolygonFilter::DrawPolygonBoundingBoxes(cv::Mat& frame,
+                                             double scale) const {
   for (size_t i = 0; i < polygons_.size(); ++i) {
     const auto& polygon = polygons_[i];
     const auto& vertices = polygon.GetVertices();
@@ -114,6 +126,11 @@ void PolygonFilter::DrawPolygonBoundingBoxes(cv::Mat& frame) const {
       max_y = std::max(max_y, vertex.GetY());
     }
 
+    min_x *= scale;
+    max_x *= scale;
+    min_y *= scale;
+    max_y *= scale;
+
     // Convert to integer coordinates
     int left = static_cast<int>(std::max(0.0, min_x));
     int top = static_cast<int>(std::max(0.0, min_y));
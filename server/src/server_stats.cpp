@@ -0,0 +1,122 @@
+#include "server_stats.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace aa::server {
+
+PerfStageSnapshot& PerfStageSnapshot::operator+=(
+    const PerfStageSnapshot& other) {
+  frames += other.frames;
+  cycles += other.cycles;
+  instructions += other.instructions;
+  llc_misses += other.llc_misses;
+  branch_misses += other.branch_misses;
+  time_ns += other.time_ns;
+  return *this;
+}
+
+double ServerStatsSnapshot::MeanLatencyMs() const {
+  if (requests == 0) return 0.0;
+  return static_cast<double>(busy_ns) / static_cast<double>(requests) / 1e6;
+}
+
+ServerStatsSnapshot& ServerStatsSnapshot::operator+=(
+    const ServerStatsSnapshot& other) {
+  requests += other.requests;
+  failures += other.failures;
+  detections += other.detections;
+  busy_ns += other.busy_ns;
+  for (int i = 0; i < kPerfStageCount; ++i) {
+    stages[i] += other.stages[i];
+  }
+  return *this;
+}
+
+std::string ServerStatsSnapshot::ToString() const {
+  std::ostringstream summary;
+  summary << "requests=" << requests << " failures=" << failures
+          << " detections=" << detections << " mean_latency=" << std::fixed
+          << std::setprecision(2) << MeanLatencyMs() << "ms";
+  return summary.str();
+}
+
+std::string ServerStatsSnapshot::StagesToString() const {
+  std::ostringstream summary;
+  summary << std::fixed;
+  for (int i = 0; i < kPerfStageCount; ++i) {
+    const auto& stage = stages[i];
+    if (stage.frames == 0) continue;
+
+    auto frames = static_cast<double>(stage.frames);
+    auto cycles = static_cast<double>(stage.cycles);
+    auto kilo_instructions = static_cast<double>(stage.instructions) / 1e3;
+    if (summary.tellp() > 0) summary << "\n";
+    summary << PerfStageName(static_cast<PerfStage>(i))
+            << ": frames=" << stage.frames << std::setprecision(0)
+            << " cycles/frame=" << cycles / frames << std::setprecision(2)
+            << " ipc="
+            << (cycles > 0 ? static_cast<double>(stage.instructions) / cycles
+                           : 0.0)
+            << " llc_mpki="
+            << (kilo_instructions > 0 ? stage.llc_misses / kilo_instructions
+                                      : 0.0)
+            << " branch_mpki="
+            << (kilo_instructions > 0
+                    ? stage.branch_misses / kilo_instructions
+                    : 0.0)
+            << " time/frame=" << static_cast<double>(stage.time_ns) / frames /
+                                     1e6
+            << "ms";
+  }
+  return summary.str();
+}
+
+void ServerStats::Record(bool ok, std::chrono::nanoseconds elapsed) {
+  requests.fetch_add(1, std::memory_order_relaxed);
+  if (!ok) {
+    failures.fetch_add(1, std::memory_order_relaxed);
+  }
+  busy_ns.fetch_add(static_cast<uint64_t>(elapsed.count()),
+                    std::memory_order_relaxed);
+}
+
+void ServerStats::AddDetections(uint64_t count) {
+  detections.fetch_add(count, std::memory_order_relaxed);
+}
+
+void ServerStats::RecordStage(PerfStage stage, const PerfReading& delta,
+                              uint32_t frames) {
+  auto& counters = stages[static_cast<int>(stage)];
+  counters.frames.fetch_add(frames, std::memory_order_relaxed);
+  counters.cycles.fetch_add(delta.cycles, std::memory_order_relaxed);
+  counters.instructions.fetch_add(delta.instructions,
+                                  std::memory_order_relaxed);
+  counters.llc_misses.fetch_add(delta.llc_misses, std::memory_order_relaxed);
+  counters.branch_misses.fetch_add(delta.branch_misses,
+                                   std::memory_order_relaxed);
+  counters.time_ns.fetch_add(delta.time_ns, std::memory_order_relaxed);
+}
+
+ServerStatsSnapshot ServerStats::Snapshot() const {
+  ServerStatsSnapshot snapshot;
+  snapshot.requests = requests.load(std::memory_order_relaxed);
+  snapshot.failures = failures.load(std::memory_order_relaxed);
+  snapshot.detections = detections.load(std::memory_order_relaxed);
+  snapshot.busy_ns = busy_ns.load(std::memory_order_relaxed);
+  for (int i = 0; i < kPerfStageCount; ++i) {
+    const auto& counters = stages[i];
+    auto& stage = snapshot.stages[i];
+    stage.frames = counters.frames.load(std::memory_order_relaxed);
+    stage.cycles = counters.cycles.load(std::memory_order_relaxed);
+    stage.instructions =
+        counters.instructions.load(std::memory_order_relaxed);
+    stage.llc_misses = counters.llc_misses.load(std::memory_order_relaxed);
+    stage.branch_misses =
+        counters.branch_misses.load(std::memory_order_relaxed);
+    stage.time_ns = counters.time_ns.load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+}  // namespace aa::server
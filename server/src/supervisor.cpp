@@ -0,0 +1,349 @@
+#include "supervisor.h"
+
+#include <poll.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+
+#include <opencv2/core/utility.hpp>
+
+#include "logging.h"
+
+namespace {
+// Workers dying faster than this are restarted with a delay
+constexpr auto kMinWorkerUptime = std::chrono::seconds{1};
+
+// Exited workers are reaped at least this often (ms)
+constexpr int kReapIntervalMs = 200;
+}  // namespace
+
+namespace aa::server {
+
+Supervisor::Supervisor(int workers, int cpus_per_worker,
+                       WorkerMain worker_main)
+    : workers_{std::max(1, workers)},
+      cpus_per_worker_{std::max(0, cpus_per_worker)},
+      worker_main_{std::move(worker_main)},
+      pids_(static_cast<std::size_t>(workers_), 0),
+      started_(static_cast<std::size_t>(workers_)),
+      restart_at_(static_cast<std::size_t>(workers_)) {
+  std::size_t size = sizeof(ServerStats) * static_cast<std::size_t>(workers_);
+  void* block = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (block == MAP_FAILED) {
+    AA_LOG_ERROR("Failed to map shared stats: " << std::strerror(errno));
+    throw std::runtime_error("Failed to map shared stats");
+  }
+
+  stats_ = static_cast<ServerStats*>(block);
+  for (int i = 0; i < workers_; ++i) {
+    new (&stats_[i]) ServerStats();
+  }
+
+  wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wake_fd_ < 0) {
+    AA_LOG_ERROR("Failed to create eventfd: " << std::strerror(errno));
+    munmap(stats_, size);
+    throw std::runtime_error("Failed to create supervisor eventfd");
+  }
+}
+
+Supervisor::~Supervisor() {
+  if (stats_ != nullptr) {
+    munmap(stats_, sizeof(ServerStats) * static_cast<std::size_t>(workers_));
+  }
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+  }
+}
+
+int Supervisor::Run() {
+  sigset_t handled;
+  sigemptyset(&handled);
+  for (int signal : {SIGINT, SIGTERM, SIGUSR1, SIGCHLD}) {
+    sigaddset(&handled, signal);
+  }
+
+  // Workers get the mask the supervisor was started with back
+  sigset_t worker_mask;
+  pthread_sigmask(SIG_BLOCK, &handled, &worker_mask);
+  signal_fd_ = signalfd(-1, &handled, SFD_CLOEXEC | SFD_NONBLOCK);
+  if (signal_fd_ < 0) {
+    AA_LOG_ERROR("Failed to create signalfd: " << std::strerror(errno));
+    pthread_sigmask(SIG_SETMASK, &worker_mask, nullptr);
+    return 1;
+  }
+
+  AA_LOG_INFO("Supervisor starting " << workers_ << " worker processes");
+  AA_LOG_INFO("Send SIGUSR1 to log aggregated worker statistics.");
+
+  bool spawn_failed = false;
+  for (int i = 0; i < workers_ && !stopping_.load(); ++i) {
+    if (SpawnWorker(i, worker_mask) < 0) {
+      spawn_failed = true;
+      Stop();
+      break;
+    }
+  }
+
+  while (HasLiveWorkers() || HasPendingRestarts()) {
+    pollfd fds[] = {{signal_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    // SIGCHLD can go to another thread when Run() is not the only one, so
+    // workers are also reaped on a timer
+    if (poll(fds, 2, PollTimeoutMs()) < 0 && errno != EINTR) {
+      AA_LOG_ERROR("poll failed: " << std::strerror(errno));
+      break;
+    }
+
+    uint64_t wakeups = 0;
+    std::ignore = read(wake_fd_, &wakeups, sizeof(wakeups));
+
+    signalfd_siginfo info;
+    while (read(signal_fd_, &info, sizeof(info)) == sizeof(info)) {
+      if (info.ssi_signo == SIGINT || info.ssi_signo == SIGTERM) {
+        AA_LOG_INFO("Received signal " << info.ssi_signo
+                                       << ", stopping workers...");
+        Stop();
+      } else if (info.ssi_signo == SIGUSR1) {
+        LogStats();
+      }
+    }
+
+    ReapWorkers();
+    if (!RestartWorkers(worker_mask)) {
+      spawn_failed = true;
+    }
+  }
+
+  close(signal_fd_);
+  signal_fd_ = -1;
+  pthread_sigmask(SIG_SETMASK, &worker_mask, nullptr);
+
+  AA_LOG_INFO("Supervisor stopped. Totals: " << Aggregate().ToString());
+  return spawn_failed ? 1 : 0;
+}
+
+void Supervisor::Stop() {
+  stopping_.store(true);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (pid_t pid : pids_) {
+      if (pid > 0) {
+        kill(pid, SIGTERM);
+      }
+    }
+  }
+
+  uint64_t wakeup = 1;
+  std::ignore = write(wake_fd_, &wakeup, sizeof(wakeup));
+}
+
+ServerStatsSnapshot Supervisor::Aggregate() const {
+  ServerStatsSnapshot total;
+  for (int i = 0; i < workers_; ++i) {
+    total += stats_[i].Snapshot();
+  }
+  return total;
+}
+
+void Supervisor::LogStats() const {
+  auto total = Aggregate();
+  AA_LOG_INFO("Workers: " << workers_ << " total " << total.ToString());
+  if (auto stages = total.StagesToString(); !stages.empty()) {
+    AA_LOG_INFO("Stage counters of all workers:\n" << stages);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int i = 0; i < workers_; ++i) {
+    AA_LOG_INFO("  worker " << i << " (pid " << pids_[i]
+                            << ") " << stats_[i].Snapshot().ToString());
+  }
+}
+
+void Supervisor::ReapWorkers() {
+  int status = 0;
+  pid_t pid = 0;
+  while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+    int index = -1;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      index = FindWorker(pid);
+      if (index >= 0) pids_[index] = 0;
+    }
+    if (index < 0) continue;
+
+    if (stopping_.load()) {
+      AA_LOG_INFO("Worker " << index << " (pid " << pid << ") exited");
+      continue;
+    }
+
+    if (WIFSIGNALED(status)) {
+      AA_LOG_WARNING("Worker " << index << " (pid " << pid
+                               << ") killed by signal " << WTERMSIG(status)
+                               << ", restarting");
+    } else {
+      AA_LOG_WARNING("Worker " << index << " (pid " << pid
+                               << ") exited with status "
+                               << WEXITSTATUS(status) << ", restarting");
+    }
+
+    // Back off on crash loops, e.g. when the model cannot be loaded
+    auto now = std::chrono::steady_clock::now();
+    restart_at_[index] = now - started_[index] < kMinWorkerUptime
+                             ? now + kMinWorkerUptime
+                             : now;
+  }
+}
+
+bool Supervisor::RestartWorkers(const sigset_t& worker_mask) {
+  auto now = std::chrono::steady_clock::now();
+  for (int i = 0; i < workers_; ++i) {
+    auto& restart_at = restart_at_[i];
+    if (!restart_at) continue;
+
+    // Stop() drops pending restarts instead of waiting them out
+    if (stopping_.load()) {
+      restart_at.reset();
+      continue;
+    }
+    if (*restart_at > now) continue;
+
+    restart_at.reset();
+    if (SpawnWorker(i, worker_mask) < 0) {
+      Stop();
+      return false;
+    }
+  }
+  return true;
+}
+
+int Supervisor::PollTimeoutMs() const {
+  auto timeout = std::chrono::milliseconds{kReapIntervalMs};
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& restart_at : restart_at_) {
+    if (!restart_at) continue;
+    // Rounded up, so the loop does not wake just before the deadline
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+        std::max(*restart_at - now, std::chrono::steady_clock::duration{}));
+    timeout = std::min(timeout, remaining);
+  }
+  return static_cast<int>(timeout.count());
+}
+
+pid_t Supervisor::SpawnWorker(int index, const sigset_t& worker_mask) {
+  // Computed before fork(): the child only makes async-signal-safe calls
+  // until the worker takes over
+  const cpu_set_t cpus = WorkerCpus(index);
+  const int cpu_count = CPU_COUNT(&cpus);
+
+  pid_t pid = fork();
+
+  if (pid < 0) {
+    AA_LOG_ERROR("Failed to fork worker " << index << ": "
+                                          << std::strerror(errno));
+    return -1;
+  }
+
+  if (pid == 0) {
+    // The worker installs its own SignalSet
+    close(signal_fd_);
+    close(wake_fd_);
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    std::signal(SIGUSR1, SIG_DFL);
+    sigprocmask(SIG_SETMASK, &worker_mask, nullptr);
+    const bool pinned =
+        cpu_count == 0 || sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+    const int pin_errno = errno;
+
+    // The supervisor is single-threaded at fork(), so from here on the
+    // worker is an ordinary process
+    int code = 1;
+    try {
+      if (!pinned) {
+        AA_LOG_WARNING("Failed to pin worker " << index << ": "
+                                               << std::strerror(pin_errno));
+      }
+      if (cpu_count > 0) {
+        // Keep OpenCV's thread pool inside the pinned slice
+        cv::setNumThreads(cpu_count);
+      }
+      code = worker_main_(index, &stats_[index]);
+    } catch (const std::exception& e) {
+      AA_LOG_ERROR("Worker " << index << " failed: " << e.what());
+    }
+    std::_Exit(code);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pids_[index] = pid;
+    started_[index] = std::chrono::steady_clock::now();
+  }
+  // A Stop() racing with fork() did not see this worker yet
+  if (stopping_.load()) {
+    kill(pid, SIGTERM);
+  }
+
+  AA_LOG_INFO("Started worker " << index << " (pid " << pid << ")");
+  return pid;
+}
+
+cpu_set_t Supervisor::WorkerCpus(int index) const {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+
+  // Slices are cut from the cores this process may run on, which need not
+  // start at 0 or be contiguous under taskset or a cgroup cpuset
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    AA_LOG_WARNING("Failed to read CPU affinity: " << std::strerror(errno));
+    return set;
+  }
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+  }
+  if (cpus.empty()) return set;
+
+  int count = static_cast<int>(cpus.size());
+  int per_worker = cpus_per_worker_ > 0 ? cpus_per_worker_
+                                        : std::max(1, count / workers_);
+  for (int i = 0; i < per_worker; ++i) {
+    CPU_SET(cpus[(index * per_worker + i) % count], &set);
+  }
+  return set;
+}
+
+int Supervisor::FindWorker(pid_t pid) const {
+  auto it = std::find(pids_.begin(), pids_.end(), pid);
+  return it == pids_.end() ? -1 : static_cast<int>(it - pids_.begin());
+}
+
+bool Supervisor::HasLiveWorkers() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::any_of(pids_.begin(), pids_.end(),
+                     [](pid_t pid) { return pid > 0; });
+}
+
+bool Supervisor::HasPendingRestarts() const {
+  return std::any_of(
+      restart_at_.begin(), restart_at_.end(),
+      [](const auto& restart_at) { return restart_at.has_value(); });
+}
+
+}  // namespace aa::server
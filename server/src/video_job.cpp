@@ -0,0 +1,326 @@
+#include "video_job.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#include <google/protobuf/text_format.h>
+#include <opencv2/videoio.hpp>
+
+#include "drop_oldest_queue.h"
+#include "logging.h"
+#include "polygon.pb.h"
+#include "polygon_filter.h"
+
+namespace {
+
+// Decoded frames buffered per inference batch
+constexpr std::size_t kQueuedBatches = 2;
+
+/**
+ * @brief Decoded frame of one job segment
+ */
+struct JobFrame {
+  std::size_t segment{0};
+  uint64_t index{0};
+  double timestamp_ms{0.0};
+  cv::Mat image;
+};
+
+/**
+ * @brief Frame range [begin, end) of one decode segment
+ */
+struct Segment {
+  uint64_t begin{0};
+  uint64_t end{std::numeric_limits<uint64_t>::max()};
+};
+
+/**
+ * @brief Split a file into contiguous segments of similar length
+ *
+ * The last segment runs until the end of the file, since frame counts of
+ * some containers are estimates.
+ */
+std::vector<Segment> SplitSegments(int64_t frame_count, int segments) {
+  if (frame_count <= 0 || segments <= 1) {
+    return {Segment{}};
+  }
+
+  auto count = static_cast<uint64_t>(
+      std::min<int64_t>(segments, frame_count));
+  auto total = static_cast<uint64_t>(frame_count);
+  std::vector<Segment> result(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    result[i].begin = total * i / count;
+    result[i].end = total * (i + 1) / count;
+  }
+  result.back().end = std::numeric_limits<uint64_t>::max();
+  return result;
+}
+
+std::string PartPath(const std::string& output, std::size_t segment) {
+  return output + ".part" + std::to_string(segment);
+}
+
+}  // namespace
+
+namespace aa::server {
+
+VideoJobOptions VideoJobOptions::FromOptions(
+    const aa::shared::Options& options) {
+  VideoJobOptions job_options;
+  job_options.input = options.Get<std::string>("job");
+  job_options.output = options.Get<std::string>("job_output");
+  if (options.Has("zones")) {
+    job_options.zones = options.Get<std::string>("zones");
+  }
+  job_options.segments = std::max(1, options.Get<int>("segments"));
+  job_options.batch_size = std::max(1, options.Get<int>("batch"));
+  job_options.zone_tolerance =
+      std::max(0.0, options.Get<double>("zone_tolerance"));
+  return job_options;
+}
+
+double VideoJobStats::FramesPerSecond() const {
+  return seconds > 0.0 ? static_cast<double>(frames) / seconds : 0.0;
+}
+
+std::string VideoJobStats::ToString() const {
+  std::ostringstream out;
+  out << frames << " frames in " << std::fixed << std::setprecision(2)
+      << seconds << "s (" << std::setprecision(1) << FramesPerSecond()
+      << " fps), " << batches << " batches, " << detections
+      << " detections";
+  return out.str();
+}
+
+VideoJob::VideoJob(InferenceEngine& engine, VideoJobOptions options,
+                   DetectionBudget budget)
+    : engine_{engine},
+      options_{std::move(options)},
+      budget_{std::move(budget)} {}
+
+bool VideoJob::Run(VideoJobStats* stats) {
+  const auto start = std::chrono::steady_clock::now();
+
+  cv::VideoCapture probe(options_.input);
+  if (!probe.isOpened()) {
+    AA_LOG_ERROR("Cannot open job input " << options_.input);
+    return false;
+  }
+  const auto frame_count =
+      static_cast<int64_t>(probe.get(cv::CAP_PROP_FRAME_COUNT));
+  const int width = static_cast<int>(probe.get(cv::CAP_PROP_FRAME_WIDTH));
+  const int height = static_cast<int>(probe.get(cv::CAP_PROP_FRAME_HEIGHT));
+  probe.release();
+
+  std::vector<aa::shared::Polygon> zones;
+  if (!options_.zones.empty()) {
+    if (!LoadZones(options_.zones, zones)) return false;
+  } else {
+    // No zones: keep everything in the frame
+    zones.emplace_back(
+        std::vector<aa::shared::Point>{{0.0, 0.0},
+                                       {static_cast<double>(width), 0.0},
+                                       {static_cast<double>(width),
+                                        static_cast<double>(height)},
+                                       {0.0, static_cast<double>(height)}},
+        aa::shared::PolygonType::INCLUSION, 0, std::vector<int32_t>{});
+  }
+  if (zones.empty()) {
+    AA_LOG_ERROR("No valid zones in " << options_.zones);
+    return false;
+  }
+
+  std::sort(zones.begin(), zones.end(),
+            [](const aa::shared::Polygon& a, const aa::shared::Polygon& b) {
+              return a.GetPriority() > b.GetPriority();
+            });
+  PolygonFilter polygon_filter;
+  polygon_filter.SetPolygons(std::move(zones), options_.zone_tolerance);
+
+  std::ofstream output(options_.output);
+  if (!output) {
+    AA_LOG_ERROR("Cannot write job output " << options_.output);
+    return false;
+  }
+  output << "frame,timestamp_ms,class_id,confidence,x,y,width,height\n";
+
+  const auto segments = SplitSegments(frame_count, options_.segments);
+  std::vector<std::ofstream> parts(segments.size());
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    parts[i].open(PartPath(options_.output, i));
+    if (!parts[i]) {
+      AA_LOG_ERROR("Cannot write job part " << PartPath(options_.output, i));
+      for (std::size_t j = 0; j < i; ++j) {
+        std::remove(PartPath(options_.output, j).c_str());
+      }
+      return false;
+    }
+  }
+
+  AA_LOG_INFO("Job " << options_.input << ": "
+                     << (frame_count > 0 ? std::to_string(frame_count)
+                                         : std::string{"unknown"})
+                     << " frames, " << segments.size()
+                     << " segments, batches of " << options_.batch_size);
+
+  const auto batch_size = static_cast<std::size_t>(options_.batch_size);
+  DropOldestQueue<JobFrame> queue(batch_size * kQueuedBatches);
+  std::atomic<std::size_t> running{segments.size()};
+  std::atomic<bool> failed{false};
+
+  std::vector<std::jthread> decoders;
+  decoders.reserve(segments.size());
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    decoders.emplace_back([&, i](std::stop_token stop) {
+      try {
+        const auto& segment = segments[i];
+        cv::VideoCapture capture(options_.input);
+        if (!capture.isOpened()) {
+          AA_LOG_ERROR("Cannot open job input for segment " << i);
+          failed.store(true);
+        } else if (segment.begin > 0 &&
+                   !capture.set(cv::CAP_PROP_POS_FRAMES,
+                                static_cast<double>(segment.begin))) {
+          AA_LOG_ERROR("Cannot seek job input to frame " << segment.begin);
+          failed.store(true);
+          capture.release();
+        }
+
+        JobFrame frame;
+        for (uint64_t index = segment.begin;
+             capture.isOpened() && !stop.stop_requested() &&
+             index < segment.end && capture.read(frame.image);
+             ++index) {
+          frame.segment = i;
+          frame.index = index;
+          frame.timestamp_ms = capture.get(cv::CAP_PROP_POS_MSEC);
+          if (!queue.PushWait(std::move(frame))) break;
+          frame = JobFrame{};
+        }
+      } catch (const std::exception& e) {
+        AA_LOG_ERROR("Error decoding job segment " << i << ": " << e.what());
+        failed.store(true);
+      }
+      // The last decoder to finish ends the job
+      if (running.fetch_sub(1) == 1) queue.Close();
+    });
+  }
+
+  VideoJobStats totals;
+  std::vector<JobFrame> batch;
+  std::vector<cv::Mat> images;
+  std::vector<std::vector<aa::shared::Detection>> detections;
+  std::vector<aa::shared::Detection> filtered;
+  auto last_progress = start;
+
+  while (queue.PopBatch(batch, batch_size)) {
+    images.clear();
+    for (auto& frame : batch) {
+      images.push_back(frame.image);
+    }
+
+    try {
+      engine_.InferenceBatch(images, detections, budget_);
+    } catch (const std::exception& e) {
+      AA_LOG_ERROR("Error processing job batch: " << e.what());
+      failed.store(true);
+      break;
+    }
+
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      polygon_filter.FilterDetectionsByPolygons(detections[i], filtered);
+      auto& part = parts[batch[i].segment];
+      for (const auto& detection : filtered) {
+        part << batch[i].index << ',' << batch[i].timestamp_ms << ','
+             << detection.class_id << ',' << detection.confidence << ','
+             << detection.bbox.x << ',' << detection.bbox.y << ','
+             << detection.bbox.width << ',' << detection.bbox.height << '\n';
+      }
+      totals.detections += filtered.size();
+    }
+    totals.frames += batch.size();
+    ++totals.batches;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_progress >= options_.progress_interval) {
+      last_progress = now;
+      totals.seconds = std::chrono::duration<double>(now - start).count();
+      AA_LOG_INFO("Job progress: "
+                  << totals.frames << "/"
+                  << (frame_count > 0 ? std::to_string(frame_count)
+                                      : std::string{"?"})
+                  << " frames, " << std::fixed << std::setprecision(1)
+                  << totals.FramesPerSecond() << " fps");
+    }
+  }
+
+  // Wake decoders waiting for room before joining them
+  for (auto& decoder : decoders) decoder.request_stop();
+  queue.Close();
+  decoders.clear();
+
+  // Join the parts in segment order, which is frame order
+  for (std::size_t i = 0; i < parts.size(); ++i) {
+    parts[i].close();
+    std::ifstream part(PartPath(options_.output, i));
+    if (part.peek() != std::ifstream::traits_type::eof()) {
+      output << part.rdbuf();
+    }
+    part.close();
+    std::remove(PartPath(options_.output, i).c_str());
+  }
+  output.close();
+
+  totals.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  if (stats != nullptr) *stats = totals;
+
+  if (failed.load() || !output) {
+    AA_LOG_ERROR("Job " << options_.input << " failed after "
+                        << totals.ToString());
+    return false;
+  }
+
+  AA_LOG_INFO("Job " << options_.input << " finished: " << totals.ToString());
+  return true;
+}
+
+bool LoadZones(const std::string& path,
+               std::vector<aa::shared::Polygon>& zones) {
+  std::ifstream file(path);
+  if (!file) {
+    AA_LOG_ERROR("Cannot open zone file " << path);
+    return false;
+  }
+
+  std::stringstream text;
+  text << file.rdbuf();
+
+  aa::proto::PolygonSet set;
+  if (!google::protobuf::TextFormat::ParseFromString(text.str(), &set)) {
+    AA_LOG_ERROR("Cannot parse zone file " << path);
+    return false;
+  }
+
+  zones.clear();
+  for (int i = 0; i < set.polygons_size(); ++i) {
+    auto polygon = aa::shared::Polygon::FromProto(set.polygons(i));
+    if (polygon.GetType() == aa::shared::PolygonType::UNSPECIFIED) {
+      AA_LOG_WARNING("Skipping zone at index " << i
+                                               << " with UNSPECIFIED type");
+      continue;
+    }
+    zones.push_back(std::move(polygon));
+  }
+  return true;
+}
+
+}  // namespace aa::server
@@ -1,19 +1,42 @@
 #include "yolo.h"
 
+#include <algorithm>
+
 #include "common.h"
 #include "logging.h"
+#include "model_buffer.h"
+#include "perf_counters.h"
 
 namespace {
-const int kNumClasses = 80;
 const auto kPaddingMode = cv::dnn::ImagePaddingMode::DNN_PMODE_LETTERBOX;
 const cv::Scalar kDefaultMean = cv::Scalar::all(0.0);
 const cv::Scalar kDefaultScale = cv::Scalar::all(1.0 / 255);
 
+/**
+ * @brief Map detection boxes from network input to image coordinates
+ */
+void BlobToImageRects(cv::dnn::Image2BlobParams& params, const cv::Size& size,
+                      std::vector<aa::shared::Detection>& detections) {
+  std::vector<cv::Rect> boxes;
+  boxes.reserve(detections.size());
+  for (const auto& detection : detections) {
+    boxes.push_back(detection.bbox);
+  }
+
+  params.blobRectsToImageRects(boxes, boxes, size);
+
+  for (std::size_t i = 0; i < detections.size(); ++i) {
+    detections[i].bbox = boxes[i];
+  }
+}
+
 }  // namespace
 
 namespace aa::server {
 
-Yolo::Yolo(aa::shared::Options options) : options_{std::move(options)} {
+Yolo::Yolo(aa::shared::Options options)
+    : options_{std::move(options)},
+      nms_engine_{NmsOptions::FromOptions(options_)} {
   input_width_ = options_.Get<int>("width");
   input_height_ = options_.Get<int>("height");
   input_size_ = cv::Size(input_width_, input_height_);
@@ -24,17 +47,53 @@ Yolo::Yolo(aa::shared::Options options) : options_{std::move(options)} {
                                  : kDefaultScale;
 
   thr_ = options_.Get<float>("thr");
-  nms_ = options_.Get<float>("nms");
   padding_value_ = options_.Get<float>("padvalue");
   swap_rb_ = options_.Get<bool>("rgb");
+  input_u8_ = options_.Get<bool>("input_u8");
+
+  auto family = options_.Get<std::string>("layout");
+  if (!ParseYoloFamily(family, family_)) {
+    AA_LOG_WARNING("Unknown model layout '" << family
+                                            << "', detecting from output");
+  }
 
   Initialize();
 }
 
+ModelInfo Yolo::GetModelInfo() const {
+  ModelInfo info;
+  info.input_size = input_size_;
+  info.letterbox = kPaddingMode == cv::dnn::DNN_PMODE_LETTERBOX;
+  info.pad_value = padding_value_;
+  info.rgb = swap_rb_;
+  return info;
+}
+
+cv::dnn::Image2BlobParams MakeBlobParams(const cv::Scalar& scale,
+                                         const cv::Scalar& mean,
+                                         const cv::Size& size, bool swap_rb,
+                                         float pad_value, bool input_u8) {
+  // 8-bit blobs cannot be scaled; SetNetInput() hands scale and mean to the
+  // net
+  return cv::dnn::Image2BlobParams(
+      input_u8 ? cv::Scalar::all(1.0) : scale, size,
+      input_u8 ? cv::Scalar() : mean, swap_rb, input_u8 ? CV_8U : CV_32F,
+      cv::dnn::DNN_LAYOUT_NCHW, kPaddingMode, pad_value);
+}
+
+void SetNetInput(cv::dnn::Net& net, const cv::Mat& blob,
+                 const cv::Scalar& scale, const cv::Scalar& mean,
+                 bool input_u8) {
+  if (input_u8) {
+    net.setInput(blob, "", scale[0], mean);
+  } else {
+    net.setInput(blob);
+  }
+}
+
 auto Yolo::PreProcess() {
-  cv::dnn::Image2BlobParams img_params(scale_, input_size_, mean_, swap_rb_,
-                                       CV_32F, cv::dnn::DNN_LAYOUT_NCHW,
-                                       kPaddingMode, padding_value_);
+  auto img_params = MakeBlobParams(scale_, mean_, input_size_, swap_rb_,
+                                   padding_value_, input_u8_);
 
   cv::dnn::Image2BlobParams net_params{};
   net_params.scalefactor = scale_;
@@ -46,58 +105,33 @@ auto Yolo::PreProcess() {
   return std::make_pair(img_params, net_params);
 }
 
-auto Yolo::PostProcess(std::vector<cv::Mat>& outs) {
-  std::vector<int> class_ids;
-  std::vector<float> confidences;
-  std::vector<cv::Rect2d> boxes;
+void Yolo::SetInput(const cv::Mat& blob) {
+  SetNetInput(net_, blob, scale_, mean_, input_u8_);
+}
+
+auto Yolo::PostProcess(std::vector<cv::Mat>& outs,
+                       const DetectionBudget& budget) {
   std::vector<aa::shared::Detection> detections;
 
-  CV_CheckEQ(
-      outs[0].dims, 3,
-      "Invalid output shape. The shape should be [1, #anchors, nc+5 or nc+4]");
-  CV_CheckEQ((outs[0].size[2] == kNumClasses + 5 ||
-              outs[0].size[2] == kNumClasses + 4),
-             true, "Invalid output shape: ");
-
-  for (auto preds : outs) {
-    preds = preds.reshape(1, preds.size[1]);
-
-    for (int i = 0; i < preds.rows; ++i) {
-      float obj_conf = preds.at<float>(i, 4);
-      if (obj_conf < thr_) continue;
-
-      cv::Mat scores = preds.row(i).colRange(5, preds.cols);
-      double conf;
-      cv::Point max_loc;
-      cv::minMaxLoc(scores, 0, &conf, 0, &max_loc);
-      conf = conf * obj_conf;
-      if (conf < thr_) continue;
-
-      float* det = preds.ptr<float>(i);
-      double cx = det[0];
-      double cy = det[1];
-      double w = det[2];
-      double h = det[3];
-
-      boxes.push_back(
-          cv::Rect2d(cx - 0.5 * w, cy - 0.5 * h, cx + 0.5 * w, cy + 0.5 * h));
-      class_ids.push_back(max_loc.x);
-      confidences.push_back(static_cast<float>(conf));
-    }
+  // Models with dynamic shapes are resolved on their first output
+  if (!decoder_.IsValid()) {
+    const auto& output = outs[0];
+    ResolveLayout(
+        std::vector<int>(&output.size[0], &output.size[0] + output.dims));
   }
 
-  std::vector<int> keep_idx;
-  cv::dnn::NMSBoxes(boxes, confidences, thr_, nms_, keep_idx);
+  DecodeWithinBudget(decoder_, nms_engine_, outs, thr_, budget, candidates_,
+                     keep_);
 
-  detections.clear();
-  for (auto i : keep_idx) {
+  detections.reserve(keep_.size());
+  for (auto i : keep_) {
     aa::shared::Detection detection;
-    detection.class_id = class_ids[i];
-    detection.confidence = confidences[i];
-    cv::Rect2d rect2d = boxes[i];
-    detection.bbox = cv::Rect(cvFloor(rect2d.x), cvFloor(rect2d.y),
-                              cvFloor(rect2d.width - rect2d.x),
-                              cvFloor(rect2d.height - rect2d.y));
+    detection.class_id = candidates_.class_id[i];
+    detection.confidence = candidates_.score[i];
+    detection.bbox = cv::Rect(cvFloor(candidates_.x1[i]),
+                              cvFloor(candidates_.y1[i]),
+                              cvFloor(candidates_.x2[i] - candidates_.x1[i]),
+                              cvFloor(candidates_.y2[i] - candidates_.y1[i]));
     detections.push_back(detection);
   }
 
@@ -105,44 +139,154 @@ auto Yolo::PostProcess(std::vector<cv::Mat>& outs) {
 }
 
 void Yolo::Inference(cv::Mat& img,
-                     std::vector<aa::shared::Detection>& detections) {
+                     std::vector<aa::shared::Detection>& detections,
+                     const DetectionBudget& budget) {
   auto&& [img_params, net_params] = PreProcess();
-  auto input = cv::dnn::blobFromImageWithParams(img, img_params);
+  cv::Mat input;
+  {
+    PerfScope scope(PerfStage::kPreprocess);
+    input = cv::dnn::blobFromImageWithParams(img, img_params);
+  }
 
-  net_.setInput(input);
+  SetInput(input);
 
   std::vector<cv::Mat> outs;
-  net_.forward(outs, net_.getUnconnectedOutLayersNames());
+  {
+    PerfScope scope(PerfStage::kForward);
+    net_.forward(outs, net_.getUnconnectedOutLayersNames());
+  }
 
-  detections = PostProcess(outs);
+  PerfScope scope(PerfStage::kPostprocess);
+  detections = PostProcess(outs, budget);
+  BlobToImageRects(net_params, img.size(), detections);
+}
 
-  std::vector<cv::Rect> boxes;
-  for (const auto& detection : detections) {
-    boxes.push_back(detection.bbox);
+void Yolo::InferenceBatch(
+    std::vector<cv::Mat>& inputs,
+    std::vector<std::vector<aa::shared::Detection>>& detections,
+    const DetectionBudget& budget) {
+  if (inputs.size() < 2 || !batching_) {
+    InferenceEngine::InferenceBatch(inputs, detections, budget);
+    return;
   }
 
-  net_params.blobRectsToImageRects(boxes, boxes, img.size());
+  auto&& [img_params, net_params] = PreProcess();
+  cv::Mat input;
+  {
+    PerfScope scope(PerfStage::kPreprocess);
+    input = cv::dnn::blobFromImagesWithParams(inputs, img_params);
+  }
 
-  for (std::size_t i = 0; i < detections.size(); ++i) {
-    detections[i].bbox = boxes[i];
+  SetInput(input);
+
+  const int batch = static_cast<int>(inputs.size());
+  std::vector<cv::Mat> outs;
+  try {
+    PerfScope scope(PerfStage::kForward);
+    net_.forward(outs, net_.getUnconnectedOutLayersNames());
+  } catch (const cv::Exception& e) {
+    outs.clear();
+    AA_LOG_DEBUG("Batched forward failed: " << e.what());
+  }
+
+  bool batched = !outs.empty();
+  for (const auto& out : outs) {
+    batched = batched && out.dims == 3 && out.size[0] == batch;
+  }
+  if (!batched) {
+    AA_LOG_WARNING("Model does not accept batches of "
+                   << batch << " frames, processing frames one by one");
+    batching_ = false;
+    InferenceEngine::InferenceBatch(inputs, detections, budget);
+    return;
+  }
+
+  // Views of one image's rows in every output, shaped like a batch of one
+  PerfScope scope(PerfStage::kPostprocess);
+  detections.resize(inputs.size());
+  std::vector<cv::Mat> image_outs(outs.size());
+  for (int b = 0; b < batch; ++b) {
+    for (std::size_t o = 0; o < outs.size(); ++o) {
+      int sizes[] = {1, outs[o].size[1], outs[o].size[2]};
+      image_outs[o] = cv::Mat(3, sizes, outs[o].type(), outs[o].ptr(b));
+    }
+    detections[b] = PostProcess(image_outs, budget);
+    BlobToImageRects(net_params, inputs[b].size(), detections[b]);
   }
 }
 
 void Yolo::DrawBoundingBoxes(
-    cv::Mat& img, const std::vector<aa::shared::Detection>& detections) const {
-  for (const auto& detection : detections) {
-    cv::Rect box = detection.bbox;
-    aa::shared::DrawBoundingBox(img, box.x, box.y, box.width + box.x,
-                                box.height + box.y, detection.class_id,
-                                detection.confidence, aa::shared::Color::kRed,
-                                true);
-  }
+    cv::Mat& img, const std::vector<aa::shared::Detection>& detections,
+    double scale) const {
+  DrawLabeledBoxes(img, detections, scale, labels_);
 }
 
 void Yolo::Initialize() {
-  net_ = cv::dnn::readNet(options_.Get<std::string>("model"));
+  auto model_path = options_.Get<std::string>("model");
+
+  std::vector<std::string> model_labels;
+  if (model_path.ends_with(".onnx")) {
+    // Parse from the page cache instead of reading the file into a buffer
+    ModelBuffer model(model_path);
+    net_ = cv::dnn::readNetFromONNX(model.Data(), model.Size());
+    if (!options_.Has("labels")) {
+      model_labels = LoadLabelsFromModel({model.Data(), model.Size()});
+    }
+  } else {
+    net_ = cv::dnn::readNet(model_path);
+  }
   net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
   net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+
+  if (options_.Has("labels")) {
+    labels_ = LoadLabelsFromFile(options_.Get<std::string>("labels"));
+    AA_LOG_INFO("Loaded " << labels_.size() << " labels from "
+                          << options_.Get<std::string>("labels"));
+  } else {
+    labels_ = std::move(model_labels);
+  }
+
+  // Shape inference runs no forward pass, so this is safe before fork()
+  std::vector<cv::dnn::MatShape> in_shapes;
+  std::vector<cv::dnn::MatShape> out_shapes;
+  try {
+    net_.getLayerShapes(cv::dnn::MatShape{1, 3, input_height_, input_width_},
+                        net_.getUnconnectedOutLayers().front(), in_shapes,
+                        out_shapes);
+  } catch (const cv::Exception& e) {
+    AA_LOG_DEBUG("Output shape unknown before the first frame: "
+                 << e.what());
+    return;
+  }
+  if (out_shapes.empty()) return;
+
+  try {
+    ResolveLayout(out_shapes.front());
+  } catch (const cv::Exception& e) {
+    AA_LOG_ERROR("Model " << model_path << " does not match its labels or "
+                          << "--layout: " << e.what());
+    throw std::runtime_error("Model output does not match its labels");
+  }
+}
+
+void Yolo::ResolveLayout(const std::vector<int>& shape) {
+  auto layout = OutputLayout::Resolve(family_, shape,
+                                      static_cast<int>(labels_.size()));
+  decoder_ = YoloDecoder(layout);
+
+  const auto num_coco = static_cast<int>(aa::shared::kCocoClasses.size());
+  if (labels_.empty()) {
+    if (layout.num_classes == num_coco) {
+      labels_.assign(aa::shared::kCocoClasses.begin(),
+                     aa::shared::kCocoClasses.end());
+    } else {
+      for (int i = 0; i < layout.num_classes; ++i) {
+        labels_.push_back("class_" + std::to_string(i));
+      }
+    }
+  }
+
+  AA_LOG_INFO("Model output layout: " << layout.ToString());
 }
 
 }  // namespace aa::server
@@ -0,0 +1,402 @@
+#include "yolo_decoder.h"
+
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+
+#include <google/protobuf/io/coded_stream.h>
+
+#include "logging.h"
+
+namespace {
+
+// COCO models are compiled with a fixed class count
+constexpr int kCocoNumClasses = 80;
+
+// ONNX ModelProto.metadata_props (field 14) and the key (1) and value (2)
+// of its StringStringEntryProto, all length-delimited
+constexpr uint32_t kMetadataPropsTag = (14 << 3) | 2;
+constexpr uint32_t kEntryKeyTag = (1 << 3) | 2;
+constexpr uint32_t kEntryValueTag = (2 << 3) | 2;
+
+// Class IDs with more digits are not labels of a detection head
+constexpr std::size_t kMaxLabelDigits = 5;
+
+/**
+ * @brief Skip a protobuf field of any wire type but groups
+ */
+bool SkipField(google::protobuf::io::CodedInputStream& input, uint32_t tag) {
+  uint64_t varint = 0;
+  uint32_t length = 0;
+  switch (tag & 7) {
+    case 0:
+      return input.ReadVarint64(&varint);
+    case 1:
+      return input.Skip(8);
+    case 2:
+      return input.ReadVarint32(&length) &&
+             input.Skip(static_cast<int>(length));
+    case 5:
+      return input.Skip(4);
+    default:
+      return false;
+  }
+}
+
+bool ReadString(google::protobuf::io::CodedInputStream& input,
+                std::string& value) {
+  uint32_t length = 0;
+  return input.ReadVarint32(&length) &&
+         input.ReadString(&value, static_cast<int>(length));
+}
+
+/**
+ * @brief Parse a "{0: 'person', 1: 'bicycle'}" dictionary into labels
+ */
+std::vector<std::string> ParseNames(const std::string& names) {
+  static const std::regex kEntry(R"((\d+)\s*:\s*['"]([^'"]*)['"])");
+
+  std::vector<std::string> labels;
+  for (auto it = std::sregex_iterator(names.begin(), names.end(), kEntry);
+       it != std::sregex_iterator(); ++it) {
+    auto digits = (*it)[1].str();
+    if (digits.size() > kMaxLabelDigits) continue;
+    auto id = static_cast<std::size_t>(std::stoul(digits));
+    if (id >= labels.size()) labels.resize(id + 1);
+    labels[id] = (*it)[2].str();
+  }
+  return labels;
+}
+
+template <int NumClasses>
+inline int ClassCount(const aa::server::OutputLayout& layout) {
+  if constexpr (NumClasses > 0) {
+    return NumClasses;
+  } else {
+    return layout.num_classes;
+  }
+}
+
+/**
+ * @brief Decode a row layout [1, anchors, 4 + obj + nc]
+ */
+template <bool Objectness, int NumClasses>
+void DecodeRows(const float* data, const aa::server::OutputLayout& layout,
+                float threshold, const std::vector<int32_t>& whitelist,
+                aa::server::NmsCandidates& candidates, std::vector<float>&,
+                std::vector<int32_t>&) {
+  const int num_classes = ClassCount<NumClasses>(layout);
+  const int class_offset = Objectness ? 5 : 4;
+  const int attributes = class_offset + num_classes;
+
+  for (int a = 0; a < layout.num_anchors; ++a) {
+    const float* row = data + static_cast<std::size_t>(a) * attributes;
+
+    float obj_conf = 1.0f;
+    if constexpr (Objectness) {
+      obj_conf = row[4];
+      if (obj_conf < threshold) continue;
+    }
+
+    const float* scores = row + class_offset;
+    float conf = -1.0f;
+    int class_id = -1;
+    if (whitelist.empty()) {
+      for (int c = 0; c < num_classes; ++c) {
+        if (scores[c] > conf) {
+          conf = scores[c];
+          class_id = c;
+        }
+      }
+    } else {
+      for (auto c : whitelist) {
+        if (c >= 0 && c < num_classes && scores[c] > conf) {
+          conf = scores[c];
+          class_id = c;
+        }
+      }
+    }
+    if (class_id < 0) continue;
+
+    conf *= obj_conf;
+    if (conf < threshold) continue;
+
+    float cx = row[0];
+    float cy = row[1];
+    float w = row[2];
+    float h = row[3];
+    candidates.Add(cx - 0.5f * w, cy - 0.5f * h, cx + 0.5f * w, cy + 0.5f * h,
+                   conf, class_id);
+  }
+}
+
+/**
+ * @brief Decode a transposed layout [1, 4 + obj + nc, anchors]
+ */
+template <bool Objectness, int NumClasses>
+void DecodeColumns(const float* data, const aa::server::OutputLayout& layout,
+                   float threshold, const std::vector<int32_t>& whitelist,
+                   aa::server::NmsCandidates& candidates,
+                   std::vector<float>& best_score,
+                   std::vector<int32_t>& best_class) {
+  const int num_classes = ClassCount<NumClasses>(layout);
+  const int class_offset = Objectness ? 5 : 4;
+  const std::size_t anchors = static_cast<std::size_t>(layout.num_anchors);
+
+  best_score.assign(anchors, -1.0f);
+  best_class.assign(anchors, -1);
+  float* best = best_score.data();
+  int32_t* best_id = best_class.data();
+
+  // Element-wise running max over contiguous class rows
+  auto scan = [&](int32_t c) {
+    const float* scores = data + (class_offset + c) * anchors;
+    for (std::size_t a = 0; a < anchors; ++a) {
+      const bool better = scores[a] > best[a];
+      best[a] = better ? scores[a] : best[a];
+      best_id[a] = better ? c : best_id[a];
+    }
+  };
+
+  if (whitelist.empty()) {
+    for (int c = 0; c < num_classes; ++c) scan(c);
+  } else {
+    for (auto c : whitelist) {
+      if (c >= 0 && c < num_classes) scan(c);
+    }
+  }
+
+  const float* cx = data;
+  const float* cy = data + anchors;
+  const float* w = data + 2 * anchors;
+  const float* h = data + 3 * anchors;
+
+  for (std::size_t a = 0; a < anchors; ++a) {
+    if (best_id[a] < 0) continue;
+
+    float conf = best[a];
+    if constexpr (Objectness) {
+      conf *= data[4 * anchors + a];
+    }
+    if (conf < threshold) continue;
+
+    candidates.Add(cx[a] - 0.5f * w[a], cy[a] - 0.5f * h[a],
+                   cx[a] + 0.5f * w[a], cy[a] + 0.5f * h[a], conf,
+                   best_id[a]);
+  }
+}
+
+const char* FamilyName(aa::server::YoloFamily family) {
+  switch (family) {
+    case aa::server::YoloFamily::kYolox:
+      return "yolox";
+    case aa::server::YoloFamily::kYolov5:
+      return "yolov5";
+    case aa::server::YoloFamily::kYolov8:
+      return "yolov8";
+    default:
+      return "auto";
+  }
+}
+
+}  // namespace
+
+namespace aa::server {
+
+bool ParseYoloFamily(std::string_view name, YoloFamily& family) {
+  if (name == "auto") {
+    family = YoloFamily::kAuto;
+  } else if (name == "yolox") {
+    family = YoloFamily::kYolox;
+  } else if (name == "yolov5") {
+    family = YoloFamily::kYolov5;
+  } else if (name == "yolov8") {
+    family = YoloFamily::kYolov8;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+OutputLayout OutputLayout::Resolve(YoloFamily family, const cv::Mat& output,
+                                   int num_classes_hint) {
+  const int* sizes = &output.size[0];
+  return Resolve(family, std::vector<int>(sizes, sizes + output.dims),
+                 num_classes_hint);
+}
+
+OutputLayout OutputLayout::Resolve(YoloFamily family,
+                                   const std::vector<int>& shape,
+                                   int num_classes_hint) {
+  CV_CheckEQ(static_cast<int>(shape.size()), 3,
+             "Invalid output shape. The shape should be [1, d1, d2]");
+
+  const int d1 = shape[1];
+  const int d2 = shape[2];
+
+  OutputLayout layout;
+  layout.family = family;
+
+  if (family == YoloFamily::kAuto) {
+    // Anchors always outnumber attributes, so the longer axis is anchors
+    if (d1 < d2) {
+      layout.family = YoloFamily::kYolov8;
+    } else {
+      layout.family = YoloFamily::kYolox;
+      // Row outputs without objectness can only be told apart by a hint
+      layout.has_objectness =
+          !(num_classes_hint > 0 && d2 == num_classes_hint + 4);
+    }
+  }
+
+  if (layout.family == YoloFamily::kYolov8) {
+    layout.transposed = true;
+    layout.has_objectness = false;
+    layout.num_anchors = d2;
+    layout.num_classes = d1 - layout.ClassOffset();
+  } else {
+    layout.transposed = false;
+    if (family != YoloFamily::kAuto) {
+      layout.has_objectness = true;
+    }
+    layout.num_anchors = d1;
+    layout.num_classes = d2 - layout.ClassOffset();
+  }
+
+  CV_CheckGT(layout.num_classes, 0, "Output shape has no class scores");
+  if (num_classes_hint > 0) {
+    CV_CheckEQ(layout.num_classes, num_classes_hint,
+               "Output class count does not match the label count");
+  }
+
+  return layout;
+}
+
+std::string OutputLayout::ToString() const {
+  std::ostringstream description;
+  description << FamilyName(family) << " "
+              << (transposed ? "[1, attrs, anchors]" : "[1, anchors, attrs]")
+              << " anchors=" << num_anchors << " classes=" << num_classes
+              << " objectness=" << (has_objectness ? "yes" : "no");
+  return description.str();
+}
+
+YoloDecoder::YoloDecoder(OutputLayout layout) : layout_{layout} {
+  const bool coco = layout_.num_classes == kCocoNumClasses;
+
+  if (layout_.transposed) {
+    if (layout_.has_objectness) {
+      decode_ = coco ? &DecodeColumns<true, kCocoNumClasses>
+                     : &DecodeColumns<true, 0>;
+    } else {
+      decode_ = coco ? &DecodeColumns<false, kCocoNumClasses>
+                     : &DecodeColumns<false, 0>;
+    }
+  } else {
+    if (layout_.has_objectness) {
+      decode_ = coco ? &DecodeRows<true, kCocoNumClasses>
+                     : &DecodeRows<true, 0>;
+    } else {
+      decode_ = coco ? &DecodeRows<false, kCocoNumClasses>
+                     : &DecodeRows<false, 0>;
+    }
+  }
+}
+
+void YoloDecoder::Decode(const cv::Mat& output, float threshold,
+                         const std::vector<int32_t>& whitelist,
+                         NmsCandidates& candidates) {
+  CV_Assert(decode_ != nullptr);
+  CV_CheckType(output.type(), output.type() == CV_32F,
+               "YOLO output must be CV_32F");
+  CV_Assert(output.isContinuous());
+  CV_CheckEQ(static_cast<int>(output.total()),
+             layout_.num_anchors * layout_.Attributes(),
+             "YOLO output does not match the resolved layout");
+
+  decode_(output.ptr<float>(), layout_, threshold, whitelist, candidates,
+          best_score_, best_class_);
+}
+
+void DecodeWithinBudget(YoloDecoder& decoder, Nms& nms,
+                        const std::vector<cv::Mat>& outs, float threshold,
+                        const DetectionBudget& budget,
+                        NmsCandidates& candidates, std::vector<int>& keep) {
+  const float thr = std::max(threshold, budget.min_confidence);
+
+  candidates.Clear();
+  for (const auto& preds : outs) {
+    decoder.Decode(preds, thr, budget.class_whitelist, candidates);
+  }
+
+  int max_detections = nms.GetOptions().max_detections;
+  if (budget.max_detections > 0) {
+    max_detections = max_detections > 0
+                         ? std::min(max_detections, budget.max_detections)
+                         : budget.max_detections;
+  }
+
+  nms.Run(candidates, thr, max_detections, keep);
+}
+
+std::vector<std::string> LoadLabelsFromFile(const std::string& path) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to open label file: " + path);
+  }
+
+  std::vector<std::string> labels;
+  std::string line;
+  while (std::getline(file, line)) {
+    auto begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) continue;
+    auto end = line.find_last_not_of(" \t\r");
+    labels.push_back(line.substr(begin, end - begin + 1));
+  }
+
+  return labels;
+}
+
+std::vector<std::string> LoadLabelsFromModel(std::string_view model) {
+  if (model.size() > static_cast<std::size_t>(INT_MAX)) {
+    return {};
+  }
+
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(model.data()),
+      static_cast<int>(model.size()));
+
+  while (uint32_t tag = input.ReadTag()) {
+    if (tag != kMetadataPropsTag) {
+      if (!SkipField(input, tag)) break;
+      continue;
+    }
+
+    uint32_t length = 0;
+    if (!input.ReadVarint32(&length)) break;
+    auto limit = input.PushLimit(static_cast<int>(length));
+    std::string key;
+    std::string value;
+    while (uint32_t entry_tag = input.ReadTag()) {
+      bool ok = entry_tag == kEntryKeyTag     ? ReadString(input, key)
+                : entry_tag == kEntryValueTag ? ReadString(input, value)
+                                              : SkipField(input, entry_tag);
+      if (!ok) return {};
+    }
+    input.PopLimit(limit);
+
+    if (key == "names") {
+      auto labels = ParseNames(value);
+      AA_LOG_DEBUG("Loaded " << labels.size()
+                             << " labels from model metadata");
+      return labels;
+    }
+  }
+
+  return {};
+}
+
+}  // namespace aa::server
@@ -0,0 +1,143 @@
+#include "zone_crops.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Distance to a crop edge within which a box counts as cut off (pixels)
+constexpr int kEdgeMargin = 2;
+
+/**
+ * @brief Factor by which letterboxing scales a region to the model input
+ */
+double LetterboxScale(const cv::Size& region, const cv::Size& input) {
+  return std::min(static_cast<double>(input.width) / region.width,
+                  static_cast<double>(input.height) / region.height);
+}
+
+/**
+ * @brief Check whether a box in crop coordinates is cut by an inner edge
+ */
+bool IsCutByCrop(const cv::Rect& box, const cv::Rect& crop,
+                 const cv::Size& frame_size) {
+  return (crop.x > 0 && box.x <= kEdgeMargin) ||
+         (crop.y > 0 && box.y <= kEdgeMargin) ||
+         (crop.br().x < frame_size.width &&
+          box.br().x >= crop.width - kEdgeMargin) ||
+         (crop.br().y < frame_size.height &&
+          box.br().y >= crop.height - kEdgeMargin);
+}
+
+}  // namespace
+
+namespace aa::server {
+
+ZoneCropOptions ZoneCropOptions::FromOptions(
+    const aa::shared::Options& options) {
+  ZoneCropOptions crop_options;
+  crop_options.max_crops = std::max(0, options.Get<int>("zone_crops"));
+  crop_options.input_size =
+      cv::Size(options.Get<int>("width"), options.Get<int>("height"));
+  crop_options.nms = NmsOptions::FromOptions(options);
+  return crop_options;
+}
+
+void SelectZoneCrops(const std::vector<aa::shared::Polygon>& zones,
+                     const cv::Size& frame_size,
+                     const ZoneCropOptions& options,
+                     std::vector<cv::Rect>& crops) {
+  crops.clear();
+  if (options.max_crops <= 0 || frame_size.empty()) return;
+
+  const cv::Rect frame(cv::Point(0, 0), frame_size);
+  const double frame_scale = LetterboxScale(frame_size, options.input_size);
+  for (const auto& zone : zones) {
+    if (!zone.GetInferenceCrop() ||
+        zone.GetType() != aa::shared::PolygonType::INCLUSION ||
+        zone.GetVertices().size() < 3) {
+      continue;
+    }
+
+    double left = std::numeric_limits<double>::max();
+    double top = std::numeric_limits<double>::max();
+    double right = std::numeric_limits<double>::lowest();
+    double bottom = std::numeric_limits<double>::lowest();
+    for (const auto& vertex : zone.GetVertices()) {
+      left = std::min(left, vertex.GetX());
+      top = std::min(top, vertex.GetY());
+      right = std::max(right, vertex.GetX());
+      bottom = std::max(bottom, vertex.GetY());
+    }
+
+    cv::Rect crop(cv::Point(static_cast<int>(std::floor(left)),
+                            static_cast<int>(std::floor(top))),
+                  cv::Point(static_cast<int>(std::ceil(right)),
+                            static_cast<int>(std::ceil(bottom))));
+    crop &= frame;
+    if (crop.empty() ||
+        LetterboxScale(crop.size(), options.input_size) <
+            options.min_gain * frame_scale) {
+      continue;
+    }
+
+    crops.push_back(crop);
+    if (static_cast<int>(crops.size()) == options.max_crops) break;
+  }
+}
+
+ZoneCropMerger::ZoneCropMerger(const ZoneCropOptions& options)
+    : nms_{[&options] {
+        // Candidates are already thresholded by the passes that found them
+        NmsOptions nms = options.nms;
+        nms.score_threshold = 0.0f;
+        nms.top_k = 0;
+        nms.mode = NmsMode::kHard;
+        return nms;
+      }()} {}
+
+void ZoneCropMerger::Merge(
+    const cv::Size& frame_size, std::span<const cv::Rect> crops,
+    std::span<const std::vector<aa::shared::Detection>> crop_detections,
+    int max_detections, std::vector<aa::shared::Detection>& detections) {
+  if (crops.empty()) return;
+
+  candidates_.Clear();
+  auto add = [this](const cv::Rect& box, const aa::shared::Detection& d) {
+    candidates_.Add(static_cast<float>(box.x), static_cast<float>(box.y),
+                    static_cast<float>(box.br().x),
+                    static_cast<float>(box.br().y), d.confidence, d.class_id);
+  };
+  for (const auto& detection : detections) {
+    add(detection.bbox, detection);
+  }
+  for (std::size_t i = 0; i < crops.size() && i < crop_detections.size();
+       ++i) {
+    for (const auto& detection : crop_detections[i]) {
+      if (IsCutByCrop(detection.bbox, crops[i], frame_size)) continue;
+      cv::Rect box = detection.bbox;
+      box.x += crops[i].x;
+      box.y += crops[i].y;
+      add(box, detection);
+    }
+  }
+
+  nms_.Run(candidates_, 0.0f,
+           max_detections > 0 ? max_detections
+                              : nms_.GetOptions().max_detections,
+           keep_);
+
+  merged_.clear();
+  for (int index : keep_) {
+    merged_.push_back(
+        {cv::Rect(cv::Point(static_cast<int>(candidates_.x1[index]),
+                            static_cast<int>(candidates_.y1[index])),
+                  cv::Point(static_cast<int>(candidates_.x2[index]),
+                            static_cast<int>(candidates_.y2[index]))),
+         candidates_.class_id[index], candidates_.score[index]});
+  }
+  detections.swap(merged_);
+}
+
+}  // namespace aa::server
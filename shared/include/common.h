@@ -48,4 +48,20 @@ void DrawBoundingBox(cv::Mat& frame, int left, int top, int right, int bottom,
                      int class_id, float conf, const cv::Scalar& color,
                      bool filled = false);
 
+/**
+ * @brief Draw a prediction box with an explicit label on an image
+ * @param frame The image to draw on
+ * @param left Left coordinate of the bounding box
+ * @param top Top coordinate of the bounding box
+ * @param right Right coordinate of the bounding box
+ * @param bottom Bottom coordinate of the bounding box
+ * @param label Class label (empty to show the score only)
+ * @param conf Confidence score of the detection
+ * @param color Box color
+ * @param filled Draw a semi-transparent fill inside the box
+ */
+void DrawBoundingBox(cv::Mat& frame, int left, int top, int right, int bottom,
+                     std::string_view label, float conf,
+                     const cv::Scalar& color, bool filled = false);
+
 }  // namespace aa::shared
@@ -9,10 +9,24 @@
 
 namespace aa::shared {
 
+/**
+ * @brief Compress an image with the codec of a frame encoding
+ * @param mat Image to compress
+ * @param encoding JPEG, PNG or WebP
+ * @param quality JPEG/WebP quality 1-100 (0 = codec default)
+ * @return Compressed image bytes
+ * @throws std::runtime_error for RAW, unknown encodings or codec failures
+ */
+std::vector<uint8_t> EncodeImage(const cv::Mat& mat,
+                                 ::aa::proto::FrameEncoding encoding,
+                                 int quality = 0);
+
 /**
  * @brief C++ representation of Frame protobuf message
  *
  * Represents video frame data corresponding to OpenCV cv::Mat structure.
+ * The payload is either raw pixels or a compressed image (JPEG/PNG/WebP),
+ * see GetEncoding().
  */
 class Frame {
  public:
@@ -64,6 +78,17 @@ class Frame {
    */
   explicit Frame(const cv::Mat& mat);
 
+  /**
+   * @brief Create a Frame holding a compressed image
+   * @param mat OpenCV Mat to encode
+   * @param encoding Payload format (RAW keeps raw pixels)
+   * @param quality JPEG/WebP quality 1-100 (0 = codec default)
+   * @return Frame instance
+   * @throws std::runtime_error if the codec is unavailable or fails
+   */
+  static Frame Encode(const cv::Mat& mat, ::aa::proto::FrameEncoding encoding,
+                      int quality = 0);
+
   /**
    * @brief Create Frame from protobuf message
    * @param proto_frame Protobuf Frame message
@@ -78,8 +103,8 @@ class Frame {
   ::aa::proto::Frame ToProto() const;
 
   /**
-   * @brief Convert Frame to OpenCV Mat
-   * @return OpenCV Mat representation
+   * @brief Convert Frame to OpenCV Mat, decoding compressed payloads
+   * @return OpenCV Mat representation (empty if the payload is invalid)
    */
   cv::Mat ToMat() const;
 
@@ -89,6 +114,7 @@ class Frame {
   int32_t GetElmType() const { return elm_type_; }
   int32_t GetElmSize() const { return elm_size_; }
   const std::vector<uint8_t>& GetData() const { return data_; }
+  ::aa::proto::FrameEncoding GetEncoding() const { return encoding_; }
 
   // Setters
   void SetRows(int32_t rows) { rows_ = rows; }
@@ -96,13 +122,18 @@ class Frame {
   void SetElmType(int32_t elm_type) { elm_type_ = elm_type; }
   void SetElmSize(int32_t elm_size) { elm_size_ = elm_size; }
   void SetData(std::vector<uint8_t> data) { data_ = std::move(data); }
+  void SetEncoding(::aa::proto::FrameEncoding encoding) {
+    encoding_ = encoding;
+  }
 
  private:
   int32_t rows_{0};            ///< Number of rows (height)
   int32_t cols_{0};            ///< Number of columns (width)
   int32_t elm_type_{0};        ///< Element type (CV_8UC3, CV_32FC1, etc.)
   int32_t elm_size_{0};        ///< Size of each element in bytes
-  std::vector<uint8_t> data_;  ///< Raw pixel data
+  std::vector<uint8_t> data_;  ///< Raw pixel data or compressed image
+  ::aa::proto::FrameEncoding encoding_{
+      ::aa::proto::FRAME_ENCODING_RAW};  ///< Payload format of data_
 };
 
 }  // namespace aa::shared
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include "frame.pb.h"
+
+namespace aa::shared {
+
+/**
+ * @brief Sender side of tile-based frame delta encoding
+ *
+ * Splits each frame into square tiles and emits only the tiles that changed
+ * since the previous frame, as a FrameDelta message. The first frame, and
+ * any frame whose size or type differs from the previous one, is sent as a
+ * keyframe carrying all tiles.
+ *
+ * With a non-zero threshold, tiles whose largest per-channel difference does
+ * not exceed it are treated as unchanged. The encoder then keeps the frame
+ * the receiver actually holds as its reference, so small differences never
+ * accumulate into drift.
+ *
+ * Usage:
+ * @code
+ * FrameDeltaEncoder encoder(32);
+ * while (capture.read(frame)) {
+ *   *request.mutable_delta() = encoder.Encode(frame);
+ *   stream->Write(request);
+ * }
+ * @endcode
+ */
+class FrameDeltaEncoder {
+ public:
+  /**
+   * @brief Construct an encoder
+   *
+   * @param tile_size Tile edge length in pixels (at least 1)
+   * @param threshold Largest per-channel difference treated as unchanged
+   */
+  explicit FrameDeltaEncoder(int tile_size = 32, double threshold = 0.0);
+
+  /**
+   * @brief Encode a frame relative to the previously encoded one
+   *
+   * @param frame Frame to encode (any type, must not be empty)
+   * @return Delta carrying the changed tiles
+   */
+  aa::proto::FrameDelta Encode(const cv::Mat& frame);
+
+  /**
+   * @brief Forget the reference so the next frame is a keyframe
+   */
+  void Reset();
+
+ private:
+  int tile_size_;
+  double threshold_;
+  cv::Mat reference_;  ///< Frame as reconstructed by the receiver
+};
+
+/**
+ * @brief Receiver side of tile-based frame delta encoding
+ *
+ * Keeps the reconstructed frame of one session and patches it in place
+ * with the tiles of each delta, so unchanged regions are never copied.
+ */
+class FrameDeltaDecoder {
+ public:
+  /**
+   * @brief Apply a delta to the session frame
+   *
+   * Malformed deltas, and non-keyframe deltas that do not match the current
+   * frame, are rejected without touching the frame.
+   *
+   * @param delta Delta produced by FrameDeltaEncoder
+   * @return false if the delta was rejected
+   */
+  bool Apply(const aa::proto::FrameDelta& delta);
+
+  /**
+   * @brief Current reconstructed frame (empty before the first keyframe)
+   *
+   * The frame is updated in place by the next Apply(); clone it to keep it.
+   */
+  const cv::Mat& GetFrame() const { return frame_; }
+
+  /**
+   * @brief Drop the session frame; the next delta must be a keyframe
+   */
+  void Reset();
+
+ private:
+  cv::Mat frame_;
+};
+
+}  // namespace aa::shared
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include "detector_service.pb.h"
+#include "point.h"
+
+namespace aa::shared {
+
+/**
+ * @brief Resize of a source frame into the smaller frame sent for it
+ *
+ * Maps source frame coordinates to sent frame coordinates as
+ * sent = source * scale + offset, per axis, and back. The client builds a
+ * transform with Fit(), shrinks the frame with Apply() and attaches
+ * ToProto() to the request; the server maps the request zones into the
+ * sent frame and its detections back into the source frame. A default
+ * constructed transform is the identity.
+ *
+ * Usage:
+ * @code
+ * auto transform = FrameTransform::Fit(image.size(), {640, 640}, true);
+ * *request.mutable_frame() = Frame{transform.Apply(image, 114.0)}.ToProto();
+ * *request.mutable_transform() = transform.ToProto();
+ * @endcode
+ */
+class FrameTransform {
+ public:
+  FrameTransform() = default;
+
+  /**
+   * @brief Shrink a frame to fit a model input the way the server does
+   *
+   * Matches the letterbox of cv::dnn::blobFromImageWithParams: the frame is
+   * scaled by the largest factor that fits it into the input, keeping its
+   * aspect ratio, and centered with padding. Frames that already fit are
+   * not enlarged.
+   *
+   * @param source Source frame size
+   * @param input Model input size
+   * @param pad Pad the frame to the input size; otherwise only scale it and
+   * leave the padding to the server
+   * @return FrameTransform Transform of the frame (identity if it fits)
+   */
+  static FrameTransform Fit(const cv::Size& source, const cv::Size& input,
+                            bool pad);
+
+  /**
+   * @brief Create a transform from its protobuf message
+   *
+   * @param proto Protobuf FrameTransform message
+   * @return FrameTransform Transform, check IsValid() before use
+   */
+  static FrameTransform FromProto(const ::aa::proto::FrameTransform& proto);
+
+  /**
+   * @brief Convert the transform to its protobuf message
+   * @return Protobuf FrameTransform message
+   */
+  ::aa::proto::FrameTransform ToProto() const;
+
+  /**
+   * @brief Check that the scales and the source size are positive
+   */
+  bool IsValid() const;
+
+  /**
+   * @brief Check whether the transform leaves frames unchanged
+   */
+  bool IsIdentity() const;
+
+  /**
+   * @brief Resize (and pad) a source frame
+   *
+   * @param source Source frame of SourceSize()
+   * @param pad_value Value of the padding pixels
+   * @return cv::Mat Frame to send
+   */
+  cv::Mat Apply(const cv::Mat& source, double pad_value) const;
+
+  /**
+   * @brief Map a source frame point into the sent frame
+   */
+  Point ToSent(const Point& point) const;
+
+  /**
+   * @brief Map a sent frame box back into the source frame
+   *
+   * @param box Box in sent frame coordinates
+   * @return cv::Rect Box in source frame coordinates, clipped to it
+   */
+  cv::Rect ToSource(const cv::Rect& box) const;
+
+  const cv::Size& SourceSize() const { return source_size_; }
+
+ private:
+  cv::Size source_size_;  ///< Empty for the identity
+  cv::Size scaled_size_;  ///< Size of the scaled frame, padding excluded
+  cv::Size sent_size_;    ///< Size of the sent frame, padding included
+  double scale_x_{1.0};
+  double scale_y_{1.0};
+  double offset_x_{0.0};
+  double offset_y_{0.0};
+};
+
+}  // namespace aa::shared
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <grpcpp/support/byte_buffer.h>
+#include <grpcpp/support/slice.h>
+#include <opencv2/core.hpp>
+
+#include "detector_service.pb.h"
+
+namespace aa::shared {
+
+/**
+ * @brief Frame pixels or compressed image handed to gRPC without copying
+ *
+ * Keeps the memory of a cv::Mat or an encoded buffer alive through a shared
+ * owner, so the bytes can be referenced by a grpc::Slice until the transport
+ * has written them.
+ */
+class FramePayload {
+ public:
+  /**
+   * @brief Empty payload
+   */
+  FramePayload() = default;
+
+  /**
+   * @brief Reference the raw pixels of an image
+   *
+   * The Mat header is retained, not the pixels copied. Non-continuous
+   * images (ROIs) are cloned once to get row-major bytes without padding.
+   *
+   * @param mat Image whose pixels become the payload
+   */
+  explicit FramePayload(const cv::Mat& mat);
+
+  /**
+   * @brief Take ownership of an encoded buffer
+   * @param data Compressed image bytes
+   */
+  explicit FramePayload(std::vector<uint8_t> data);
+
+  /**
+   * @brief Create the payload of a result frame and fill its header
+   *
+   * @param img Image to send
+   * @param encoding Payload format (RAW references the pixels)
+   * @param quality JPEG/WebP quality 1-100 (0 = codec default)
+   * @param header Frame message receiving rows, cols, type and encoding;
+   * its data field is left empty
+   * @return FramePayload Payload matching the header
+   * @throws std::runtime_error if the codec is unavailable or fails
+   */
+  static FramePayload Encode(const cv::Mat& img,
+                             ::aa::proto::FrameEncoding encoding, int quality,
+                             ::aa::proto::Frame* header);
+
+  const uint8_t* Data() const { return data_; }
+  std::size_t Size() const { return size_; }
+  bool Empty() const { return size_ == 0; }
+
+  /**
+   * @brief Wrap the payload in a slice sharing ownership of the bytes
+   */
+  grpc::Slice ToSlice() const;
+
+ private:
+  std::shared_ptr<const void> owner_;  ///< Keeps data_ alive
+  const uint8_t* data_{nullptr};
+  std::size_t size_{0};
+};
+
+/**
+ * @brief Serialize a response with its frame payload as a separate slice
+ *
+ * Produces the exact protobuf wire format of ProcessFrameResponse with
+ * result.data set to the payload, but writes the payload as its own slice
+ * instead of copying it into the message. Any data already present in
+ * response.result() is replaced.
+ *
+ * @param response Response without the frame bytes
+ * @param payload Bytes of result.data
+ * @return grpc::ByteBuffer Serialized message
+ */
+grpc::ByteBuffer SerializeFrameResponse(
+    const ::aa::proto::ProcessFrameResponse& response,
+    const FramePayload& payload);
+
+/**
+ * @brief Read-only view of a serialized ProcessFrameResponse
+ *
+ * Parses every field except result.data into a regular message and keeps
+ * result.data as a view into the received buffer. When the payload spans
+ * several slices it is gathered once into an owned buffer. The view is
+ * valid as long as this object lives.
+ *
+ * Usage:
+ * @code
+ * grpc::ByteBuffer buffer;
+ * client.ProcessFrameRaw(request, &buffer);
+ * FrameResponseView view;
+ * if (view.Parse(buffer) && view.Response().success()) {
+ *   cv::imshow("result", view.ToMat());
+ * }
+ * @endcode
+ */
+class FrameResponseView {
+ public:
+  FrameResponseView() = default;
+
+  // The payload view points into members, so the view is pinned
+  FrameResponseView(const FrameResponseView&) = delete;
+  FrameResponseView& operator=(const FrameResponseView&) = delete;
+
+  /**
+   * @brief Parse a serialized response
+   *
+   * @param buffer Serialized ProcessFrameResponse
+   * @return bool False if the buffer is not a valid message
+   */
+  bool Parse(const grpc::ByteBuffer& buffer);
+
+  /**
+   * @brief Response fields; result().data() is always empty
+   */
+  const ::aa::proto::ProcessFrameResponse& Response() const {
+    return response_;
+  }
+
+  /**
+   * @brief Bytes of result.data
+   */
+  std::string_view Payload() const { return payload_; }
+
+  /**
+   * @brief Whether Payload() points into the received buffer
+   */
+  bool IsZeroCopy() const { return zero_copy_; }
+
+  /**
+   * @brief Image of the result frame
+   *
+   * Raw payloads are wrapped without copying and are only valid while this
+   * view lives; compressed payloads are decoded.
+   *
+   * @return cv::Mat Result image (empty if the payload is invalid)
+   */
+  cv::Mat ToMat() const;
+
+ private:
+  ::aa::proto::ProcessFrameResponse response_;
+  std::vector<grpc::Slice> slices_;  ///< Keep the received bytes alive
+  std::string gathered_;             ///< Payload spanning several slices
+  std::string_view payload_;
+  bool zero_copy_{false};
+};
+
+}  // namespace aa::shared
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <opencv2/opencv.hpp>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <vector>
 
 namespace aa::shared {
 
@@ -98,4 +101,15 @@ class Options {
   bool ValidateArguments();
 };
 
+/**
+ * @brief Parse a comma-separated class ID list such as "0,2,7"
+ *
+ * Spaces around entries and empty entries are skipped.
+ *
+ * @param list Class list from the command line
+ * @param classes Parsed class IDs are appended here
+ * @return true if every entry is a non-negative integer
+ */
+bool ParseClassList(std::string_view list, std::vector<int32_t>& classes);
+
 }  // namespace aa::shared
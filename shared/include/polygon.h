@@ -86,6 +86,7 @@ class Polygon {
   const std::vector<int32_t>& GetTargetClasses() const {
     return target_classes_;
   }
+  bool GetInferenceCrop() const { return inference_crop_; }
 
   // Setters
   void SetVertices(std::vector<Point> vertices) {
@@ -96,6 +97,9 @@ class Polygon {
   void SetTargetClasses(std::vector<int32_t> target_classes) {
     target_classes_ = std::move(target_classes);
   }
+  void SetInferenceCrop(bool inference_crop) {
+    inference_crop_ = inference_crop;
+  }
 
   /**
    * @brief Scale polygon vertices by given factors
@@ -141,6 +145,7 @@ class Polygon {
       0};  ///< Processing priority for objects within this polygon
   std::vector<int32_t> target_classes_;  ///< List of target object classes to
                                          ///< detect in this polygon
+  bool inference_crop_{false};  ///< Zone gets an inference pass of its own
 };
 
 }  // namespace aa::shared
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <grpc/compression.h>
+#include <grpcpp/resource_quota.h>
+#include <grpcpp/server_builder.h>
+#include <grpcpp/support/channel_arguments.h>
+
+#include "options.h"
+
+namespace aa::shared {
+
+/**
+ * @brief gRPC transport settings shared by servers and client channels
+ *
+ * Groups the HTTP/2 flow-control window, message size limits, keepalive,
+ * sync server pollers, the server resource quota and per-call compression
+ * into named presets selected with --transport, so both ends of a link are
+ * tuned alike. Zero leaves a setting at the gRPC default.
+ *
+ * Presets:
+ * - default: gRPC defaults
+ * - lan: low latency links; moderate window, frequent keepalive, more
+ *   pollers so short calls do not queue behind each other
+ * - wan: high latency links; a window large enough to keep a
+ *   multi-megabyte frame in flight, relaxed keepalive
+ *
+ * Usage:
+ * @code
+ * auto transport = TransportProfile::FromOptions(options);
+ * grpc::ServerBuilder builder;
+ * transport.ApplyTo(builder);
+ * @endcode
+ */
+struct TransportProfile {
+  std::string name{"default"};           ///< Preset name
+  /// Largest request a server accepts, bytes, -1 = unlimited
+  int server_max_receive_message_size{0};
+  /// Largest response a client channel accepts, bytes; channels made by
+  /// RpcClient are unlimited unless this is set
+  int channel_max_receive_message_size{0};
+  int max_send_message_size{0};          ///< Bytes, -1 = unlimited
+  int stream_window_bytes{0};            ///< HTTP/2 per-stream lookahead
+  int write_buffer_size{0};              ///< HTTP/2 write buffer in bytes
+  int keepalive_time_ms{0};              ///< Ping period on idle connections
+  int keepalive_timeout_ms{0};           ///< Ping acknowledgement deadline
+  bool keepalive_without_calls{false};   ///< Ping without active calls
+  int min_pollers{0};                    ///< Sync server minimum pollers
+  int max_pollers{0};                    ///< Sync server maximum pollers
+  std::size_t resource_quota_bytes{0};   ///< Server memory quota
+  /// Per-call compression of messages
+  grpc_compression_algorithm compression{GRPC_COMPRESS_NONE};
+
+  /**
+   * @brief Preset by name
+   *
+   * @param name default, lan or wan
+   * @return Preset, or std::nullopt for unknown names
+   */
+  static std::optional<TransportProfile> FromName(std::string_view name);
+
+  /**
+   * @brief Preset selected by --transport, with --compression applied
+   *
+   * Expects options validated by Options; unknown names fall back to the
+   * default preset.
+   */
+  static TransportProfile FromOptions(const Options& options);
+
+  /**
+   * @brief Compression algorithm by name
+   *
+   * @param name none, deflate or gzip
+   * @return Algorithm, or std::nullopt for unknown names
+   */
+  static std::optional<grpc_compression_algorithm> CompressionFromName(
+      std::string_view name);
+
+  /**
+   * @brief Apply the profile to a server before it is built
+   */
+  void ApplyTo(grpc::ServerBuilder& builder) const;
+
+  /**
+   * @brief Apply the profile to the arguments of a client channel
+   */
+  void ApplyTo(grpc::ChannelArguments& args) const;
+};
+
+}  // namespace aa::shared
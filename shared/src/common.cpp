@@ -1,16 +1,23 @@
 #include "common.h"
 
+#include <algorithm>
+
 #include "types.h"
 
 namespace aa::shared {
 
 void DrawSemiTransparentRect(cv::Mat& frame, int left, int top, int right,
                              int bottom, const cv::Scalar& color, float alpha) {
-  cv::Mat overlay;
-  frame.copyTo(overlay);
-  cv::rectangle(overlay, cv::Point(left, top), cv::Point(right, bottom), color,
-                cv::FILLED);
-  cv::addWeighted(overlay, alpha, frame, 1.0 - alpha, 0, frame);
+  // Blending only changes the filled rectangle, so only its ROI is copied
+  cv::Rect rect(cv::Point(std::min(left, right), std::min(top, bottom)),
+                cv::Point(std::max(left, right) + 1,
+                          std::max(top, bottom) + 1));
+  rect &= cv::Rect(0, 0, frame.cols, frame.rows);
+  if (rect.empty()) return;
+
+  cv::Mat roi = frame(rect);
+  cv::Mat overlay(roi.size(), roi.type(), color);
+  cv::addWeighted(overlay, alpha, roi, 1.0 - alpha, 0, roi);
 }
 
 void DrawColoredRect(cv::Mat& frame, int left, int top, int right, int bottom,
@@ -22,6 +29,18 @@ void DrawColoredRect(cv::Mat& frame, int left, int top, int right, int bottom,
 void DrawBoundingBox(cv::Mat& frame, int left, int top, int right, int bottom,
                      int class_id, float conf, const cv::Scalar& color,
                      bool filled) {
+  std::string class_name =
+      class_id >= 0 && class_id < static_cast<int>(kCocoClasses.size())
+          ? std::string(kCocoClasses[class_id])
+          : "class_" + std::to_string(class_id);
+
+  DrawBoundingBox(frame, left, top, right, bottom, std::string_view{class_name},
+                  conf, color, filled);
+}
+
+void DrawBoundingBox(cv::Mat& frame, int left, int top, int right, int bottom,
+                     std::string_view class_name, float conf,
+                     const cv::Scalar& color, bool filled) {
   if (filled) {
     DrawSemiTransparentRect(frame, left, top, right, bottom, color, 0.3f);
   }
@@ -30,11 +49,8 @@ void DrawBoundingBox(cv::Mat& frame, int left, int top, int right, int bottom,
 
   std::string label = cv::format("%.2f", conf);
 
-  if (!kCocoClasses.empty()) {
-    CV_Assert(class_id < static_cast<int>(kCocoClasses.size()));
-    label = std::string(kCocoClasses[class_id]) + ": " + label;
-  } else {
-    label = "class_" + std::to_string(class_id) + ": " + label;
+  if (!class_name.empty()) {
+    label = std::string(class_name) + ": " + label;
   }
 
   int base_line;
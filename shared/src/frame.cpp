@@ -1,9 +1,41 @@
 #include "frame.h"
 
+#include <stdexcept>
 #include <utility>
 
+#include <opencv2/imgcodecs.hpp>
+
 namespace aa::shared {
 
+std::vector<uint8_t> EncodeImage(const cv::Mat& mat,
+                                 ::aa::proto::FrameEncoding encoding,
+                                 int quality) {
+  std::string extension;
+  std::vector<int> params;
+  switch (encoding) {
+    case ::aa::proto::FRAME_ENCODING_JPEG:
+      extension = ".jpg";
+      if (quality > 0) params = {cv::IMWRITE_JPEG_QUALITY, quality};
+      break;
+    case ::aa::proto::FRAME_ENCODING_PNG:
+      extension = ".png";
+      break;
+    case ::aa::proto::FRAME_ENCODING_WEBP:
+      extension = ".webp";
+      if (quality > 0) params = {cv::IMWRITE_WEBP_QUALITY, quality};
+      break;
+    default:
+      throw std::runtime_error("Unsupported frame encoding " +
+                               std::to_string(encoding));
+  }
+
+  std::vector<uint8_t> data;
+  if (!cv::imencode(extension, mat, data, params)) {
+    throw std::runtime_error("Failed to encode frame as " + extension);
+  }
+  return data;
+}
+
 Frame::Frame(int32_t rows, int32_t cols, int32_t elm_type, int32_t elm_size,
              std::vector<uint8_t> data)
     : rows_{rows},
@@ -17,19 +49,22 @@ Frame::Frame(const Frame& other)
       cols_{other.cols_},
       elm_type_{other.elm_type_},
       elm_size_{other.elm_size_},
-      data_{other.data_} {}  // Deep copy of vector
+      data_{other.data_},  // Deep copy of vector
+      encoding_{other.encoding_} {}
 
 Frame::Frame(Frame&& other) noexcept
     : rows_{other.rows_},
       cols_{other.cols_},
       elm_type_{other.elm_type_},
       elm_size_{other.elm_size_},
-      data_{std::move(other.data_)} {
+      data_{std::move(other.data_)},
+      encoding_{other.encoding_} {
   // Reset moved-from object to valid state
   other.rows_ = 0;
   other.cols_ = 0;
   other.elm_type_ = 0;
   other.elm_size_ = 0;
+  other.encoding_ = ::aa::proto::FRAME_ENCODING_RAW;
 }
 
 Frame& Frame::operator=(const Frame& other) {
@@ -39,6 +74,7 @@ Frame& Frame::operator=(const Frame& other) {
     elm_type_ = other.elm_type_;
     elm_size_ = other.elm_size_;
     data_ = other.data_;  // Deep copy of vector
+    encoding_ = other.encoding_;
   }
   return *this;
 }
@@ -50,12 +86,14 @@ Frame& Frame::operator=(Frame&& other) noexcept {
     elm_type_ = other.elm_type_;
     elm_size_ = other.elm_size_;
     data_ = std::move(other.data_);
+    encoding_ = other.encoding_;
 
     // Reset moved-from object to valid state
     other.rows_ = 0;
     other.cols_ = 0;
     other.elm_type_ = 0;
     other.elm_size_ = 0;
+    other.encoding_ = ::aa::proto::FRAME_ENCODING_RAW;
   }
   return *this;
 }
@@ -70,14 +108,29 @@ Frame::Frame(const cv::Mat& mat)
   std::memcpy(data_.data(), mat.data, data_size);
 }
 
+Frame Frame::Encode(const cv::Mat& mat, ::aa::proto::FrameEncoding encoding,
+                    int quality) {
+  if (encoding == ::aa::proto::FRAME_ENCODING_RAW) {
+    return Frame{mat};
+  }
+
+  Frame frame{mat.rows, mat.cols, mat.type(),
+              static_cast<int32_t>(mat.elemSize()),
+              EncodeImage(mat, encoding, quality)};
+  frame.encoding_ = encoding;
+  return frame;
+}
+
 Frame Frame::FromProto(const ::aa::proto::Frame& proto_frame) {
   std::vector<uint8_t> data;
   const std::string& proto_data = proto_frame.data();
   data.reserve(proto_data.size());
   data.assign(proto_data.begin(), proto_data.end());
 
-  return Frame{proto_frame.rows(), proto_frame.cols(), proto_frame.elm_type(),
-               proto_frame.elm_size(), std::move(data)};
+  Frame frame{proto_frame.rows(), proto_frame.cols(), proto_frame.elm_type(),
+              proto_frame.elm_size(), std::move(data)};
+  frame.encoding_ = proto_frame.encoding();
+  return frame;
 }
 
 ::aa::proto::Frame Frame::ToProto() const {
@@ -87,6 +140,7 @@ Frame Frame::FromProto(const ::aa::proto::Frame& proto_frame) {
   proto_frame.set_elm_type(elm_type_);
   proto_frame.set_elm_size(elm_size_);
   proto_frame.set_data(data_.data(), data_.size());
+  proto_frame.set_encoding(encoding_);
   return proto_frame;
 }
 
@@ -96,6 +150,10 @@ cv::Mat Frame::ToMat() const {
     return cv::Mat();  // Return empty Mat for invalid data
   }
 
+  if (encoding_ != ::aa::proto::FRAME_ENCODING_RAW) {
+    return cv::imdecode(data_, cv::IMREAD_UNCHANGED);
+  }
+
   // Calculate expected data size
   size_t expected_size = static_cast<size_t>(rows_) * cols_ * elm_size_;
   if (data_.size() != expected_size) {
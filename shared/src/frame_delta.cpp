@@ -0,0 +1,173 @@
+#include "frame_delta.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Upper bound on decoded frame size, rejects corrupt or hostile headers
+constexpr int64_t kMaxPixels = int64_t{1} << 28;
+
+bool TileChanged(const cv::Mat& current, const cv::Mat& reference,
+                 double threshold) {
+  if (threshold > 0.0) {
+    return cv::norm(current, reference, cv::NORM_INF) > threshold;
+  }
+
+  std::size_t row_bytes = current.cols * current.elemSize();
+  for (int row = 0; row < current.rows; ++row) {
+    if (std::memcmp(current.ptr(row), reference.ptr(row), row_bytes) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void AppendTile(const cv::Mat& tile, std::string* payload) {
+  std::size_t row_bytes = tile.cols * tile.elemSize();
+  for (int row = 0; row < tile.rows; ++row) {
+    payload->append(reinterpret_cast<const char*>(tile.ptr(row)), row_bytes);
+  }
+}
+
+int TileCount(int length, int tile_size) {
+  return (length + tile_size - 1) / tile_size;
+}
+
+}  // namespace
+
+namespace aa::shared {
+
+FrameDeltaEncoder::FrameDeltaEncoder(int tile_size, double threshold)
+    : tile_size_{std::max(1, tile_size)},
+      threshold_{std::max(0.0, threshold)} {}
+
+aa::proto::FrameDelta FrameDeltaEncoder::Encode(const cv::Mat& frame) {
+  CV_Assert(!frame.empty() && frame.dims == 2);
+
+  bool keyframe = reference_.empty() || reference_.size() != frame.size() ||
+                  reference_.type() != frame.type();
+  if (keyframe) {
+    reference_.create(frame.size(), frame.type());
+  }
+
+  aa::proto::FrameDelta delta;
+  delta.set_rows(frame.rows);
+  delta.set_cols(frame.cols);
+  delta.set_elm_type(frame.type());
+  delta.set_elm_size(static_cast<int32_t>(frame.elemSize()));
+  delta.set_tile_size(tile_size_);
+  delta.set_keyframe(keyframe);
+
+  int tiles_x = TileCount(frame.cols, tile_size_);
+  int tiles_y = TileCount(frame.rows, tile_size_);
+  std::string* mask = delta.mutable_tile_mask();
+  mask->assign((tiles_x * tiles_y + 7) / 8, '\0');
+
+  std::string* payload = delta.mutable_tiles();
+  if (keyframe) {
+    payload->reserve(frame.total() * frame.elemSize());
+  }
+
+  int index = 0;
+  for (int ty = 0; ty < tiles_y; ++ty) {
+    for (int tx = 0; tx < tiles_x; ++tx, ++index) {
+      cv::Rect rect(tx * tile_size_, ty * tile_size_,
+                    std::min(tile_size_, frame.cols - tx * tile_size_),
+                    std::min(tile_size_, frame.rows - ty * tile_size_));
+      cv::Mat current = frame(rect);
+      cv::Mat reference = reference_(rect);
+
+      if (!keyframe && !TileChanged(current, reference, threshold_)) {
+        continue;
+      }
+
+      (*mask)[index / 8] |= static_cast<char>(1 << (index % 8));
+      AppendTile(current, payload);
+      current.copyTo(reference);
+    }
+  }
+
+  return delta;
+}
+
+void FrameDeltaEncoder::Reset() { reference_.release(); }
+
+bool FrameDeltaDecoder::Apply(const aa::proto::FrameDelta& delta) {
+  int rows = delta.rows();
+  int cols = delta.cols();
+  int type = delta.elm_type();
+  int tile_size = delta.tile_size();
+
+  if (rows <= 0 || cols <= 0 || tile_size <= 0 ||
+      int64_t{rows} * cols > kMaxPixels || type < 0 ||
+      type >= CV_DEPTH_MAX * CV_CN_MAX ||
+      delta.elm_size() != static_cast<int32_t>(CV_ELEM_SIZE(type))) {
+    return false;
+  }
+
+  if (!delta.keyframe() &&
+      (frame_.empty() || frame_.rows != rows || frame_.cols != cols ||
+       frame_.type() != type)) {
+    return false;
+  }
+
+  int tiles_x = TileCount(cols, tile_size);
+  int tiles_y = TileCount(rows, tile_size);
+  const std::string& mask = delta.tile_mask();
+  if (mask.size() != static_cast<std::size_t>((tiles_x * tiles_y + 7) / 8)) {
+    return false;
+  }
+
+  auto has_tile = [&mask](int index) {
+    return (static_cast<unsigned char>(mask[index / 8]) >> (index % 8)) & 1;
+  };
+  auto tile_rect = [&](int tx, int ty) {
+    return cv::Rect(tx * tile_size, ty * tile_size,
+                    std::min(tile_size, cols - tx * tile_size),
+                    std::min(tile_size, rows - ty * tile_size));
+  };
+
+  // Validate the payload size before touching the frame
+  std::size_t elem_size = static_cast<std::size_t>(delta.elm_size());
+  std::size_t expected = 0;
+  int index = 0;
+  for (int ty = 0; ty < tiles_y; ++ty) {
+    for (int tx = 0; tx < tiles_x; ++tx, ++index) {
+      if (has_tile(index)) {
+        expected += tile_rect(tx, ty).area() * elem_size;
+      } else if (delta.keyframe()) {
+        return false;
+      }
+    }
+  }
+  if (expected != delta.tiles().size()) {
+    return false;
+  }
+
+  if (delta.keyframe()) {
+    frame_.create(rows, cols, type);
+  }
+
+  const char* source = delta.tiles().data();
+  index = 0;
+  for (int ty = 0; ty < tiles_y; ++ty) {
+    for (int tx = 0; tx < tiles_x; ++tx, ++index) {
+      if (!has_tile(index)) continue;
+
+      cv::Rect rect = tile_rect(tx, ty);
+      std::size_t row_bytes = rect.width * elem_size;
+      for (int row = 0; row < rect.height; ++row) {
+        std::memcpy(frame_.ptr(rect.y + row) + rect.x * elem_size, source,
+                    row_bytes);
+        source += row_bytes;
+      }
+    }
+  }
+
+  return true;
+}
+
+void FrameDeltaDecoder::Reset() { frame_.release(); }
+
+}  // namespace aa::shared
@@ -0,0 +1,108 @@
+#include "frame_transform.h"
+
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+
+namespace aa::shared {
+
+FrameTransform FrameTransform::Fit(const cv::Size& source,
+                                   const cv::Size& input, bool pad) {
+  FrameTransform transform;
+  if (source.empty() || input.empty()) return transform;
+
+  // Same rounding as the letterbox of blobFromImageWithParams
+  float factor =
+      std::min(input.width / static_cast<float>(source.width),
+               input.height / static_cast<float>(source.height));
+  if (factor >= 1.0f) return transform;
+
+  transform.source_size_ = source;
+  transform.scaled_size_ =
+      cv::Size(std::max(1, static_cast<int>(source.width * factor)),
+               std::max(1, static_cast<int>(source.height * factor)));
+  transform.scale_x_ =
+      static_cast<double>(transform.scaled_size_.width) / source.width;
+  transform.scale_y_ =
+      static_cast<double>(transform.scaled_size_.height) / source.height;
+  if (pad) {
+    transform.sent_size_ = input;
+    transform.offset_x_ = (input.width - transform.scaled_size_.width) / 2;
+    transform.offset_y_ = (input.height - transform.scaled_size_.height) / 2;
+  } else {
+    transform.sent_size_ = transform.scaled_size_;
+  }
+  return transform;
+}
+
+FrameTransform FrameTransform::FromProto(
+    const ::aa::proto::FrameTransform& proto) {
+  FrameTransform transform;
+  transform.source_size_ =
+      cv::Size(static_cast<int>(proto.source_width()),
+               static_cast<int>(proto.source_height()));
+  transform.scale_x_ = proto.scale_x();
+  transform.scale_y_ = proto.scale_y();
+  transform.offset_x_ = proto.offset_x();
+  transform.offset_y_ = proto.offset_y();
+  transform.scaled_size_ =
+      cv::Size(cvRound(transform.source_size_.width * transform.scale_x_),
+               cvRound(transform.source_size_.height * transform.scale_y_));
+  // Padding is centered, so it is the same on both sides up to a pixel
+  transform.sent_size_ = cv::Size(
+      transform.scaled_size_.width + 2 * cvRound(transform.offset_x_),
+      transform.scaled_size_.height + 2 * cvRound(transform.offset_y_));
+  return transform;
+}
+
+::aa::proto::FrameTransform FrameTransform::ToProto() const {
+  ::aa::proto::FrameTransform proto;
+  proto.set_source_width(static_cast<uint32_t>(source_size_.width));
+  proto.set_source_height(static_cast<uint32_t>(source_size_.height));
+  proto.set_scale_x(static_cast<float>(scale_x_));
+  proto.set_scale_y(static_cast<float>(scale_y_));
+  proto.set_offset_x(static_cast<float>(offset_x_));
+  proto.set_offset_y(static_cast<float>(offset_y_));
+  return proto;
+}
+
+bool FrameTransform::IsValid() const {
+  return source_size_.width > 0 && source_size_.height > 0 && scale_x_ > 0.0 &&
+         scale_y_ > 0.0 && offset_x_ >= 0.0 && offset_y_ >= 0.0;
+}
+
+bool FrameTransform::IsIdentity() const { return source_size_.empty(); }
+
+cv::Mat FrameTransform::Apply(const cv::Mat& source, double pad_value) const {
+  if (IsIdentity()) return source;
+
+  cv::Mat scaled;
+  cv::resize(source, scaled, scaled_size_, 0, 0, cv::INTER_LINEAR);
+  if (sent_size_ == scaled_size_) return scaled;
+
+  int left = static_cast<int>(offset_x_);
+  int top = static_cast<int>(offset_y_);
+  cv::Mat sent;
+  cv::copyMakeBorder(scaled, sent, top, sent_size_.height - top - scaled.rows,
+                     left, sent_size_.width - left - scaled.cols,
+                     cv::BORDER_CONSTANT, cv::Scalar::all(pad_value));
+  return sent;
+}
+
+Point FrameTransform::ToSent(const Point& point) const {
+  return Point{point.GetX() * scale_x_ + offset_x_,
+               point.GetY() * scale_y_ + offset_y_};
+}
+
+cv::Rect FrameTransform::ToSource(const cv::Rect& box) const {
+  if (IsIdentity()) return box;
+
+  cv::Rect source(
+      cv::Point(cvRound((box.x - offset_x_) / scale_x_),
+                cvRound((box.y - offset_y_) / scale_y_)),
+      cv::Point(cvRound((box.x + box.width - offset_x_) / scale_x_),
+                cvRound((box.y + box.height - offset_y_) / scale_y_)));
+  return source & cv::Rect(cv::Point(0, 0), source_size_);
+}
+
+}  // namespace aa::shared
@@ -0,0 +1,300 @@
+#include "frame_wire.h"
+
+#include <algorithm>
+#include <span>
+#include <utility>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "frame.h"
+
+namespace {
+
+// Wire types and tags of the fields handled explicitly
+constexpr uint32_t kWireVarint = 0;
+constexpr uint32_t kWireFixed64 = 1;
+constexpr uint32_t kWireLength = 2;
+constexpr uint32_t kWireFixed32 = 5;
+constexpr uint32_t kResultField = 1;  // ProcessFrameResponse.result
+constexpr uint32_t kDataField = 5;    // Frame.data
+
+void AppendVarint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Sequential reader over the slices of a ByteBuffer
+ */
+class SliceCursor {
+ public:
+  explicit SliceCursor(const std::vector<grpc::Slice>& slices)
+      : slices_{slices} {
+    for (const auto& slice : slices_) total_ += slice.size();
+    SkipEmpty();
+  }
+
+  std::size_t Position() const { return position_; }
+  std::size_t Remaining() const { return total_ - position_; }
+
+  bool ReadVarint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (Remaining() == 0) return false;
+      uint8_t byte = Current()[0];
+      Advance(1);
+      *value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+  }
+
+  /// Append the next n bytes to out
+  bool Read(std::size_t n, std::string* out) {
+    if (n > Remaining()) return false;
+    while (n > 0) {
+      std::size_t chunk = std::min(n, CurrentSize());
+      out->append(reinterpret_cast<const char*>(Current()), chunk);
+      Advance(chunk);
+      n -= chunk;
+    }
+    return true;
+  }
+
+  /// The next n bytes if they lie in a single slice; no bytes always do
+  bool Peek(std::size_t n, std::span<const uint8_t>* bytes) const {
+    if (n == 0) {
+      *bytes = {};
+      return true;
+    }
+    if (n > Remaining() || n > CurrentSize()) return false;
+    *bytes = {Current(), n};
+    return true;
+  }
+
+  void Advance(std::size_t n) {
+    position_ += n;
+    offset_ += n;
+    while (index_ < slices_.size() && offset_ >= slices_[index_].size()) {
+      offset_ -= slices_[index_].size();
+      ++index_;
+    }
+  }
+
+ private:
+  const std::vector<grpc::Slice>& slices_;
+  std::size_t total_{0};
+  std::size_t position_{0};
+  std::size_t index_{0};   ///< Current slice
+  std::size_t offset_{0};  ///< Offset in the current slice
+
+  const uint8_t* Current() const { return slices_[index_].begin() + offset_; }
+  std::size_t CurrentSize() const {
+    return index_ < slices_.size() ? slices_[index_].size() - offset_ : 0;
+  }
+  void SkipEmpty() { Advance(0); }
+};
+
+/**
+ * @brief Copy one field whose tag has been read already to out
+ */
+bool CopyField(SliceCursor* cursor, uint64_t tag, std::string* out) {
+  AppendVarint(out, tag);
+  switch (tag & 0x7) {
+    case kWireVarint: {
+      uint64_t value = 0;
+      if (!cursor->ReadVarint(&value)) return false;
+      AppendVarint(out, value);
+      return true;
+    }
+    case kWireFixed64:
+      return cursor->Read(8, out);
+    case kWireLength: {
+      uint64_t length = 0;
+      if (!cursor->ReadVarint(&length)) return false;
+      AppendVarint(out, length);
+      return cursor->Read(length, out);
+    }
+    case kWireFixed32:
+      return cursor->Read(4, out);
+    default:
+      // Groups are not used by proto3
+      return false;
+  }
+}
+
+}  // namespace
+
+namespace aa::shared {
+
+FramePayload::FramePayload(const cv::Mat& mat) {
+  auto owner = std::make_shared<cv::Mat>(mat.isContinuous() ? mat
+                                                            : mat.clone());
+  data_ = owner->data;
+  size_ = owner->total() * owner->elemSize();
+  owner_ = std::move(owner);
+}
+
+FramePayload::FramePayload(std::vector<uint8_t> data) {
+  auto owner = std::make_shared<std::vector<uint8_t>>(std::move(data));
+  data_ = owner->data();
+  size_ = owner->size();
+  owner_ = std::move(owner);
+}
+
+FramePayload FramePayload::Encode(const cv::Mat& img,
+                                  ::aa::proto::FrameEncoding encoding,
+                                  int quality, ::aa::proto::Frame* header) {
+  header->set_rows(img.rows);
+  header->set_cols(img.cols);
+  header->set_elm_type(img.type());
+  header->set_elm_size(static_cast<int32_t>(img.elemSize()));
+  header->set_encoding(encoding);
+  header->clear_data();
+
+  if (encoding == ::aa::proto::FRAME_ENCODING_RAW) {
+    return FramePayload{img};
+  }
+  return FramePayload{EncodeImage(img, encoding, quality)};
+}
+
+grpc::Slice FramePayload::ToSlice() const {
+  if (Empty()) return grpc::Slice{};
+
+  // The slice owns a reference to the payload until gRPC releases it
+  auto* owner = new std::shared_ptr<const void>(owner_);
+  return grpc::Slice{
+      const_cast<uint8_t*>(data_), size_,
+      [](void* user_data) {
+        delete static_cast<std::shared_ptr<const void>*>(user_data);
+      },
+      owner};
+}
+
+grpc::ByteBuffer SerializeFrameResponse(
+    const ::aa::proto::ProcessFrameResponse& response,
+    const FramePayload& payload) {
+  ::aa::proto::ProcessFrameResponse rest = response;
+  ::aa::proto::Frame header;
+  if (rest.has_result()) {
+    header = std::move(*rest.mutable_result());
+    rest.clear_result();
+  }
+  header.clear_data();
+
+  if (payload.Empty()) {
+    // Nothing to reference: the plain message is as cheap
+    if (response.has_result()) *rest.mutable_result() = std::move(header);
+    std::string bytes = rest.SerializeAsString();
+    grpc::Slice slice{bytes};
+    return grpc::ByteBuffer{&slice, 1};
+  }
+
+  // result = {header fields, data = payload}; fields may come in any order
+  std::string data_prefix;
+  AppendVarint(&data_prefix, (kDataField << 3) | kWireLength);
+  AppendVarint(&data_prefix, payload.Size());
+
+  std::string head;
+  std::string header_bytes = header.SerializeAsString();
+  AppendVarint(&head, (kResultField << 3) | kWireLength);
+  AppendVarint(&head,
+               header_bytes.size() + data_prefix.size() + payload.Size());
+  head += header_bytes;
+  head += data_prefix;
+
+  grpc::Slice slices[] = {grpc::Slice{head}, payload.ToSlice(),
+                          grpc::Slice{rest.SerializeAsString()}};
+  return grpc::ByteBuffer{slices, 3};
+}
+
+bool FrameResponseView::Parse(const grpc::ByteBuffer& buffer) {
+  response_.Clear();
+  slices_.clear();
+  gathered_.clear();
+  payload_ = {};
+  zero_copy_ = false;
+
+  if (!buffer.Dump(&slices_).ok()) return false;
+
+  SliceCursor cursor{slices_};
+  std::string header;  // Fields of result except data
+  std::string rest;    // Fields of the response except result
+  bool has_result = false;
+
+  while (cursor.Remaining() > 0) {
+    uint64_t tag = 0;
+    if (!cursor.ReadVarint(&tag)) return false;
+
+    if (tag != ((kResultField << 3) | kWireLength)) {
+      if (!CopyField(&cursor, tag, &rest)) return false;
+      continue;
+    }
+
+    uint64_t length = 0;
+    if (!cursor.ReadVarint(&length) || length > cursor.Remaining()) {
+      return false;
+    }
+    has_result = true;
+
+    std::size_t end = cursor.Position() + length;
+    while (cursor.Position() < end) {
+      uint64_t field_tag = 0;
+      if (!cursor.ReadVarint(&field_tag)) return false;
+
+      if (field_tag != ((kDataField << 3) | kWireLength)) {
+        if (!CopyField(&cursor, field_tag, &header)) return false;
+        continue;
+      }
+
+      uint64_t size = 0;
+      if (!cursor.ReadVarint(&size) || cursor.Position() > end ||
+          size > end - cursor.Position()) {
+        return false;
+      }
+      std::span<const uint8_t> bytes;
+      if (cursor.Peek(size, &bytes)) {
+        payload_ = {reinterpret_cast<const char*>(bytes.data()), size};
+        zero_copy_ = true;
+        cursor.Advance(size);
+      } else {
+        gathered_.clear();
+        if (!cursor.Read(size, &gathered_)) return false;
+        payload_ = gathered_;
+        zero_copy_ = false;
+      }
+    }
+    if (cursor.Position() != end) return false;
+  }
+
+  if (!response_.ParseFromString(rest)) return false;
+  if (has_result && !response_.mutable_result()->ParseFromString(header)) {
+    return false;
+  }
+  return true;
+}
+
+cv::Mat FrameResponseView::ToMat() const {
+  const auto& result = response_.result();
+  if (payload_.empty()) return {};
+
+  if (result.encoding() != ::aa::proto::FRAME_ENCODING_RAW) {
+    cv::Mat encoded(1, static_cast<int>(payload_.size()), CV_8UC1,
+                    const_cast<char*>(payload_.data()));
+    return cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+  }
+
+  if (result.rows() <= 0 || result.cols() <= 0 ||
+      static_cast<std::size_t>(result.rows()) * result.cols() *
+              CV_ELEM_SIZE(result.elm_type()) !=
+          payload_.size()) {
+    return {};
+  }
+  return cv::Mat(result.rows(), result.cols(), result.elm_type(),
+                 const_cast<char*>(payload_.data()));
+}
+
+}  // namespace aa::shared
@@ -1,6 +1,9 @@
 #include "options.h"
 
+#include <charconv>
+
 #include "logging.h"
+#include "transport_profile.h"
 
 namespace {
 // Define command line parameters using OpenCV's format
@@ -18,11 +21,89 @@ const cv::String keys =
     "{width w        |  640  | Frame width for processing}"
     "{height h       |  640  | Frame height for processing}"
     "{padvalue       | 114.0 | padding value. }"
+    "{layout         | auto  | Model output layout: auto, yolox, yolov5 or "
+    "yolov8. }"
+    "{labels         |      | Class label file, one label per line. }"
     "{rgb            |   0   | Indicate that model works with RGB input images "
     "instead BGR ones. }"
+    "{input_u8       | false | Feed the model 8-bit blobs; the network input "
+    "applies scale and mean. }"
     "{confidence c   | 0.5   | Confidence threshold for detection (0.0-1.0)}"
     "{thr            | 0.5   | Confidence threshold. }"
     "{nms            | 0.4   | Non-maximum suppression threshold. }"
+    "{nms_mode       | hard  | NMS mode: hard or soft (Gaussian decay). }"
+    "{nms_agnostic   | false | Suppress overlapping boxes across classes. }"
+    "{soft_sigma     | 0.5   | Gaussian sigma for soft NMS. }"
+    "{topk           | 1000  | Candidates kept before NMS (0 = all). }"
+    "{max_det        | 300   | Detections kept after NMS (0 = unlimited). }"
+    "{engine         | yolo  | Server: inference engine: yolo or fake (no "
+    "model, synthetic detections). }"
+    "{fake_detections| 10    | Server: detections per frame of the fake "
+    "engine. }"
+    "{fake_latency_ms| 0     | Server: simulated compute time per frame of "
+    "the fake engine. }"
+    "{fake_spin      | false | Server: busy-wait the fake compute time "
+    "instead of sleeping. }"
+    "{workers        | 1     | Server worker processes sharing the port. }"
+    "{cpus_per_worker| 0     | Cores pinned per worker (0 = split evenly). }"
+    "{share_model    | true  | Server: load the model once before forking "
+    "workers, which share its pages. }"
+    "{job            |      | Server: process this video file offline and "
+    "exit. }"
+    "{job_output     | detections.csv | Server: CSV file for --job "
+    "detections. }"
+    "{zones          |      | Server: text-format PolygonSet zone file for "
+    "--job. }"
+    "{segments       | 4     | Server: --job parts decoded in parallel. }"
+    "{batch          | 8     | Server: frames per inference batch, of --job "
+    "or of queued requests. }"
+    "{decode_workers | 2     | Server: threads decoding request frames. }"
+    "{render_workers | 2     | Server: threads drawing and encoding results. }"
+    "{stage_queue    | 16    | Server: frames queued between pipeline "
+    "stages. }"
+    "{zone_crops     | 4     | Server: zone inference crops per frame "
+    "(0 = off). }"
+    "{zone_tolerance | 0     | Server: zone simplification tolerance in "
+    "pixels (0 = exact). }"
+    "{perf_sample    | 0     | Server: read hardware counters per stage on "
+    "every Nth frame (0 = off). }"
+    "{backends       |      | Dispatcher: comma-separated backend addresses. }"
+    "{max_inflight   | 64    | Dispatcher: in-flight requests per backend. }"
+    "{max_queued     | 64    | Dispatcher: queued requests per backend. }"
+    "{health_interval| 1000  | Dispatcher: backend health poll period (ms). }"
+    "{timeout        | 10000 | Dispatcher: backend request timeout (ms). }"
+    "{stream_id      |      | Client: stream id used for sharding. }"
+    "{stream         | false | Client: send the input video as a stream. }"
+    "{source         | false | Client: have the server open --input itself "
+    "and stream back detections only. }"
+    "{lossless       | false | Client: with --source, never drop frames. }"
+    "{events         | false | Client: with --source, receive zone "
+    "occupancy events instead of detections. }"
+    "{debounce       | 3     | Client: frames a zone count must hold before "
+    "an event. }"
+    "{chunk_size     | 1048576 | Client: frames above this many bytes are "
+    "uploaded in chunks of this size (0 = never). }"
+    "{input_dir      |      | Client: process every image in this "
+    "directory. }"
+    "{output_dir     | results | Client: directory for --input_dir results. }"
+    "{jobs           | 4     | Client: images in flight with --input_dir. }"
+    "{preprocess     | none  | Client: fit the frame to the server's model "
+    "input before sending: none, letterbox or resize. }"
+    "{tile_size      | 32    | Client: delta tile edge length in pixels. }"
+    "{delta_threshold| 0     | Client: max pixel change treated as static. }"
+    "{result_width   |      | Client: max width of the returned frame. }"
+    "{result_height  |      | Client: max height of the returned frame. }"
+    "{result_codec   |      | Client: returned frame codec: raw, jpeg, png "
+    "or webp. }"
+    "{result_quality |      | Client: JPEG/WebP quality of the returned "
+    "frame (1-100). }"
+    "{classes        |      | Client: comma-separated class whitelist. }"
+    "{min_conf       |      | Client: per-request minimum confidence. }"
+    "{max_results    |      | Client: per-request maximum detections. }"
+    "{transport      | default | gRPC transport profile: default, lan or "
+    "wan. }"
+    "{compression    |      | Per-call compression: none, deflate or gzip "
+    "(overrides the profile). }"
     "{verbose v      | false | Enable verbose output}";
 }  // namespace
 
@@ -66,9 +147,22 @@ bool Options::ValidateArguments() {
   // Context-aware validation based on instance type
   bool is_server = instance_name_.find("Server") != std::string::npos;
   bool is_client = instance_name_.find("Client") != std::string::npos;
+  bool is_dispatcher = instance_name_.find("Dispatcher") != std::string::npos;
 
-  // Validate model parameter - REQUIRED for server, optional for client
-  if (is_server) {
+  cv::String engine = parser_.get<cv::String>("engine");
+  if (engine != "yolo" && engine != "fake") {
+    AA_LOG_ERROR("engine must be either 'yolo' or 'fake'");
+    return false;
+  }
+
+  if (parser_.get<int>("fake_detections") < 0 ||
+      parser_.get<double>("fake_latency_ms") < 0.0) {
+    AA_LOG_ERROR("fake_detections and fake_latency_ms must be non-negative");
+    return false;
+  }
+
+  // Validate model parameter - REQUIRED for server unless it fakes inference
+  if (is_server && engine != "fake") {
     try {
       cv::String model_path = parser_.get<cv::String>("model");
       if (model_path.empty() || model_path == "true" || model_path == "false" ||
@@ -89,8 +183,8 @@ bool Options::ValidateArguments() {
     }
   }
 
-  // Validate input parameter - REQUIRED for client, optional for server
-  if (is_client) {
+  // Validate input parameter - REQUIRED for client unless it runs a batch
+  if (is_client && !parser_.has("input_dir")) {
     try {
       cv::String input_path = parser_.get<cv::String>("input");
       if (input_path.empty() || input_path == "true" || input_path == "false" ||
@@ -111,6 +205,14 @@ bool Options::ValidateArguments() {
     }
   }
 
+  // Validate backends parameter - REQUIRED for dispatcher
+  if (is_dispatcher && !parser_.has("backends")) {
+    AA_LOG_ERROR(
+        "Backends parameter is required for DetectorDispatcher. "
+        "Use: --backends=host1:50051,host2:50051");
+    return false;
+  }
+
   // Validate ranges (common for both client and server)
   double confidence = parser_.get<double>("confidence");
   if (confidence < 0.0 || confidence > 1.0) {
@@ -118,6 +220,123 @@ bool Options::ValidateArguments() {
     return false;
   }
 
+  if (parser_.has("min_conf")) {
+    double min_conf = parser_.get<double>("min_conf");
+    if (min_conf < 0.0 || min_conf > 1.0) {
+      AA_LOG_ERROR("min_conf must be between 0.0 and 1.0");
+      return false;
+    }
+  }
+
+  if (parser_.has("classes")) {
+    std::vector<int32_t> classes;
+    if (!ParseClassList(parser_.get<cv::String>("classes"), classes)) {
+      AA_LOG_ERROR("classes must be comma-separated non-negative integers");
+      return false;
+    }
+  }
+
+  if (parser_.has("result_codec")) {
+    cv::String codec = parser_.get<cv::String>("result_codec");
+    if (codec != "raw" && codec != "jpeg" && codec != "png" &&
+        codec != "webp") {
+      AA_LOG_ERROR("result_codec must be one of: raw, jpeg, png, webp");
+      return false;
+    }
+  }
+
+  if (parser_.has("result_quality")) {
+    int quality = parser_.get<int>("result_quality");
+    if (quality < 1 || quality > 100) {
+      AA_LOG_ERROR("result_quality must be between 1 and 100");
+      return false;
+    }
+  }
+
+  cv::String nms_mode = parser_.get<cv::String>("nms_mode");
+  if (nms_mode != "hard" && nms_mode != "soft") {
+    AA_LOG_ERROR("NMS mode must be either 'hard' or 'soft'");
+    return false;
+  }
+
+  cv::String layout = parser_.get<cv::String>("layout");
+  if (layout != "auto" && layout != "yolox" && layout != "yolov5" &&
+      layout != "yolov8") {
+    AA_LOG_ERROR("Layout must be one of: auto, yolox, yolov5, yolov8");
+    return false;
+  }
+
+  if (parser_.get<int>("topk") < 0 || parser_.get<int>("max_det") < 0) {
+    AA_LOG_ERROR("topk and max_det must be non-negative");
+    return false;
+  }
+
+  if (!(parser_.get<float>("soft_sigma") > 0.0f)) {
+    AA_LOG_ERROR("soft_sigma must be positive");
+    return false;
+  }
+
+  if (parser_.get<int>("workers") < 1 ||
+      parser_.get<int>("cpus_per_worker") < 0) {
+    AA_LOG_ERROR("workers must be at least 1, cpus_per_worker non-negative");
+    return false;
+  }
+
+  if (parser_.get<int>("batch") < 1 ||
+      parser_.get<int>("decode_workers") < 1 ||
+      parser_.get<int>("render_workers") < 1 ||
+      parser_.get<int>("stage_queue") < 1 ||
+      parser_.get<int>("zone_crops") < 0 ||
+      parser_.get<double>("zone_tolerance") < 0.0 ||
+      parser_.get<int>("perf_sample") < 0) {
+    AA_LOG_ERROR(
+        "batch, decode_workers, render_workers and stage_queue must be "
+        "positive, zone_crops, zone_tolerance and perf_sample non-negative");
+    return false;
+  }
+
+  if (parser_.get<int>("max_inflight") < 1 ||
+      parser_.get<int>("health_interval") < 1 ||
+      parser_.get<int>("timeout") < 1) {
+    AA_LOG_ERROR("max_inflight, health_interval and timeout must be positive");
+    return false;
+  }
+
+  if (parser_.get<int>("max_queued") < 0) {
+    AA_LOG_ERROR("max_queued must be non-negative");
+    return false;
+  }
+
+  cv::String preprocess = parser_.get<cv::String>("preprocess");
+  if (preprocess != "none" && preprocess != "letterbox" &&
+      preprocess != "resize") {
+    AA_LOG_ERROR("preprocess must be one of: none, letterbox, resize");
+    return false;
+  }
+
+  if (parser_.get<int>("jobs") < 1) {
+    AA_LOG_ERROR("jobs must be at least 1");
+    return false;
+  }
+
+  if (parser_.get<int>("tile_size") < 1 ||
+      parser_.get<double>("delta_threshold") < 0.0) {
+    AA_LOG_ERROR("tile_size must be positive, delta_threshold non-negative");
+    return false;
+  }
+
+  if (!TransportProfile::FromName(parser_.get<cv::String>("transport"))) {
+    AA_LOG_ERROR("transport must be one of: default, lan, wan");
+    return false;
+  }
+
+  if (parser_.has("compression") &&
+      !TransportProfile::CompressionFromName(
+          parser_.get<cv::String>("compression"))) {
+    AA_LOG_ERROR("compression must be one of: none, deflate, gzip");
+    return false;
+  }
+
   int width = parser_.get<int>("width");
   int height = parser_.get<int>("height");
   if (width <= 0 || height <= 0) {
@@ -128,4 +347,26 @@ bool Options::ValidateArguments() {
   return true;
 }
 
+bool ParseClassList(std::string_view list, std::vector<int32_t>& classes) {
+  while (!list.empty()) {
+    auto comma = list.find(',');
+    auto entry = list.substr(0, comma);
+    list = comma == std::string_view::npos ? std::string_view{}
+                                           : list.substr(comma + 1);
+    auto begin = entry.find_first_not_of(' ');
+    if (begin == std::string_view::npos) continue;
+    entry = entry.substr(begin, entry.find_last_not_of(' ') - begin + 1);
+
+    int32_t class_id = 0;
+    auto [end, error] =
+        std::from_chars(entry.data(), entry.data() + entry.size(), class_id);
+    if (error != std::errc{} || end != entry.data() + entry.size() ||
+        class_id < 0) {
+      return false;
+    }
+    classes.push_back(class_id);
+  }
+  return true;
+}
+
 }  // namespace aa::shared
@@ -17,16 +17,19 @@ Polygon::Polygon(const Polygon& other)
     : vertices_{other.vertices_},  // Deep copy of vector of Points
       type_{other.type_},
       priority_{other.priority_},
-      target_classes_{other.target_classes_} {}  // Deep copy of vector
+      target_classes_{other.target_classes_},  // Deep copy of vector
+      inference_crop_{other.inference_crop_} {}
 
 Polygon::Polygon(Polygon&& other) noexcept
     : vertices_{std::move(other.vertices_)},
       type_{other.type_},
       priority_{other.priority_},
-      target_classes_{std::move(other.target_classes_)} {
+      target_classes_{std::move(other.target_classes_)},
+      inference_crop_{other.inference_crop_} {
   // Reset moved-from object to valid state
   other.type_ = PolygonType::UNSPECIFIED;
   other.priority_ = 0;
+  other.inference_crop_ = false;
 }
 
 Polygon& Polygon::operator=(const Polygon& other) {
@@ -35,6 +38,7 @@ Polygon& Polygon::operator=(const Polygon& other) {
     type_ = other.type_;
     priority_ = other.priority_;
     target_classes_ = other.target_classes_;  // Deep copy of vector
+    inference_crop_ = other.inference_crop_;
   }
   return *this;
 }
@@ -45,10 +49,12 @@ Polygon& Polygon::operator=(Polygon&& other) noexcept {
     type_ = other.type_;
     priority_ = other.priority_;
     target_classes_ = std::move(other.target_classes_);
+    inference_crop_ = other.inference_crop_;
 
     // Reset moved-from object to valid state
     other.type_ = PolygonType::UNSPECIFIED;
     other.priority_ = 0;
+    other.inference_crop_ = false;
   }
   return *this;
 }
@@ -68,8 +74,10 @@ Polygon Polygon::FromProto(const ::aa::proto::Polygon& proto_polygon) {
     target_classes.push_back(target_class);
   }
 
-  return Polygon{std::move(vertices), type, proto_polygon.priority(),
-                 std::move(target_classes)};
+  Polygon polygon{std::move(vertices), type, proto_polygon.priority(),
+                  std::move(target_classes)};
+  polygon.SetInferenceCrop(proto_polygon.inference_crop());
+  return polygon;
 }
 
 ::aa::proto::Polygon Polygon::ToProto() const {
@@ -92,6 +100,8 @@ Polygon Polygon::FromProto(const ::aa::proto::Polygon& proto_polygon) {
     proto_polygon.add_target_classes(target_class);
   }
 
+  proto_polygon.set_inference_crop(inference_crop_);
+
   return proto_polygon;
 }
 
@@ -0,0 +1,134 @@
+#include "transport_profile.h"
+
+namespace aa::shared {
+
+std::optional<TransportProfile> TransportProfile::FromName(
+    std::string_view name) {
+  TransportProfile profile;
+  profile.name = std::string{name};
+
+  if (name == "default") {
+    return profile;
+  }
+
+  if (name == "lan") {
+    // Round trips are short; the window only has to cover a burst
+    profile.server_max_receive_message_size = 64 << 20;
+    profile.stream_window_bytes = 1 << 20;
+    profile.keepalive_time_ms = 10000;
+    profile.keepalive_timeout_ms = 2000;
+    profile.min_pollers = 2;
+    profile.max_pollers = 8;
+    return profile;
+  }
+
+  if (name == "wan") {
+    // Keeps a whole 4K frame in flight over a 100 ms round trip
+    profile.server_max_receive_message_size = 64 << 20;
+    profile.stream_window_bytes = 32 << 20;
+    profile.write_buffer_size = 1 << 20;
+    profile.keepalive_time_ms = 30000;
+    profile.keepalive_timeout_ms = 10000;
+    profile.keepalive_without_calls = true;
+    profile.resource_quota_bytes = std::size_t{1} << 30;
+    return profile;
+  }
+
+  return std::nullopt;
+}
+
+TransportProfile TransportProfile::FromOptions(const Options& options) {
+  auto profile = FromName(options.Get<std::string>("transport"))
+                     .value_or(TransportProfile{});
+  if (options.Has("compression")) {
+    profile.compression =
+        CompressionFromName(options.Get<std::string>("compression"))
+            .value_or(GRPC_COMPRESS_NONE);
+  }
+  return profile;
+}
+
+std::optional<grpc_compression_algorithm>
+TransportProfile::CompressionFromName(std::string_view name) {
+  if (name == "none") return GRPC_COMPRESS_NONE;
+  if (name == "deflate") return GRPC_COMPRESS_DEFLATE;
+  if (name == "gzip") return GRPC_COMPRESS_GZIP;
+  return std::nullopt;
+}
+
+void TransportProfile::ApplyTo(grpc::ServerBuilder& builder) const {
+  if (server_max_receive_message_size != 0) {
+    builder.SetMaxReceiveMessageSize(server_max_receive_message_size);
+  }
+  if (max_send_message_size != 0) {
+    builder.SetMaxSendMessageSize(max_send_message_size);
+  }
+  if (stream_window_bytes > 0) {
+    builder.AddChannelArgument(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES,
+                               stream_window_bytes);
+  }
+  if (write_buffer_size > 0) {
+    builder.AddChannelArgument(GRPC_ARG_HTTP2_WRITE_BUFFER_SIZE,
+                               write_buffer_size);
+  }
+  if (keepalive_time_ms > 0) {
+    builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIME_MS, keepalive_time_ms);
+    // Accept the client's pings at the same period
+    builder.AddChannelArgument(
+        GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS,
+        keepalive_time_ms);
+    builder.AddChannelArgument(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+  }
+  if (keepalive_timeout_ms > 0) {
+    builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIMEOUT_MS,
+                               keepalive_timeout_ms);
+  }
+  if (keepalive_without_calls) {
+    builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+  }
+  if (min_pollers > 0) {
+    builder.SetSyncServerOption(grpc::ServerBuilder::MIN_POLLERS,
+                                min_pollers);
+  }
+  if (max_pollers > 0) {
+    builder.SetSyncServerOption(grpc::ServerBuilder::MAX_POLLERS,
+                                max_pollers);
+  }
+  if (resource_quota_bytes > 0) {
+    grpc::ResourceQuota quota("aa_" + name);
+    quota.Resize(resource_quota_bytes);
+    builder.SetResourceQuota(quota);
+  }
+  if (compression != GRPC_COMPRESS_NONE) {
+    builder.SetDefaultCompressionAlgorithm(compression);
+  }
+}
+
+void TransportProfile::ApplyTo(grpc::ChannelArguments& args) const {
+  if (channel_max_receive_message_size != 0) {
+    args.SetMaxReceiveMessageSize(channel_max_receive_message_size);
+  }
+  if (max_send_message_size != 0) {
+    args.SetMaxSendMessageSize(max_send_message_size);
+  }
+  if (stream_window_bytes > 0) {
+    args.SetInt(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES, stream_window_bytes);
+  }
+  if (write_buffer_size > 0) {
+    args.SetInt(GRPC_ARG_HTTP2_WRITE_BUFFER_SIZE, write_buffer_size);
+  }
+  if (keepalive_time_ms > 0) {
+    args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, keepalive_time_ms);
+  }
+  if (keepalive_timeout_ms > 0) {
+    args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, keepalive_timeout_ms);
+  }
+  if (keepalive_without_calls) {
+    args.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+  }
+  if (compression != GRPC_COMPRESS_NONE) {
+    args.SetCompressionAlgorithm(compression);
+  }
+}
+
+}  // namespace aa::shared
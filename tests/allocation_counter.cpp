@@ -0,0 +1,182 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || \
+    __has_feature(memory_sanitizer)
+#define AA_SANITIZER_ALLOCATOR 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define AA_SANITIZER_ALLOCATOR 1
+#endif
+
+#if !defined(AA_SANITIZER_ALLOCATOR)
+#define AA_ALLOCATION_HOOKS 1
+#endif
+
+namespace {
+
+// Constant-initialized, so they are usable by allocations during startup
+std::atomic<bool> g_counting{false};
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_bytes{0};
+
+inline void CountAllocation(std::size_t size) {
+  if (g_counting.load(std::memory_order_relaxed)) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+}
+
+bool ParseCount(const std::string& field, uint64_t* value) {
+  const char* end = field.data() + field.size();
+  auto [parsed, error] = std::from_chars(field.data(), end, *value);
+  return error == std::errc{} && parsed == end;
+}
+
+}  // namespace
+
+#if defined(AA_ALLOCATION_HOOKS) && defined(__GLIBC__)
+
+// Every allocator in the process (operator new, OpenCV's fastMalloc,
+// protobuf, gRPC) ends up in the malloc family, so wrapping it counts all
+// of them exactly once.
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+
+void* malloc(std::size_t size) noexcept {
+  CountAllocation(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept {
+  CountAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept {
+  CountAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) noexcept {
+  CountAllocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+  CountAllocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, std::size_t alignment,
+                   std::size_t size) noexcept {
+  if (alignment % sizeof(void*) != 0 ||
+      (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  CountAllocation(size);
+  void* block = __libc_memalign(alignment, size);
+  if (block == nullptr) return ENOMEM;
+  *ptr = block;
+  return 0;
+}
+}  // extern "C"
+
+#elif defined(AA_ALLOCATION_HOOKS)
+
+// Without glibc only C++ allocations can be intercepted portably
+void* operator new(std::size_t size) {
+  CountAllocation(size);
+  if (void* block = std::malloc(size > 0 ? size : 1)) return block;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+#endif
+
+namespace aa::testing {
+
+bool AllocationCountingAvailable() {
+#if defined(AA_ALLOCATION_HOOKS)
+  return true;
+#else
+  return false;
+#endif
+}
+
+AllocationScope::AllocationScope() {
+  g_allocations.store(0, std::memory_order_relaxed);
+  g_bytes.store(0, std::memory_order_relaxed);
+  g_counting.store(true, std::memory_order_seq_cst);
+}
+
+AllocationScope::~AllocationScope() {
+  if (active_) Stop();
+}
+
+AllocationStats AllocationScope::Stop() {
+  g_counting.store(false, std::memory_order_seq_cst);
+  active_ = false;
+
+  AllocationStats stats;
+  stats.allocations = g_allocations.load(std::memory_order_relaxed);
+  stats.bytes = g_bytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::map<std::string, AllocationBudget> LoadAllocationBudgets(
+    const std::string& file) {
+  std::ifstream input(file);
+  if (!input) {
+    throw std::runtime_error("Cannot open allocation budgets " + file);
+  }
+
+  std::map<std::string, AllocationBudget> budgets;
+  std::string line;
+  int number = 0;
+  while (std::getline(input, line)) {
+    ++number;
+    auto begin = line.find_first_not_of(" \t");
+    if (begin == std::string::npos || line[begin] == '#') continue;
+
+    std::istringstream fields(line);
+    std::string path;
+    std::string allocations;
+    std::string bytes;
+    AllocationBudget budget;
+    if (!(fields >> path >> allocations >> bytes)) {
+      throw std::runtime_error("Malformed budget at " + file + ":" +
+                               std::to_string(number));
+    }
+    if (allocations == "-" && bytes == "-") {
+      budget.measured = false;
+    } else if (!ParseCount(allocations, &budget.allocations) ||
+               !ParseCount(bytes, &budget.bytes)) {
+      throw std::runtime_error("Malformed budget at " + file + ":" +
+                               std::to_string(number));
+    }
+    budgets[path] = budget;
+  }
+  return budgets;
+}
+
+}  // namespace aa::testing
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * @file allocation_counter.h
+ * @brief Heap allocation counting for steady-state allocation tests
+ *
+ * Linking allocation_counter.cpp into a test binary replaces the global
+ * allocation functions (malloc family on glibc, operator new elsewhere)
+ * with counting wrappers. Counting is off until an AllocationScope is
+ * active and covers allocations from all threads, so work done by OpenCV
+ * or gRPC worker threads on behalf of the measured call is included.
+ */
+
+namespace aa::testing {
+
+/**
+ * @brief Allocations observed while counting was enabled
+ */
+struct AllocationStats {
+  uint64_t allocations{0};  ///< Number of allocated blocks
+  uint64_t bytes{0};        ///< Requested bytes
+};
+
+/**
+ * @brief Whether the counting hooks are compiled into this binary
+ *
+ * False under sanitizers, which install their own allocator.
+ */
+bool AllocationCountingAvailable();
+
+/**
+ * @brief Counts heap allocations for its lifetime
+ *
+ * Only one scope may be active at a time.
+ *
+ * Usage:
+ * @code
+ * AllocationScope scope;
+ * RunHotPath();
+ * auto stats = scope.Stop();
+ * @endcode
+ */
+class AllocationScope {
+ public:
+  AllocationScope();
+  ~AllocationScope();
+
+  AllocationScope(const AllocationScope&) = delete;
+  AllocationScope& operator=(const AllocationScope&) = delete;
+
+  /**
+   * @brief Stop counting and return the totals
+   */
+  AllocationStats Stop();
+
+ private:
+  bool active_{true};
+};
+
+/**
+ * @brief Per-call allocation budget of a hot path
+ */
+struct AllocationBudget {
+  uint64_t allocations{0};  ///< Maximum blocks per call
+  uint64_t bytes{0};        ///< Maximum requested bytes per call
+  bool measured{true};      ///< False until recorded from a measured run
+};
+
+/**
+ * @brief Load budgets from a file of "<path> <allocations> <bytes>" lines
+ *
+ * Blank lines and lines starting with '#' are ignored. A path whose
+ * allocations and bytes are both "-" has not been measured yet.
+ *
+ * @param file Budget file
+ * @return Budgets by path name
+ * @throws std::runtime_error if the file cannot be read or is malformed
+ */
+std::map<std::string, AllocationBudget> LoadAllocationBudgets(
+    const std::string& file);
+
+}  // namespace aa::testing
@@ -0,0 +1,289 @@
+/**
+ * @file test_allocations.cpp
+ * @brief Steady-state allocation budgets of the server hot paths
+ *
+ * Runs each hot path in a loop with global allocation counting enabled and
+ * fails when the allocations per call exceed the budget checked in at
+ * tests/allocation_budgets.txt. Full ProcessFrame runs with a stub engine,
+ * so everything but the forward pass is covered without a model.
+ *
+ * With AA_RECORD_ALLOCATIONS set, budgets are printed instead of checked:
+ * the measured numbers plus a fixed margin, as lines for the budget file.
+ * Paths budgeted as "-" are printed the same way and fail until recorded.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "allocation_counter.h"
+#include "common.h"
+#include "detector_server.h"
+#include "frame.h"
+#include "frame_wire.h"
+#include "inference_engine.h"
+#include "logging.h"
+#include "nms.h"
+#include "options.h"
+#include "polygon_filter.h"
+#include "yolo_decoder.h"
+
+namespace aa::server {
+
+namespace {
+
+constexpr int kWarmupCalls = 16;
+constexpr int kMeasuredCalls = 64;
+
+// Recorded margin per call, only on paths that allocate at all
+constexpr uint64_t kMarginAllocations = 2;
+constexpr uint64_t kMarginBytes = 4096;
+
+const std::vector<aa::shared::Detection> kStubDetections = {
+    {cv::Rect(20, 40, 30, 60), 0, 0.9f},    // Inside the inclusion zone
+    {cv::Rect(60, 100, 30, 60), 2, 0.8f},   // Inside the inclusion zone
+    {cv::Rect(100, 20, 30, 60), 0, 0.7f},   // Inside the inclusion zone
+    {cv::Rect(200, 100, 20, 20), 0, 0.9f},  // Inside the exclusion zone
+    {cv::Rect(280, 200, 20, 20), 0, 0.6f},  // Outside all zones
+};
+
+/**
+ * @brief Engine returning fixed detections, drawn like Yolo draws them
+ */
+class StubEngine final : public InferenceEngine {
+ public:
+  void Inference(cv::Mat&, std::vector<aa::shared::Detection>& detections,
+                 const DetectionBudget&) override {
+    detections.assign(kStubDetections.begin(), kStubDetections.end());
+  }
+
+  void DrawBoundingBoxes(cv::Mat& img,
+                         const std::vector<aa::shared::Detection>& detections,
+                         double scale) const override {
+    for (const auto& detection : detections) {
+      cv::Rect box(cvRound(detection.bbox.x * scale),
+                   cvRound(detection.bbox.y * scale),
+                   cvRound(detection.bbox.width * scale),
+                   cvRound(detection.bbox.height * scale));
+      aa::shared::DrawBoundingBox(img, box.x, box.y, box.x + box.width,
+                                  box.y + box.height, detection.class_id,
+                                  detection.confidence,
+                                  aa::shared::Color::kRed, true);
+    }
+  }
+};
+
+aa::shared::Polygon MakeRect(double x1, double y1, double x2, double y2,
+                             aa::shared::PolygonType type, int priority) {
+  return aa::shared::Polygon{{aa::shared::Point{x1, y1},
+                              aa::shared::Point{x2, y1},
+                              aa::shared::Point{x2, y2},
+                              aa::shared::Point{x1, y2}},
+                             type,
+                             priority,
+                             {}};
+}
+
+std::vector<aa::shared::Polygon> MakeZones() {
+  std::vector<aa::shared::Polygon> zones;
+  zones.push_back(
+      MakeRect(0, 0, 160, 240, aa::shared::PolygonType::INCLUSION, 1));
+  zones.push_back(
+      MakeRect(180, 80, 240, 140, aa::shared::PolygonType::EXCLUSION, 2));
+  return zones;
+}
+
+cv::Mat MakeImage(int width, int height) {
+  cv::Mat img(height, width, CV_8UC3);
+  cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(255));
+  return img;
+}
+
+/**
+ * @brief Warm a path up, then measure its allocations per call
+ */
+template <typename Call>
+aa::testing::AllocationStats MeasurePerCall(Call&& call) {
+  for (int i = 0; i < kWarmupCalls; ++i) call();
+
+  aa::testing::AllocationScope scope;
+  for (int i = 0; i < kMeasuredCalls; ++i) call();
+  auto total = scope.Stop();
+
+  // Round up: one stray allocation per run still counts
+  return {(total.allocations + kMeasuredCalls - 1) / kMeasuredCalls,
+          (total.bytes + kMeasuredCalls - 1) / kMeasuredCalls};
+}
+
+}  // namespace
+
+class AllocationTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    budgets_ = aa::testing::LoadAllocationBudgets(AA_ALLOCATION_BUDGETS);
+  }
+
+  void SetUp() override {
+    if (!aa::testing::AllocationCountingAvailable()) {
+      GTEST_SKIP() << "Allocation hooks are disabled under sanitizers";
+    }
+    // Production runs with per-frame INFO logs off on hot paths
+    log_level_ = aa::shared::Logging::GetLogLevel();
+    aa::shared::Logging::SetLogLevel(
+        cv::utils::logging::LogLevel::LOG_LEVEL_WARNING);
+  }
+
+  void TearDown() override { aa::shared::Logging::SetLogLevel(log_level_); }
+
+  void ExpectWithinBudget(const std::string& path,
+                          const aa::testing::AllocationStats& per_call) {
+    auto it = budgets_.find(path);
+    ASSERT_NE(it, budgets_.end()) << "No budget for path " << path;
+
+    if (std::getenv("AA_RECORD_ALLOCATIONS") != nullptr) {
+      Record(path, per_call);
+      return;
+    }
+    if (!it->second.measured) {
+      Record(path, per_call);
+      ADD_FAILURE() << "No measured budget for " << path
+                    << ", record one with AA_RECORD_ALLOCATIONS=1";
+      return;
+    }
+
+    EXPECT_LE(per_call.allocations, it->second.allocations)
+        << path << " allocates " << per_call.allocations
+        << " blocks per call, budget " << it->second.allocations;
+    EXPECT_LE(per_call.bytes, it->second.bytes)
+        << path << " allocates " << per_call.bytes
+        << " bytes per call, budget " << it->second.bytes;
+  }
+
+ private:
+  static std::map<std::string, aa::testing::AllocationBudget> budgets_;
+
+  static void Record(const std::string& path,
+                     const aa::testing::AllocationStats& per_call) {
+    aa::testing::AllocationBudget budget;
+    if (per_call.allocations > 0) {
+      budget.allocations = per_call.allocations + kMarginAllocations;
+      budget.bytes = per_call.bytes + kMarginBytes;
+    }
+    std::cout << "[ BUDGET   ] " << path << " " << budget.allocations << " "
+              << budget.bytes << "  (measured " << per_call.allocations
+              << " blocks, " << per_call.bytes << " bytes per call)"
+              << std::endl;
+  }
+  cv::utils::logging::LogLevel log_level_{
+      cv::utils::logging::LogLevel::LOG_LEVEL_INFO};
+};
+
+std::map<std::string, aa::testing::AllocationBudget> AllocationTest::budgets_;
+
+TEST_F(AllocationTest, PolygonFilter) {
+  PolygonFilter filter;
+  filter.SetPolygons(MakeZones());
+  std::vector<aa::shared::Detection> filtered;
+
+  auto per_call = MeasurePerCall(
+      [&] { filter.FilterDetectionsByPolygons(kStubDetections, filtered); });
+
+  EXPECT_EQ(filtered.size(), 3u);
+  ExpectWithinBudget("polygon_filter", per_call);
+}
+
+TEST_F(AllocationTest, YoloPostProcess) {
+  int sizes[] = {1, 8400, 85};
+  cv::Mat output(3, sizes, CV_32F, cv::Scalar(0.0f));
+  for (int anchor = 0; anchor < 8400; anchor += 97) {
+    float* row = output.ptr<float>() + anchor * 85;
+    row[0] = static_cast<float>(anchor % 640);
+    row[1] = static_cast<float>(anchor % 480);
+    row[2] = 40.0f;
+    row[3] = 20.0f;
+    row[4] = 0.9f;
+    row[5 + anchor % 80] = 0.8f;
+  }
+
+  YoloDecoder decoder(OutputLayout::Resolve(YoloFamily::kYolox, output));
+  const std::vector<int32_t> whitelist;
+  Nms nms;
+  NmsCandidates candidates;
+  std::vector<int> keep;
+
+  auto per_call = MeasurePerCall([&] {
+    candidates.Clear();
+    decoder.Decode(output, 0.5f, whitelist, candidates);
+    nms.Run(candidates, keep);
+  });
+
+  EXPECT_FALSE(keep.empty());
+  ExpectWithinBudget("yolo_postprocess", per_call);
+}
+
+TEST_F(AllocationTest, FrameToMat) {
+  auto proto = aa::shared::Frame{MakeImage(640, 480)}.ToProto();
+  cv::Mat mat;
+
+  auto per_call = MeasurePerCall(
+      [&] { mat = aa::shared::Frame::FromProto(proto).ToMat(); });
+
+  EXPECT_EQ(mat.cols, 640);
+  ExpectWithinBudget("frame_to_mat", per_call);
+}
+
+TEST_F(AllocationTest, FrameResponse) {
+  auto img = MakeImage(640, 480);
+  aa::proto::ProcessFrameResponse response;
+  response.set_success(true);
+  std::size_t size = 0;
+
+  auto per_call = MeasurePerCall([&] {
+    auto payload = aa::shared::FramePayload::Encode(
+        img, aa::proto::FRAME_ENCODING_RAW, 0, response.mutable_result());
+    auto buffer = aa::shared::SerializeFrameResponse(response, payload);
+    size = buffer.Length();
+  });
+
+  EXPECT_GT(size, img.total() * img.elemSize());
+  ExpectWithinBudget("frame_response", per_call);
+}
+
+TEST_F(AllocationTest, ProcessFrame) {
+  const char* argv[] = {"test_program", "--address=localhost:50099",
+                        "--model=stub.onnx"};
+  aa::shared::Options options(3, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+  DetectorServer server(std::move(options), std::make_unique<StubEngine>());
+
+  aa::proto::ProcessFrameRequest request;
+  *request.mutable_frame() = aa::shared::Frame{MakeImage(320, 240)}.ToProto();
+  for (const auto& zone : MakeZones()) {
+    *request.add_polygons() = zone.ToProto();
+  }
+
+  grpc::ByteBuffer response;
+  grpc::Status status;
+
+  auto per_call = MeasurePerCall([&] {
+    response.Clear();
+    status = server.ProcessFrame(&request, &response);
+  });
+
+  ASSERT_TRUE(status.ok()) << status.error_message();
+  aa::shared::FrameResponseView view;
+  ASSERT_TRUE(view.Parse(response));
+  EXPECT_TRUE(view.Response().success());
+  EXPECT_EQ(server.GetStats().detections,
+            3u * (kWarmupCalls + kMeasuredCalls));
+  ExpectWithinBudget("process_frame", per_call);
+}
+
+}  // namespace aa::server
@@ -0,0 +1,131 @@
+/**
+ * @file test_async_file_io.cpp
+ * @brief Unit tests for whole-file reads and writes on the I/O thread
+ */
+
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "async_file_io.h"
+
+namespace aa::client {
+
+namespace {
+
+/**
+ * @brief Temporary directory removed at the end of the test
+ */
+class TempDir {
+ public:
+  TempDir()
+      : path_{std::filesystem::path(testing::TempDir()) /
+              ("async_file_io_test_" +
+               std::string(testing::UnitTest::GetInstance()
+                               ->current_test_info()
+                               ->name()))} {
+    std::filesystem::create_directories(path_);
+  }
+  ~TempDir() { std::filesystem::remove_all(path_); }
+
+  const std::filesystem::path& Path() const { return path_; }
+
+ private:
+  std::filesystem::path path_;
+};
+
+AsyncFileIo::Bytes ReadFile(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+AsyncFileIo::Bytes MakeBytes(std::size_t size) {
+  AsyncFileIo::Bytes bytes(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    bytes[i] = static_cast<uint8_t>(i * 13);
+  }
+  return bytes;
+}
+
+}  // namespace
+
+TEST(AsyncFileIoTest, ReadsWholeFile) {
+  TempDir dir;
+  const auto bytes = MakeBytes(100000);
+  {
+    std::ofstream file(dir.Path() / "input.bin", std::ios::binary);
+    file.write(reinterpret_cast<const char*>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+  }
+  std::ofstream(dir.Path() / "empty.bin").close();
+
+  AsyncFileIo io;
+  auto contents = io.Read(dir.Path() / "input.bin");
+  auto empty = io.Read(dir.Path() / "empty.bin");
+  auto missing = io.Read(dir.Path() / "missing.bin");
+
+  auto read = contents.get();
+  ASSERT_TRUE(read.has_value());
+  EXPECT_EQ(*read, bytes);
+  auto read_empty = empty.get();
+  ASSERT_TRUE(read_empty.has_value());
+  EXPECT_TRUE(read_empty->empty());
+  EXPECT_FALSE(missing.get().has_value());
+}
+
+TEST(AsyncFileIoTest, WritesReplaceFilesBeforeFlushReturns) {
+  TempDir dir;
+  const auto path = dir.Path() / "output.bin";
+  std::ofstream(path) << "previous, longer contents of the file";
+
+  AsyncFileIo io;
+  const auto first = MakeBytes(4);
+  const auto second = MakeBytes(250000);
+  io.Write(path, first);
+  io.Write(dir.Path() / "second.bin", second);
+
+  EXPECT_EQ(io.Flush(), 0u);
+  EXPECT_EQ(ReadFile(path), first);
+  EXPECT_EQ(ReadFile(dir.Path() / "second.bin"), second);
+}
+
+TEST(AsyncFileIoTest, FlushCountsFailedWritesOnce) {
+  TempDir dir;
+  AsyncFileIo io;
+  io.Write(dir.Path() / "missing" / "a.bin", MakeBytes(8));
+  io.Write(dir.Path() / "ok.bin", MakeBytes(8));
+  io.Write(dir.Path() / "missing" / "b.bin", MakeBytes(8));
+
+  EXPECT_EQ(io.Flush(), 2u);
+  EXPECT_TRUE(std::filesystem::exists(dir.Path() / "ok.bin"));
+
+  // Failures are reported by the Flush() that saw them only
+  io.Write(dir.Path() / "ok.bin", MakeBytes(16));
+  EXPECT_EQ(io.Flush(), 0u);
+}
+
+TEST(AsyncFileIoTest, ReadEndingBeforeStatSizeKeepsWhatWasRead) {
+  // sysfs attributes report a full page but hold a few bytes, like a file
+  // that shrank between fstat() and read()
+  const std::filesystem::path path = "/sys/devices/system/cpu/online";
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0 || st.st_size == 0) {
+    GTEST_SKIP() << "No sysfs attribute to read";
+  }
+  const auto expected = ReadFile(path);
+  ASSERT_LT(expected.size(), static_cast<std::size_t>(st.st_size));
+
+  AsyncFileIo io;
+  auto read = io.Read(path).get();
+  ASSERT_TRUE(read.has_value());
+  EXPECT_EQ(*read, expected);
+}
+
+}  // namespace aa::client
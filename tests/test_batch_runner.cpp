@@ -0,0 +1,126 @@
+/**
+ * @file test_batch_runner.cpp
+ * @brief Tests of directory batch runs against an in-process server
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "batch_runner.h"
+#include "detector_server.h"
+
+namespace aa::client {
+
+namespace {
+
+constexpr const char* kAddress = "localhost:50071";
+
+/**
+ * @brief Temporary directory removed at the end of the test
+ */
+class TempDir {
+ public:
+  TempDir()
+      : path_{std::filesystem::path(testing::TempDir()) /
+              ("batch_runner_test_" +
+               std::string(testing::UnitTest::GetInstance()
+                               ->current_test_info()
+                               ->name()))} {
+    std::filesystem::create_directories(path_);
+  }
+  ~TempDir() { std::filesystem::remove_all(path_); }
+
+  const std::filesystem::path& Path() const { return path_; }
+
+ private:
+  std::filesystem::path path_;
+};
+
+void Touch(const std::filesystem::path& path, const std::string& contents) {
+  std::ofstream(path, std::ios::binary) << contents;
+}
+
+}  // namespace
+
+TEST(BatchRunnerTest, ListImagesFiltersAndSortsByName) {
+  TempDir dir;
+  Touch(dir.Path() / "b.png", "");
+  Touch(dir.Path() / "a.jpeg", "");
+  Touch(dir.Path() / "C.JPG", "");
+  Touch(dir.Path() / "notes.txt", "");
+  Touch(dir.Path() / "png", "");
+  std::filesystem::create_directories(dir.Path() / "nested.png");
+  Touch(dir.Path() / "nested.png" / "d.png", "");
+
+  auto images = BatchRunner::ListImages(dir.Path());
+  ASSERT_EQ(images.size(), 3u);
+  EXPECT_EQ(images[0].filename(), "C.JPG");
+  EXPECT_EQ(images[1].filename(), "a.jpeg");
+  EXPECT_EQ(images[2].filename(), "b.png");
+
+  EXPECT_TRUE(BatchRunner::ListImages(dir.Path() / "missing").empty());
+}
+
+TEST(BatchRunnerTest, WritesResultsAndCountsFailures) {
+  TempDir dir;
+  const auto input = dir.Path() / "input";
+  const auto output = dir.Path() / "output";
+  std::filesystem::create_directories(input);
+  cv::Mat image(120, 160, CV_8UC3, cv::Scalar(40, 80, 120));
+  ASSERT_TRUE(cv::imwrite((input / "a.png").string(), image));
+  ASSERT_TRUE(cv::imwrite((input / "a.jpg").string(), image));
+  Touch(input / "broken.png", "not an image");
+  Touch(input / "notes.txt", "skipped");
+
+  const std::string address = std::string("--address=") + kAddress;
+  const char* server_argv[] = {"test_program", address.c_str(),
+                               "--engine=fake", "--fake_detections=2"};
+  aa::shared::Options server_options(4, server_argv, "Test Detector Server");
+  ASSERT_TRUE(server_options.IsValid());
+  aa::server::DetectorServer server(std::move(server_options));
+  server.Initialize();
+  std::thread server_thread([&server] { server.Start(); });
+
+  const char* client_argv[] = {"test_program", address.c_str()};
+  aa::shared::Options client_options(2, client_argv, "Test Detector Client");
+  DetectorClient client(std::move(client_options));
+  bool connected = client.Channel()->WaitForConnected(
+      std::chrono::system_clock::now() + std::chrono::seconds(10));
+
+  BatchStats stats;
+  if (connected) {
+    BatchOptions batch_options;
+    batch_options.input_dir = input;
+    batch_options.output_dir = output;
+    batch_options.jobs = 2;
+    BatchRunner runner(client, batch_options, {});
+    EXPECT_FALSE(runner.Run(&stats));
+  }
+
+  // The server is stopped before any assertion can return early
+  server.Shutdown();
+  server_thread.join();
+  ASSERT_TRUE(connected);
+
+  EXPECT_EQ(stats.images, 3u);
+  EXPECT_EQ(stats.processed, 2u);
+  EXPECT_EQ(stats.failed, 1u);
+  EXPECT_GT(stats.bytes_written, 0u);
+
+  // Inputs sharing a stem keep separate results
+  for (const char* name : {"a.png.png", "a.jpg.png"}) {
+    cv::Mat result = cv::imread((output / name).string());
+    ASSERT_FALSE(result.empty()) << name;
+    EXPECT_EQ(result.size(), image.size()) << name;
+  }
+  EXPECT_FALSE(std::filesystem::exists(output / "broken.png.png"));
+}
+
+}  // namespace aa::client
@@ -0,0 +1,169 @@
+/**
+ * @file test_compiled_polygon.cpp
+ * @brief Unit tests for zone simplification and compiled point queries
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "compiled_polygon.h"
+#include "polygon.h"
+
+namespace aa::server {
+
+namespace {
+
+aa::shared::Polygon MakeZone(std::vector<aa::shared::Point> vertices) {
+  return aa::shared::Polygon(std::move(vertices),
+                             aa::shared::PolygonType::INCLUSION, 1, {});
+}
+
+/**
+ * @brief Zone with vertices on a circle, optionally alternating radii
+ */
+aa::shared::Polygon MakeRing(int count, double radius, double inner_radius,
+                             bool round) {
+  std::vector<aa::shared::Point> vertices;
+  for (int i = 0; i < count; ++i) {
+    double angle = 2.0 * M_PI * i / count;
+    double r = i % 2 == 0 ? radius : inner_radius;
+    double x = 200.0 + r * std::cos(angle);
+    double y = 200.0 + r * std::sin(angle);
+    if (round) {
+      x = std::round(x);
+      y = std::round(y);
+    }
+    vertices.push_back({x, y});
+  }
+  return MakeZone(std::move(vertices));
+}
+
+/**
+ * @brief Expect the compiled zone to agree with Polygon::Contains
+ *
+ * Checks a half-pixel grid, which hits vertex heights and outline points,
+ * and random points.
+ */
+void ExpectSameAsPolygon(const aa::shared::Polygon& zone,
+                         const CompiledPolygon& compiled) {
+  for (double y = 0.0; y <= 400.0; y += 0.5) {
+    for (double x = 0.0; x <= 400.0; x += 2.5) {
+      ASSERT_EQ(compiled.Contains(x, y), zone.Contains(x, y))
+          << "at (" << x << ", " << y << ")";
+    }
+  }
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> coordinate(0.0, 400.0);
+  for (int i = 0; i < 20000; ++i) {
+    double x = coordinate(rng);
+    double y = coordinate(rng);
+    ASSERT_EQ(compiled.Contains(x, y), zone.Contains(x, y))
+        << "at (" << x << ", " << y << ")";
+  }
+}
+
+}  // namespace
+
+TEST(CompiledPolygonTest, ConvexZoneMatchesPolygon) {
+  auto zone = MakeRing(256, 150.0, 150.0, false);
+  auto compiled = CompiledPolygon::Compile(zone, 0.0);
+
+  EXPECT_TRUE(compiled.IsConvex());
+  EXPECT_EQ(compiled.GetVertices().size(), 256u);
+  ExpectSameAsPolygon(zone, compiled);
+}
+
+TEST(CompiledPolygonTest, ClockwiseZoneIsConvex) {
+  auto zone = MakeZone({{100, 100}, {100, 300}, {300, 300}, {300, 100}});
+  auto compiled = CompiledPolygon::Compile(zone, 0.0);
+
+  EXPECT_TRUE(compiled.IsConvex());
+  ExpectSameAsPolygon(zone, compiled);
+}
+
+TEST(CompiledPolygonTest, ConcaveZoneMatchesPolygon) {
+  auto zone = MakeRing(300, 180.0, 120.0, true);
+  auto compiled = CompiledPolygon::Compile(zone, 0.0);
+
+  EXPECT_FALSE(compiled.IsConvex());
+  ExpectSameAsPolygon(zone, compiled);
+}
+
+TEST(CompiledPolygonTest, StarPolygonIsNotConvex) {
+  // Every turn of a pentagram goes the same way, but it winds twice
+  std::vector<aa::shared::Point> vertices;
+  for (int i = 0; i < 5; ++i) {
+    double angle = 2.0 * M_PI * (2 * i % 5) / 5.0;
+    vertices.push_back({200.0 + 150.0 * std::cos(angle),
+                        200.0 + 150.0 * std::sin(angle)});
+  }
+  auto zone = MakeZone(std::move(vertices));
+  auto compiled = CompiledPolygon::Compile(zone, 0.0);
+
+  EXPECT_FALSE(compiled.IsConvex());
+  ExpectSameAsPolygon(zone, compiled);
+}
+
+TEST(CompiledPolygonTest, OutlinePointsAreOutside) {
+  // L-shaped zone with a redundant vertex in the middle of its bottom edge
+  auto zone = MakeZone(
+      {{100, 100}, {200, 100}, {200, 200}, {300, 200}, {300, 300},
+       {200, 300}, {100, 300}});
+  auto compiled = CompiledPolygon::Compile(zone, 0.0);
+
+  EXPECT_FALSE(compiled.IsConvex());
+  EXPECT_EQ(compiled.GetVertices().size(), 6u);
+  EXPECT_FALSE(compiled.Contains(100.0, 100.0));  // Vertex
+  EXPECT_FALSE(compiled.Contains(200.0, 300.0));  // Dropped vertex
+  EXPECT_FALSE(compiled.Contains(150.0, 100.0));  // Horizontal edge
+  EXPECT_FALSE(compiled.Contains(200.0, 150.0));  // Vertical edge
+  EXPECT_FALSE(compiled.Contains(250.0, 200.0));  // Inner corner edge
+  EXPECT_TRUE(compiled.Contains(150.0, 200.0));   // At a vertex height
+  EXPECT_TRUE(compiled.Contains(250.0, 250.0));
+  EXPECT_FALSE(compiled.Contains(250.0, 150.0));  // In the notch
+}
+
+TEST(CompiledPolygonTest, ToleranceDropsJitteredVertices) {
+  // Rectangle whose top edge was drawn freehand, wobbling by 0.4 pixels
+  std::vector<aa::shared::Point> vertices;
+  for (int i = 0; i <= 100; ++i) {
+    vertices.push_back({100.0 + 2.0 * i, 100.0 + (i % 2 == 0 ? 0.0 : 0.4)});
+  }
+  vertices.push_back({300.0, 300.0});
+  vertices.push_back({100.0, 300.0});
+  auto zone = MakeZone(std::move(vertices));
+
+  auto exact = CompiledPolygon::Compile(zone, 0.0);
+  EXPECT_EQ(exact.GetVertices().size(), 103u);
+  EXPECT_FALSE(exact.IsConvex());
+
+  auto simplified = CompiledPolygon::Compile(zone, 1.0);
+  EXPECT_EQ(simplified.GetVertices().size(), 4u);
+  EXPECT_TRUE(simplified.IsConvex());
+  EXPECT_TRUE(simplified.Contains(200.0, 200.0));
+  EXPECT_TRUE(simplified.Contains(101.0, 100.5));
+  EXPECT_FALSE(simplified.Contains(200.0, 99.0));
+}
+
+TEST(CompiledPolygonTest, ToleranceNeverErasesAZone) {
+  auto zone = MakeZone({{100, 100}, {101, 100}, {101, 101}, {100, 101}});
+  auto compiled = CompiledPolygon::Compile(zone, 10.0);
+
+  EXPECT_EQ(compiled.GetVertices().size(), 4u);
+  EXPECT_TRUE(compiled.Contains(100.5, 100.5));
+}
+
+TEST(CompiledPolygonTest, DegenerateZoneContainsNothing) {
+  auto line = MakeZone({{100, 100}, {200, 200}, {100, 100}});
+  EXPECT_FALSE(CompiledPolygon::Compile(line, 0.0).Contains(150.0, 150.0));
+
+  auto flat = MakeZone({{100, 100}, {200, 100}, {300, 100}});
+  EXPECT_FALSE(CompiledPolygon::Compile(flat, 0.0).Contains(150.0, 100.0));
+  EXPECT_FALSE(CompiledPolygon::Compile(flat, 0.0).Contains(150.0, 101.0));
+}
+
+}  // namespace aa::server
@@ -1,16 +1,65 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <stdexcept>
 #include <fstream>
+#include <future>
+#include <thread>
+#include <vector>
 #include <opencv2/opencv.hpp>
 
 #include "detector_server.h"
+#include "frame.h"
+#include "frame_wire.h"
 #include "options.h"
+#include "polygon.h"
 
 namespace aa::server {
 
+namespace {
+
+/**
+ * @brief Engine holding its first frame until released, recording batches
+ */
+class GatedEngine final : public InferenceEngine {
+ public:
+  void Inference(cv::Mat&, std::vector<aa::shared::Detection>& detections,
+                 const DetectionBudget&) override {
+    entered = true;
+    while (!released.load()) std::this_thread::yield();
+    detections = {{cv::Rect(10, 10, 20, 20), 0, 0.9f}};
+    batches.push_back(1);
+  }
+
+  void InferenceBatch(
+      std::vector<cv::Mat>& inputs,
+      std::vector<std::vector<aa::shared::Detection>>& detections,
+      const DetectionBudget&) override {
+    detections.assign(inputs.size(),
+                      {{cv::Rect(10, 10, 20, 20), 0, 0.9f}});
+    batches.push_back(inputs.size());
+  }
+
+  ModelInfo GetModelInfo() const override {
+    ModelInfo info;
+    info.input_size = input_size;
+    return info;
+  }
+
+  void DrawBoundingBoxes(cv::Mat&, const std::vector<aa::shared::Detection>&,
+                         double) const override {}
+
+  cv::Size input_size;  ///< Reported model input (empty = unknown)
+  std::atomic<bool> entered{false};
+  std::atomic<bool> released{false};
+  std::vector<std::size_t> batches;  ///< Written by the forward stage only
+};
+
+}  // namespace
+
 class DetectorServerTest : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -90,4 +139,327 @@ TEST_F(DetectorServerTest, MultipleShutdownCalls) {
   });
 }
 
+// Test: Frames queued behind a busy engine are inferred as one batch
+TEST_F(DetectorServerTest, PipelineBatchesQueuedFrames) {
+  const char* argv[] = {"test_program", "--address=localhost:50053",
+                        "--model=stub.onnx", "--batch=8"};
+  aa::shared::Options options(4, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+
+  auto engine = std::make_unique<GatedEngine>();
+  auto* gated = engine.get();
+  DetectorServer server(std::move(options), std::move(engine));
+
+  aa::proto::ProcessFrameRequest request;
+  *request.mutable_frame() =
+      aa::shared::Frame{cv::Mat(120, 160, CV_8UC3, cv::Scalar::all(0))}
+          .ToProto();
+  *request.add_polygons() =
+      aa::shared::Polygon({{0, 0}, {160, 0}, {160, 120}, {0, 120}},
+                          aa::shared::PolygonType::INCLUSION, 1, {})
+          .ToProto();
+
+  constexpr int kRequests = 6;
+  std::atomic<int> succeeded{0};
+  std::vector<std::thread> clients;
+  for (int i = 0; i < kRequests; ++i) {
+    clients.emplace_back([&] {
+      grpc::ByteBuffer response;
+      aa::shared::FrameResponseView view;
+      if (server.ProcessFrame(&request, &response).ok() &&
+          view.Parse(response) && view.Response().success()) {
+        ++succeeded;
+      }
+    });
+  }
+
+  // Let the other requests queue up behind the first one
+  while (!gated->entered.load()) std::this_thread::yield();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  gated->released = true;
+  for (auto& client : clients) client.join();
+
+  EXPECT_EQ(succeeded.load(), kRequests);
+  EXPECT_EQ(server.GetStats().detections, static_cast<uint64_t>(kRequests));
+  std::size_t frames = 0;
+  for (auto size : gated->batches) frames += size;
+  EXPECT_EQ(frames, static_cast<std::size_t>(kRequests));
+  EXPECT_LT(gated->batches.size(), static_cast<std::size_t>(kRequests));
+}
+
+// Test: ProcessFrame returns at once and completes from the pipeline
+TEST_F(DetectorServerTest, ProcessFrameCompletesAsynchronously) {
+  const char* argv[] = {"test_program", "--address=localhost:50053",
+                        "--model=stub.onnx"};
+  aa::shared::Options options(3, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+  auto engine = std::make_unique<GatedEngine>();
+  auto* gated = engine.get();
+  DetectorServer server(std::move(options), std::move(engine));
+
+  aa::proto::ProcessFrameRequest request;
+  *request.mutable_frame() =
+      aa::shared::Frame{cv::Mat(120, 160, CV_8UC3, cv::Scalar::all(0))}
+          .ToProto();
+  *request.add_polygons() =
+      aa::shared::Polygon({{0, 0}, {160, 0}, {160, 120}, {0, 120}},
+                          aa::shared::PolygonType::INCLUSION, 1, {})
+          .ToProto();
+
+  grpc::ByteBuffer response;
+  std::promise<grpc::Status> finished;
+  auto result = finished.get_future();
+  server.ProcessFrame(&request, &response, [&](grpc::Status status) {
+    finished.set_value(std::move(status));
+  });
+
+  // The frame is held in the engine, yet the call has already returned
+  while (!gated->entered.load()) std::this_thread::yield();
+  EXPECT_EQ(result.wait_for(std::chrono::milliseconds(50)),
+            std::future_status::timeout);
+  gated->released = true;
+
+  ASSERT_TRUE(result.get().ok());
+  aa::shared::FrameResponseView view;
+  ASSERT_TRUE(view.Parse(response));
+  EXPECT_TRUE(view.Response().success());
+}
+
+// Test: A full decode queue rejects frames instead of blocking the caller
+TEST_F(DetectorServerTest, FullDecodeQueueRejectsFrames) {
+  const char* argv[] = {"test_program", "--address=localhost:50053",
+                        "--model=stub.onnx", "--stage_queue=1"};
+  aa::shared::Options options(4, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+  auto engine = std::make_unique<GatedEngine>();
+  auto* gated = engine.get();
+  DetectorServer server(std::move(options), std::move(engine));
+
+  aa::proto::ProcessFrameRequest request;
+  *request.mutable_frame() =
+      aa::shared::Frame{cv::Mat(120, 160, CV_8UC3, cv::Scalar::all(0))}
+          .ToProto();
+  *request.add_polygons() =
+      aa::shared::Polygon({{0, 0}, {160, 0}, {160, 120}, {0, 120}},
+                          aa::shared::PolygonType::INCLUSION, 1, {})
+          .ToProto();
+
+  // The engine holds the first frame, so the stage queues fill up
+  constexpr int kRequests = 64;
+  std::vector<grpc::ByteBuffer> responses(kRequests);
+  std::atomic<int> completed{0};
+  std::atomic<int> exhausted{0};
+  for (auto& response : responses) {
+    server.ProcessFrame(&request, &response, [&](grpc::Status status) {
+      if (status.error_code() == grpc::StatusCode::RESOURCE_EXHAUSTED) {
+        ++exhausted;
+      }
+      ++completed;
+    });
+  }
+  EXPECT_GT(exhausted.load(), 0);
+
+  gated->released = true;
+  while (completed.load() < kRequests) std::this_thread::yield();
+  EXPECT_LT(exhausted.load(), kRequests);
+}
+
+// Test: A zone crop runs in the frame's batch and maps back to the frame
+TEST_F(DetectorServerTest, ZoneCropJoinsForwardBatch) {
+  const char* argv[] = {"test_program", "--address=localhost:50053",
+                        "--model=stub.onnx"};
+  aa::shared::Options options(3, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+  auto engine = std::make_unique<GatedEngine>();
+  auto* gated = engine.get();
+  gated->released = true;
+  DetectorServer server(std::move(options), std::move(engine));
+
+  aa::proto::ProcessFrameRequest request;
+  *request.mutable_frame() =
+      aa::shared::Frame{cv::Mat(480, 640, CV_8UC3, cv::Scalar::all(0))}
+          .ToProto();
+  aa::shared::Polygon zone({{400, 300}, {560, 300}, {560, 420}, {400, 420}},
+                           aa::shared::PolygonType::INCLUSION, 1, {});
+  zone.SetInferenceCrop(true);
+  *request.add_polygons() = zone.ToProto();
+
+  grpc::ByteBuffer response;
+  aa::shared::FrameResponseView view;
+  ASSERT_TRUE(server.ProcessFrame(&request, &response).ok());
+  ASSERT_TRUE(view.Parse(response));
+  EXPECT_TRUE(view.Response().success());
+
+  // Only the crop's box lands inside the zone once offset into the frame
+  ASSERT_EQ(gated->batches, std::vector<std::size_t>{2});
+  EXPECT_EQ(server.GetStats().detections, 1u);
+}
+
+// Test: Zone crops count toward the batch cap of a forward pass
+TEST_F(DetectorServerTest, ZoneCropsCountTowardBatchCap) {
+  const char* argv[] = {"test_program", "--address=localhost:50053",
+                        "--model=stub.onnx", "--batch=2"};
+  aa::shared::Options options(4, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+  auto engine = std::make_unique<GatedEngine>();
+  auto* gated = engine.get();
+  DetectorServer server(std::move(options), std::move(engine));
+
+  const auto frame =
+      aa::shared::Frame{cv::Mat(480, 640, CV_8UC3, cv::Scalar::all(0))}
+          .ToProto();
+  aa::proto::ProcessFrameRequest plain;
+  *plain.mutable_frame() = frame;
+  *plain.add_polygons() =
+      aa::shared::Polygon({{0, 0}, {640, 0}, {640, 480}, {0, 480}},
+                          aa::shared::PolygonType::INCLUSION, 1, {})
+          .ToProto();
+  aa::proto::ProcessFrameRequest cropped;
+  *cropped.mutable_frame() = frame;
+  aa::shared::Polygon zone({{400, 300}, {560, 300}, {560, 420}, {400, 420}},
+                           aa::shared::PolygonType::INCLUSION, 1, {});
+  zone.SetInferenceCrop(true);
+  *cropped.add_polygons() = zone.ToProto();
+
+  // The plain frame holds the engine while the cropped ones queue up
+  std::vector<std::thread> clients;
+  clients.emplace_back([&] {
+    grpc::ByteBuffer response;
+    EXPECT_TRUE(server.ProcessFrame(&plain, &response).ok());
+  });
+  while (!gated->entered.load()) std::this_thread::yield();
+  constexpr int kCropped = 3;
+  for (int i = 0; i < kCropped; ++i) {
+    clients.emplace_back([&] {
+      grpc::ByteBuffer response;
+      EXPECT_TRUE(server.ProcessFrame(&cropped, &response).ok());
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  gated->released = true;
+  for (auto& client : clients) client.join();
+
+  // Each cropped frame is two images, so no pass takes two of them
+  std::size_t images = 0;
+  for (auto size : gated->batches) {
+    EXPECT_LE(size, 2u);
+    images += size;
+  }
+  EXPECT_EQ(images, 1u + 2 * kCropped);
+}
+
+// Test: The frames of a ProcessFrames call share one forward pass
+TEST_F(DetectorServerTest, ProcessFramesRunsOneBatch) {
+  const char* argv[] = {"test_program", "--address=localhost:50053",
+                        "--model=stub.onnx"};
+  aa::shared::Options options(3, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+  auto engine = std::make_unique<GatedEngine>();
+  auto* gated = engine.get();
+  gated->released = true;
+  DetectorServer server(std::move(options), std::move(engine));
+
+  aa::proto::ProcessFramesRequest request;
+  aa::proto::ProcessFramesResponse response;
+  EXPECT_EQ(server.ProcessFrames(&request, &response).error_code(),
+            grpc::StatusCode::INVALID_ARGUMENT);
+
+  *request.add_polygons() =
+      aa::shared::Polygon({{0, 0}, {640, 0}, {640, 480}, {0, 480}},
+                          aa::shared::PolygonType::INCLUSION, 1, {})
+          .ToProto();
+  const auto frame =
+      aa::shared::Frame{cv::Mat(480, 640, CV_8UC3, cv::Scalar::all(0))}
+          .ToProto();
+  for (int i = 0; i < 4; ++i) {
+    *request.add_frames()->mutable_frame() = frame;
+  }
+  // Own zones that exclude the engine's box, and a delta, which is rejected
+  *request.mutable_frames(1)->add_polygons() =
+      aa::shared::Polygon({{0, 0}, {640, 0}, {640, 480}, {0, 480}},
+                          aa::shared::PolygonType::EXCLUSION, 1, {})
+          .ToProto();
+  request.mutable_frames(2)->mutable_delta();
+
+  ASSERT_TRUE(server.ProcessFrames(&request, &response).ok());
+  ASSERT_EQ(response.results_size(), 4);
+  EXPECT_TRUE(response.results(0).success());
+  EXPECT_TRUE(response.results(1).success());
+  EXPECT_FALSE(response.results(2).success());
+  EXPECT_TRUE(response.results(3).success());
+  EXPECT_GT(response.results(0).result().data().size(), 0u);
+
+  ASSERT_EQ(gated->batches, std::vector<std::size_t>{3});
+  EXPECT_EQ(server.GetStats().detections, 2u);
+}
+
+// Test: Zones and detections of a client-resized frame use source pixels
+TEST_F(DetectorServerTest, TransformedFrameReportsSourceDetections) {
+  const char* argv[] = {"test_program", "--address=localhost:50053",
+                        "--model=stub.onnx"};
+  aa::shared::Options options(3, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+  auto engine = std::make_unique<GatedEngine>();
+  engine->released = true;
+  DetectorServer server(std::move(options), std::move(engine));
+
+  aa::proto::GetModelInfoResponse info;
+  EXPECT_EQ(server.GetModelInfo(nullptr, &info).error_code(),
+            grpc::StatusCode::FAILED_PRECONDITION);
+
+  // A 1920x1080 source sent as 640x360; the engine finds (10, 10, 20, 20)
+  aa::proto::ProcessFrameRequest request;
+  *request.mutable_frame() =
+      aa::shared::Frame{cv::Mat(360, 640, CV_8UC3, cv::Scalar::all(0))}
+          .ToProto();
+  auto* transform = request.mutable_transform();
+  transform->set_source_width(1920);
+  transform->set_source_height(1080);
+  transform->set_scale_x(640.0f / 1920.0f);
+  transform->set_scale_y(360.0f / 1080.0f);
+  *request.add_polygons() =
+      aa::shared::Polygon({{0, 0}, {300, 0}, {300, 300}, {0, 300}},
+                          aa::shared::PolygonType::INCLUSION, 1, {})
+          .ToProto();
+
+  grpc::ByteBuffer response;
+  aa::shared::FrameResponseView view;
+  ASSERT_TRUE(server.ProcessFrame(&request, &response).ok());
+  ASSERT_TRUE(view.Parse(response));
+  ASSERT_TRUE(view.Response().success());
+  ASSERT_EQ(view.Response().detections_size(), 1);
+  const auto& detection = view.Response().detections(0);
+  EXPECT_EQ(detection.x(), 30);
+  EXPECT_EQ(detection.y(), 30);
+  EXPECT_EQ(detection.width(), 60);
+  EXPECT_EQ(detection.height(), 60);
+
+  transform->set_scale_x(0.0f);
+  ASSERT_TRUE(server.ProcessFrame(&request, &response).ok());
+  ASSERT_TRUE(view.Parse(response));
+  EXPECT_FALSE(view.Response().success());
+}
+
+// Test: Warm-up runs one frame of the model input size, if it has one
+TEST_F(DetectorServerTest, WarmUpRunsModelInputSize) {
+  const char* argv[] = {"test_program", "--address=localhost:50054",
+                        "--model=stub.onnx"};
+  aa::shared::Options options(3, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+
+  auto sized = std::make_unique<GatedEngine>();
+  sized->released = true;
+  sized->input_size = cv::Size(64, 48);
+  auto* sized_engine = sized.get();
+  DetectorServer server(options, std::move(sized));
+  server.WarmUp();
+  EXPECT_EQ(sized_engine->batches, std::vector<std::size_t>{1});
+
+  auto unsized = std::make_unique<GatedEngine>();
+  auto* unsized_engine = unsized.get();
+  DetectorServer skipped(options, std::move(unsized));
+  skipped.WarmUp();
+  EXPECT_FALSE(unsized_engine->entered.load());
+}
+
 }  // namespace aa::server
@@ -0,0 +1,333 @@
+/**
+ * @file test_dispatcher.cpp
+ * @brief Tests of backend slots and queues and of dispatcher routing
+ *
+ * Routing is checked without backends running: backends start out healthy
+ * and their health and slots are set by the test. The forwarding test runs
+ * two fake-engine servers and a dispatcher in process.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "backend.h"
+#include "detector_client.h"
+#include "detector_dispatcher.h"
+#include "detector_server.h"
+#include "frame.h"
+#include "hash_ring.h"
+
+namespace aa::dispatcher {
+
+namespace {
+
+// Nothing listens on these; backends are never probed by the unit tests
+const std::vector<std::string> kBackends = {
+    "localhost:50091", "localhost:50092", "localhost:50093"};
+
+constexpr std::size_t kTimeoutMs = 1000;
+
+std::string StreamId(int i) { return "camera-" + std::to_string(i); }
+
+/**
+ * @brief Dispatcher over kBackends with two slots and one queue entry each
+ */
+std::unique_ptr<DetectorDispatcher> MakeDispatcher() {
+  const std::string backends = "--backends=" + kBackends[0] + "," +
+                               kBackends[1] + "," + kBackends[2];
+  const char* argv[] = {"test_program", "--address=localhost:50090",
+                        backends.c_str(), "--max_inflight=2",
+                        "--max_queued=1"};
+  aa::shared::Options options(5, argv, "Test Detector Dispatcher");
+  EXPECT_TRUE(options.IsValid());
+  return std::make_unique<DetectorDispatcher>(std::move(options));
+}
+
+}  // namespace
+
+TEST(BackendTest, TryAcquireBoundsInFlight) {
+  Backend backend(kBackends[0], 2, 0, kTimeoutMs);
+  EXPECT_TRUE(backend.TryAcquire());
+  EXPECT_TRUE(backend.TryAcquire());
+  EXPECT_FALSE(backend.TryAcquire());
+  EXPECT_EQ(backend.InFlight(), 2);
+  EXPECT_TRUE(backend.IsFull());
+
+  backend.Release();
+  EXPECT_EQ(backend.InFlight(), 1);
+  EXPECT_FALSE(backend.IsFull());
+  EXPECT_TRUE(backend.TryAcquire());
+
+  backend.Release();
+  backend.Release();
+  EXPECT_EQ(backend.InFlight(), 0);
+}
+
+TEST(BackendTest, QueuedRequestsTakeReleasedSlotsInOrder) {
+  Backend backend(kBackends[0], 1, 2, kTimeoutMs);
+  std::vector<int> started;
+  EXPECT_TRUE(backend.Submit([&started] { started.push_back(1); }));
+  EXPECT_TRUE(backend.Submit([&started] { started.push_back(2); }));
+  EXPECT_TRUE(backend.Submit([&started] { started.push_back(3); }));
+  EXPECT_EQ(started, std::vector<int>({1}));
+  EXPECT_EQ(backend.Queued(), 2);
+  EXPECT_TRUE(backend.IsFull());
+
+  // A rejected request is handed back untouched and never runs
+  std::function<void()> rejected = [&started] { started.push_back(4); };
+  EXPECT_FALSE(backend.Submit(std::move(rejected)));
+  EXPECT_TRUE(rejected);
+  EXPECT_FALSE(backend.TryAcquire());
+
+  backend.Release();
+  EXPECT_EQ(started, std::vector<int>({1, 2}));
+  EXPECT_EQ(backend.InFlight(), 1);
+  EXPECT_EQ(backend.Queued(), 1);
+
+  backend.Release();
+  backend.Release();
+  EXPECT_EQ(started, std::vector<int>({1, 2, 3}));
+  EXPECT_EQ(backend.InFlight(), 0);
+  EXPECT_EQ(backend.Queued(), 0);
+}
+
+TEST(BackendTest, AcquireWaitsForReleasedSlot) {
+  Backend backend(kBackends[0], 1, 1, kTimeoutMs);
+  ASSERT_TRUE(backend.TryAcquire());
+
+  std::atomic<bool> acquired{false};
+  std::thread waiter([&] { acquired = backend.Acquire(); });
+  while (backend.Queued() == 0) std::this_thread::yield();
+  EXPECT_FALSE(acquired.load());
+
+  // The queue holds one waiter, so another one is rejected at once
+  EXPECT_FALSE(backend.Acquire());
+
+  backend.Release();
+  waiter.join();
+  EXPECT_TRUE(acquired.load());
+  EXPECT_EQ(backend.InFlight(), 1);
+  backend.Release();
+}
+
+TEST(BackendTest, LoadScoreCountsInFlightAndQueued) {
+  Backend backend(kBackends[0], 1, 1, kTimeoutMs);
+
+  // Without a load report every request counts as 1 ms
+  EXPECT_DOUBLE_EQ(backend.LoadScore(), 1.0);
+  ASSERT_TRUE(backend.TryAcquire());
+  EXPECT_DOUBLE_EQ(backend.LoadScore(), 2.0);
+  ASSERT_TRUE(backend.Submit([] {}));
+  EXPECT_DOUBLE_EQ(backend.LoadScore(), 3.0);
+
+  backend.Release();
+  EXPECT_DOUBLE_EQ(backend.LoadScore(), 2.0);
+  backend.Release();
+  EXPECT_DOUBLE_EQ(backend.LoadScore(), 1.0);
+}
+
+TEST(DispatcherTest, StreamsFollowTheRing) {
+  auto dispatcher = MakeDispatcher();
+  HashRing ring(kBackends);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(dispatcher->SelectBackend(StreamId(i)),
+              ring.Lookup(StreamId(i)))
+        << StreamId(i);
+    EXPECT_EQ(dispatcher->SelectBackend(StreamId(i)),
+              dispatcher->SelectBackend(StreamId(i)));
+  }
+}
+
+TEST(DispatcherTest, UnhealthyBackendFailsOverAndRecovers) {
+  auto dispatcher = MakeDispatcher();
+  HashRing ring(kBackends);
+  const std::size_t owner = dispatcher->SelectBackend("camera-1").value();
+
+  dispatcher->GetBackend(owner).SetHealthy(false);
+  auto next = ring.Lookup(
+      "camera-1", [owner](std::size_t index) { return index != owner; });
+  EXPECT_EQ(dispatcher->SelectBackend("camera-1"), next);
+
+  // Streams of the other backends stay where they are
+  for (int i = 0; i < 100; ++i) {
+    auto home = ring.Lookup(StreamId(i)).value();
+    if (home != owner) {
+      EXPECT_EQ(dispatcher->SelectBackend(StreamId(i)), home) << StreamId(i);
+    }
+  }
+
+  dispatcher->GetBackend(owner).SetHealthy(true);
+  EXPECT_EQ(dispatcher->SelectBackend("camera-1"), owner);
+}
+
+TEST(DispatcherTest, FullBackendFailsOverUntilItDrains) {
+  auto dispatcher = MakeDispatcher();
+  HashRing ring(kBackends);
+  const std::size_t owner = dispatcher->SelectBackend("camera-1").value();
+  auto& backend = dispatcher->GetBackend(owner);
+
+  // Busy slots alone keep the stream home, since requests can still queue
+  ASSERT_TRUE(backend.TryAcquire());
+  ASSERT_TRUE(backend.TryAcquire());
+  EXPECT_EQ(dispatcher->SelectBackend("camera-1"), owner);
+
+  ASSERT_TRUE(backend.Submit([] {}));
+  ASSERT_TRUE(backend.IsFull());
+  auto next = ring.Lookup(
+      "camera-1", [owner](std::size_t index) { return index != owner; });
+  EXPECT_EQ(dispatcher->SelectBackend("camera-1"), next);
+
+  backend.Release();
+  EXPECT_EQ(dispatcher->SelectBackend("camera-1"), owner);
+  backend.Release();
+  backend.Release();
+}
+
+TEST(DispatcherTest, StatelessRequestsPickTheLeastLoaded) {
+  auto dispatcher = MakeDispatcher();
+  EXPECT_EQ(dispatcher->SelectBackend({}), 0u);
+
+  ASSERT_TRUE(dispatcher->GetBackend(0).TryAcquire());
+  EXPECT_EQ(dispatcher->SelectBackend({}), 1u);
+
+  dispatcher->GetBackend(1).SetHealthy(false);
+  EXPECT_EQ(dispatcher->SelectBackend({}), 2u);
+
+  dispatcher->GetBackend(2).SetHealthy(false);
+  EXPECT_EQ(dispatcher->SelectBackend({}), 0u);
+
+  dispatcher->GetBackend(0).SetHealthy(false);
+  EXPECT_FALSE(dispatcher->SelectBackend({}).has_value());
+  EXPECT_FALSE(dispatcher->SelectBackend("camera-1").has_value());
+  dispatcher->GetBackend(0).Release();
+}
+
+TEST(DispatcherTest, ForwardsStreamsToTwoBackends) {
+  const std::vector<std::string> addresses = {"localhost:50082",
+                                              "localhost:50083"};
+  std::vector<std::unique_ptr<aa::server::DetectorServer>> servers;
+  std::vector<std::thread> server_threads;
+  for (const auto& address : addresses) {
+    const std::string flag = "--address=" + address;
+    const char* argv[] = {"test_program", flag.c_str(), "--engine=fake",
+                          "--fake_detections=1"};
+    aa::shared::Options options(4, argv, "Test Detector Server");
+    ASSERT_TRUE(options.IsValid());
+    servers.push_back(
+        std::make_unique<aa::server::DetectorServer>(std::move(options)));
+    servers.back()->Initialize();
+  }
+  for (auto& server : servers) {
+    server_threads.emplace_back([&server] { server->Start(); });
+  }
+
+  // Backends listen before the dispatcher's first health probe
+  bool connected = true;
+  for (const auto& address : addresses) {
+    auto channel =
+        grpc::CreateChannel(address, grpc::InsecureChannelCredentials());
+    connected = connected &&
+                channel->WaitForConnected(std::chrono::system_clock::now() +
+                                          std::chrono::seconds(10));
+  }
+
+  const std::string backends = "--backends=" + addresses[0] + "," +
+                               addresses[1];
+  const char* dispatcher_argv[] = {"test_program", "--address=localhost:50081",
+                                   backends.c_str(), "--health_interval=100"};
+  aa::shared::Options dispatcher_options(4, dispatcher_argv,
+                                         "Test Detector Dispatcher");
+  ASSERT_TRUE(dispatcher_options.IsValid());
+  DetectorDispatcher dispatcher(std::move(dispatcher_options));
+  dispatcher.Initialize();
+  std::thread dispatcher_thread([&dispatcher] { dispatcher.Start(); });
+
+  const char* client_argv[] = {"test_program", "--address=localhost:50081"};
+  aa::shared::Options client_options(2, client_argv, "Test Detector Client");
+  aa::client::DetectorClient client(std::move(client_options));
+  connected = connected &&
+              client.Channel()->WaitForConnected(
+                  std::chrono::system_clock::now() + std::chrono::seconds(10));
+
+  aa::proto::ProcessFrameRequest request;
+  *request.mutable_frame() =
+      aa::shared::Frame{cv::Mat(120, 160, CV_8UC3, cv::Scalar::all(0))}
+          .ToProto();
+
+  // Each stream sends its frames through the dispatcher to its owner
+  constexpr int kStreams = 8;
+  constexpr int kFramesPerStream = 2;
+  std::vector<uint64_t> expected(addresses.size(), 0);
+  int succeeded = 0;
+  if (connected) {
+    for (int i = 0; i < kStreams; ++i) {
+      request.set_stream_id(StreamId(i));
+      ++expected[dispatcher.SelectBackend(StreamId(i)).value()];
+      for (int frame = 0; frame < kFramesPerStream; ++frame) {
+        aa::proto::ProcessFrameResponse response;
+        if (client.ProcessFrame(request, &response).ok() &&
+            response.success()) {
+          ++succeeded;
+        }
+      }
+    }
+  }
+  std::vector<uint64_t> forwarded;
+  for (const auto& server : servers) {
+    forwarded.push_back(server->GetStats().requests);
+  }
+
+  // Streams of a stopped backend move to the other one
+  const std::size_t stopped = 0;
+  int moved_stream = -1;
+  bool moved_ok = false;
+  if (connected) {
+    servers[stopped]->Shutdown();
+    server_threads[stopped].join();
+    for (int i = 0; i < kStreams && moved_stream < 0; ++i) {
+      if (HashRing(addresses).Lookup(StreamId(i)) == stopped) moved_stream = i;
+    }
+    if (moved_stream >= 0) {
+      request.set_stream_id(StreamId(moved_stream));
+      // The first frames may still reach the stopped backend
+      for (int attempt = 0; attempt < 20 && !moved_ok; ++attempt) {
+        aa::proto::ProcessFrameResponse response;
+        moved_ok = client.ProcessFrame(request, &response).ok() &&
+                   response.success();
+        if (!moved_ok) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+      }
+    }
+  }
+
+  // Everything is stopped before any assertion can return early
+  dispatcher.Shutdown();
+  dispatcher_thread.join();
+  for (std::size_t i = 0; i < servers.size(); ++i) {
+    if (server_threads[i].joinable()) {
+      servers[i]->Shutdown();
+      server_threads[i].join();
+    }
+  }
+  ASSERT_TRUE(connected);
+
+  EXPECT_EQ(succeeded, kStreams * kFramesPerStream);
+  for (std::size_t i = 0; i < addresses.size(); ++i) {
+    EXPECT_EQ(forwarded[i], expected[i] * kFramesPerStream) << addresses[i];
+  }
+  if (moved_stream >= 0) {
+    EXPECT_TRUE(moved_ok) << StreamId(moved_stream);
+  }
+}
+
+}  // namespace aa::dispatcher
@@ -0,0 +1,111 @@
+/**
+ * @file test_drop_oldest_queue.cpp
+ * @brief Unit tests for the bounded drop-oldest queue
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "drop_oldest_queue.h"
+
+namespace aa::server {
+
+TEST(DropOldestQueueTest, PopsInOrder) {
+  DropOldestQueue<int> queue(4);
+  EXPECT_FALSE(queue.Push(1));
+  EXPECT_FALSE(queue.Push(2));
+
+  int item = 0;
+  ASSERT_TRUE(queue.Pop(item));
+  EXPECT_EQ(item, 1);
+  ASSERT_TRUE(queue.Pop(item));
+  EXPECT_EQ(item, 2);
+}
+
+TEST(DropOldestQueueTest, FullQueueDropsOldest) {
+  DropOldestQueue<int> queue(2);
+  EXPECT_FALSE(queue.Push(1));
+  EXPECT_FALSE(queue.Push(2));
+  EXPECT_TRUE(queue.Push(3));
+  queue.Close();
+
+  int item = 0;
+  ASSERT_TRUE(queue.Pop(item));
+  EXPECT_EQ(item, 2);
+  ASSERT_TRUE(queue.Pop(item));
+  EXPECT_EQ(item, 3);
+  EXPECT_FALSE(queue.Pop(item));
+}
+
+TEST(DropOldestQueueTest, ZeroCapacityHoldsOneItem) {
+  DropOldestQueue<int> queue(0);
+  EXPECT_FALSE(queue.Push(1));
+  EXPECT_TRUE(queue.Push(2));
+
+  int item = 0;
+  ASSERT_TRUE(queue.Pop(item));
+  EXPECT_EQ(item, 2);
+}
+
+TEST(DropOldestQueueTest, CloseDrainsThenStops) {
+  DropOldestQueue<int> queue(4);
+  queue.Push(7);
+  queue.Close();
+  EXPECT_FALSE(queue.Push(8));
+  EXPECT_FALSE(queue.PushWait(9));
+
+  int item = 0;
+  ASSERT_TRUE(queue.Pop(item));
+  EXPECT_EQ(item, 7);
+  EXPECT_FALSE(queue.Pop(item));
+}
+
+TEST(DropOldestQueueTest, CloseWakesBlockedConsumer) {
+  DropOldestQueue<int> queue(1);
+  std::thread consumer([&] {
+    int item = 0;
+    EXPECT_FALSE(queue.Pop(item));
+  });
+
+  queue.Close();
+  consumer.join();
+}
+
+TEST(DropOldestQueueTest, PopBatchTakesWhatIsQueued) {
+  DropOldestQueue<int> queue(8);
+  for (int i = 0; i < 5; ++i) queue.Push(i);
+
+  std::vector<int> items;
+  ASSERT_TRUE(queue.PopBatch(items, 3));
+  EXPECT_EQ(items, (std::vector<int>{0, 1, 2}));
+  ASSERT_TRUE(queue.PopBatch(items, 3));
+  EXPECT_EQ(items, (std::vector<int>{3, 4}));
+
+  queue.Close();
+  EXPECT_FALSE(queue.PopBatch(items, 3));
+  EXPECT_TRUE(items.empty());
+}
+
+TEST(DropOldestQueueTest, PushWaitKeepsEveryItem) {
+  constexpr int kItems = 1000;
+  DropOldestQueue<int> queue(2);
+
+  std::thread producer([&] {
+    for (int i = 0; i < kItems; ++i) {
+      ASSERT_TRUE(queue.PushWait(i));
+    }
+    queue.Close();
+  });
+
+  int expected = 0;
+  int item = 0;
+  while (queue.Pop(item)) {
+    EXPECT_EQ(item, expected++);
+  }
+  producer.join();
+  EXPECT_EQ(expected, kItems);
+}
+
+}  // namespace aa::server
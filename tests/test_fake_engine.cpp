@@ -0,0 +1,135 @@
+/**
+ * @file test_fake_engine.cpp
+ * @brief Unit tests for the fake inference engine
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "detector_server.h"
+#include "fake_engine.h"
+#include "frame.h"
+#include "frame_wire.h"
+#include "options.h"
+#include "polygon.h"
+
+namespace aa::server {
+
+namespace {
+
+FakeEngineOptions MakeOptions(int detections) {
+  FakeEngineOptions options;
+  options.detections = detections;
+  return options;
+}
+
+}  // namespace
+
+TEST(FakeEngineTest, DetectionsAreDeterministicAndInsideTheFrame) {
+  FakeEngine engine(MakeOptions(7));
+  cv::Mat image(480, 640, CV_8UC3, cv::Scalar::all(0));
+
+  std::vector<aa::shared::Detection> first;
+  std::vector<aa::shared::Detection> second;
+  engine.Inference(image, first, {});
+  engine.Inference(image, second, {});
+
+  ASSERT_EQ(first.size(), 7u);
+  const cv::Rect frame(0, 0, image.cols, image.rows);
+  for (std::size_t i = 0; i < first.size(); ++i) {
+    EXPECT_EQ(first[i].bbox, second[i].bbox);
+    EXPECT_EQ(first[i].class_id, static_cast<int>(i));
+    EXPECT_EQ((first[i].bbox & frame), first[i].bbox);
+    if (i > 0) {
+      EXPECT_LT(first[i].confidence, first[i - 1].confidence);
+    }
+  }
+}
+
+TEST(FakeEngineTest, BudgetIsApplied) {
+  FakeEngine engine(MakeOptions(20));
+  cv::Mat image(240, 320, CV_8UC3, cv::Scalar::all(0));
+  std::vector<aa::shared::Detection> detections;
+
+  DetectionBudget budget;
+  budget.class_whitelist = {1, 3, 5};
+  engine.Inference(image, detections, budget);
+  ASSERT_EQ(detections.size(), 3u);
+  EXPECT_EQ(detections[2].class_id, 5);
+
+  budget = {};
+  budget.min_confidence = 0.5f;
+  engine.Inference(image, detections, budget);
+  ASSERT_FALSE(detections.empty());
+  for (const auto& detection : detections) {
+    EXPECT_GE(detection.confidence, 0.5f);
+  }
+
+  budget = {};
+  budget.max_detections = 4;
+  engine.Inference(image, detections, budget);
+  EXPECT_EQ(detections.size(), 4u);
+}
+
+TEST(FakeEngineTest, ComputeTimeIsSimulated) {
+  for (bool spin : {false, true}) {
+    auto options = MakeOptions(1);
+    options.compute_time = std::chrono::milliseconds(20);
+    options.spin = spin;
+    FakeEngine engine(options);
+    cv::Mat image(64, 64, CV_8UC3, cv::Scalar::all(0));
+    std::vector<aa::shared::Detection> detections;
+
+    auto start = std::chrono::steady_clock::now();
+    engine.Inference(image, detections, {});
+    EXPECT_GE(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(20))
+        << (spin ? "spinning" : "sleeping");
+  }
+}
+
+TEST(FakeEngineTest, ServerRunsWithoutModel) {
+  const char* argv[] = {"test_program", "--address=localhost:50054",
+                        "--engine=fake", "--fake_detections=4"};
+  aa::shared::Options options(4, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+  DetectorServer server(std::move(options));
+
+  aa::proto::ProcessFrameRequest request;
+  *request.mutable_frame() =
+      aa::shared::Frame{cv::Mat(240, 320, CV_8UC3, cv::Scalar::all(0))}
+          .ToProto();
+  *request.add_polygons() =
+      aa::shared::Polygon({{0, 0}, {320, 0}, {320, 240}, {0, 240}},
+                          aa::shared::PolygonType::INCLUSION, 1, {})
+          .ToProto();
+
+  grpc::ByteBuffer response;
+  ASSERT_TRUE(server.ProcessFrame(&request, &response).ok());
+  aa::shared::FrameResponseView view;
+  ASSERT_TRUE(view.Parse(response));
+  EXPECT_TRUE(view.Response().success());
+  EXPECT_EQ(server.GetStats().detections, 4u);
+}
+
+TEST(FakeEngineTest, ServerReportsModelInfo) {
+  const char* argv[] = {"test_program", "--address=localhost:50054",
+                        "--engine=fake", "--width=416", "--height=320"};
+  aa::shared::Options options(5, argv, "Test Detector Server");
+  ASSERT_TRUE(options.IsValid());
+  DetectorServer server(std::move(options));
+
+  aa::proto::GetModelInfoResponse info;
+  ASSERT_TRUE(server.GetModelInfo(nullptr, &info).ok());
+  EXPECT_EQ(info.input_width(), 416u);
+  EXPECT_EQ(info.input_height(), 320u);
+  EXPECT_EQ(info.padding_mode(), aa::proto::PADDING_MODE_LETTERBOX);
+  EXPECT_EQ(info.channel_order(), aa::proto::CHANNEL_ORDER_BGR);
+}
+
+}  // namespace aa::server
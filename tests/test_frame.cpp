@@ -156,4 +156,38 @@ TEST(FrameCopyMoveTest, DeepCopyAssignmentDataIndependence) {
   EXPECT_EQ(assigned.GetData()[0], 100);
 }
 
+TEST(FrameEncodingTest, PngRoundTripIsLossless) {
+  cv::Mat mat(24, 32, CV_8UC3);
+  cv::randu(mat, cv::Scalar::all(0), cv::Scalar::all(255));
+
+  auto frame = Frame::Encode(mat, ::aa::proto::FRAME_ENCODING_PNG);
+  EXPECT_EQ(frame.GetEncoding(), ::aa::proto::FRAME_ENCODING_PNG);
+
+  auto decoded = Frame::FromProto(frame.ToProto()).ToMat();
+  ASSERT_EQ(decoded.size(), mat.size());
+  ASSERT_EQ(decoded.type(), mat.type());
+  EXPECT_EQ(cv::norm(decoded, mat, cv::NORM_INF), 0.0);
+}
+
+TEST(FrameEncodingTest, JpegIsSmallerThanRaw) {
+  cv::Mat mat(240, 320, CV_8UC3, cv::Scalar(40, 80, 120));
+
+  auto raw = Frame::Encode(mat, ::aa::proto::FRAME_ENCODING_RAW);
+  auto jpeg = Frame::Encode(mat, ::aa::proto::FRAME_ENCODING_JPEG, 70);
+
+  EXPECT_EQ(raw.GetEncoding(), ::aa::proto::FRAME_ENCODING_RAW);
+  EXPECT_LT(jpeg.GetData().size(), raw.GetData().size() / 10);
+
+  auto decoded = jpeg.ToMat();
+  ASSERT_EQ(decoded.size(), mat.size());
+  EXPECT_LT(cv::norm(decoded, mat, cv::NORM_INF), 8.0);
+}
+
+TEST(FrameEncodingTest, CorruptPayloadDecodesToEmpty) {
+  Frame frame{2, 2, CV_8UC3, 3, std::vector<uint8_t>(12, 7)};
+  frame.SetEncoding(::aa::proto::FRAME_ENCODING_JPEG);
+
+  EXPECT_TRUE(frame.ToMat().empty());
+}
+
 }  // namespace aa::shared
@@ -0,0 +1,163 @@
+/**
+ * @file test_frame_delta.cpp
+ * @brief Unit tests for tile-based frame delta encoding
+ *
+ * Round-trips synthetic frames through FrameDeltaEncoder and
+ * FrameDeltaDecoder and checks which tiles are sent, that reconstruction is
+ * exact, and that malformed deltas are rejected.
+ */
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "frame_delta.h"
+
+namespace aa::shared {
+
+namespace {
+
+// Frame with a deterministic non-constant pattern
+cv::Mat MakeFrame(int rows, int cols) {
+  cv::Mat frame(rows, cols, CV_8UC3);
+  cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+  return frame;
+}
+
+int CountTiles(const aa::proto::FrameDelta& delta) {
+  int count = 0;
+  for (unsigned char byte : delta.tile_mask()) {
+    for (; byte != 0; byte &= byte - 1) ++count;
+  }
+  return count;
+}
+
+bool Equal(const cv::Mat& a, const cv::Mat& b) {
+  return a.size() == b.size() && a.type() == b.type() &&
+         cv::norm(a, b, cv::NORM_INF) == 0.0;
+}
+
+}  // namespace
+
+TEST(FrameDeltaTest, FirstFrameIsKeyframe) {
+  FrameDeltaEncoder encoder(32);
+  FrameDeltaDecoder decoder;
+  cv::Mat frame = MakeFrame(100, 70);  // Edge tiles are partial
+
+  auto delta = encoder.Encode(frame);
+  EXPECT_TRUE(delta.keyframe());
+  EXPECT_EQ(CountTiles(delta), 4 * 3);
+  EXPECT_EQ(delta.tiles().size(), frame.total() * frame.elemSize());
+
+  ASSERT_TRUE(decoder.Apply(delta));
+  EXPECT_TRUE(Equal(decoder.GetFrame(), frame));
+}
+
+TEST(FrameDeltaTest, StaticFrameSendsNoTiles) {
+  FrameDeltaEncoder encoder(16);
+  cv::Mat frame = MakeFrame(64, 64);
+
+  encoder.Encode(frame);
+  auto delta = encoder.Encode(frame);
+
+  EXPECT_FALSE(delta.keyframe());
+  EXPECT_EQ(CountTiles(delta), 0);
+  EXPECT_TRUE(delta.tiles().empty());
+}
+
+TEST(FrameDeltaTest, SendsOnlyChangedTiles) {
+  FrameDeltaEncoder encoder(16);
+  FrameDeltaDecoder decoder;
+  cv::Mat frame = MakeFrame(64, 64);
+  ASSERT_TRUE(decoder.Apply(encoder.Encode(frame)));
+
+  cv::Mat next = frame.clone();
+  next.at<cv::Vec3b>(5, 5) = cv::Vec3b(1, 2, 3);
+  next.at<cv::Vec3b>(63, 63) = cv::Vec3b(4, 5, 6);
+
+  auto delta = encoder.Encode(next);
+  EXPECT_EQ(CountTiles(delta), 2);
+  EXPECT_EQ(delta.tiles().size(), 2u * 16 * 16 * 3);
+
+  ASSERT_TRUE(decoder.Apply(delta));
+  EXPECT_TRUE(Equal(decoder.GetFrame(), next));
+}
+
+TEST(FrameDeltaTest, ThresholdKeepsDecoderInSync) {
+  FrameDeltaEncoder encoder(8, 4.0);
+  FrameDeltaDecoder decoder;
+  cv::Mat frame(16, 16, CV_8UC1, cv::Scalar(100));
+  ASSERT_TRUE(decoder.Apply(encoder.Encode(frame)));
+
+  // Changes within the threshold are not sent. Each step is compared with
+  // what the decoder holds (100), not with the previous input, so slow
+  // drift is sent once it exceeds the threshold.
+  for (int value = 101; value <= 104; ++value) {
+    frame.setTo(cv::Scalar(value));
+    auto delta = encoder.Encode(frame);
+    EXPECT_EQ(CountTiles(delta), 0);
+    ASSERT_TRUE(decoder.Apply(delta));
+  }
+
+  frame.setTo(cv::Scalar(105));
+  auto delta = encoder.Encode(frame);
+  EXPECT_EQ(CountTiles(delta), 4);
+  ASSERT_TRUE(decoder.Apply(delta));
+  EXPECT_TRUE(Equal(decoder.GetFrame(), frame));
+}
+
+TEST(FrameDeltaTest, SizeChangeStartsNewKeyframe) {
+  FrameDeltaEncoder encoder(32);
+  encoder.Encode(MakeFrame(64, 64));
+
+  auto delta = encoder.Encode(MakeFrame(32, 48));
+  EXPECT_TRUE(delta.keyframe());
+  EXPECT_EQ(delta.rows(), 32);
+  EXPECT_EQ(delta.cols(), 48);
+}
+
+TEST(FrameDeltaTest, RejectsDeltaWithoutKeyframe) {
+  FrameDeltaEncoder encoder(16);
+  cv::Mat frame = MakeFrame(32, 32);
+  encoder.Encode(frame);
+
+  FrameDeltaDecoder decoder;
+  EXPECT_FALSE(decoder.Apply(encoder.Encode(frame)));
+  EXPECT_TRUE(decoder.GetFrame().empty());
+}
+
+TEST(FrameDeltaTest, RejectsTruncatedPayload) {
+  FrameDeltaEncoder encoder(16);
+  FrameDeltaDecoder decoder;
+  cv::Mat frame = MakeFrame(32, 32);
+  ASSERT_TRUE(decoder.Apply(encoder.Encode(frame)));
+  cv::Mat before = decoder.GetFrame().clone();
+
+  cv::Mat next = MakeFrame(32, 32);
+  auto delta = encoder.Encode(next);
+  delta.mutable_tiles()->pop_back();
+
+  EXPECT_FALSE(decoder.Apply(delta));
+  EXPECT_TRUE(Equal(decoder.GetFrame(), before));
+}
+
+TEST(FrameDeltaTest, RejectsInconsistentHeader) {
+  FrameDeltaDecoder decoder;
+  auto delta = FrameDeltaEncoder(16).Encode(MakeFrame(32, 32));
+
+  auto bad_size = delta;
+  bad_size.set_elm_size(1);
+  EXPECT_FALSE(decoder.Apply(bad_size));
+
+  auto bad_mask = delta;
+  bad_mask.mutable_tile_mask()->push_back('\0');
+  EXPECT_FALSE(decoder.Apply(bad_mask));
+
+  auto bad_tile = delta;
+  bad_tile.set_tile_size(0);
+  EXPECT_FALSE(decoder.Apply(bad_tile));
+
+  EXPECT_TRUE(decoder.Apply(delta));
+}
+
+}  // namespace aa::shared
@@ -0,0 +1,131 @@
+/**
+ * @file test_frame_pool.cpp
+ * @brief Unit tests for the chunked upload buffer pool
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <utility>
+
+#include "frame_pool.h"
+
+namespace aa::server {
+
+TEST(FramePoolTest, ReleasedBufferIsReused) {
+  FramePool pool;
+  uint8_t* data = nullptr;
+  {
+    auto buffer = pool.Acquire(1024);
+    EXPECT_EQ(buffer.Size(), 1024u);
+    data = buffer.Data();
+  }
+  EXPECT_EQ(pool.FreeCount(), 1u);
+
+  // A smaller frame fits in the same storage
+  auto buffer = pool.Acquire(512);
+  EXPECT_EQ(buffer.Data(), data);
+  EXPECT_EQ(buffer.Size(), 512u);
+  EXPECT_EQ(pool.FreeCount(), 0u);
+}
+
+TEST(FramePoolTest, TooSmallBufferIsNotReused) {
+  FramePool pool;
+  { auto buffer = pool.Acquire(16); }
+
+  auto buffer = pool.Acquire(64);
+  EXPECT_EQ(buffer.Size(), 64u);
+  EXPECT_EQ(pool.FreeCount(), 1u);
+}
+
+TEST(FramePoolTest, PicksSmallestFittingBuffer) {
+  FramePool pool;
+  uint8_t* medium = nullptr;
+  {
+    auto large = pool.Acquire(4096);
+    auto buffer = pool.Acquire(256);
+    medium = buffer.Data();
+  }
+  ASSERT_EQ(pool.FreeCount(), 2u);
+
+  auto buffer = pool.Acquire(200);
+  EXPECT_EQ(buffer.Data(), medium);
+}
+
+TEST(FramePoolTest, KeepsLargestBuffersWhenFull) {
+  FramePool pool(1);
+  uint8_t* large = nullptr;
+  {
+    auto small = pool.Acquire(16);
+    auto buffer = pool.Acquire(4096);
+    large = buffer.Data();
+  }
+  ASSERT_EQ(pool.FreeCount(), 1u);
+
+  auto buffer = pool.Acquire(1024);
+  EXPECT_EQ(buffer.Data(), large);
+}
+
+TEST(FramePoolTest, GrowsWithReceivedData) {
+  FramePool pool;
+  auto buffer = pool.Acquire(4, 100);
+  EXPECT_EQ(buffer.Capacity(), 4u);
+  std::memcpy(buffer.Data(), "abcd", 4);
+
+  // Doubles while the data grows, keeping what was written
+  buffer.Resize(6);
+  EXPECT_EQ(buffer.Capacity(), 8u);
+  EXPECT_EQ(std::memcmp(buffer.Data(), "abcd", 4), 0);
+
+  // Never past the expected size, unless more is asked for
+  buffer.Resize(80);
+  EXPECT_EQ(buffer.Capacity(), 80u);
+  buffer.Resize(90);
+  EXPECT_EQ(buffer.Capacity(), 100u);
+  buffer.Resize(120);
+  EXPECT_EQ(buffer.Capacity(), 120u);
+  EXPECT_EQ(buffer.Size(), 120u);
+  EXPECT_EQ(std::memcmp(buffer.Data(), "abcd", 4), 0);
+}
+
+TEST(FramePoolTest, ReusesBufferHoldingExpectedSize) {
+  FramePool pool;
+  uint8_t* large = nullptr;
+  {
+    auto small = pool.Acquire(64);
+    auto buffer = pool.Acquire(1024);
+    large = buffer.Data();
+  }
+
+  auto buffer = pool.Acquire(16, 1000);
+  EXPECT_EQ(buffer.Data(), large);
+  EXPECT_EQ(buffer.Size(), 16u);
+  buffer.Resize(1000);
+  EXPECT_EQ(buffer.Data(), large);
+}
+
+TEST(FramePoolTest, CapsRetainedBytes) {
+  FramePool pool(4, 1000, 600);
+  {
+    auto huge = pool.Acquire(700);
+    auto a = pool.Acquire(500);
+    auto b = pool.Acquire(400);
+    auto c = pool.Acquire(300);
+  }
+
+  // The 700-byte buffer is freed; 300 goes to stay within 1000 bytes
+  EXPECT_EQ(pool.FreeCount(), 2u);
+  EXPECT_EQ(pool.FreeBytes(), 900u);
+}
+
+TEST(FramePoolTest, MovedBufferReturnsOnce) {
+  FramePool pool;
+  {
+    auto buffer = pool.Acquire(128);
+    auto moved = std::move(buffer);
+    EXPECT_EQ(moved.Size(), 128u);
+  }
+  EXPECT_EQ(pool.FreeCount(), 1u);
+}
+
+}  // namespace aa::server
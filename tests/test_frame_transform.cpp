@@ -0,0 +1,82 @@
+/**
+ * @file test_frame_transform.cpp
+ * @brief Unit tests for client-side frame resizing and coordinate mapping
+ */
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "frame_transform.h"
+#include "point.h"
+
+namespace aa::shared {
+
+TEST(FrameTransformTest, LetterboxMatchesServerLetterbox) {
+  auto transform =
+      FrameTransform::Fit(cv::Size(1920, 1080), cv::Size(640, 640), true);
+  ASSERT_FALSE(transform.IsIdentity());
+  ASSERT_TRUE(transform.IsValid());
+
+  cv::Mat sent = transform.Apply(
+      cv::Mat(1080, 1920, CV_8UC3, cv::Scalar::all(255)), 114.0);
+  EXPECT_EQ(sent.size(), cv::Size(640, 640));
+  EXPECT_EQ(sent.at<cv::Vec3b>(0, 0)[0], 114);
+  EXPECT_EQ(sent.at<cv::Vec3b>(320, 320)[0], 255);
+
+  auto proto = transform.ToProto();
+  EXPECT_EQ(proto.source_width(), 1920u);
+  EXPECT_EQ(proto.source_height(), 1080u);
+  EXPECT_FLOAT_EQ(proto.offset_x(), 0.0f);
+  EXPECT_FLOAT_EQ(proto.offset_y(), 140.0f);
+}
+
+TEST(FrameTransformTest, ResizeLeavesPaddingToServer) {
+  auto transform =
+      FrameTransform::Fit(cv::Size(3840, 2160), cv::Size(640, 640), false);
+  cv::Mat sent =
+      transform.Apply(cv::Mat(2160, 3840, CV_8UC3, cv::Scalar::all(0)), 0.0);
+  EXPECT_EQ(sent.size(), cv::Size(640, 360));
+  EXPECT_FLOAT_EQ(transform.ToProto().offset_y(), 0.0f);
+}
+
+TEST(FrameTransformTest, FramesThatFitAreNotEnlarged) {
+  auto transform =
+      FrameTransform::Fit(cv::Size(320, 240), cv::Size(640, 640), true);
+  EXPECT_TRUE(transform.IsIdentity());
+  EXPECT_EQ(transform.ToSource(cv::Rect(1, 2, 3, 4)), cv::Rect(1, 2, 3, 4));
+}
+
+TEST(FrameTransformTest, MapsBetweenSourceAndSentFrames) {
+  auto transform = FrameTransform::FromProto(
+      FrameTransform::Fit(cv::Size(1920, 1080), cv::Size(640, 640), true)
+          .ToProto());
+  ASSERT_TRUE(transform.IsValid());
+
+  Point sent = transform.ToSent(Point(300.0, 600.0));
+  EXPECT_NEAR(sent.GetX(), 100.0, 1e-3);
+  EXPECT_NEAR(sent.GetY(), 340.0, 1e-3);
+
+  EXPECT_EQ(transform.ToSource(cv::Rect(100, 340, 20, 10)),
+            cv::Rect(300, 600, 60, 30));
+
+  // Boxes reaching into the padding are clipped to the source frame
+  EXPECT_EQ(transform.ToSource(cv::Rect(0, 130, 20, 20)),
+            cv::Rect(0, 0, 60, 30));
+}
+
+TEST(FrameTransformTest, RejectsInvalidTransforms) {
+  aa::proto::FrameTransform proto;
+  proto.set_source_width(1920);
+  proto.set_source_height(1080);
+  proto.set_scale_x(0.5f);
+  EXPECT_FALSE(FrameTransform::FromProto(proto).IsValid());
+
+  proto.set_scale_y(0.5f);
+  EXPECT_TRUE(FrameTransform::FromProto(proto).IsValid());
+
+  proto.set_offset_x(-1.0f);
+  EXPECT_FALSE(FrameTransform::FromProto(proto).IsValid());
+}
+
+}  // namespace aa::shared
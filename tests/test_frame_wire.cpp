@@ -0,0 +1,180 @@
+/**
+ * @file test_frame_wire.cpp
+ * @brief Unit tests for the raw ByteBuffer ProcessFrameResponse path
+ *
+ * Checks that responses serialized with the frame payload as a separate
+ * slice are valid protobuf messages, and that FrameResponseView parses
+ * both these and regularly serialized responses.
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <grpcpp/impl/codegen/proto_utils.h>
+#include <opencv2/core.hpp>
+
+#include "frame_wire.h"
+
+namespace aa::shared {
+
+namespace {
+
+cv::Mat MakeImage() {
+  cv::Mat img(6, 5, CV_8UC3);
+  for (std::size_t i = 0; i < img.total() * img.elemSize(); ++i) {
+    img.data[i] = static_cast<uint8_t>(i * 7);
+  }
+  return img;
+}
+
+std::string Bytes(const cv::Mat& img) {
+  return {reinterpret_cast<const char*>(img.data),
+          img.total() * img.elemSize()};
+}
+
+aa::proto::ProcessFrameResponse MakeResponse(const cv::Mat& img,
+                                             FramePayload* payload) {
+  aa::proto::ProcessFrameResponse response;
+  response.set_success(true);
+  *payload = FramePayload::Encode(img, aa::proto::FRAME_ENCODING_RAW, 0,
+                                  response.mutable_result());
+  return response;
+}
+
+// Split serialized bytes into slices at the given offsets
+grpc::ByteBuffer Split(const std::string& bytes,
+                       const std::vector<std::size_t>& cuts) {
+  std::vector<grpc::Slice> slices;
+  std::size_t begin = 0;
+  for (std::size_t cut : cuts) {
+    slices.emplace_back(bytes.data() + begin, cut - begin);
+    begin = cut;
+  }
+  slices.emplace_back(bytes.data() + begin, bytes.size() - begin);
+  return grpc::ByteBuffer{slices.data(), slices.size()};
+}
+
+}  // namespace
+
+TEST(FrameWireTest, PayloadReferencesImage) {
+  auto img = MakeImage();
+  FramePayload payload{img};
+
+  EXPECT_EQ(payload.Data(), img.data);
+  EXPECT_EQ(payload.Size(), img.total() * img.elemSize());
+  EXPECT_TRUE(FramePayload{}.Empty());
+}
+
+TEST(FrameWireTest, RoundTripKeepsPayloadInPlace) {
+  auto img = MakeImage();
+  FramePayload payload;
+  auto buffer = SerializeFrameResponse(MakeResponse(img, &payload), payload);
+
+  FrameResponseView view;
+  ASSERT_TRUE(view.Parse(buffer));
+  EXPECT_TRUE(view.Response().success());
+  EXPECT_EQ(view.Response().result().rows(), 6);
+  EXPECT_EQ(view.Response().result().cols(), 5);
+  EXPECT_TRUE(view.Response().result().data().empty());
+  EXPECT_TRUE(view.IsZeroCopy());
+  EXPECT_EQ(view.Payload(), Bytes(img));
+
+  auto mat = view.ToMat();
+  ASSERT_FALSE(mat.empty());
+  EXPECT_EQ(mat.type(), CV_8UC3);
+  EXPECT_EQ(Bytes(mat), Bytes(img));
+}
+
+TEST(FrameWireTest, SerializedResponseIsRegularMessage) {
+  auto img = MakeImage();
+  FramePayload payload;
+  auto buffer = SerializeFrameResponse(MakeResponse(img, &payload), payload);
+
+  aa::proto::ProcessFrameResponse response;
+  ASSERT_TRUE(grpc::SerializationTraits<aa::proto::ProcessFrameResponse>::
+                  Deserialize(&buffer, &response)
+                      .ok());
+  EXPECT_TRUE(response.success());
+  EXPECT_EQ(response.result().rows(), 6);
+  EXPECT_EQ(response.result().elm_type(), CV_8UC3);
+  EXPECT_EQ(response.result().data(), Bytes(img));
+}
+
+TEST(FrameWireTest, GathersPayloadSpanningSlices) {
+  auto img = MakeImage();
+  aa::proto::ProcessFrameResponse response;
+  response.set_success(true);
+  response.mutable_result()->set_rows(img.rows);
+  response.mutable_result()->set_cols(img.cols);
+  response.mutable_result()->set_elm_type(img.type());
+  response.mutable_result()->set_data(Bytes(img));
+  auto bytes = response.SerializeAsString();
+
+  FrameResponseView single;
+  ASSERT_TRUE(single.Parse(Split(bytes, {})));
+  EXPECT_TRUE(single.IsZeroCopy());
+  EXPECT_EQ(single.Payload(), Bytes(img));
+
+  FrameResponseView split;
+  ASSERT_TRUE(split.Parse(Split(bytes, {3, 20, 50})));
+  EXPECT_FALSE(split.IsZeroCopy());
+  EXPECT_TRUE(split.Response().success());
+  EXPECT_EQ(split.Response().result().cols(), 5);
+  EXPECT_EQ(split.Payload(), Bytes(img));
+}
+
+TEST(FrameWireTest, EmptyPayloadWithoutResult) {
+  aa::proto::ProcessFrameResponse response;
+  response.set_success(false);
+  auto buffer = SerializeFrameResponse(response, FramePayload{});
+
+  FrameResponseView view;
+  ASSERT_TRUE(view.Parse(buffer));
+  EXPECT_FALSE(view.Response().success());
+  EXPECT_FALSE(view.Response().has_result());
+  EXPECT_TRUE(view.ToMat().empty());
+}
+
+TEST(FrameWireTest, EmptyPayloadAtEndOfBuffer) {
+  aa::proto::Frame header;
+  header.set_rows(0);
+  header.set_encoding(aa::proto::FRAME_ENCODING_RAW);
+  std::string result = header.SerializeAsString();
+  result += static_cast<char>((aa::proto::Frame::kDataFieldNumber << 3) | 2);
+  result += '\0';
+
+  aa::proto::ProcessFrameResponse rest;
+  rest.set_success(true);
+  std::string bytes = rest.SerializeAsString();
+  bytes += static_cast<char>(
+      (aa::proto::ProcessFrameResponse::kResultFieldNumber << 3) | 2);
+  bytes += static_cast<char>(result.size());
+  bytes += result;
+
+  // The cursor reaches the end of the buffer right at the empty payload
+  for (const auto& cuts :
+       {std::vector<std::size_t>{}, std::vector<std::size_t>{bytes.size()}}) {
+    FrameResponseView view;
+    ASSERT_TRUE(view.Parse(Split(bytes, cuts)));
+    EXPECT_TRUE(view.Response().success());
+    EXPECT_TRUE(view.Response().has_result());
+    EXPECT_TRUE(view.Payload().empty());
+    EXPECT_TRUE(view.ToMat().empty());
+  }
+}
+
+TEST(FrameWireTest, RejectsTruncatedResponse) {
+  auto img = MakeImage();
+  FramePayload payload;
+  auto response = MakeResponse(img, &payload);
+  response.mutable_result()->set_data(Bytes(img));
+  auto bytes = response.SerializeAsString();
+  bytes.resize(bytes.size() - 10);
+
+  FrameResponseView view;
+  EXPECT_FALSE(view.Parse(Split(bytes, {})));
+}
+
+}  // namespace aa::shared
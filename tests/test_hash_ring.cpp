@@ -0,0 +1,110 @@
+/**
+ * @file test_hash_ring.cpp
+ * @brief Unit tests for the dispatcher's consistent hash ring
+ *
+ * Checks that streams are spread evenly, that routing is stable and
+ * independent of backend order, and that removing or skipping a backend
+ * only moves the streams it owned.
+ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "hash_ring.h"
+
+namespace aa::dispatcher {
+
+namespace {
+
+const std::vector<std::string> kBackends = {"10.0.0.1:50051", "10.0.0.2:50051",
+                                            "10.0.0.3:50051",
+                                            "10.0.0.4:50051"};
+
+constexpr int kStreams = 10000;
+
+std::string StreamId(int i) { return "camera-" + std::to_string(i); }
+
+// Address owning a key, so rings over different node lists can be compared
+std::string Owner(const HashRing& ring, const std::vector<std::string>& nodes,
+                  const std::string& key) {
+  return nodes[ring.Lookup(key).value()];
+}
+
+}  // namespace
+
+TEST(HashRingTest, EmptyRingHasNoOwner) {
+  HashRing ring({});
+  EXPECT_EQ(ring.Size(), 0u);
+  EXPECT_FALSE(ring.Lookup("camera-1").has_value());
+}
+
+TEST(HashRingTest, SpreadsStreamsEvenly) {
+  HashRing ring(kBackends);
+  std::map<std::size_t, int> counts;
+  for (int i = 0; i < kStreams; ++i) {
+    ++counts[ring.Lookup(StreamId(i)).value()];
+  }
+
+  ASSERT_EQ(counts.size(), kBackends.size());
+  for (const auto& [backend, count] : counts) {
+    EXPECT_GT(count, kStreams / 4 * 3 / 4) << kBackends[backend];
+    EXPECT_LT(count, kStreams / 4 * 5 / 4) << kBackends[backend];
+  }
+}
+
+TEST(HashRingTest, IndependentOfBackendOrder) {
+  std::vector<std::string> reversed(kBackends.rbegin(), kBackends.rend());
+  HashRing ring(kBackends);
+  HashRing reversed_ring(reversed);
+
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(Owner(ring, kBackends, StreamId(i)),
+              Owner(reversed_ring, reversed, StreamId(i)));
+  }
+}
+
+TEST(HashRingTest, RemovingBackendOnlyMovesItsStreams) {
+  std::vector<std::string> remaining = {kBackends[0], kBackends[1],
+                                        kBackends[3]};
+  HashRing ring(kBackends);
+  HashRing smaller_ring(remaining);
+
+  int moved = 0;
+  for (int i = 0; i < kStreams; ++i) {
+    auto before = Owner(ring, kBackends, StreamId(i));
+    auto after = Owner(smaller_ring, remaining, StreamId(i));
+    if (before != kBackends[2]) {
+      EXPECT_EQ(before, after) << StreamId(i);
+    } else {
+      ++moved;
+    }
+  }
+  EXPECT_GT(moved, 0);
+  EXPECT_LT(moved, kStreams / 2);
+}
+
+TEST(HashRingTest, SkipsRejectedBackends) {
+  HashRing ring(kBackends);
+  auto not_first = [](std::size_t index) { return index != 0; };
+
+  for (int i = 0; i < 1000; ++i) {
+    auto owner = ring.Lookup(StreamId(i)).value();
+    auto rerouted = ring.Lookup(StreamId(i), not_first).value();
+
+    EXPECT_NE(rerouted, 0u);
+    if (owner != 0) {
+      EXPECT_EQ(owner, rerouted) << StreamId(i);
+    }
+  }
+}
+
+TEST(HashRingTest, NoOwnerWhenAllRejected) {
+  HashRing ring(kBackends);
+  EXPECT_FALSE(
+      ring.Lookup("camera-1", [](std::size_t) { return false; }).has_value());
+}
+
+}  // namespace aa::dispatcher
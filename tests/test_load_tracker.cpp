@@ -0,0 +1,95 @@
+/**
+ * @file test_load_tracker.cpp
+ * @brief Unit tests for the server load tracker
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <utility>
+
+#include "load_tracker.h"
+
+namespace aa::server {
+
+namespace {
+
+aa::proto::LoadReport Report(const LoadTracker& tracker) {
+  aa::proto::LoadReport report;
+  tracker.Fill(&report);
+  return report;
+}
+
+}  // namespace
+
+TEST(LoadTrackerTest, StartsIdle) {
+  LoadTracker tracker;
+  auto report = Report(tracker);
+
+  EXPECT_EQ(report.queue_depth(), 0u);
+  EXPECT_EQ(report.in_flight(), 0u);
+  EXPECT_FLOAT_EQ(report.ewma_service_ms(), 0.0f);
+  EXPECT_EQ(report.input_width(), 0u);
+}
+
+TEST(LoadTrackerTest, TicketsCountQueueAndInFlight) {
+  LoadTracker tracker;
+  {
+    auto first = tracker.Enter();
+    auto second = tracker.Enter();
+    EXPECT_EQ(Report(tracker).queue_depth(), 2u);
+    EXPECT_EQ(Report(tracker).in_flight(), 2u);
+
+    first.Begin();
+    EXPECT_EQ(Report(tracker).queue_depth(), 1u);
+    EXPECT_EQ(Report(tracker).in_flight(), 2u);
+
+    // Moved-from tickets do not release twice
+    auto moved = std::move(second);
+  }
+
+  auto report = Report(tracker);
+  EXPECT_EQ(report.queue_depth(), 0u);
+  EXPECT_EQ(report.in_flight(), 0u);
+}
+
+TEST(LoadTrackerTest, CompleteRecordsServiceAndInput) {
+  LoadTracker tracker(0.5);
+  {
+    auto ticket = tracker.Enter();
+    ticket.Begin();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ticket.Complete(640, 480);
+  }
+
+  auto report = Report(tracker);
+  EXPECT_GE(report.ewma_service_ms(), 20.0f);
+  EXPECT_EQ(report.input_width(), 640u);
+  EXPECT_EQ(report.input_height(), 480u);
+
+  // A fast request pulls the average halfway down
+  float previous = report.ewma_service_ms();
+  {
+    auto ticket = tracker.Enter();
+    ticket.Begin();
+    ticket.Complete(320, 240);
+  }
+  report = Report(tracker);
+  EXPECT_LT(report.ewma_service_ms(), previous * 0.6f);
+  EXPECT_EQ(report.input_width(), 320u);
+}
+
+TEST(LoadTrackerTest, QueuedTicketDoesNotRecord) {
+  LoadTracker tracker;
+  {
+    auto ticket = tracker.Enter();
+    ticket.Complete(640, 480);
+  }
+
+  auto report = Report(tracker);
+  EXPECT_FLOAT_EQ(report.ewma_service_ms(), 0.0f);
+  EXPECT_EQ(report.input_width(), 0u);
+}
+
+}  // namespace aa::server
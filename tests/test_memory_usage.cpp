@@ -0,0 +1,43 @@
+/**
+ * @file test_memory_usage.cpp
+ * @brief Unit tests for the process memory report
+ */
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "memory_usage.h"
+
+namespace aa::server {
+
+TEST(MemoryUsageTest, ParsesSmapsRollup) {
+  std::istringstream rollup(
+      "55d0c0a00000-7ffd2b1fe000 ---p 00000000 00:00 0    [rollup]\n"
+      "Rss:                4096 kB\n"
+      "Pss:                2560 kB\n"
+      "Pss_Anon:           1024 kB\n"
+      "Shared_Clean:       2048 kB\n"
+      "Shared_Dirty:       1024 kB\n"
+      "Private_Clean:       512 kB\n"
+      "Private_Dirty:       512 kB\n"
+      "Referenced:         4096 kB\n");
+
+  auto usage = MemoryUsage::Parse(rollup);
+
+  EXPECT_EQ(usage.rss, 4096u * 1024);
+  EXPECT_EQ(usage.pss, 2560u * 1024);
+  EXPECT_EQ(usage.shared, 3072u * 1024);
+  EXPECT_EQ(usage.private_bytes, 1024u * 1024);
+  EXPECT_EQ(usage.ToString(),
+            "rss 4.0 MiB, pss 2.5 MiB, shared 3.0 MiB, private 1.0 MiB");
+}
+
+TEST(MemoryUsageTest, ReadsOwnProcess) {
+  auto usage = MemoryUsage::Read();
+
+  EXPECT_GT(usage.rss, 0u);
+  EXPECT_LE(usage.private_bytes, usage.rss);
+}
+
+}  // namespace aa::server
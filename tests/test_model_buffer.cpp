@@ -0,0 +1,60 @@
+/**
+ * @file test_model_buffer.cpp
+ * @brief Unit tests for read-only model file mappings
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "model_buffer.h"
+
+namespace aa::server {
+
+namespace {
+
+/**
+ * @brief Temporary file removed at the end of the test
+ */
+class TempFile {
+ public:
+  explicit TempFile(const std::string& contents)
+      : path_{testing::TempDir() + "model_buffer_test.onnx"} {
+    std::ofstream(path_, std::ios::binary) << contents;
+  }
+  ~TempFile() { std::remove(path_.c_str()); }
+
+  const std::string& Path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+}  // namespace
+
+TEST(ModelBufferTest, MapsFileContents) {
+  const std::string contents("weights\0and more", 16);
+  TempFile file(contents);
+
+  ModelBuffer model(file.Path());
+
+  EXPECT_EQ(model.Path(), file.Path());
+  ASSERT_EQ(model.Size(), contents.size());
+  EXPECT_EQ(std::string(model.Data(), model.Size()), contents);
+}
+
+TEST(ModelBufferTest, MissingFileThrows) {
+  EXPECT_THROW(ModelBuffer("/nonexistent/path/model.onnx"),
+               std::runtime_error);
+}
+
+TEST(ModelBufferTest, EmptyFileThrows) {
+  TempFile file("");
+
+  EXPECT_THROW(ModelBuffer model(file.Path()), std::runtime_error);
+}
+
+}  // namespace aa::server
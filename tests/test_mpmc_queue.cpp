@@ -0,0 +1,178 @@
+/**
+ * @file test_mpmc_queue.cpp
+ * @brief Unit tests for the lock-free MPMC queue and pipeline stages
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mpmc_queue.h"
+#include "pipeline_stage.h"
+
+namespace aa::server {
+
+TEST(MpmcQueueTest, PopsInOrder) {
+  MpmcQueue<int> queue(4);
+  int item = 1;
+  ASSERT_TRUE(queue.TryPush(item));
+  item = 2;
+  ASSERT_TRUE(queue.TryPush(item));
+
+  ASSERT_TRUE(queue.TryPop(item));
+  EXPECT_EQ(item, 1);
+  ASSERT_TRUE(queue.TryPop(item));
+  EXPECT_EQ(item, 2);
+  EXPECT_FALSE(queue.TryPop(item));
+}
+
+TEST(MpmcQueueTest, CapacityRoundsUpToPowerOfTwo) {
+  EXPECT_EQ(MpmcQueue<int>(0).Capacity(), 2u);
+  EXPECT_EQ(MpmcQueue<int>(5).Capacity(), 8u);
+  EXPECT_EQ(MpmcQueue<int>(16).Capacity(), 16u);
+}
+
+TEST(MpmcQueueTest, FullQueueRejectsTryPush) {
+  MpmcQueue<int> queue(2);
+  int item = 1;
+  ASSERT_TRUE(queue.TryPush(item));
+  ASSERT_TRUE(queue.TryPush(item));
+  item = 3;
+  EXPECT_FALSE(queue.TryPush(item));
+  EXPECT_EQ(item, 3);
+
+  // A pop frees a cell for the next lap around the ring
+  ASSERT_TRUE(queue.TryPop(item));
+  item = 3;
+  EXPECT_TRUE(queue.TryPush(item));
+}
+
+TEST(MpmcQueueTest, CloseDrainsThenStops) {
+  MpmcQueue<int> queue(4);
+  ASSERT_TRUE(queue.Push(7));
+  queue.Close();
+  EXPECT_FALSE(queue.Push(8));
+
+  int item = 0;
+  ASSERT_TRUE(queue.Pop(item));
+  EXPECT_EQ(item, 7);
+  EXPECT_FALSE(queue.Pop(item));
+}
+
+TEST(MpmcQueueTest, CloseWakesWaiters) {
+  MpmcQueue<int> empty(2);
+  std::thread consumer([&] {
+    int item = 0;
+    EXPECT_FALSE(empty.Pop(item));
+  });
+
+  MpmcQueue<int> full(2);
+  ASSERT_TRUE(full.Push(1));
+  ASSERT_TRUE(full.Push(2));
+  std::thread producer([&] { EXPECT_FALSE(full.Push(3)); });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  empty.Close();
+  full.Close();
+  consumer.join();
+  producer.join();
+}
+
+TEST(MpmcQueueTest, ConcurrentProducersAndConsumers) {
+  constexpr int kProducers = 4;
+  constexpr int kConsumers = 4;
+  constexpr int kItems = 20000;
+  MpmcQueue<int> queue(8);
+
+  std::vector<std::atomic<int>> seen(kProducers * kItems);
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < kConsumers; ++c) {
+    consumers.emplace_back([&] {
+      int item = 0;
+      while (queue.Pop(item)) seen[item].fetch_add(1);
+    });
+  }
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < kItems; ++i) {
+        ASSERT_TRUE(queue.Push(p * kItems + i));
+      }
+    });
+  }
+  for (auto& producer : producers) producer.join();
+  queue.Close();
+  for (auto& consumer : consumers) consumer.join();
+
+  // Every item is delivered exactly once
+  for (const auto& count : seen) {
+    ASSERT_EQ(count.load(), 1);
+  }
+}
+
+TEST(PipelineStageTest, ChainedStagesProcessEveryItem) {
+  std::mutex mutex;
+  std::vector<int> results;
+  {
+    PipelineStage<int> second(1, 4, 1, [&](std::vector<int>& items) {
+      std::lock_guard<std::mutex> lock(mutex);
+      results.insert(results.end(), items.begin(), items.end());
+    });
+    PipelineStage<int> first(3, 4, 1, [&](std::vector<int>& items) {
+      for (int item : items) second.Submit(item * 10);
+    });
+    EXPECT_EQ(first.Workers(), 3u);
+    for (int i = 0; i < 100; ++i) ASSERT_TRUE(first.Submit(i));
+  }
+
+  ASSERT_EQ(results.size(), 100u);
+  std::sort(results.begin(), results.end());
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(results[i], i * 10);
+}
+
+TEST(PipelineStageTest, QueuedItemsAreBatched) {
+  std::atomic<bool> release{false};
+  std::vector<std::size_t> sizes;
+  {
+    PipelineStage<int> stage(1, 16, 4, [&](std::vector<int>& items) {
+      // The first call holds the worker while the rest queue up
+      while (!release.load()) std::this_thread::yield();
+      sizes.push_back(items.size());
+    });
+    for (int i = 0; i < 9; ++i) ASSERT_TRUE(stage.Submit(i));
+    release = true;
+  }
+
+  ASSERT_FALSE(sizes.empty());
+  std::size_t total = 0;
+  for (auto size : sizes) {
+    EXPECT_LE(size, 4u);
+    total += size;
+  }
+  EXPECT_EQ(total, 9u);
+  EXPECT_LT(sizes.size(), 9u);
+}
+
+TEST(PipelineStageTest, WorkersKeepTheirOwnHandlerState) {
+  std::atomic<int> max_calls{0};
+  {
+    int calls = 0;  // copied into each worker's handler
+    PipelineStage<int> stage(2, 8, 1, [&max_calls, calls](auto&) mutable {
+      ++calls;
+      int seen = max_calls.load();
+      while (calls > seen && !max_calls.compare_exchange_weak(seen, calls)) {
+      }
+    });
+    for (int i = 0; i < 10; ++i) ASSERT_TRUE(stage.Submit(i));
+  }
+  EXPECT_GE(max_calls.load(), 5);
+  EXPECT_LE(max_calls.load(), 10);
+}
+
+}  // namespace aa::server
@@ -0,0 +1,193 @@
+/**
+ * @file test_nms.cpp
+ * @brief Unit tests for the class-aware batched NMS engine
+ *
+ * Covers hard and soft suppression, class-aware and class-agnostic modes,
+ * top-K pre-selection, output limits and box geometry away from the origin.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "nms.h"
+
+namespace aa::server {
+
+namespace {
+
+NmsOptions MakeOptions(bool agnostic = false, NmsMode mode = NmsMode::kHard) {
+  NmsOptions options;
+  options.score_threshold = 0.3f;
+  options.iou_threshold = 0.5f;
+  options.top_k = 0;
+  options.max_detections = 0;
+  options.class_agnostic = agnostic;
+  options.mode = mode;
+  return options;
+}
+
+}  // namespace
+
+// Two heavily overlapping boxes of the same class: only the best survives
+TEST(NmsTest, SuppressesOverlappingSameClass) {
+  NmsCandidates candidates;
+  candidates.Add(100, 100, 200, 200, 0.9f, 0);
+  candidates.Add(105, 105, 205, 205, 0.8f, 0);
+  candidates.Add(400, 400, 500, 500, 0.7f, 0);
+
+  Nms nms(MakeOptions());
+  std::vector<int> keep;
+  nms.Run(candidates, keep);
+
+  ASSERT_EQ(keep.size(), 2u);
+  EXPECT_EQ(keep[0], 0);
+  EXPECT_EQ(keep[1], 2);
+}
+
+// Overlapping boxes of different classes are kept in class-aware mode
+TEST(NmsTest, PerClassKeepsDifferentClasses) {
+  NmsCandidates candidates;
+  candidates.Add(100, 100, 200, 200, 0.9f, 0);
+  candidates.Add(100, 100, 200, 200, 0.8f, 1);
+
+  Nms nms(MakeOptions(false));
+  std::vector<int> keep;
+  nms.Run(candidates, keep);
+
+  EXPECT_EQ(keep.size(), 2u);
+}
+
+// Overlapping boxes of different classes are suppressed in agnostic mode
+TEST(NmsTest, AgnosticSuppressesAcrossClasses) {
+  NmsCandidates candidates;
+  candidates.Add(100, 100, 200, 200, 0.9f, 0);
+  candidates.Add(100, 100, 200, 200, 0.8f, 1);
+
+  Nms nms(MakeOptions(true));
+  std::vector<int> keep;
+  nms.Run(candidates, keep);
+
+  ASSERT_EQ(keep.size(), 1u);
+  EXPECT_EQ(keep[0], 0);
+}
+
+// Disjoint boxes far from the origin must not suppress each other. With
+// corners stored as width/height this pair would look overlapping.
+TEST(NmsTest, CorrectGeometryAwayFromOrigin) {
+  NmsCandidates candidates;
+  candidates.Add(500, 500, 540, 540, 0.9f, 0);
+  candidates.Add(560, 500, 600, 540, 0.8f, 0);
+
+  Nms nms(MakeOptions());
+  std::vector<int> keep;
+  nms.Run(candidates, keep);
+
+  EXPECT_EQ(keep.size(), 2u);
+}
+
+// Boxes below the score threshold never appear in the output
+TEST(NmsTest, ScoreThreshold) {
+  NmsCandidates candidates;
+  candidates.Add(0, 0, 10, 10, 0.2f, 0);
+  candidates.Add(50, 50, 60, 60, 0.6f, 0);
+
+  Nms nms(MakeOptions());
+  std::vector<int> keep;
+  nms.Run(candidates, keep);
+
+  ASSERT_EQ(keep.size(), 1u);
+  EXPECT_EQ(keep[0], 1);
+}
+
+// Top-K pre-selection only considers the highest scored candidates
+TEST(NmsTest, TopKPreselection) {
+  NmsCandidates candidates;
+  for (int i = 0; i < 10; ++i) {
+    float x = static_cast<float>(i) * 100.0f;
+    candidates.Add(x, 0, x + 50, 50, 0.4f + 0.05f * i, 0);
+  }
+
+  auto options = MakeOptions();
+  options.top_k = 3;
+  Nms nms(options);
+  std::vector<int> keep;
+  nms.Run(candidates, keep);
+
+  ASSERT_EQ(keep.size(), 3u);
+  EXPECT_EQ(keep[0], 9);
+  EXPECT_EQ(keep[1], 8);
+  EXPECT_EQ(keep[2], 7);
+}
+
+// Output is capped by max_detections, both configured and per call
+TEST(NmsTest, MaxDetections) {
+  NmsCandidates candidates;
+  for (int i = 0; i < 10; ++i) {
+    float x = static_cast<float>(i) * 100.0f;
+    candidates.Add(x, 0, x + 50, 50, 0.9f, i % 3);
+  }
+
+  auto options = MakeOptions();
+  options.max_detections = 5;
+  Nms nms(options);
+  std::vector<int> keep;
+
+  nms.Run(candidates, keep);
+  EXPECT_EQ(keep.size(), 5u);
+
+  nms.Run(candidates, 0.3f, 2, keep);
+  EXPECT_EQ(keep.size(), 2u);
+}
+
+// Soft NMS keeps overlapping boxes with decayed scores
+TEST(NmsTest, SoftModeDecaysScores) {
+  NmsCandidates candidates;
+  candidates.Add(100, 100, 200, 200, 0.9f, 0);
+  candidates.Add(110, 100, 210, 200, 0.85f, 0);
+
+  auto options = MakeOptions(false, NmsMode::kSoft);
+  options.score_threshold = 0.1f;
+  Nms nms(options);
+  std::vector<int> keep;
+  nms.Run(candidates, keep);
+
+  ASSERT_EQ(keep.size(), 2u);
+  EXPECT_EQ(keep[0], 0);
+  EXPECT_FLOAT_EQ(candidates.score[0], 0.9f);
+  EXPECT_LT(candidates.score[1], 0.85f);
+  EXPECT_GT(candidates.score[1], 0.1f);
+}
+
+// Results are stable when the engine and candidate buffer are reused
+TEST(NmsTest, ReuseAcrossCalls) {
+  NmsCandidates candidates;
+  Nms nms(MakeOptions());
+  std::vector<int> keep;
+
+  for (int round = 0; round < 3; ++round) {
+    candidates.Clear();
+    candidates.Add(0, 0, 100, 100, 0.9f, 0);
+    candidates.Add(5, 5, 105, 105, 0.8f, 0);
+    nms.Run(candidates, keep);
+    ASSERT_EQ(keep.size(), 1u);
+    EXPECT_EQ(keep[0], 0);
+  }
+
+  candidates.Clear();
+  nms.Run(candidates, keep);
+  EXPECT_TRUE(keep.empty());
+}
+
+TEST(NmsTest, ParseMode) {
+  NmsMode mode = NmsMode::kHard;
+  EXPECT_TRUE(ParseNmsMode("soft", mode));
+  EXPECT_EQ(mode, NmsMode::kSoft);
+  EXPECT_TRUE(ParseNmsMode("hard", mode));
+  EXPECT_EQ(mode, NmsMode::kHard);
+  EXPECT_FALSE(ParseNmsMode("linear", mode));
+  EXPECT_EQ(mode, NmsMode::kHard);
+}
+
+}  // namespace aa::server
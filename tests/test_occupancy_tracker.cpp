@@ -0,0 +1,128 @@
+/**
+ * @file test_occupancy_tracker.cpp
+ * @brief Unit tests for debounced zone occupancy events
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "occupancy_tracker.h"
+#include "point.h"
+#include "polygon.h"
+
+namespace aa::server {
+
+namespace {
+
+using aa::shared::Detection;
+
+aa::shared::Polygon MakeZone(double x1, double x2,
+                             aa::shared::PolygonType type,
+                             std::vector<int32_t> classes = {}) {
+  return aa::shared::Polygon({aa::shared::Point{x1, 0},
+                              aa::shared::Point{x2, 0},
+                              aa::shared::Point{x2, 100},
+                              aa::shared::Point{x1, 100}},
+                             type, 1, std::move(classes));
+}
+
+// Left zone [0, 100), right zone [100, 200)
+std::vector<aa::shared::Polygon> MakeZones() {
+  std::vector<aa::shared::Polygon> zones;
+  zones.push_back(MakeZone(0, 99, aa::shared::PolygonType::INCLUSION));
+  zones.push_back(MakeZone(100, 199, aa::shared::PolygonType::INCLUSION, {2}));
+  return zones;
+}
+
+Detection At(int x, int class_id) {
+  return Detection{cv::Rect(x - 5, 45, 10, 10), class_id, 0.9f};
+}
+
+aa::proto::ZoneEvents Feed(OccupancyTracker& tracker,
+                           const std::vector<Detection>& detections,
+                           uint64_t frame) {
+  aa::proto::ZoneEvents events;
+  tracker.Update(detections, frame, frame * 40.0, &events);
+  return events;
+}
+
+}  // namespace
+
+TEST(OccupancyTrackerTest, EnterIsReportedAfterDebounce) {
+  OccupancyTracker tracker(MakeZones(), 3);
+
+  EXPECT_EQ(Feed(tracker, {At(50, 0)}, 0).events_size(), 0);
+  EXPECT_EQ(Feed(tracker, {At(50, 0)}, 1).events_size(), 0);
+  auto events = Feed(tracker, {At(50, 0)}, 2);
+
+  ASSERT_EQ(events.events_size(), 1);
+  const auto& event = events.events(0);
+  EXPECT_EQ(event.type(), aa::proto::ZONE_EVENT_TYPE_ENTER);
+  EXPECT_EQ(event.zone(), 0u);
+  EXPECT_EQ(event.class_id(), 0);
+  EXPECT_EQ(event.count(), 1u);
+  EXPECT_EQ(event.previous_count(), 0u);
+  EXPECT_EQ(event.frame_index(), 2u);
+  EXPECT_DOUBLE_EQ(event.timestamp_ms(), 80.0);
+
+  // A steady scene is silent
+  EXPECT_EQ(Feed(tracker, {At(50, 0)}, 3).events_size(), 0);
+  EXPECT_EQ(tracker.Count(0, 0), 1u);
+}
+
+TEST(OccupancyTrackerTest, FlickerIsSuppressed) {
+  OccupancyTracker tracker(MakeZones(), 2);
+  Feed(tracker, {At(50, 0)}, 0);
+  ASSERT_EQ(Feed(tracker, {At(50, 0)}, 1).events_size(), 1);
+
+  // Missed for one frame only
+  EXPECT_EQ(Feed(tracker, {}, 2).events_size(), 0);
+  EXPECT_EQ(Feed(tracker, {At(50, 0)}, 3).events_size(), 0);
+
+  // Hallucinated for one frame only
+  EXPECT_EQ(Feed(tracker, {At(50, 0), At(60, 0)}, 4).events_size(), 0);
+  EXPECT_EQ(Feed(tracker, {At(50, 0)}, 5).events_size(), 0);
+  EXPECT_EQ(tracker.Count(0, 0), 1u);
+}
+
+TEST(OccupancyTrackerTest, CountChangeAndExit) {
+  OccupancyTracker tracker(MakeZones(), 1);
+  ASSERT_EQ(Feed(tracker, {At(50, 0)}, 0).events_size(), 1);
+
+  auto events = Feed(tracker, {At(50, 0), At(70, 0)}, 1);
+  ASSERT_EQ(events.events_size(), 1);
+  EXPECT_EQ(events.events(0).type(), aa::proto::ZONE_EVENT_TYPE_COUNT_CHANGED);
+  EXPECT_EQ(events.events(0).count(), 2u);
+  EXPECT_EQ(events.events(0).previous_count(), 1u);
+
+  events = Feed(tracker, {}, 2);
+  ASSERT_EQ(events.events_size(), 1);
+  EXPECT_EQ(events.events(0).type(), aa::proto::ZONE_EVENT_TYPE_EXIT);
+  EXPECT_EQ(events.events(0).count(), 0u);
+  EXPECT_EQ(tracker.Count(0, 0), 0u);
+}
+
+TEST(OccupancyTrackerTest, ZonesAndClassesAreSeparate) {
+  OccupancyTracker tracker(MakeZones(), 1);
+
+  // Class 0 in both zones, but the right zone only targets class 2
+  auto events = Feed(tracker, {At(50, 0), At(150, 0), At(150, 2)}, 0);
+  ASSERT_EQ(events.events_size(), 2);
+  EXPECT_EQ(tracker.Count(0, 0), 1u);
+  EXPECT_EQ(tracker.Count(1, 0), 0u);
+  EXPECT_EQ(tracker.Count(1, 2), 1u);
+}
+
+TEST(OccupancyTrackerTest, ExclusionZonesAreNotCounted) {
+  std::vector<aa::shared::Polygon> zones;
+  zones.push_back(MakeZone(0, 99, aa::shared::PolygonType::EXCLUSION));
+  zones.push_back(MakeZone(0, 199, aa::shared::PolygonType::INCLUSION));
+  OccupancyTracker tracker(std::move(zones), 1);
+
+  auto events = Feed(tracker, {At(150, 0)}, 0);
+  ASSERT_EQ(events.events_size(), 1);
+  EXPECT_EQ(events.events(0).zone(), 1u);
+}
+
+}  // namespace aa::server
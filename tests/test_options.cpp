@@ -451,4 +451,148 @@ TEST_F(OptionsTest, ServerInputOptional) {
   EXPECT_TRUE(server_with_both->IsValid());
 }
 
+// Test NMS option validation
+TEST_F(OptionsTest, NmsDefaults) {
+  auto options = CreateOptions({"test_program"});
+
+  EXPECT_TRUE(options->IsValid());
+  EXPECT_EQ(options->Get<std::string>("nms_mode"), "hard");
+  EXPECT_FALSE(options->Get<bool>("nms_agnostic"));
+  EXPECT_EQ(options->Get<int>("topk"), 1000);
+  EXPECT_EQ(options->Get<int>("max_det"), 300);
+}
+
+TEST_F(OptionsTest, NmsSoftMode) {
+  auto options = CreateOptions(
+      {"test_program", "--nms_mode=soft", "--soft_sigma=0.3", "--topk=0"});
+
+  EXPECT_TRUE(options->IsValid());
+  EXPECT_EQ(options->Get<std::string>("nms_mode"), "soft");
+  EXPECT_FLOAT_EQ(options->Get<float>("soft_sigma"), 0.3f);
+  EXPECT_EQ(options->Get<int>("topk"), 0);
+}
+
+TEST_F(OptionsTest, InvalidNmsMode) {
+  auto options = CreateOptions({"test_program", "--nms_mode=fuzzy"});
+
+  EXPECT_FALSE(options->IsValid());
+}
+
+TEST_F(OptionsTest, InvalidSoftSigma) {
+  for (const char* sigma : {"--soft_sigma=0", "--soft_sigma=-0.5"}) {
+    auto options = CreateOptions({"test_program", "--nms_mode=soft", sigma});
+
+    EXPECT_FALSE(options->IsValid()) << sigma;
+  }
+}
+
+TEST_F(OptionsTest, InvalidNegativeTopK) {
+  auto options = CreateOptions({"test_program", "--topk=-1"});
+
+  EXPECT_FALSE(options->IsValid());
+}
+
+// Test per-request budget options
+TEST_F(OptionsTest, BudgetOptionsOptional) {
+  auto options = CreateOptions({"test_program"});
+
+  EXPECT_TRUE(options->IsValid());
+  EXPECT_FALSE(options->Has("classes"));
+  EXPECT_FALSE(options->Has("min_conf"));
+  EXPECT_FALSE(options->Has("max_results"));
+}
+
+TEST_F(OptionsTest, InvalidMinConf) {
+  auto options = CreateOptions({"test_program", "--min_conf=1.5"});
+
+  EXPECT_FALSE(options->IsValid());
+}
+
+TEST_F(OptionsTest, InvalidClasses) {
+  EXPECT_TRUE(CreateOptions({"test_program", "--classes=0,2,,7"})->IsValid());
+  EXPECT_FALSE(CreateOptions({"test_program", "--classes=0,car"})->IsValid());
+  EXPECT_FALSE(CreateOptions({"test_program", "--classes=-1"})->IsValid());
+  EXPECT_FALSE(
+      CreateOptions({"test_program", "--classes=99999999999"})->IsValid());
+}
+
+TEST(ParseClassListTest, ParsesEntries) {
+  std::vector<int32_t> classes;
+
+  EXPECT_TRUE(ParseClassList("0, 2,,7 ,", classes));
+  EXPECT_EQ(classes, (std::vector<int32_t>{0, 2, 7}));
+  EXPECT_FALSE(ParseClassList("3x", classes));
+}
+
+// Test multi-process worker options
+TEST_F(OptionsTest, WorkerDefaults) {
+  auto options = CreateOptions({"test_program"});
+
+  EXPECT_TRUE(options->IsValid());
+  EXPECT_EQ(options->Get<int>("workers"), 1);
+  EXPECT_EQ(options->Get<int>("cpus_per_worker"), 0);
+  EXPECT_TRUE(options->Get<bool>("share_model"));
+}
+
+TEST_F(OptionsTest, InvalidZeroWorkers) {
+  auto options = CreateOptions({"test_program", "--workers=0"});
+
+  EXPECT_FALSE(options->IsValid());
+}
+
+// Zones stay exact unless simplification is asked for
+TEST_F(OptionsTest, ZoneToleranceDefaultsToExact) {
+  auto options = CreateOptions({"test_program"});
+
+  EXPECT_TRUE(options->IsValid());
+  EXPECT_EQ(options->Get<double>("zone_tolerance"), 0.0);
+  EXPECT_FALSE(
+      CreateOptions({"test_program", "--zone_tolerance=-1"})->IsValid());
+}
+
+// Test dispatcher options
+TEST_F(OptionsTest, DispatcherRequiresBackends) {
+  auto without_backends =
+      CreateOptions({"test_program"}, "Detector Dispatcher");
+  EXPECT_FALSE(without_backends->IsValid());
+
+  auto with_backends = CreateOptions(
+      {"test_program", "--backends=localhost:50052,localhost:50053"},
+      "Detector Dispatcher");
+  EXPECT_TRUE(with_backends->IsValid());
+  EXPECT_EQ(with_backends->Get<int>("max_inflight"), 64);
+  EXPECT_EQ(with_backends->Get<int>("max_queued"), 64);
+}
+
+TEST_F(OptionsTest, InvalidMaxInflight) {
+  auto options = CreateOptions({"test_program", "--max_inflight=0"});
+
+  EXPECT_FALSE(options->IsValid());
+}
+
+TEST_F(OptionsTest, InvalidMaxQueued) {
+  EXPECT_FALSE(CreateOptions({"test_program", "--max_queued=-1"})->IsValid());
+  EXPECT_TRUE(CreateOptions({"test_program", "--max_queued=0"})->IsValid());
+}
+
+// Test result frame options
+TEST_F(OptionsTest, ResultFrameOptions) {
+  auto options = CreateOptions(
+      {"test_program", "--result_width=480", "--result_codec=jpeg",
+       "--result_quality=80"});
+
+  EXPECT_TRUE(options->IsValid());
+  EXPECT_EQ(options->Get<int>("result_width"), 480);
+  EXPECT_FALSE(options->Has("result_height"));
+  EXPECT_EQ(options->Get<std::string>("result_codec"), "jpeg");
+}
+
+TEST_F(OptionsTest, InvalidResultCodec) {
+  auto codec = CreateOptions({"test_program", "--result_codec=gif"});
+  EXPECT_FALSE(codec->IsValid());
+
+  auto quality = CreateOptions({"test_program", "--result_quality=0"});
+  EXPECT_FALSE(quality->IsValid());
+}
+
 }  // namespace
@@ -0,0 +1,219 @@
+/**
+ * @file test_supervisor.cpp
+ * @brief Unit tests for the pre-fork supervisor and shared server stats
+ *
+ * Forks real worker processes that record into their shared stats blocks
+ * and checks that the supervisor aggregates the counters and shuts the
+ * workers down on Stop().
+ */
+
+#include <gtest/gtest.h>
+
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <tuple>
+
+#include "server_stats.h"
+#include "supervisor.h"
+
+namespace aa::server {
+
+TEST(ServerStatsTest, RecordAndSnapshot) {
+  ServerStats stats;
+  stats.Record(true, std::chrono::milliseconds(4));
+  stats.Record(false, std::chrono::milliseconds(2));
+  stats.AddDetections(5);
+
+  auto snapshot = stats.Snapshot();
+  EXPECT_EQ(snapshot.requests, 2u);
+  EXPECT_EQ(snapshot.failures, 1u);
+  EXPECT_EQ(snapshot.detections, 5u);
+  EXPECT_DOUBLE_EQ(snapshot.MeanLatencyMs(), 3.0);
+}
+
+TEST(ServerStatsTest, SnapshotsAccumulate) {
+  ServerStatsSnapshot total;
+  ServerStatsSnapshot worker;
+  worker.requests = 3;
+  worker.detections = 7;
+
+  total += worker;
+  total += worker;
+
+  EXPECT_EQ(total.requests, 6u);
+  EXPECT_EQ(total.detections, 14u);
+  EXPECT_DOUBLE_EQ(ServerStatsSnapshot{}.MeanLatencyMs(), 0.0);
+}
+
+TEST(SupervisorTest, AggregatesWorkerStatsAndStops) {
+  Supervisor supervisor(3, 1, [](int index, ServerStats* stats) {
+    for (int i = 0; i <= index; ++i) {
+      stats->Record(true, std::chrono::milliseconds(1));
+    }
+    stats->AddDetections(1);
+    pause();  // Until SIGTERM from Stop()
+    return 0;
+  });
+
+  int exit_code = -1;
+  std::thread runner([&] { exit_code = supervisor.Run(); });
+
+  // Workers record 1 + 2 + 3 requests
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (supervisor.Aggregate().requests < 6 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  auto total = supervisor.Aggregate();
+  EXPECT_EQ(total.requests, 6u);
+  EXPECT_EQ(total.detections, 3u);
+
+  supervisor.Stop();
+  runner.join();
+  EXPECT_EQ(exit_code, 0);
+}
+
+TEST(SupervisorTest, RestartsExitedWorkerWithSignalsUnblocked) {
+  Supervisor supervisor(1, 1, [](int, ServerStats* stats) {
+    // Run() blocks SIGTERM for itself; the worker must get it back
+    sigset_t mask;
+    sigprocmask(SIG_BLOCK, nullptr, &mask);
+    if (!sigismember(&mask, SIGTERM)) stats->AddDetections(1);
+
+    stats->Record(true, std::chrono::milliseconds(1));
+    if (stats->Snapshot().requests == 1) return 3;  // First run exits
+    pause();
+    return 0;
+  });
+
+  int exit_code = -1;
+  std::thread runner([&] { exit_code = supervisor.Run(); });
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (supervisor.Aggregate().requests < 2 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  auto total = supervisor.Aggregate();
+  EXPECT_EQ(total.requests, 2u);
+  EXPECT_EQ(total.detections, 2u);
+
+  supervisor.Stop();
+  runner.join();
+  EXPECT_EQ(exit_code, 0);
+}
+
+// Stop() does not wait out the restart delay of a crash-looping worker
+TEST(SupervisorTest, StopsDuringRestartBackoff) {
+  Supervisor supervisor(1, 1, [](int, ServerStats* stats) {
+    stats->Record(false, std::chrono::milliseconds(1));
+    return 3;  // Always exits at once
+  });
+
+  int exit_code = -1;
+  std::thread runner([&] { exit_code = supervisor.Run(); });
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (supervisor.Aggregate().requests < 1 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  // Reaped by now, with the restart a second away
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+  auto stop_start = std::chrono::steady_clock::now();
+  supervisor.Stop();
+  runner.join();
+  EXPECT_LT(std::chrono::steady_clock::now() - stop_start,
+            std::chrono::milliseconds(500));
+  EXPECT_EQ(supervisor.Aggregate().requests, 1u);
+  EXPECT_EQ(exit_code, 0);
+}
+
+// Workers are pinned inside the supervisor's own affinity mask
+TEST(SupervisorTest, PinsWorkersWithinAllowedCpus) {
+  cpu_set_t allowed;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  int last = -1;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) last = cpu;
+  }
+  if (CPU_COUNT(&allowed) < 2 || last == 0) {
+    GTEST_SKIP() << "Needs two allowed CPUs";
+  }
+
+  Supervisor supervisor(1, 1, [last](int, ServerStats* stats) {
+    cpu_set_t pinned;
+    sched_getaffinity(0, sizeof(pinned), &pinned);
+    if (CPU_COUNT(&pinned) == 1 && CPU_ISSET(last, &pinned)) {
+      stats->AddDetections(1);
+    }
+    stats->Record(true, std::chrono::milliseconds(1));
+    pause();
+    return 0;
+  });
+
+  // The supervisor may only run on the last CPU, which is not CPU 0
+  int exit_code = -1;
+  std::thread runner([&] {
+    cpu_set_t only_last;
+    CPU_ZERO(&only_last);
+    CPU_SET(last, &only_last);
+    sched_setaffinity(0, sizeof(only_last), &only_last);
+    exit_code = supervisor.Run();
+  });
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (supervisor.Aggregate().requests < 1 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  EXPECT_EQ(supervisor.Aggregate().detections, 1u);
+
+  supervisor.Stop();
+  runner.join();
+  EXPECT_EQ(exit_code, 0);
+}
+
+// SIGTERM to a single-threaded supervisor stops it through its signalfd
+TEST(SupervisorTest, StopsOnSigterm) {
+  int ready[2];
+  ASSERT_EQ(pipe(ready), 0);
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    close(ready[0]);
+    Supervisor supervisor(2, 1, [&](int, ServerStats*) {
+      char byte = 1;
+      std::ignore = write(ready[1], &byte, 1);
+      pause();
+      return 0;
+    });
+    std::_Exit(supervisor.Run());
+  }
+
+  close(ready[1]);
+  char byte = 0;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(read(ready[0], &byte, 1), 1);
+  }
+  close(ready[0]);
+
+  kill(pid, SIGTERM);
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+}  // namespace aa::server
@@ -0,0 +1,96 @@
+/**
+ * @file test_transport_profile.cpp
+ * @brief Unit tests for gRPC transport profiles
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "transport_profile.h"
+
+namespace aa::shared {
+
+namespace {
+
+/**
+ * @brief Integer value of a channel argument, or -1 if it is not set
+ */
+int ArgValue(const grpc::ChannelArguments& args, const std::string& key) {
+  auto c_args = args.c_channel_args();
+  for (std::size_t i = 0; i < c_args.num_args; ++i) {
+    if (key == c_args.args[i].key && c_args.args[i].type == GRPC_ARG_INTEGER) {
+      return c_args.args[i].value.integer;
+    }
+  }
+  return -1;
+}
+
+Options MakeOptions(std::vector<const char*> args) {
+  args.insert(args.begin(), "test_program");
+  return Options(static_cast<int>(args.size()), args.data(), "Test Client");
+}
+
+}  // namespace
+
+TEST(TransportProfileTest, KnownPresets) {
+  for (const char* name : {"default", "lan", "wan"}) {
+    auto profile = TransportProfile::FromName(name);
+    ASSERT_TRUE(profile.has_value()) << name;
+    EXPECT_EQ(profile->name, name);
+  }
+  EXPECT_FALSE(TransportProfile::FromName("satellite").has_value());
+}
+
+TEST(TransportProfileTest, DefaultLeavesChannelUntouched) {
+  grpc::ChannelArguments args;
+  TransportProfile{}.ApplyTo(args);
+  EXPECT_EQ(ArgValue(args, GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES), -1);
+  EXPECT_EQ(ArgValue(args, GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH), -1);
+  EXPECT_EQ(ArgValue(args, GRPC_ARG_KEEPALIVE_TIME_MS), -1);
+}
+
+TEST(TransportProfileTest, WanWidensTheWindow) {
+  auto lan = TransportProfile::FromName("lan").value();
+  auto wan = TransportProfile::FromName("wan").value();
+  EXPECT_GT(wan.stream_window_bytes, lan.stream_window_bytes);
+
+  // A raw 4K frame fits in the window and in one message
+  EXPECT_GE(wan.stream_window_bytes, 3840 * 2160 * 3);
+  EXPECT_GE(wan.server_max_receive_message_size, 3840 * 2160 * 3);
+
+  grpc::ChannelArguments args;
+  wan.ApplyTo(args);
+  EXPECT_EQ(ArgValue(args, GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES),
+            wan.stream_window_bytes);
+  // The request limit is the server's; responses stay unlimited
+  EXPECT_EQ(ArgValue(args, GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH), -1);
+  EXPECT_EQ(ArgValue(args, GRPC_ARG_KEEPALIVE_TIME_MS), wan.keepalive_time_ms);
+  EXPECT_EQ(ArgValue(args, GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS), 1);
+}
+
+TEST(TransportProfileTest, CompressionNames) {
+  EXPECT_EQ(TransportProfile::CompressionFromName("none"), GRPC_COMPRESS_NONE);
+  EXPECT_EQ(TransportProfile::CompressionFromName("gzip"), GRPC_COMPRESS_GZIP);
+  EXPECT_EQ(TransportProfile::CompressionFromName("deflate"),
+            GRPC_COMPRESS_DEFLATE);
+  EXPECT_FALSE(TransportProfile::CompressionFromName("zstd").has_value());
+}
+
+TEST(TransportProfileTest, FromOptions) {
+  auto options = MakeOptions({"--input=in.jpg", "--transport=wan",
+                              "--compression=gzip"});
+  ASSERT_TRUE(options.IsValid());
+
+  auto profile = TransportProfile::FromOptions(options);
+  EXPECT_EQ(profile.name, "wan");
+  EXPECT_EQ(profile.compression, GRPC_COMPRESS_GZIP);
+}
+
+TEST(TransportProfileTest, OptionsRejectUnknownNames) {
+  EXPECT_FALSE(MakeOptions({"--input=in.jpg", "--transport=fast"}).IsValid());
+  EXPECT_FALSE(
+      MakeOptions({"--input=in.jpg", "--compression=brotli"}).IsValid());
+}
+
+}  // namespace aa::shared
@@ -0,0 +1,187 @@
+/**
+ * @file test_video_job.cpp
+ * @brief Tests for the offline video job mode
+ *
+ * Writes a short MJPEG clip whose frames encode their index in the pixel
+ * values, and runs VideoJob on it with an engine that reports that index
+ * as the class id, so frame order in the output can be checked.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "inference_engine.h"
+#include "video_job.h"
+
+namespace aa::server {
+
+namespace {
+
+constexpr int kFrames = 12;
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+constexpr int kLevelStep = 20;
+
+/**
+ * @brief Engine detecting one object whose class is the frame index
+ */
+class IndexEngine final : public InferenceEngine {
+ public:
+  void Inference(cv::Mat& input,
+                 std::vector<aa::shared::Detection>& detections,
+                 const DetectionBudget&) override {
+    int level = input.at<cv::Vec3b>(kHeight / 2, kWidth / 2)[0];
+    detections = {{cv::Rect(8, 8, 16, 16),
+                   (level + kLevelStep / 2) / kLevelStep, 0.9f}};
+  }
+
+  void InferenceBatch(
+      std::vector<cv::Mat>& inputs,
+      std::vector<std::vector<aa::shared::Detection>>& detections,
+      const DetectionBudget& budget) override {
+    max_batch = std::max(max_batch, inputs.size());
+    InferenceEngine::InferenceBatch(inputs, detections, budget);
+  }
+
+  void DrawBoundingBoxes(cv::Mat&, const std::vector<aa::shared::Detection>&,
+                         double) const override {}
+
+  std::size_t max_batch{0};
+};
+
+std::vector<std::vector<std::string>> ReadCsv(const std::string& path) {
+  std::vector<std::vector<std::string>> rows;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::vector<std::string> row;
+    std::stringstream fields{line};
+    std::string field;
+    while (std::getline(fields, field, ',')) row.push_back(field);
+    rows.push_back(std::move(row));
+  }
+  return rows;
+}
+
+}  // namespace
+
+class VideoJobTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    input_ = ::testing::TempDir() + "aa_video_job_test.avi";
+    output_ = ::testing::TempDir() + "aa_video_job_test.csv";
+    cv::VideoWriter writer(input_, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                           25.0, cv::Size(kWidth, kHeight));
+    if (!writer.isOpened()) {
+      GTEST_SKIP() << "OpenCV cannot write MJPEG video";
+    }
+    for (int i = 0; i < kFrames; ++i) {
+      writer.write(cv::Mat(kHeight, kWidth, CV_8UC3,
+                           cv::Scalar::all(i * kLevelStep)));
+    }
+  }
+
+  void TearDown() override {
+    std::remove(input_.c_str());
+    std::remove(output_.c_str());
+  }
+
+  VideoJobOptions MakeOptions(int segments, int batch_size) const {
+    VideoJobOptions options;
+    options.input = input_;
+    options.output = output_;
+    options.segments = segments;
+    options.batch_size = batch_size;
+    return options;
+  }
+
+  std::string input_;
+  std::string output_;
+};
+
+TEST_F(VideoJobTest, WritesEveryFrameInOrder) {
+  IndexEngine engine;
+  VideoJob job(engine, MakeOptions(3, 4));
+
+  VideoJobStats stats;
+  ASSERT_TRUE(job.Run(&stats));
+
+  EXPECT_EQ(stats.frames, static_cast<uint64_t>(kFrames));
+  EXPECT_EQ(stats.detections, static_cast<uint64_t>(kFrames));
+  EXPECT_GE(stats.batches, static_cast<uint64_t>(kFrames / 4));
+  EXPECT_LE(engine.max_batch, 4u);
+
+  auto rows = ReadCsv(output_);
+  ASSERT_EQ(rows.size(), static_cast<std::size_t>(kFrames + 1));
+  EXPECT_EQ(rows[0][0], "frame");
+  for (int i = 0; i < kFrames; ++i) {
+    const auto& row = rows[i + 1];
+    ASSERT_EQ(row.size(), 8u);
+    EXPECT_EQ(std::stoi(row[0]), i);
+    EXPECT_EQ(std::stoi(row[2]), i) << "frame " << i << " decoded out of place";
+    EXPECT_EQ(row[4], "8");
+  }
+
+  // Part files are joined and removed
+  std::ifstream part(output_ + ".part0");
+  EXPECT_FALSE(part.good());
+}
+
+TEST_F(VideoJobTest, ZonesFilterDetections) {
+  auto zones_path = ::testing::TempDir() + "aa_video_job_zones.txtpb";
+  {
+    std::ofstream zones(zones_path);
+    zones << "polygons {\n"
+             "  vertices { x: 32 y: 0 }\n"
+             "  vertices { x: 64 y: 0 }\n"
+             "  vertices { x: 64 y: 48 }\n"
+             "  vertices { x: 32 y: 48 }\n"
+             "  type: POLYGON_TYPE_INCLUSION\n"
+             "}\n";
+  }
+
+  IndexEngine engine;
+  auto options = MakeOptions(1, 8);
+  options.zones = zones_path;
+  VideoJob job(engine, options);
+
+  VideoJobStats stats;
+  ASSERT_TRUE(job.Run(&stats));
+  std::remove(zones_path.c_str());
+
+  EXPECT_EQ(stats.frames, static_cast<uint64_t>(kFrames));
+  EXPECT_EQ(stats.detections, 0u);
+  EXPECT_EQ(ReadCsv(output_).size(), 1u);
+}
+
+TEST_F(VideoJobTest, MissingInputFails) {
+  IndexEngine engine;
+  auto options = MakeOptions(2, 4);
+  options.input = input_ + ".missing";
+  VideoJob job(engine, options);
+
+  EXPECT_FALSE(job.Run());
+}
+
+TEST(LoadZonesTest, RejectsMalformedFile) {
+  auto path = ::testing::TempDir() + "aa_bad_zones.txtpb";
+  {
+    std::ofstream zones(path);
+    zones << "polygons { vertices { x: } }";
+  }
+
+  std::vector<aa::shared::Polygon> zones;
+  EXPECT_FALSE(LoadZones(path, zones));
+  EXPECT_FALSE(LoadZones(path + ".missing", zones));
+  std::remove(path.c_str());
+}
+
+}  // namespace aa::server
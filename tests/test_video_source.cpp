@@ -0,0 +1,194 @@
+/**
+ * @file test_video_source.cpp
+ * @brief Tests for server-pulled video sources
+ *
+ * Writes a short MJPEG clip with OpenCV's built-in AVI writer and runs
+ * DetectorServer::RunSource on it in-process with a stub engine, so no
+ * model, camera or network is needed.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "detector_server.h"
+#include "inference_engine.h"
+#include "options.h"
+#include "point.h"
+#include "polygon.h"
+
+namespace aa::server {
+
+namespace {
+
+constexpr int kFrames = 10;
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+
+/**
+ * @brief Engine returning one detection inside and one outside the zone
+ */
+class StubEngine final : public InferenceEngine {
+ public:
+  explicit StubEngine(std::chrono::milliseconds delay = {}) : delay_{delay} {}
+
+  void Inference(cv::Mat&, std::vector<aa::shared::Detection>& detections,
+                 const DetectionBudget&) override {
+    std::this_thread::sleep_for(delay_);
+    detections = {{cv::Rect(4, 4, 10, 10), 0, 0.9f},
+                  {cv::Rect(50, 30, 10, 10), 0, 0.8f}};
+  }
+
+  void DrawBoundingBoxes(cv::Mat&, const std::vector<aa::shared::Detection>&,
+                         double) const override {}
+
+ private:
+  std::chrono::milliseconds delay_;
+};
+
+}  // namespace
+
+class VideoSourceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = ::testing::TempDir() + "aa_video_source_test.avi";
+    cv::VideoWriter writer(path_, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                           25.0, cv::Size(kWidth, kHeight));
+    if (!writer.isOpened()) {
+      GTEST_SKIP() << "OpenCV cannot write MJPEG video";
+    }
+    for (int i = 0; i < kFrames; ++i) {
+      writer.write(cv::Mat(kHeight, kWidth, CV_8UC3, cv::Scalar::all(i * 20)));
+    }
+  }
+
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  std::unique_ptr<DetectorServer> MakeServer(
+      std::chrono::milliseconds delay = {}) {
+    const char* argv[] = {"test_program", "--address=localhost:50098",
+                          "--model=stub.onnx"};
+    aa::shared::Options options(3, argv, "Test Detector Server");
+    return std::make_unique<DetectorServer>(
+        std::move(options), std::make_unique<StubEngine>(delay));
+  }
+
+  aa::proto::StartSourceRequest MakeRequest() const {
+    aa::proto::StartSourceRequest request;
+    request.set_uri(path_);
+    aa::shared::Polygon zone({aa::shared::Point{0, 0},
+                              aa::shared::Point{32, 0},
+                              aa::shared::Point{32, 32},
+                              aa::shared::Point{0, 32}},
+                             aa::shared::PolygonType::INCLUSION, 1, {});
+    *request.add_polygons() = zone.ToProto();
+    return request;
+  }
+
+  std::string path_;
+};
+
+TEST_F(VideoSourceTest, LosslessSourceStreamsEveryFrame) {
+  auto server = MakeServer();
+  auto request = MakeRequest();
+  request.set_lossless(true);
+
+  std::vector<aa::proto::SourceDetections> messages;
+  auto status = server->RunSource(request, [&](const auto& detections) {
+    messages.push_back(detections);
+    return true;
+  });
+
+  ASSERT_TRUE(status.ok()) << status.error_message();
+  ASSERT_EQ(messages.size(), static_cast<std::size_t>(kFrames));
+  for (int i = 0; i < kFrames; ++i) {
+    const auto& message = messages[i];
+    EXPECT_EQ(message.frame_index(), static_cast<uint64_t>(i));
+    EXPECT_EQ(message.width(), static_cast<uint32_t>(kWidth));
+    EXPECT_EQ(message.height(), static_cast<uint32_t>(kHeight));
+    EXPECT_EQ(message.dropped_frames(), 0u);
+    ASSERT_EQ(message.detections_size(), 1);
+    EXPECT_EQ(message.detections(0).x(), 4);
+    EXPECT_FLOAT_EQ(message.detections(0).confidence(), 0.9f);
+  }
+  EXPECT_EQ(server->GetStats().detections, static_cast<uint64_t>(kFrames));
+}
+
+TEST_F(VideoSourceTest, SlowInferenceDropsOldestFrames) {
+  auto server = MakeServer(std::chrono::milliseconds{20});
+  auto request = MakeRequest();
+  request.set_queue_size(1);
+
+  std::vector<aa::proto::SourceDetections> messages;
+  auto status = server->RunSource(request, [&](const auto& detections) {
+    messages.push_back(detections);
+    return true;
+  });
+
+  ASSERT_TRUE(status.ok()) << status.error_message();
+  ASSERT_FALSE(messages.empty());
+  uint64_t reported = 0;
+  for (std::size_t i = 0; i < messages.size(); ++i) {
+    if (i > 0) {
+      EXPECT_GT(messages[i].frame_index(), messages[i - 1].frame_index());
+    }
+    reported += 1 + messages[i].dropped_frames();
+  }
+  EXPECT_LE(reported, static_cast<uint64_t>(kFrames));
+}
+
+TEST_F(VideoSourceTest, OversizeQueueIsRejected) {
+  auto server = MakeServer();
+  auto request = MakeRequest();
+  request.set_queue_size(1u << 20);
+
+  bool called = false;
+  auto status = server->RunSource(request, [&](const auto&) {
+    called = true;
+    return true;
+  });
+
+  EXPECT_EQ(status.error_code(), grpc::StatusCode::INVALID_ARGUMENT);
+  EXPECT_FALSE(called);
+}
+
+TEST_F(VideoSourceTest, SinkStopsSource) {
+  auto server = MakeServer();
+  auto request = MakeRequest();
+  request.set_lossless(true);
+
+  int received = 0;
+  auto status = server->RunSource(request, [&](const auto&) {
+    return ++received < 3;
+  });
+
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(received, 3);
+}
+
+TEST_F(VideoSourceTest, MissingSourceIsNotFound) {
+  auto server = MakeServer();
+  auto request = MakeRequest();
+  request.set_uri(path_ + ".missing");
+
+  auto status = server->RunSource(request, [](const auto&) { return true; });
+  EXPECT_EQ(status.error_code(), grpc::StatusCode::NOT_FOUND);
+}
+
+TEST_F(VideoSourceTest, MissingZonesAreRejected) {
+  auto server = MakeServer();
+  auto request = MakeRequest();
+  request.clear_polygons();
+
+  auto status = server->RunSource(request, [](const auto&) { return true; });
+  EXPECT_EQ(status.error_code(), grpc::StatusCode::INVALID_ARGUMENT);
+}
+
+}  // namespace aa::server
@@ -0,0 +1,294 @@
+/**
+ * @file test_yolo_decoder.cpp
+ * @brief Unit tests for YOLO input blobs, output layout resolution and
+ * decoding
+ *
+ * Builds synthetic output tensors for YOLOX/YOLOv5 row layouts and
+ * YOLOv8-style transposed layouts and checks that the specialized decoders
+ * produce the expected candidates.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+
+#include "yolo.h"
+#include "yolo_decoder.h"
+
+namespace aa::server {
+
+namespace {
+
+// Row layout [1, anchors, 5 + nc] with one confident anchor
+cv::Mat MakeRowOutput(int anchors, int num_classes, int hit_anchor,
+                      int hit_class) {
+  int sizes[] = {1, anchors, 5 + num_classes};
+  cv::Mat output(3, sizes, CV_32F, cv::Scalar(0.0f));
+  float* row = output.ptr<float>() + hit_anchor * (5 + num_classes);
+  row[0] = 100.0f;  // cx
+  row[1] = 80.0f;   // cy
+  row[2] = 40.0f;   // w
+  row[3] = 20.0f;   // h
+  row[4] = 0.9f;    // objectness
+  row[5 + hit_class] = 0.8f;
+  return output;
+}
+
+// Transposed layout [1, 4 + nc, anchors] with one confident anchor
+cv::Mat MakeColumnOutput(int anchors, int num_classes, int hit_anchor,
+                         int hit_class) {
+  int sizes[] = {1, 4 + num_classes, anchors};
+  cv::Mat output(3, sizes, CV_32F, cv::Scalar(0.0f));
+  float* data = output.ptr<float>();
+  data[0 * anchors + hit_anchor] = 100.0f;
+  data[1 * anchors + hit_anchor] = 80.0f;
+  data[2 * anchors + hit_anchor] = 40.0f;
+  data[3 * anchors + hit_anchor] = 20.0f;
+  data[(4 + hit_class) * anchors + hit_anchor] = 0.7f;
+  return output;
+}
+
+// Length-delimited protobuf field with a one-byte tag
+std::string Field(int number, const std::string& payload) {
+  std::string bytes(1, static_cast<char>((number << 3) | 2));
+  std::size_t length = payload.size();
+  do {
+    auto byte = static_cast<uint8_t>(length & 0x7f);
+    length >>= 7;
+    if (length != 0) byte |= 0x80;
+    bytes.push_back(static_cast<char>(byte));
+  } while (length != 0);
+  return bytes + payload;
+}
+
+// Row layout with six separate boxes alternating classes 0 and 2, in
+// descending score order
+cv::Mat MakeCrowdOutput() {
+  constexpr int kClasses = 80;
+  int sizes[] = {1, 20, 5 + kClasses};
+  cv::Mat output(3, sizes, CV_32F, cv::Scalar(0.0f));
+  for (int i = 0; i < 6; ++i) {
+    float* row = output.ptr<float>() + i * (5 + kClasses);
+    row[0] = 50.0f + 100.0f * i;  // cx, boxes never overlap
+    row[1] = 80.0f;
+    row[2] = 40.0f;
+    row[3] = 20.0f;
+    row[4] = 1.0f;
+    row[5 + (i % 2 == 0 ? 0 : 2)] = 0.95f - 0.05f * i;
+  }
+  return output;
+}
+
+}  // namespace
+
+TEST(YoloDecoderTest, ResolveAutoRowLayout) {
+  auto output = MakeRowOutput(100, 80, 0, 0);
+  auto layout = OutputLayout::Resolve(YoloFamily::kAuto, output);
+
+  EXPECT_FALSE(layout.transposed);
+  EXPECT_TRUE(layout.has_objectness);
+  EXPECT_EQ(layout.num_classes, 80);
+  EXPECT_EQ(layout.num_anchors, 100);
+}
+
+TEST(YoloDecoderTest, ResolveAutoTransposedLayout) {
+  auto output = MakeColumnOutput(200, 3, 0, 0);
+  auto layout = OutputLayout::Resolve(YoloFamily::kAuto, output);
+
+  EXPECT_EQ(layout.family, YoloFamily::kYolov8);
+  EXPECT_TRUE(layout.transposed);
+  EXPECT_FALSE(layout.has_objectness);
+  EXPECT_EQ(layout.num_classes, 3);
+  EXPECT_EQ(layout.num_anchors, 200);
+}
+
+TEST(YoloDecoderTest, ResolveRejectsLabelMismatch) {
+  auto output = MakeRowOutput(100, 80, 0, 0);
+  EXPECT_THROW(OutputLayout::Resolve(YoloFamily::kYolox, output, 10),
+               cv::Exception);
+}
+
+TEST(YoloDecoderTest, DecodeRowLayout) {
+  auto output = MakeRowOutput(50, 80, 7, 16);
+  YoloDecoder decoder(OutputLayout::Resolve(YoloFamily::kYolox, output));
+
+  NmsCandidates candidates;
+  decoder.Decode(output, 0.5f, {}, candidates);
+
+  ASSERT_EQ(candidates.Size(), 1u);
+  EXPECT_EQ(candidates.class_id[0], 16);
+  EXPECT_NEAR(candidates.score[0], 0.72f, 1e-5);
+  EXPECT_FLOAT_EQ(candidates.x1[0], 80.0f);
+  EXPECT_FLOAT_EQ(candidates.y1[0], 70.0f);
+  EXPECT_FLOAT_EQ(candidates.x2[0], 120.0f);
+  EXPECT_FLOAT_EQ(candidates.y2[0], 90.0f);
+}
+
+TEST(YoloDecoderTest, DecodeTransposedCustomClassCount) {
+  auto output = MakeColumnOutput(300, 5, 123, 4);
+  YoloDecoder decoder(OutputLayout::Resolve(YoloFamily::kYolov8, output));
+
+  NmsCandidates candidates;
+  decoder.Decode(output, 0.5f, {}, candidates);
+
+  ASSERT_EQ(candidates.Size(), 1u);
+  EXPECT_EQ(candidates.class_id[0], 4);
+  EXPECT_FLOAT_EQ(candidates.score[0], 0.7f);
+  EXPECT_FLOAT_EQ(candidates.x1[0], 80.0f);
+}
+
+TEST(YoloDecoderTest, WhitelistSkipsOtherClasses) {
+  auto row = MakeRowOutput(20, 80, 3, 2);
+  YoloDecoder row_decoder(OutputLayout::Resolve(YoloFamily::kYolov5, row));
+  NmsCandidates candidates;
+
+  row_decoder.Decode(row, 0.5f, {0}, candidates);
+  EXPECT_TRUE(candidates.Empty());
+  row_decoder.Decode(row, 0.5f, {0, 2}, candidates);
+  EXPECT_EQ(candidates.Size(), 1u);
+
+  candidates.Clear();
+  auto column = MakeColumnOutput(20, 80, 3, 2);
+  YoloDecoder column_decoder(
+      OutputLayout::Resolve(YoloFamily::kYolov8, column));
+  column_decoder.Decode(column, 0.5f, {1}, candidates);
+  EXPECT_TRUE(candidates.Empty());
+  column_decoder.Decode(column, 0.5f, {2}, candidates);
+  EXPECT_EQ(candidates.Size(), 1u);
+}
+
+// The request budget caps the kept boxes and filters classes after NMS
+TEST(YoloDecoderTest, BudgetCapsAndFiltersDetections) {
+  std::vector<cv::Mat> outs{MakeCrowdOutput()};
+  YoloDecoder decoder(OutputLayout::Resolve(YoloFamily::kYolov5, outs[0]));
+  Nms nms;
+  NmsCandidates candidates;
+  std::vector<int> keep;
+
+  DecodeWithinBudget(decoder, nms, outs, 0.5f, {}, candidates, keep);
+  EXPECT_EQ(keep.size(), 6u);
+
+  DetectionBudget top_k;
+  top_k.max_detections = 2;
+  DecodeWithinBudget(decoder, nms, outs, 0.5f, top_k, candidates, keep);
+  ASSERT_EQ(keep.size(), 2u);
+  EXPECT_FLOAT_EQ(candidates.score[keep[0]], 0.95f);
+  EXPECT_FLOAT_EQ(candidates.score[keep[1]], 0.90f);
+
+  DetectionBudget classes;
+  classes.class_whitelist = {2};
+  DecodeWithinBudget(decoder, nms, outs, 0.5f, classes, candidates, keep);
+  ASSERT_EQ(keep.size(), 3u);
+  for (auto i : keep) EXPECT_EQ(candidates.class_id[i], 2);
+
+  DetectionBudget both = classes;
+  both.max_detections = 1;
+  both.min_confidence = 0.6f;
+  DecodeWithinBudget(decoder, nms, outs, 0.5f, both, candidates, keep);
+  ASSERT_EQ(keep.size(), 1u);
+  EXPECT_EQ(candidates.class_id[keep[0]], 2);
+  EXPECT_FLOAT_EQ(candidates.score[keep[0]], 0.90f);
+}
+
+TEST(YoloDecoderTest, ParseFamily) {
+  YoloFamily family = YoloFamily::kAuto;
+  EXPECT_TRUE(ParseYoloFamily("yolov8", family));
+  EXPECT_EQ(family, YoloFamily::kYolov8);
+  EXPECT_FALSE(ParseYoloFamily("yolov99", family));
+  EXPECT_EQ(family, YoloFamily::kYolov8);
+}
+
+TEST(YoloDecoderTest, ResolveFromShape) {
+  const std::vector<int> shape{1, 84, 8400};
+  auto layout = OutputLayout::Resolve(YoloFamily::kAuto, shape);
+
+  EXPECT_TRUE(layout.transposed);
+  EXPECT_EQ(layout.num_classes, 80);
+  EXPECT_EQ(layout.num_anchors, 8400);
+  EXPECT_THROW(OutputLayout::Resolve(YoloFamily::kAuto, shape, 3),
+               cv::Exception);
+}
+
+// Labels come from metadata_props only, never from bytes inside the graph
+TEST(YoloDecoderTest, LoadLabelsFromModelMetadata) {
+  std::string graph_bytes("\x01\xffnames\x12\x0a{0: 'bad'}", 19);
+  std::string model = std::string("\x08\x08", 2) +  // ir_version
+                      Field(2, "pytorch") +           // producer_name
+                      Field(7, Field(1, graph_bytes)) +  // graph
+                      Field(14, Field(1, "stride") + Field(2, "32")) +
+                      Field(14, Field(1, "names") +
+                                    Field(2, "{0: 'person', 1: 'car', "
+                                             "2: \"bus\"}"));
+
+  auto labels = LoadLabelsFromModel(model);
+  ASSERT_EQ(labels.size(), 3u);
+  EXPECT_EQ(labels[0], "person");
+  EXPECT_EQ(labels[1], "car");
+  EXPECT_EQ(labels[2], "bus");
+
+  // No names entry, and a model cut off inside the graph
+  auto graph_only = std::string("\x08\x08", 2) + Field(7, graph_bytes);
+  EXPECT_TRUE(LoadLabelsFromModel(graph_only).empty());
+  EXPECT_TRUE(
+      LoadLabelsFromModel(std::string_view(model).substr(0, 20)).empty());
+}
+
+TEST(YoloInputTest, U8InputMatchesFloatBlob) {
+  cv::Mat img(30, 40, CV_8UC3);
+  cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+  const cv::Scalar scale = cv::Scalar::all(1.0 / 255);
+  const cv::Scalar mean = cv::Scalar::all(20.0);
+  const cv::Size size(32, 32);
+
+  // A net of one identity layer returns what its input layer produced
+  cv::dnn::Net net;
+  cv::dnn::LayerParams params;
+  params.name = "identity";
+  params.type = "Identity";
+  net.addLayerToPrev(params.name, params.type, params);
+  net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+  net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+
+  auto run = [&](bool input_u8) {
+    auto blob = cv::dnn::blobFromImageWithParams(
+        img, MakeBlobParams(scale, mean, size, true, 114.0f, input_u8));
+    EXPECT_EQ(blob.depth(), input_u8 ? CV_8U : CV_32F);
+    SetNetInput(net, blob, scale, mean, input_u8);
+    return net.forward().clone();
+  };
+
+  cv::Mat expected = run(false);
+  cv::Mat actual = run(true);
+  ASSERT_EQ(actual.type(), CV_32F);
+  ASSERT_EQ(actual.total(), expected.total());
+  EXPECT_LT(cv::norm(actual, expected, cv::NORM_INF), 1e-5);
+}
+
+TEST(YoloDecoderTest, LoadLabelsFromFile) {
+  const char* path = "test_labels.txt";
+  {
+    std::ofstream file(path);
+    file << "person\n  car \n\nbus\r\n";
+  }
+
+  auto labels = LoadLabelsFromFile(path);
+  std::remove(path);
+
+  ASSERT_EQ(labels.size(), 3u);
+  EXPECT_EQ(labels[0], "person");
+  EXPECT_EQ(labels[1], "car");
+  EXPECT_EQ(labels[2], "bus");
+
+  EXPECT_THROW(LoadLabelsFromFile("/nonexistent/labels.txt"),
+               std::runtime_error);
+}
+
+}  // namespace aa::server
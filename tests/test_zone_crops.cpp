@@ -0,0 +1,138 @@
+/**
+ * @file test_zone_crops.cpp
+ * @brief Unit tests for per-zone inference crop selection and merging
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "polygon.h"
+#include "zone_crops.h"
+
+namespace aa::server {
+
+namespace {
+
+aa::shared::Polygon MakeZone(double x, double y, double width, double height,
+                             bool crop = true,
+                             aa::shared::PolygonType type =
+                                 aa::shared::PolygonType::INCLUSION) {
+  aa::shared::Polygon zone({{x, y}, {x + width, y}, {x + width, y + height},
+                            {x, y + height}},
+                           type, 1, {});
+  zone.SetInferenceCrop(crop);
+  return zone;
+}
+
+}  // namespace
+
+TEST(ZoneCropsTest, SelectsSmallZonesThatRequestACrop) {
+  std::vector<aa::shared::Polygon> zones = {
+      MakeZone(100, 100, 200, 150),
+      MakeZone(500, 100, 200, 150, false),
+      MakeZone(900, 100, 200, 150, true,
+               aa::shared::PolygonType::EXCLUSION),
+  };
+  std::vector<cv::Rect> crops;
+  SelectZoneCrops(zones, cv::Size(1920, 1080), {}, crops);
+
+  ASSERT_EQ(crops.size(), 1u);
+  EXPECT_EQ(crops[0], cv::Rect(100, 100, 200, 150));
+}
+
+TEST(ZoneCropsTest, SkipsZonesTheFullFrameAlreadyResolves) {
+  std::vector<aa::shared::Polygon> zones = {MakeZone(0, 0, 1800, 1000)};
+  std::vector<cv::Rect> crops;
+  SelectZoneCrops(zones, cv::Size(1920, 1080), {}, crops);
+  EXPECT_TRUE(crops.empty());
+}
+
+TEST(ZoneCropsTest, ClipsToFrameAndCapsCount) {
+  std::vector<aa::shared::Polygon> zones = {
+      MakeZone(-50, -50, 150, 150),
+      MakeZone(300, 300, 100, 100),
+      MakeZone(600, 600, 100, 100),
+  };
+  ZoneCropOptions options;
+  options.max_crops = 2;
+  std::vector<cv::Rect> crops;
+  SelectZoneCrops(zones, cv::Size(1920, 1080), options, crops);
+
+  ASSERT_EQ(crops.size(), 2u);
+  EXPECT_EQ(crops[0], cv::Rect(0, 0, 100, 100));
+  EXPECT_EQ(crops[1], cv::Rect(300, 300, 100, 100));
+
+  options.max_crops = 0;
+  SelectZoneCrops(zones, cv::Size(1920, 1080), options, crops);
+  EXPECT_TRUE(crops.empty());
+}
+
+TEST(ZoneCropsTest, MergeMapsCropDetectionsIntoTheFrame) {
+  ZoneCropMerger merger;
+  std::vector<cv::Rect> crops = {cv::Rect(400, 300, 200, 200)};
+  std::vector<std::vector<aa::shared::Detection>> crop_detections = {
+      {{cv::Rect(50, 60, 20, 30), 0, 0.8f}}};
+  std::vector<aa::shared::Detection> detections = {
+      {cv::Rect(10, 10, 40, 40), 2, 0.9f}};
+
+  merger.Merge(cv::Size(1920, 1080), crops, crop_detections, 0, detections);
+
+  ASSERT_EQ(detections.size(), 2u);
+  EXPECT_EQ(detections[0].bbox, cv::Rect(10, 10, 40, 40));
+  EXPECT_EQ(detections[1].bbox, cv::Rect(450, 360, 20, 30));
+  EXPECT_EQ(detections[1].class_id, 0);
+  EXPECT_FLOAT_EQ(detections[1].confidence, 0.8f);
+}
+
+TEST(ZoneCropsTest, MergeKeepsTheBestBoxOfAnObjectSeenAtBothScales) {
+  ZoneCropMerger merger;
+  std::vector<cv::Rect> crops = {cv::Rect(400, 300, 200, 200)};
+  std::vector<std::vector<aa::shared::Detection>> crop_detections = {
+      {{cv::Rect(51, 61, 20, 30), 0, 0.85f}}};
+  std::vector<aa::shared::Detection> detections = {
+      {cv::Rect(450, 360, 20, 30), 0, 0.6f}};
+
+  merger.Merge(cv::Size(1920, 1080), crops, crop_detections, 0, detections);
+
+  ASSERT_EQ(detections.size(), 1u);
+  EXPECT_EQ(detections[0].bbox, cv::Rect(451, 361, 20, 30));
+  EXPECT_FLOAT_EQ(detections[0].confidence, 0.85f);
+}
+
+TEST(ZoneCropsTest, MergeDropsBoxesCutByAnInnerCropEdge) {
+  ZoneCropMerger merger;
+  std::vector<cv::Rect> crops = {cv::Rect(400, 300, 200, 200),
+                                 cv::Rect(0, 0, 200, 200)};
+  std::vector<std::vector<aa::shared::Detection>> crop_detections = {
+      {{cv::Rect(0, 50, 30, 30), 0, 0.9f},
+       {cv::Rect(170, 50, 30, 30), 0, 0.9f}},
+      // Edges on the frame border do not cut objects
+      {{cv::Rect(0, 0, 30, 30), 0, 0.9f}}};
+  std::vector<aa::shared::Detection> detections;
+
+  merger.Merge(cv::Size(1920, 1080), crops, crop_detections, 0, detections);
+
+  ASSERT_EQ(detections.size(), 1u);
+  EXPECT_EQ(detections[0].bbox, cv::Rect(0, 0, 30, 30));
+}
+
+TEST(ZoneCropsTest, MergeAppliesDetectionCap) {
+  ZoneCropMerger merger;
+  std::vector<cv::Rect> crops = {cv::Rect(400, 300, 200, 200)};
+  std::vector<std::vector<aa::shared::Detection>> crop_detections = {
+      {{cv::Rect(20, 20, 10, 10), 0, 0.7f},
+       {cv::Rect(80, 80, 10, 10), 0, 0.8f}}};
+  std::vector<aa::shared::Detection> detections = {
+      {cv::Rect(10, 10, 10, 10), 0, 0.9f}};
+
+  merger.Merge(cv::Size(1920, 1080), crops, crop_detections, 2, detections);
+
+  ASSERT_EQ(detections.size(), 2u);
+  EXPECT_FLOAT_EQ(detections[0].confidence, 0.9f);
+  EXPECT_FLOAT_EQ(detections[1].confidence, 0.8f);
+}
+
+}  // namespace aa::server